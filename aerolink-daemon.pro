@@ -0,0 +1,25 @@
+# 无界面守护进程：qmake aerolink-daemon.pro
+# QImage 编解码需要 gui 模块，但不链接 widgets，也不创建 QGuiApplication
+
+TARGET = aerolink-daemon
+TEMPLATE = app
+
+QT += core gui network
+QT -= widgets
+
+CONFIG += c++20 console
+CONFIG -= app_bundle
+
+!unix: error("aerolink-daemon relies on Unix signals and is only supported on Unix.")
+
+include(aerolink_core.pri)
+
+SOURCES += \
+    daemon_main.cpp \
+    unix_signal_watcher.cpp
+
+HEADERS += \
+    unix_signal_watcher.h
+
+target.path = /opt/aerolink/bin
+INSTALLS += target
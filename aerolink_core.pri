@@ -0,0 +1,72 @@
+# 界面程序与 aerolink-daemon 共用的监控/打包/传输模块（不依赖 widgets）
+
+SOURCES += \
+    $$PWD/AuxFileReader.cpp \
+    $$PWD/async_transfer.cpp \
+    $$PWD/command_frame_parser.cpp \
+    $$PWD/directory_snapshot.cpp \
+    $$PWD/durable_queue.cpp \
+    $$PWD/file_monitor.cpp \
+    $$PWD/hdr_histogram.cpp \
+    $$PWD/image_transfer.cpp \
+    $$PWD/image_utils.cpp \
+    $$PWD/isar_request_queue.cpp \
+    $$PWD/log_categories.cpp \
+    $$PWD/log_ring_buffer.cpp \
+    $$PWD/logmanager.cpp \
+    $$PWD/metrics_server.cpp \
+    $$PWD/package_sar_data.cpp \
+    $$PWD/pipeline_config.cpp \
+    $$PWD/product_cache.cpp \
+    $$PWD/product_correlator.cpp \
+    $$PWD/product_journal.cpp \
+    $$PWD/product_timing.cpp \
+    $$PWD/scene_delta.cpp \
+    $$PWD/slc_chip.cpp \
+    $$PWD/slc_multilook.cpp \
+    $$PWD/trace_recorder.cpp \
+    $$PWD/transfer_metrics.cpp \
+    $$PWD/transfer_pipeline.cpp \
+    $$PWD/transfer_scheduler.cpp \
+    $$PWD/worker_pool.cpp
+
+HEADERS += \
+    $$PWD/AuxFileReader.h \
+    $$PWD/async_transfer.h \
+    $$PWD/command_frame_parser.h \
+    $$PWD/directory_snapshot.h \
+    $$PWD/durable_queue.h \
+    $$PWD/file_monitor.h \
+    $$PWD/hdr_histogram.h \
+    $$PWD/image_transfer.h \
+    $$PWD/image_utils.h \
+    $$PWD/isar_request_queue.h \
+    $$PWD/log_categories.h \
+    $$PWD/log_ring_buffer.h \
+    $$PWD/logmanager.h \
+    $$PWD/metrics_server.h \
+    $$PWD/package_sar_data.h \
+    $$PWD/pipeline_config.h \
+    $$PWD/product_cache.h \
+    $$PWD/product_correlator.h \
+    $$PWD/product_journal.h \
+    $$PWD/product_timing.h \
+    $$PWD/radar_protocol.h \
+    $$PWD/scene_delta.h \
+    $$PWD/slc_chip.h \
+    $$PWD/slc_format.h \
+    $$PWD/slc_multilook.h \
+    $$PWD/trace_recorder.h \
+    $$PWD/transfer_metrics.h \
+    $$PWD/transfer_pipeline.h \
+    $$PWD/transfer_scheduler.h \
+    $$PWD/worker_pool.h
+
+linux {
+    SOURCES += \
+        $$PWD/epoll_command_server.cpp \
+        $$PWD/inotify_watcher.cpp
+    HEADERS += \
+        $$PWD/epoll_command_server.h \
+        $$PWD/inotify_watcher.h
+}
@@ -0,0 +1,238 @@
+#include "async_transfer.h"
+#include "package_sar_data.h"
+#include "trace_recorder.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <memory>
+
+namespace async {
+namespace detail {
+
+SocketAwaiter::SocketAwaiter(QTcpSocket* socket, int timeoutMs)
+    : m_socket(socket)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(qMax(1, timeoutMs));
+}
+
+void SocketAwaiter::suspend(std::coroutine_handle<> handle) {
+    m_handle = handle;
+    watch(QObject::connect(&m_timer, &QTimer::timeout, m_socket, [this]() { finish(false); }));
+    m_timer.start();
+}
+
+void SocketAwaiter::watch(const QMetaObject::Connection& connection) {
+    m_connections.append(connection);
+}
+
+void SocketAwaiter::restartTimer() {
+    m_timer.start();
+}
+
+void SocketAwaiter::finish(bool ok) {
+    if (m_done) {
+        return;
+    }
+    m_done = true;
+    m_result = ok;
+    m_timer.stop();
+    for (const QMetaObject::Connection& connection : m_connections) {
+        QObject::disconnect(connection);
+    }
+    m_connections.clear();
+    // 不在信号发射过程中恢复：协程继续执行时可能关闭甚至释放套接字
+    const std::coroutine_handle<> handle = m_handle;
+    QMetaObject::invokeMethod(m_socket, [handle]() { handle.resume(); }, Qt::QueuedConnection);
+}
+
+} // namespace detail
+
+ConnectAwaiter::ConnectAwaiter(QTcpSocket* socket, const QString& host, quint16 port, int timeoutMs)
+    : SocketAwaiter(socket, timeoutMs),
+    m_host(host),
+    m_port(port)
+{
+}
+
+bool ConnectAwaiter::await_ready() const noexcept {
+    return m_socket->state() == QAbstractSocket::ConnectedState;
+}
+
+void ConnectAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    watch(QObject::connect(m_socket, &QTcpSocket::connected, m_socket, [this]() { finish(true); }));
+    watch(QObject::connect(m_socket, &QTcpSocket::errorOccurred, m_socket, [this]() { finish(false); }));
+    suspend(handle);
+    m_socket->connectToHost(m_host, m_port);
+}
+
+DrainAwaiter::DrainAwaiter(QTcpSocket* socket, int timeoutMs)
+    : SocketAwaiter(socket, timeoutMs)
+{
+}
+
+bool DrainAwaiter::await_ready() const noexcept {
+    return m_socket->bytesToWrite() == 0;
+}
+
+void DrainAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    watch(QObject::connect(m_socket, &QTcpSocket::bytesWritten, m_socket, [this]() {
+        if (m_socket->bytesToWrite() == 0) {
+            finish(true);
+        } else {
+            restartTimer();
+        }
+    }));
+    watch(QObject::connect(m_socket, &QTcpSocket::errorOccurred, m_socket, [this]() { finish(false); }));
+    watch(QObject::connect(m_socket, &QTcpSocket::disconnected, m_socket, [this]() { finish(false); }));
+    suspend(handle);
+}
+
+AckAwaiter::AckAwaiter(QTcpSocket* socket, const QByteArray& expected, int timeoutMs)
+    : SocketAwaiter(socket, timeoutMs),
+    m_expected(expected)
+{
+}
+
+void AckAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    watch(QObject::connect(m_socket, &QTcpSocket::readyRead, m_socket, [this]() { check(); }));
+    watch(QObject::connect(m_socket, &QTcpSocket::errorOccurred, m_socket, [this]() { finish(false); }));
+    watch(QObject::connect(m_socket, &QTcpSocket::disconnected, m_socket, [this]() { finish(false); }));
+    suspend(handle);
+    // 确认可能在写完之前就已到达
+    if (m_socket->bytesAvailable() > 0) {
+        check();
+    }
+}
+
+void AckAwaiter::check() {
+    m_received += m_socket->readAll();
+    if (m_received.contains(m_expected)) {
+        finish(true);
+    }
+}
+
+} // namespace async
+
+namespace {
+struct DeleteLater {
+    void operator()(QObject* object) const { object->deleteLater(); }
+};
+}
+
+async::Task<ImageTransferResult> transferPackedFileAsync(QString packedPath, QString ipAddress, quint16 port, TransferOptions options)
+{
+    if (!QFileInfo::exists(packedPath)) {
+        ImageTransferResult result;
+        result.success = false;
+        result.message = "Packed file not found: " + packedPath;
+        co_return result;
+    }
+    co_return co_await transferPacketsAsync(std::make_shared<SarPacketizer>(packedPath), ipAddress, port, options);
+}
+
+async::Task<ImageTransferResult> transferPacketsAsync(std::shared_ptr<PacketSource> source, QString ipAddress, quint16 port, TransferOptions options)
+{
+    ImageTransferResult result;
+    result.success = false;
+
+    // 从开始建连计时；首字节以第一次 bytesWritten（数据真正交给内核）为准，而不是写入 Qt 缓冲
+    QElapsedTimer clock;
+    clock.start();
+    const qint64 traceStartUs = TraceRecorder::nowUs();
+    auto firstSentUs = std::make_shared<qint64>(-1);
+
+    std::unique_ptr<QTcpSocket, DeleteLater> socket(new QTcpSocket);
+    QObject::connect(socket.get(), &QTcpSocket::bytesWritten, socket.get(), [firstSentUs, clock]() {
+        if (*firstSentUs < 0) {
+            *firstSentUs = clock.nsecsElapsed() / 1000;
+        }
+    });
+    if (!co_await async::connectTo(socket.get(), ipAddress, port, options.connectTimeoutMs)) {
+        result.message = QString("Failed to connect to %1:%2: %3").arg(ipAddress).arg(port).arg(socket->errorString());
+        socket->abort();
+        co_return result;
+    }
+    const qint64 connectedUs = clock.nsecsElapsed() / 1000;
+
+    int imageNumber = -1;  // 跟踪区间的标签，取自第一帧的帧头
+    while (source->hasNextPacket()) {
+        const QByteArray packetData = source->getNextPacket();
+        if (packetData.isEmpty()) {
+            result.message = "Failed to get next packet from packet source.";
+            socket->abort();
+            co_return result;
+        }
+        if (imageNumber < 0) {
+            // 首包短于帧头时不按帧头解释，跟踪区间标为 0
+            imageNumber = packetData.size() >= qsizetype(sizeof(SAR_Frame))
+                ? reinterpret_cast<const SAR_Frame*>(packetData.constData())->image_number
+                : 0;
+        }
+        if (socket->write(packetData) == -1) {
+            result.message = "Failed to write data to socket: " + socket->errorString();
+            socket->abort();
+            co_return result;
+        }
+        result.bytesSent += packetData.size();
+        // 发送缓冲积压到上限时让出线程，等待链路把数据发出去
+        if (socket->bytesToWrite() >= options.maxBufferedBytes
+            && !co_await async::drain(socket.get(), options.stallTimeoutMs)) {
+            result.message = "Transfer stalled: " + socket->errorString();
+            socket->abort();
+            co_return result;
+        }
+    }
+
+    if (!co_await async::drain(socket.get(), options.stallTimeoutMs)) {
+        result.message = "Transfer stalled: " + socket->errorString();
+        socket->abort();
+        co_return result;
+    }
+    const qint64 lastSentUs = clock.nsecsElapsed() / 1000;
+    const qint64 firstUs = *firstSentUs >= 0 ? *firstSentUs : lastSentUs;
+    result.timing.set(TimingStage::FirstByte, firstUs);
+    result.timing.set(TimingStage::LastByte, lastSentUs - firstUs);
+    TraceRecorder::recordComplete("connect", traceStartUs, connectedUs, imageNumber);
+    TraceRecorder::recordComplete("send", traceStartUs + connectedUs, lastSentUs - connectedUs, imageNumber);
+
+    if (options.waitForAck) {
+        if (!co_await async::ack(socket.get(), QByteArrayLiteral("OK"), options.ackTimeoutMs)) {
+            qWarning() << "Timeout waiting for acknowledgment from" << ipAddress << port;
+            result.message = "Timeout waiting for acknowledgment.";
+            socket->abort();
+            co_return result;
+        }
+        result.timing.set(TimingStage::Ack, clock.nsecsElapsed() / 1000 - lastSentUs);
+        TraceRecorder::recordComplete("ack", traceStartUs + lastSentUs, result.timing.get(TimingStage::Ack), imageNumber);
+    }
+
+    socket->disconnectFromHost();
+    result.success = true;
+    result.message = "Transfer completed successfully.";
+    co_return result;
+}
+
+IoExecutor::IoExecutor(const QString& name)
+    : m_context(new QObject)
+{
+    m_thread.setObjectName(name);
+    m_context->moveToThread(&m_thread);
+    m_thread.start();
+}
+
+IoExecutor::~IoExecutor() {
+    // 未完成的传输随线程退出一并放弃，调度器会在下次启动时从持久化队列中重发
+    m_thread.quit();
+    m_thread.wait();
+    delete m_context;
+}
+
+void IoExecutor::post(std::function<void()> fn) {
+    QMetaObject::invokeMethod(m_context, std::move(fn), Qt::QueuedConnection);
+}
+
+QObject* IoExecutor::context() const {
+    return m_context;
+}
@@ -0,0 +1,216 @@
+#ifndef ASYNC_TRANSFER_H
+#define ASYNC_TRANSFER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "image_transfer.h"
+
+// 传输参数
+struct TransferOptions {
+    int connectTimeoutMs = 5000;
+    int stallTimeoutMs = 10000;           // 发送缓冲长时间没有进展视为链路中断
+    qint64 maxBufferedBytes = 256 * 1024; // 套接字待发送字节超过该值时等待排空
+    bool waitForAck = false;              // 发送完毕后是否等待接收端回复 "OK"
+    int ackTimeoutMs = 5000;
+};
+
+namespace async {
+
+/**
+ * @brief 协程返回类型。
+ *
+ * 调用即开始执行，直到第一次挂起；co_await 一个 Task 会在其完成时恢复等待方。
+ * 所有挂起点都在 Qt 事件循环中以排队调用的方式恢复，因此同一线程上可同时进行多个协程，
+ * 不需要局部 QEventLoop。
+ */
+template <typename T>
+class Task {
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            // 结束时把控制权交还给等待方；帧由 Task 析构时销毁
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    std::coroutine_handle<> continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() const noexcept {}
+            };
+            return FinalAwaiter{};
+        }
+        void return_value(T result) { value = std::move(result); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    Task& operator=(Task&&) = delete;
+    ~Task() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return m_handle.done(); }
+    void await_suspend(std::coroutine_handle<> awaiting) noexcept { m_handle.promise().continuation = awaiting; }
+    T await_resume() {
+        if (m_handle.promise().error) {
+            std::rethrow_exception(m_handle.promise().error);
+        }
+        return std::move(*m_handle.promise().value);
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+// 顶层协程：不返回结果，帧在结束时自行销毁
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+// 在当前线程启动 task，完成后以结果调用 done
+template <typename T>
+Detached start(Task<T> task, std::type_identity_t<std::function<void(T)>> done) {
+    T result = co_await task;
+    done(std::move(result));
+}
+
+namespace detail {
+
+/**
+ * @brief 等待套接字事件的可等待对象基类。
+ * 事件到达或超时后断开全部连接，并把恢复操作排入套接字所在线程的事件队列，
+ * 避免在套接字的信号发射过程中继续执行（协程可能随即销毁套接字）。
+ */
+class SocketAwaiter {
+public:
+    SocketAwaiter(QTcpSocket* socket, int timeoutMs);
+    SocketAwaiter(const SocketAwaiter&) = delete;
+    SocketAwaiter& operator=(const SocketAwaiter&) = delete;
+
+    bool await_resume() const noexcept { return m_result; }
+
+protected:
+    void suspend(std::coroutine_handle<> handle);
+    void finish(bool ok);
+    void watch(const QMetaObject::Connection& connection);
+    void restartTimer();
+
+    QTcpSocket* m_socket;
+    QTimer m_timer;
+    std::coroutine_handle<> m_handle;
+    QList<QMetaObject::Connection> m_connections;
+    bool m_result = false;
+    bool m_done = false;
+};
+
+} // namespace detail
+
+class ConnectAwaiter : public detail::SocketAwaiter {
+public:
+    ConnectAwaiter(QTcpSocket* socket, const QString& host, quint16 port, int timeoutMs);
+    bool await_ready() const noexcept;
+    void await_suspend(std::coroutine_handle<> handle);
+
+private:
+    QString m_host;
+    quint16 m_port;
+};
+
+// 等待套接字发送缓冲排空；timeoutMs 内没有任何进展则失败
+class DrainAwaiter : public detail::SocketAwaiter {
+public:
+    DrainAwaiter(QTcpSocket* socket, int timeoutMs);
+    bool await_ready() const noexcept;
+    void await_suspend(std::coroutine_handle<> handle);
+};
+
+// 等待接收端回复包含 expected 的确认
+class AckAwaiter : public detail::SocketAwaiter {
+public:
+    AckAwaiter(QTcpSocket* socket, const QByteArray& expected, int timeoutMs);
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle);
+
+private:
+    void check();
+
+    QByteArray m_expected;
+    QByteArray m_received;
+};
+
+inline ConnectAwaiter connectTo(QTcpSocket* socket, const QString& host, quint16 port, int timeoutMs) {
+    return ConnectAwaiter(socket, host, port, timeoutMs);
+}
+
+inline DrainAwaiter drain(QTcpSocket* socket, int timeoutMs) {
+    return DrainAwaiter(socket, timeoutMs);
+}
+
+inline AckAwaiter ack(QTcpSocket* socket, const QByteArray& expected, int timeoutMs) {
+    return AckAwaiter(socket, expected, timeoutMs);
+}
+
+} // namespace async
+
+/**
+ * @brief 异步发送一个已打包的 bin 文件：co_await 连接、逐包写入（缓冲过多时等待排空）、可选等待确认。
+ * 必须在运行事件循环的线程中调用；同一线程可同时进行任意多个传输。
+ */
+async::Task<ImageTransferResult> transferPackedFileAsync(QString packedPath, QString ipAddress, quint16 port, TransferOptions options = TransferOptions());
+
+/**
+ * @brief 异步发送任意包源（如直接从 SLC 映射中切出的芯片）；transferPackedFileAsync 即以 bin 文件为包源调用它。
+ * 包源在 I/O 线程中被逐包读取，调用方不得再同时访问它。
+ */
+async::Task<ImageTransferResult> transferPacketsAsync(std::shared_ptr<PacketSource> source, QString ipAddress, quint16 port, TransferOptions options = TransferOptions());
+
+/**
+ * @class IoExecutor
+ * @brief 运行事件循环的 I/O 线程，传输协程在其中执行。
+ */
+class IoExecutor {
+public:
+    explicit IoExecutor(const QString& name = QStringLiteral("io"));
+    ~IoExecutor();
+
+    // 在 I/O 线程中执行 fn（线程安全）
+    void post(std::function<void()> fn);
+    QObject* context() const;
+
+private:
+    QThread m_thread;
+    QObject* m_context;
+};
+
+#endif // ASYNC_TRANSFER_H
@@ -0,0 +1,18 @@
+# CommandFrameParser 失步恢复、0x02 区域扩展与 0x03 缺包描述解析的行为测试：qmake command-frame-parser-test.pro && make check
+# 只依赖 QtCore 与 QtTest
+
+TARGET = command-frame-parser-test
+TEMPLATE = app
+
+QT = core testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    command_frame_parser_test.cpp \
+    command_frame_parser.cpp
+
+HEADERS += \
+    command_frame_parser.h \
+    radar_protocol.h
@@ -0,0 +1,22 @@
+# EpollCommandServer 压力测试：qmake command-server-bench.pro
+# 只依赖 QtCore（指令帧中的 QByteArray），不链接 network/gui
+
+TARGET = command-server-bench
+TEMPLATE = app
+
+QT = core
+
+CONFIG += c++20 console
+CONFIG -= app_bundle
+
+!linux: error("command-server-bench exercises the epoll backend and is only supported on Linux.")
+
+SOURCES += \
+    command_server_bench.cpp \
+    command_frame_parser.cpp \
+    epoll_command_server.cpp
+
+HEADERS += \
+    command_frame_parser.h \
+    epoll_command_server.h \
+    radar_protocol.h
@@ -0,0 +1,261 @@
+#include "command_frame_parser.h"
+#include <QBitArray>
+#include <QtEndian>
+#include <cstring>
+
+static const quint8 SYNC_FIRST = 0xE9;   // 0x9EE9 小端序
+static const quint8 SYNC_SECOND = 0x9E;
+static const qint64 LENGTH_OFFSET = offsetof(DataHeader, data_length);
+static const qint64 CHECKSUM_OFFSET = offsetof(DataHeader, checksum);
+static const quint8 INFO_MARKER_FIRST = 0xAA;   // DataInfo 帧头 0x55AA 小端序
+static const quint8 INFO_MARKER_SECOND = 0x55;
+
+CommandFrameParser::CommandFrameParser(int capacity)
+{
+    quint64 size = 1;
+    const quint64 wanted = quint64(qMax(capacity, 2 * (HEADER_SIZE + MAX_PAYLOAD)));
+    while (size < wanted) {
+        size <<= 1;
+    }
+    m_data.reset(new char[size]);
+    m_mask = size - 1;
+}
+
+qint64 CommandFrameParser::capacity() const {
+    return qint64(m_mask + 1);
+}
+
+qint64 CommandFrameParser::bufferedBytes() const {
+    return qint64(m_tail - m_head);
+}
+
+char* CommandFrameParser::writePointer(qint64* available) {
+    const quint64 index = m_tail & m_mask;
+    const quint64 freeBytes = quint64(capacity()) - (m_tail - m_head);
+    // 只返回到缓冲末尾为止的连续部分，回绕后的部分下次再写
+    *available = qint64(qMin(freeBytes, quint64(capacity()) - index));
+    return m_data.get() + index;
+}
+
+void CommandFrameParser::commitWrite(qint64 bytes) {
+    m_tail += quint64(qBound<qint64>(0, bytes, capacity() - bufferedBytes()));
+}
+
+qint64 CommandFrameParser::append(const char* data, qint64 size) {
+    qint64 written = 0;
+    while (written < size) {
+        qint64 available = 0;
+        char* dst = writePointer(&available);
+        if (available == 0) {
+            break;
+        }
+        const qint64 chunk = qMin(available, size - written);
+        memcpy(dst, data + written, size_t(chunk));
+        commitWrite(chunk);
+        written += chunk;
+    }
+    return written;
+}
+
+quint8 CommandFrameParser::at(qint64 offset) const {
+    return quint8(m_data[(m_head + quint64(offset)) & m_mask]);
+}
+
+void CommandFrameParser::skip(qint64 bytes) {
+    m_head += quint64(bytes);
+}
+
+void CommandFrameParser::seekSync() {
+    while (m_tail - m_head >= 2) {
+        // 在到缓冲末尾为止的连续区内用 memchr 找同步字首字节
+        const quint64 index = m_head & m_mask;
+        const quint64 span = qMin(m_tail - m_head, quint64(capacity()) - index);
+        const void* hit = memchr(m_data.get() + index, SYNC_FIRST, size_t(span));
+        if (!hit) {
+            m_discarded += span;
+            m_head += span;
+            continue;
+        }
+        const quint64 skipped = quint64(static_cast<const char*>(hit) - (m_data.get() + index));
+        m_discarded += skipped;
+        m_head += skipped;
+        if (m_tail - m_head < 2 || at(1) == SYNC_SECOND) {
+            return;
+        }
+        ++m_discarded;
+        ++m_head;
+    }
+    // 只剩一个字节：若不是同步字首字节则同样丢弃
+    if (m_tail - m_head == 1 && at(0) != SYNC_FIRST) {
+        ++m_discarded;
+        ++m_head;
+    }
+}
+
+quint8 CommandFrameParser::checksum(qint64 offset, qint64 length) const {
+    quint8 sum = 0;
+    quint64 index = (m_head + quint64(offset)) & m_mask;
+    while (length > 0) {
+        const qint64 span = qMin(length, capacity() - qint64(index));
+        const quint8* p = reinterpret_cast<const quint8*>(m_data.get() + index);
+        for (qint64 i = 0; i < span; ++i) {
+            sum += p[i];
+        }
+        length -= span;
+        index = 0;
+    }
+    return sum;
+}
+
+void CommandFrameParser::copyOut(qint64 offset, char* dst, qint64 length) const {
+    quint64 index = (m_head + quint64(offset)) & m_mask;
+    while (length > 0) {
+        const qint64 span = qMin(length, capacity() - qint64(index));
+        memcpy(dst, m_data.get() + index, size_t(span));
+        dst += span;
+        length -= span;
+        index = 0;
+    }
+}
+
+bool CommandFrameParser::next(CommandFrame* frame) {
+    for (;;) {
+        seekSync();
+        if (bufferedBytes() < HEADER_SIZE) {
+            return false;
+        }
+
+        const qint64 dataLength = qint64(at(LENGTH_OFFSET)) | (qint64(at(LENGTH_OFFSET + 1)) << 8);
+        if (dataLength < qint64(sizeof(DataInfo)) || dataLength > MAX_PAYLOAD) {
+            // 同步字出现在数据中间的伪帧头，跳过后继续找
+            ++m_rejected;
+            ++m_discarded;
+            skip(1);
+            continue;
+        }
+        // 长度看似合理的伪帧头不能让后面的有效指令等满声明的长度：
+        // DataInfo 帧头一到就先核对，不是 0x55AA 立即跳过
+        if (bufferedBytes() < HEADER_SIZE + 2) {
+            return false;
+        }
+        if (at(HEADER_SIZE) != INFO_MARKER_FIRST || at(HEADER_SIZE + 1) != INFO_MARKER_SECOND) {
+            ++m_rejected;
+            ++m_discarded;
+            skip(1);
+            continue;
+        }
+        if (bufferedBytes() < HEADER_SIZE + dataLength) {
+            return false;
+        }
+
+        if (checksum(HEADER_SIZE, dataLength) != at(CHECKSUM_OFFSET)) {
+            ++m_rejected;
+            ++m_discarded;
+            skip(1);
+            continue;
+        }
+
+        DataInfo info;
+        copyOut(HEADER_SIZE, reinterpret_cast<char*>(&info), sizeof(DataInfo));
+        frame->info.frame_header = qFromLittleEndian(info.frame_header);
+        frame->info.data_length = qFromLittleEndian(info.data_length);
+        frame->info.message_count = qFromLittleEndian(info.message_count);
+        frame->info.source_address = qFromLittleEndian(info.source_address);
+        frame->info.destination_address = qFromLittleEndian(info.destination_address);
+        frame->info.command_type = info.command_type;
+        frame->info.reserved = info.reserved;
+        frame->info.image_number = qFromLittleEndian(info.image_number);
+        frame->info.pixel_offset_x = qFromLittleEndian(info.pixel_offset_x);
+        frame->info.pixel_offset_y = qFromLittleEndian(info.pixel_offset_y);
+        frame->info.total_y = qFromLittleEndian(info.total_y);
+
+        const qint64 extraLength = dataLength - qint64(sizeof(DataInfo));
+        frame->extra.resize(extraLength);
+        if (extraLength > 0) {
+            copyOut(HEADER_SIZE + qint64(sizeof(DataInfo)), frame->extra.data(), extraLength);
+        }
+        skip(HEADER_SIZE + dataLength);
+        return true;
+    }
+}
+
+quint64 CommandFrameParser::takeDiscardedBytes() {
+    const quint64 discarded = m_discarded;
+    m_discarded = 0;
+    return discarded;
+}
+
+quint64 CommandFrameParser::takeRejectedFrames() {
+    const quint64 rejected = m_rejected;
+    m_rejected = 0;
+    return rejected;
+}
+
+RoiCropExtension decodeRoiCropExtension(const QByteArray& extra) {
+    RoiCropExtension extension;
+    memset(&extension, 0, sizeof(extension));
+    if (extra.size() >= int(sizeof(RoiCropExtension))) {
+        memcpy(&extension, extra.constData(), sizeof(RoiCropExtension));
+        extension.width = qFromLittleEndian(extension.width);
+        extension.height = qFromLittleEndian(extension.height);
+    }
+    return extension;
+}
+
+MissingPackets decodeMissingPackets(const QByteArray& extra, QList<quint16>* packets) {
+    packets->clear();
+    if (extra.isEmpty()) {
+        return MissingPackets::WholeImage;
+    }
+    if (extra.size() < int(sizeof(RetransmitExtension))) {
+        return MissingPackets::Invalid;
+    }
+    RetransmitExtension extension;
+    memcpy(&extension, extra.constData(), sizeof(extension));
+    const quint16 firstPacket = qFromLittleEndian(extension.first_packet);
+    const int count = qFromLittleEndian(extension.count);
+    if (extension.encoding != RETRANSMIT_RANGES && extension.encoding != RETRANSMIT_BITMAP) {
+        return MissingPackets::Invalid;
+    }
+    if (count == 0) {
+        return MissingPackets::WholeImage;
+    }
+    const uchar* data = reinterpret_cast<const uchar*>(extra.constData()) + sizeof(RetransmitExtension);
+    const qint64 available = extra.size() - qint64(sizeof(RetransmitExtension));
+
+    // 区间可能重叠，先落到位图上再按序取出
+    QBitArray missing(65536);
+    if (extension.encoding == RETRANSMIT_RANGES) {
+        if (available < qint64(count) * 4) {
+            return MissingPackets::Invalid;
+        }
+        for (int i = 0; i < count; ++i) {
+            const quint16 first = qFromLittleEndian<quint16>(data + 4 * i);
+            const quint16 last = qFromLittleEndian<quint16>(data + 4 * i + 2);
+            for (int packet = first; packet <= last; ++packet) {
+                missing.setBit(packet);
+            }
+        }
+    } else {
+        if (available < count) {
+            return MissingPackets::Invalid;
+        }
+        for (int i = 0; i < count * 8; ++i) {
+            const int packet = firstPacket + i;
+            if (packet > 0xFFFF) {
+                break;
+            }
+            if (data[i / 8] & (1 << (i % 8))) {
+                missing.setBit(packet);
+            }
+        }
+    }
+    // 包号从 1 开始，0 不是有效包
+    missing.clearBit(0);
+    for (int packet = 1; packet < missing.size(); ++packet) {
+        if (missing.testBit(packet)) {
+            packets->append(quint16(packet));
+        }
+    }
+    return packets->isEmpty() ? MissingPackets::NoneSelected : MissingPackets::Selected;
+}
@@ -0,0 +1,86 @@
+#ifndef COMMAND_FRAME_PARSER_H
+#define COMMAND_FRAME_PARSER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QtGlobal>
+#include <memory>
+#include "radar_protocol.h"
+
+// 一条校验通过的指令帧（DataInfo 字段已转换为本机字节序）
+struct CommandFrame {
+    DataInfo info;
+    QByteArray extra;   // DataInfo 之后的附加数据，没有时为空
+};
+
+/**
+ * @class CommandFrameParser
+ * @brief 单个连接的指令帧解析器：定长环形缓冲 + 原地校验。
+ *
+ * 套接字数据直接读入环形缓冲（writePointer/commitWrite），解析时不移动、不复制缓冲内容，
+ * 帧头字段与校验和都在环内原地计算，只有校验通过的 20 字节 DataInfo 被拷出。
+ * 遇到非法帧头、长度越界、校验和错误或 DataInfo 帧头错误时只跳过 1 个字节，
+ * 继续向后查找下一个同步字 E9 9E，垃圾数据之后的有效指令不会丢失。
+ * DataInfo 帧头在数据到齐前就先核对，数据中偶然出现的同步字不会让后续指令等待整个声明长度。
+ */
+class CommandFrameParser {
+public:
+    static const int HEADER_SIZE = sizeof(DataHeader);
+    static const int MAX_PAYLOAD = 4096;   // 超过此长度的帧视为失步
+
+    // capacity 向上取整为 2 的幂，且至少容纳一个最大帧
+    explicit CommandFrameParser(int capacity = 16 * 1024);
+
+    // 可直接写入的连续空闲区；空间不足时 available 为 0
+    char* writePointer(qint64* available);
+    void commitWrite(qint64 bytes);
+    // 拷贝写入，空间不足时写入能容纳的部分并返回写入字节数
+    qint64 append(const char* data, qint64 size);
+
+    // 取出下一条完整且校验通过的帧；数据不足时返回 false
+    bool next(CommandFrame* frame);
+
+    qint64 bufferedBytes() const;
+    qint64 capacity() const;
+    // 取出并清零因失步被跳过的字节数与校验失败次数
+    quint64 takeDiscardedBytes();
+    quint64 takeRejectedFrames();
+
+private:
+    quint8 at(qint64 offset) const;
+    void skip(qint64 bytes);
+    // 把读位置推进到下一个 E9 9E（或只剩一个可能是同步字首字节的 E9）
+    void seekSync();
+    quint8 checksum(qint64 offset, qint64 length) const;
+    void copyOut(qint64 offset, char* dst, qint64 length) const;
+
+    std::unique_ptr<char[]> m_data;
+    quint64 m_mask;
+    quint64 m_head = 0;     // 读位置（单调递增，取模后为下标）
+    quint64 m_tail = 0;     // 写位置
+    quint64 m_discarded = 0;
+    quint64 m_rejected = 0;
+};
+
+/**
+ * @brief 解析 0x02 指令附带的 RoiCropExtension，字段转换为本机字节序。
+ * 扩展段可省略（旧版接收端）或不完整，此时返回全零，尺寸与质量由本端配置决定。
+ */
+RoiCropExtension decodeRoiCropExtension(const QByteArray& extra);
+
+// 0x03 缺包描述的解析结果
+enum class MissingPackets {
+    WholeImage,     // 未附带描述或 count 为 0：整图重发，packets 为空
+    Selected,       // packets 为选中的包号，非空
+    NoneSelected,   // 描述非空但未选中任何有效包（位图全零、区间均为 first > last 或只含包 0）：无需补发
+    Invalid         // 编码未知或长度不足
+};
+
+/**
+ * @brief 解析 0x03 指令附带的缺包描述（RetransmitExtension 及其后的区间列表或位图），
+ * 结果为升序、去重的包号。只有未附带描述或 count 为 0 才表示整图重发；
+ * 描述了缺包却一个也没选中时返回 NoneSelected，不能当作整图重发。
+ */
+MissingPackets decodeMissingPackets(const QByteArray& extra, QList<quint16>* packets);
+
+#endif // COMMAND_FRAME_PARSER_H
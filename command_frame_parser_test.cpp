@@ -0,0 +1,282 @@
+// command_frame_parser_test.cpp
+// 指令帧解析：字段与附加数据按小端序取出、半帧时等待、垃圾与伪帧头之后重新同步、
+// 校验和错误只丢一帧、跨环形缓冲末尾的帧，以及长度可信的伪帧头不拖住后面的有效指令；
+// 0x02 ROI 裁剪指令的区域扩展：按小端取出，省略或不完整时全零；
+// 0x03 补发指令的缺包描述：区间合并、位图展开、空描述表示整图重发、
+// 非空描述未选中任何包时不当作整图重发、格式错误时拒绝。
+#include <QtTest>
+#include <QtEndian>
+#include <cstring>
+#include "command_frame_parser.h"
+
+namespace {
+
+const quint8 ISAR_REQUEST = 0x01;
+
+QByteArray makeFrame(quint8 commandType, quint16 imageNumber, const QByteArray& extra = QByteArray()) {
+    DataInfo info;
+    memset(&info, 0, sizeof(info));
+    info.frame_header = qToLittleEndian<quint16>(0x55AA);
+    info.data_length = qToLittleEndian<quint32>(quint32(sizeof(DataInfo) + extra.size()));
+    info.command_type = commandType;
+    info.image_number = qToLittleEndian(imageNumber);
+    info.pixel_offset_x = qToLittleEndian<qint16>(100);
+    info.pixel_offset_y = qToLittleEndian<qint16>(-200);
+
+    const QByteArray payload = QByteArray(reinterpret_cast<const char*>(&info), sizeof(info)) + extra;
+    DataHeader header;
+    memset(&header, 0, sizeof(header));
+    header.fixed_value = qToLittleEndian<quint16>(0x9EE9);
+    header.data_length = qToLittleEndian<quint16>(quint16(payload.size()));
+    header.checksum = calculateChecksum(payload);
+    return QByteArray(reinterpret_cast<const char*>(&header), sizeof(header)) + payload;
+}
+
+QByteArray roiExtra(quint16 width, quint16 height, quint8 quality) {
+    RoiCropExtension extension;
+    memset(&extension, 0, sizeof(extension));
+    extension.width = qToLittleEndian(width);
+    extension.height = qToLittleEndian(height);
+    extension.jpeg_quality = quality;
+    return QByteArray(reinterpret_cast<const char*>(&extension), sizeof(extension));
+}
+
+QByteArray retransmitExtra(RetransmitEncoding encoding, quint16 firstPacket, quint16 count, const QByteArray& body) {
+    RetransmitExtension extension;
+    memset(&extension, 0, sizeof(extension));
+    extension.encoding = encoding;
+    extension.first_packet = qToLittleEndian(firstPacket);
+    extension.count = qToLittleEndian(count);
+    return QByteArray(reinterpret_cast<const char*>(&extension), sizeof(extension)) + body;
+}
+
+QByteArray ranges(std::initializer_list<QPair<quint16, quint16>> list) {
+    QByteArray body;
+    for (const QPair<quint16, quint16>& range : list) {
+        uchar bytes[4];
+        qToLittleEndian(range.first, bytes);
+        qToLittleEndian(range.second, bytes + 2);
+        body.append(reinterpret_cast<const char*>(bytes), 4);
+    }
+    return body;
+}
+
+QList<quint16> drainImageNumbers(CommandFrameParser* parser) {
+    QList<quint16> numbers;
+    CommandFrame frame;
+    while (parser->next(&frame)) {
+        numbers.append(frame.info.image_number);
+    }
+    return numbers;
+}
+
+} // namespace
+
+class CommandFrameParserTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void parsesFieldsAndExtra() {
+        CommandFrameParser parser;
+        const QByteArray extra("\x01\x02\x03\x04", 4);
+        const QByteArray frame = makeFrame(ISAR_REQUEST, 4321, extra);
+        QCOMPARE(parser.append(frame.constData(), frame.size()), qint64(frame.size()));
+
+        CommandFrame parsed;
+        QVERIFY(parser.next(&parsed));
+        QCOMPARE(parsed.info.frame_header, quint16(0x55AA));
+        QCOMPARE(parsed.info.command_type, quint8(ISAR_REQUEST));
+        QCOMPARE(parsed.info.image_number, quint16(4321));
+        QCOMPARE(parsed.info.pixel_offset_x, qint16(100));
+        QCOMPARE(parsed.info.pixel_offset_y, qint16(-200));
+        QCOMPARE(parsed.extra, extra);
+        QVERIFY(!parser.next(&parsed));
+        QCOMPARE(parser.bufferedBytes(), qint64(0));
+        QCOMPARE(parser.takeDiscardedBytes(), quint64(0));
+    }
+
+    void waitsForCompleteFrame() {
+        CommandFrameParser parser;
+        const QByteArray frame = makeFrame(ISAR_REQUEST, 7);
+        CommandFrame parsed;
+        for (int i = 0; i < frame.size() - 1; ++i) {
+            parser.append(frame.constData() + i, 1);
+            QVERIFY(!parser.next(&parsed));
+        }
+        parser.append(frame.constData() + frame.size() - 1, 1);
+        QVERIFY(parser.next(&parsed));
+        QCOMPARE(parsed.info.image_number, quint16(7));
+    }
+
+    void resyncsAfterGarbage() {
+        CommandFrameParser parser;
+        // 含单独的 E9、长度越界的伪帧头，之后才是有效帧
+        QByteArray garbage("\x00\x11\xE9\x22\x33", 5);
+        QByteArray fakeHeader(int(sizeof(DataHeader)), '\0');
+        fakeHeader[0] = char(0xE9);
+        fakeHeader[1] = char(0x9E);
+        fakeHeader[int(offsetof(DataHeader, data_length)) + 1] = char(0x7F);
+        garbage += fakeHeader;
+        const QByteArray stream = garbage + makeFrame(ISAR_REQUEST, 1) + makeFrame(ISAR_REQUEST, 2);
+        parser.append(stream.constData(), stream.size());
+
+        QCOMPARE(drainImageNumbers(&parser), QList<quint16>({1, 2}));
+        QCOMPARE(parser.takeDiscardedBytes(), quint64(garbage.size()));
+        QVERIFY(parser.takeRejectedFrames() >= 1);
+        QCOMPARE(parser.bufferedBytes(), qint64(0));
+    }
+
+    void skipsFrameWithBadChecksum() {
+        CommandFrameParser parser;
+        QByteArray corrupted = makeFrame(ISAR_REQUEST, 10);
+        corrupted[corrupted.size() - 1] = char(corrupted.at(corrupted.size() - 1) ^ 0x40);
+        const QByteArray stream = corrupted + makeFrame(ISAR_REQUEST, 11);
+        parser.append(stream.constData(), stream.size());
+
+        QCOMPARE(drainImageNumbers(&parser), QList<quint16>({11}));
+        QCOMPARE(parser.takeDiscardedBytes(), quint64(corrupted.size()));
+        QCOMPARE(parser.takeRejectedFrames(), quint64(1));
+    }
+
+    void parsesFramesAcrossBufferWrap() {
+        CommandFrameParser parser(0);   // 取最小容量，让帧多次跨过环形缓冲末尾
+        const QByteArray frame = makeFrame(ISAR_REQUEST, 0, QByteArray(3000, 'x'));
+        QList<quint16> seen;
+        for (quint16 n = 0; n < 20; ++n) {
+            QByteArray copy = frame;
+            DataInfo info;
+            memcpy(&info, copy.constData() + sizeof(DataHeader), sizeof(info));
+            info.image_number = qToLittleEndian(n);
+            memcpy(copy.data() + sizeof(DataHeader), &info, sizeof(info));
+            DataHeader header;
+            memcpy(&header, copy.constData(), sizeof(header));
+            header.checksum = calculateChecksum(copy.mid(sizeof(DataHeader)));
+            memcpy(copy.data(), &header, sizeof(header));
+
+            QCOMPARE(parser.append(copy.constData(), copy.size()), qint64(copy.size()));
+            seen += drainImageNumbers(&parser);
+        }
+        QCOMPARE(seen.size(), 20);
+        for (int i = 0; i < seen.size(); ++i) {
+            QCOMPARE(seen.at(i), quint16(i));
+        }
+        QCOMPARE(parser.takeDiscardedBytes(), quint64(0));
+    }
+
+    void dropsFalseHeaderBeforeClaimedLength() {
+        CommandFrameParser parser;
+        // 数据中偶然出现的同步字，长度字段落在合法范围内，后面紧跟的却不是 DataInfo
+        QByteArray fakeHeader(int(sizeof(DataHeader)), '\0');
+        fakeHeader[0] = char(0xE9);
+        fakeHeader[1] = char(0x9E);
+        fakeHeader[int(offsetof(DataHeader, data_length)) + 1] = char(0x0F);   // 3840 字节
+        const QByteArray stream = fakeHeader + makeFrame(ISAR_REQUEST, 21);
+        parser.append(stream.constData(), stream.size());
+
+        // 不必等满 3840 字节，伪帧头之后的指令立即可用
+        QCOMPARE(drainImageNumbers(&parser), QList<quint16>({21}));
+        QCOMPARE(parser.takeDiscardedBytes(), quint64(fakeHeader.size()));
+        QCOMPARE(parser.takeRejectedFrames(), quint64(1));
+    }
+
+    void decodesRoiCropFrame() {
+        CommandFrameParser parser;
+        const QByteArray frame = makeFrame(COMMAND_ROI_CROP, 77, roiExtra(640, 480, 90));
+        QCOMPARE(parser.append(frame.constData(), frame.size()), qint64(frame.size()));
+
+        CommandFrame parsed;
+        QVERIFY(parser.next(&parsed));
+        QCOMPARE(parsed.info.command_type, quint8(COMMAND_ROI_CROP));
+        QCOMPARE(parsed.info.image_number, quint16(77));
+        QCOMPARE(parsed.info.pixel_offset_x, qint16(100));
+        QCOMPARE(parsed.info.pixel_offset_y, qint16(-200));
+        const RoiCropExtension extension = decodeRoiCropExtension(parsed.extra);
+        QCOMPARE(extension.width, quint16(640));
+        QCOMPARE(extension.height, quint16(480));
+        QCOMPARE(extension.jpeg_quality, quint8(90));
+    }
+
+    void roiCropExtensionDefaultsToZero() {
+        // 旧版接收端不带扩展段；不完整的扩展段同样按省略处理
+        for (const QByteArray& extra : {QByteArray(), roiExtra(640, 480, 90).left(4)}) {
+            const RoiCropExtension extension = decodeRoiCropExtension(extra);
+            QCOMPARE(extension.width, quint16(0));
+            QCOMPARE(extension.height, quint16(0));
+            QCOMPARE(extension.jpeg_quality, quint8(0));
+        }
+
+        CommandFrameParser parser;
+        const QByteArray frame = makeFrame(COMMAND_ROI_CROP, 78);
+        QCOMPARE(parser.append(frame.constData(), frame.size()), qint64(frame.size()));
+        CommandFrame parsed;
+        QVERIFY(parser.next(&parsed));
+        QVERIFY(parsed.extra.isEmpty());
+        QCOMPARE(decodeRoiCropExtension(parsed.extra).width, quint16(0));
+    }
+
+    void decodesEmptyExtraAsWholeResend() {
+        QList<quint16> packets = {1};
+        QCOMPARE(decodeMissingPackets(QByteArray(), &packets), MissingPackets::WholeImage);
+        QVERIFY(packets.isEmpty());
+        packets = {1};
+        QCOMPARE(decodeMissingPackets(retransmitExtra(RETRANSMIT_RANGES, 0, 0, QByteArray()), &packets),
+                 MissingPackets::WholeImage);
+        QVERIFY(packets.isEmpty());
+        QCOMPARE(decodeMissingPackets(retransmitExtra(RETRANSMIT_BITMAP, 1, 0, QByteArray()), &packets),
+                 MissingPackets::WholeImage);
+    }
+
+    void decodesEmptySelectionAsNothingToResend() {
+        QList<quint16> packets = {1};
+        // 位图全零
+        QCOMPARE(decodeMissingPackets(retransmitExtra(RETRANSMIT_BITMAP, 1, 2, QByteArray(2, '\0')), &packets),
+                 MissingPackets::NoneSelected);
+        QVERIFY(packets.isEmpty());
+        // 区间均为 first > last
+        QCOMPARE(decodeMissingPackets(retransmitExtra(RETRANSMIT_RANGES, 0, 2, ranges({{5, 4}, {9, 1}})), &packets),
+                 MissingPackets::NoneSelected);
+        QVERIFY(packets.isEmpty());
+        // 只含无效的包 0
+        QCOMPARE(decodeMissingPackets(retransmitExtra(RETRANSMIT_RANGES, 0, 1, ranges({{0, 0}})), &packets),
+                 MissingPackets::NoneSelected);
+        QCOMPARE(decodeMissingPackets(retransmitExtra(RETRANSMIT_BITMAP, 0, 1, QByteArray(1, char(0x01))), &packets),
+                 MissingPackets::NoneSelected);
+        QVERIFY(packets.isEmpty());
+    }
+
+    void decodesOverlappingRanges() {
+        QList<quint16> packets;
+        // 重叠区间合并，包号 0 不是有效包
+        const QByteArray extra = retransmitExtra(RETRANSMIT_RANGES, 0, 3, ranges({{5, 7}, {3, 5}, {0, 1}}));
+        QCOMPARE(decodeMissingPackets(extra, &packets), MissingPackets::Selected);
+        QCOMPARE(packets, QList<quint16>({1, 3, 4, 5, 6, 7}));
+    }
+
+    void decodesBitmap() {
+        QList<quint16> packets;
+        QByteArray bits;
+        bits.append(char(0x05));    // 包 10、12
+        bits.append(char(0x81));    // 包 18、25
+        QCOMPARE(decodeMissingPackets(retransmitExtra(RETRANSMIT_BITMAP, 10, 2, bits), &packets), MissingPackets::Selected);
+        QCOMPARE(packets, QList<quint16>({10, 12, 18, 25}));
+
+        // 超过 65535 的位被忽略
+        QCOMPARE(decodeMissingPackets(retransmitExtra(RETRANSMIT_BITMAP, 0xFFFE, 1, QByteArray(1, char(0xFF))), &packets),
+                 MissingPackets::Selected);
+        QCOMPARE(packets, QList<quint16>({0xFFFE, 0xFFFF}));
+    }
+
+    void rejectsMalformedExtension() {
+        QList<quint16> packets;
+        QCOMPARE(decodeMissingPackets(QByteArray("\x00\x00", 2), &packets), MissingPackets::Invalid);
+        QCOMPARE(decodeMissingPackets(retransmitExtra(RETRANSMIT_RANGES, 0, 2, ranges({{1, 2}})), &packets),
+                 MissingPackets::Invalid);
+        QCOMPARE(decodeMissingPackets(retransmitExtra(RETRANSMIT_BITMAP, 1, 4, QByteArray(3, '\xFF')), &packets),
+                 MissingPackets::Invalid);
+        QCOMPARE(decodeMissingPackets(retransmitExtra(RetransmitEncoding(7), 1, 0, QByteArray()), &packets),
+                 MissingPackets::Invalid);
+    }
+};
+
+QTEST_APPLESS_MAIN(CommandFrameParserTest)
+#include "command_frame_parser_test.moc"
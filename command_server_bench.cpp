@@ -0,0 +1,153 @@
+// command_server_bench.cpp
+// EpollCommandServer 压力测试：同一进程内启动服务端，用若干客户端线程建立大量连接并持续发送指令帧，
+// 统计服务端实际解析出的帧速率。用法：
+//   command_server_bench [io_threads] [connections] [seconds] [client_threads]
+// 默认 4 个 I/O 线程、1000 个连接、5 秒、4 个客户端线程。
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "epoll_command_server.h"
+
+static std::string makeFrame(quint16 imageNumber) {
+    DataInfo info;
+    memset(&info, 0, sizeof(info));
+    info.frame_header = 0x55AA;             // 测试平台为小端序，与协议一致
+    info.data_length = sizeof(DataInfo);
+    info.command_type = 0x01;
+    info.image_number = imageNumber;
+    info.pixel_offset_x = 100;
+    info.pixel_offset_y = 200;
+
+    DataHeader header;
+    memset(&header, 0, sizeof(header));
+    header.fixed_value = 0x9EE9;
+    header.data_length = sizeof(DataInfo);
+    quint8 sum = 0;
+    const quint8* bytes = reinterpret_cast<const quint8*>(&info);
+    for (size_t i = 0; i < sizeof(info); ++i) {
+        sum += bytes[i];
+    }
+    header.checksum = sum;
+
+    std::string frame(reinterpret_cast<const char*>(&header), sizeof(header));
+    frame.append(reinterpret_cast<const char*>(&info), sizeof(info));
+    return frame;
+}
+
+static int connectTo(uint16_t port) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char* argv[])
+{
+    const int ioThreads = argc > 1 ? atoi(argv[1]) : 4;
+    const int connections = argc > 2 ? atoi(argv[2]) : 1000;
+    const int seconds = argc > 3 ? atoi(argv[3]) : 5;
+    const int clientThreads = argc > 4 ? atoi(argv[4]) : 4;
+
+    // 客户端与服务端在同一进程，每个连接占两个描述符
+    rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    std::atomic<quint64> isarRequests{0};
+    EpollCommandServer server([&isarRequests](quint64, const CommandFrame& frame) {
+        if (frame.info.command_type == 0x01) {
+            isarRequests.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    server.setMaxConnections(connections);
+    std::string error;
+    if (!server.start("127.0.0.1", 0, ioThreads, &error)) {
+        fprintf(stderr, "server start failed: %s\n", error.c_str());
+        return 1;
+    }
+
+    std::vector<int> sockets;
+    for (int i = 0; i < connections; ++i) {
+        const int fd = connectTo(server.port());
+        if (fd < 0) {
+            fprintf(stderr, "connect %d failed: %s\n", i, strerror(errno));
+            break;
+        }
+        sockets.push_back(fd);
+    }
+    while (server.stats().activeConnections < sockets.size()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // 每次 send 发出一批帧，模拟多条指令连续到达
+    std::string batch;
+    for (int i = 0; i < 64; ++i) {
+        batch += makeFrame(quint16(i));
+    }
+    const quint64 framesPerBatch = 64;
+
+    std::atomic<bool> running{true};
+    std::atomic<quint64> framesSent{0};
+    std::vector<std::thread> clients;
+    for (int t = 0; t < clientThreads; ++t) {
+        clients.emplace_back([&, t]() {
+            quint64 sent = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                for (size_t i = size_t(t); i < sockets.size(); i += size_t(clientThreads)) {
+                    if (::send(sockets[i], batch.data(), batch.size(), MSG_NOSIGNAL) == ssize_t(batch.size())) {
+                        sent += framesPerBatch;
+                    }
+                }
+            }
+            framesSent.fetch_add(sent);
+        });
+    }
+
+    const auto begin = std::chrono::steady_clock::now();
+    const quint64 framesBefore = server.stats().frames;
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    const quint64 framesAfter = server.stats().frames;
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    running.store(false);
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    for (int fd : sockets) {
+        ::close(fd);
+    }
+
+    const EpollCommandServer::Stats stats = server.stats();
+    server.stop();
+
+    const double frameRate = double(framesAfter - framesBefore) / elapsed;
+    printf("io_threads=%d connections=%zu seconds=%.1f\n", ioThreads, sockets.size(), elapsed);
+    printf("frames/s=%.0f  MB/s=%.1f  isar_requests=%llu  discarded_bytes=%llu  rejected_connections=%llu\n",
+           frameRate, frameRate * double(batch.size() / framesPerBatch) / 1e6,
+           static_cast<unsigned long long>(isarRequests.load()),
+           static_cast<unsigned long long>(stats.discardedBytes),
+           static_cast<unsigned long long>(stats.rejectedConnections));
+    return 0;
+}
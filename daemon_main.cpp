@@ -0,0 +1,152 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTimer>
+#include <signal.h>
+#include "log_categories.h"
+#include "logmanager.h"
+#include "metrics_server.h"
+#include "pipeline_config.h"
+#include "trace_recorder.h"
+#include "transfer_pipeline.h"
+#include "unix_signal_watcher.h"
+
+/*
+ * aerolink-daemon：无界面的监控/打包/传输进程，全部参数来自配置文件。
+ *
+ *   [daemon]
+ *   state_dir=/var/lib/aerolink    ; 产品日志与持久化队列所在目录
+ *   drain_timeout_seconds=30       ; 收到 SIGTERM 后等待在途产品发送完毕的最长时间
+ *
+ * 其余分组（roots / overload / link / codec / journal / progressive / tiling / delta / cache / log / metrics）与界面程序共用，见 pipeline_config.h 与 logmanager.h。
+ * 第一次 SIGTERM/SIGINT 停止监控并排空在途产品，第二次立即退出；未发完的产品下次启动时续传。
+ * SIGUSR1 把按产品类型汇总的分环节耗时表写入日志（同样内容也可从 http://127.0.0.1:<port>/timings 获取）。
+ * SIGUSR2 开始/结束一次跟踪会话，结束时在 [trace] dir（默认 state_dir）下写出 aerolink-trace-*.json。
+ */
+
+static const int DEFAULT_DRAIN_TIMEOUT_SECONDS = 30;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("aerolink-daemon");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("AeroLink headless monitor and transfer daemon");
+    parser.addHelpOption();
+    QCommandLineOption configOption(QStringList() << "c" << "config", "Configuration file (INI).", "path", defaultConfigPath());
+    parser.addOption(configOption);
+    parser.process(app);
+
+    const QString configPath = parser.value(configOption);
+    if (!QFileInfo::exists(configPath)) {
+        qCritical() << "Configuration file not found:" << configPath;
+        return 1;
+    }
+    QSettings settings(configPath, QSettings::IniFormat);
+
+    LogManager::instance().setUiForwarding(false);
+    LogManager::instance().configure(settings);
+
+    const QList<MonitorRootConfig> roots = loadMonitorRoots(settings);
+    if (roots.isEmpty()) {
+        qCritical() << "No monitor roots configured in" << configPath;
+        LogManager::instance().shutdown();
+        return 1;
+    }
+
+    settings.beginGroup("daemon");
+    QString stateDir = settings.value("state_dir").toString();
+    if (stateDir.isEmpty()) {
+        stateDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    }
+    const int drainTimeoutSeconds = settings.value("drain_timeout_seconds", DEFAULT_DRAIN_TIMEOUT_SECONDS).toInt();
+    settings.endGroup();
+    QDir().mkpath(stateDir);
+
+    const TraceConfig traceConfig = loadTraceConfig(settings);
+    const QString traceDir = traceConfig.dir.isEmpty() ? stateDir : traceConfig.dir;
+    TraceRecorder::instance().setBufferCapacity(traceConfig.bufferEvents);
+    if (traceConfig.enabled) {
+        TraceRecorder::instance().start();
+    }
+
+    int ret = 0;
+    {
+        TransferPipeline pipeline;
+        if (!pipeline.openJournal(QDir(stateDir).filePath("product_journal.log"))) {
+            qWarning() << "Failed to open product journal in" << stateDir << ", resume after restart is disabled.";
+        }
+        pipeline.journal()->setSyncOnAppend(loadJournalSync(settings));
+        if (!pipeline.openQueue(QDir(stateDir).filePath("transfer_queue"))) {
+            qWarning() << "Failed to open transfer queue in" << stateDir << ", pending products will not survive a restart.";
+        }
+        pipeline.scheduler()->setOverloadPolicy(loadOverloadPolicy(settings));
+        const LinkConfig link = loadLinkConfig(settings);
+        pipeline.scheduler()->setMaxInFlight(link.maxInFlight);
+        pipeline.setTransferOptions(link.transfer);
+        pipeline.setProgressiveSettings(loadProgressiveSettings(settings));
+        pipeline.setTileSettings(loadTileSettings(settings));
+        pipeline.setDeltaSettings(loadDeltaSettings(settings));
+        pipeline.productCache()->setCapacity(loadProductCacheBytes(settings));
+        setImageCodecSettings(loadCodecSettings(settings));
+        pipeline.setRoots(roots);
+        if (!pipeline.start()) {
+            qCritical() << "Failed to start transfer pipeline.";
+            ret = 1;
+        } else {
+            UnixSignalWatcher signalWatcher({SIGTERM, SIGINT, SIGUSR1, SIGUSR2});
+            QObject::connect(&signalWatcher, &UnixSignalWatcher::signalReceived, &app, [&](int signalNumber) {
+                if (signalNumber == SIGUSR1) {
+                    qCInfo(lcUi).noquote() << "Product timing report:\n" + QString::fromUtf8(pipeline.renderTimings());
+                    return;
+                }
+                if (signalNumber == SIGUSR2) {
+                    if (TraceRecorder::instance().isRecording()) {
+                        QDir().mkpath(traceDir);
+                        TraceRecorder::instance().stop(TraceRecorder::timestampedPath(traceDir));
+                    } else {
+                        TraceRecorder::instance().start();
+                    }
+                    return;
+                }
+                if (pipeline.isDraining()) {
+                    qWarning() << "Signal" << signalNumber << "received again, exiting without waiting.";
+                    app.quit();
+                    return;
+                }
+                qCInfo(lcUi) << "Signal" << signalNumber << "received, draining in-flight products (up to"
+                        << drainTimeoutSeconds << "s).";
+                QTimer::singleShot(drainTimeoutSeconds * 1000, &app, [&app]() {
+                    qWarning() << "Drain timed out, remaining products stay queued for the next start.";
+                    app.quit();
+                });
+                pipeline.beginDrain();
+            });
+            QObject::connect(&pipeline, &TransferPipeline::drained, &app, &QCoreApplication::quit);
+
+            MetricsServer metricsServer([&pipeline]() { return pipeline.renderMetrics(); });
+            metricsServer.addRoute("/timings", [&pipeline]() { return pipeline.renderTimings(); });
+            const quint16 metricsPort = loadMetricsPort(settings);
+            if (metricsPort != 0) {
+                metricsServer.listen(metricsPort);
+            }
+
+            qCInfo(lcUi) << "aerolink-daemon started with" << roots.size() << "monitor roots, config" << configPath;
+            ret = app.exec();
+            pipeline.stop();
+        }
+    }
+
+    if (TraceRecorder::instance().isRecording()) {
+        QDir().mkpath(traceDir);
+        TraceRecorder::instance().stop(TraceRecorder::timestampedPath(traceDir));
+    }
+    qCInfo(lcUi) << "aerolink-daemon stopped.";
+    LogManager::instance().shutdown();
+    return ret;
+}
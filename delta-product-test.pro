@@ -0,0 +1,16 @@
+# 场景增量产品（变化瓦片选择、DeltaInfo 与瓦片头布局、接收端重建、改发完整产品的条件）的行为测试：
+# qmake delta-product-test.pro && make check
+# 打包代码依赖较多公共模块，直接引用 aerolink_core.pri；QImage 需要 gui 模块（不创建 QGuiApplication）
+
+TARGET = delta-product-test
+TEMPLATE = app
+
+QT = core gui network testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+include(aerolink_core.pri)
+
+SOURCES += \
+    delta_product_test.cpp
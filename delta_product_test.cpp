@@ -0,0 +1,282 @@
+// delta_product_test.cpp
+// 场景增量产品：只打包含变化块的瓦片（含边缘不满的瓦片），消息类型为 0x0007，
+// reserved2 中的 DeltaInfo 与各 DeltaTileHeader 的布局、校验和正确；按接收端方式在基准上覆盖各瓦片
+// 重建的图像与打包时记下的基准候选一致；没有基准、尺寸变化、连续增量达到关键帧间隔、
+// 变化瓦片比例过高时不写文件并改发完整产品；packDeltaImage 只在增量适用时给出 bin 路径
+#include <QtTest>
+#include <QDataStream>
+#include <QTemporaryDir>
+#include <cstring>
+#include "image_transfer.h"
+#include "package_sar_data.h"
+
+namespace {
+
+// 按 AuxFileReader::read 的字段顺序写一个最小的 AUX 文件，其后附带足够长度的运动数据
+bool writeAux(const QString& path, qint64 rows, qint64 cols, double xbin, double rbin) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << qint64(0) << qint64(0) << qint64(1);                         // op_mode pp_mode Kr_sign
+    for (int i = 0; i < 8; ++i) {                                       // fc .. PRF
+        out << 0.0;
+    }
+    out << rows << cols << qint64(8);                                   // pulse_num pulse_len amp_bit
+    out << xbin << rbin;
+    out << qint64(2) << qint64(0) << qint64(0);                         // geo_mode look_mode flag_flat
+    for (int i = 0; i < 27; ++i) {                                      // fdc_ref .. lng_e
+        out << 0.0;
+    }
+    out << 30.0 << 120.0 << 30.0 << 120.1 << 29.9 << 120.0 << 29.9 << 120.1;   // 四角经纬度
+    out << 0.0 << qint64(1);                                            // IMG_TH az_MLK_num
+    for (qint64 i = 0; i < rows * 7 + 10; ++i) {
+        out << 0.0;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+QImage gradientImage(int width, int height) {
+    QImage image(width, height, QImage::Format_Grayscale8);
+    for (int y = 0; y < height; ++y) {
+        uchar* line = image.scanLine(y);
+        for (int x = 0; x < width; ++x) {
+            line[x] = uchar((x + 2 * y) * 255 / (width + 2 * height));
+        }
+    }
+    return image;
+}
+
+// 重复过境的图像：在渐变底图上出现两个亮目标，分别位于瓦片 (2, 1) 与右侧边缘瓦片 (4, 2) 内
+QImage changedImage(int width, int height) {
+    QImage image = gradientImage(width, height);
+    for (const QRect& target : {QRect(140, 80, 30, 30), QRect(260, 140, 30, 30)}) {
+        for (int y = target.top(); y <= target.bottom(); ++y) {
+            memset(image.scanLine(y) + target.x(), 255, size_t(target.width()));
+        }
+    }
+    return image;
+}
+
+DeltaSettings deltaSettings() {
+    DeltaSettings settings;
+    settings.enabled = true;
+    settings.tileSize = 64;
+    settings.blockThreshold = 12;
+    settings.maxChangedFraction = 0.5;
+    settings.keyframeInterval = 10;
+    return settings;
+}
+
+struct DeltaTile {
+    DeltaTileHeader header;
+    QImage image;
+};
+
+struct DeltaMessage {
+    quint16 imageNumber = 0;
+    SAR_DataInfo dataInfo;
+    DeltaInfo deltaInfo;
+    QList<DeltaTile> tiles;
+    qsizetype trailingBytes = 0;
+};
+
+// 按接收端的方式拼回 bin 中唯一的一条消息：SAR_DataInfo 之后依次为 DeltaTileHeader 与该瓦片的 JPEG
+bool readDeltaMessage(const QString& binPath, DeltaMessage* message) {
+    QFile file(binPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray frames = file.readAll();
+    QByteArray payload;
+    qint64 offset = 0;
+    while (offset + qint64(sizeof(SAR_Frame)) <= frames.size()) {
+        SAR_Frame header;
+        memcpy(&header, frames.constData() + offset, sizeof(SAR_Frame));
+        message->imageNumber = header.image_number;
+        payload.append(frames.mid(offset + sizeof(SAR_Frame), header.data_length));
+        offset += qint64(sizeof(SAR_Frame)) + header.data_length;
+    }
+    if (payload.size() < qsizetype(sizeof(SAR_DataInfo))) {
+        return false;
+    }
+    memcpy(&message->dataInfo, payload.constData(), sizeof(SAR_DataInfo));
+    memcpy(&message->deltaInfo, message->dataInfo.reserved2, sizeof(DeltaInfo));
+    qsizetype pos = qsizetype(sizeof(SAR_DataInfo));
+    while (pos + qsizetype(sizeof(DeltaTileHeader)) <= payload.size()) {
+        DeltaTile tile;
+        memcpy(&tile.header, payload.constData() + pos, sizeof(DeltaTileHeader));
+        pos += qsizetype(sizeof(DeltaTileHeader));
+        if (pos + qsizetype(tile.header.jpeg_size) > payload.size()) {
+            return false;
+        }
+        tile.image = QImage::fromData(payload.mid(pos, tile.header.jpeg_size), "JPG").convertToFormat(QImage::Format_Grayscale8);
+        pos += qsizetype(tile.header.jpeg_size);
+        message->tiles.append(tile);
+    }
+    message->trailingBytes = payload.size() - pos;
+    return true;
+}
+
+uint8_t headerChecksum(const SAR_DataInfo& dataInfo) {
+    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&dataInfo);
+    return calculate_checksum(ptr + sizeof(uint16_t), sizeof(SAR_DataInfo) - sizeof(uint16_t) - sizeof(uint8_t));
+}
+
+} // namespace
+
+class DeltaProductTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+        m_imagePath = m_dir.filePath("pass2.png");
+        QVERIFY(changedImage(300, 200).save(m_imagePath, "PNG"));
+        m_auxPath = m_dir.filePath("pass2.aux");
+        QVERIFY(writeAux(m_auxPath, 200, 300, 1.0, 1.0));
+    }
+
+    void packsOnlyChangedTiles() {
+        DeltaBase base;
+        base.imageNumber = 40;
+        base.image = gradientImage(300, 200);
+        base.chainLength = 2;
+        const QString binPath = m_dir.filePath("delta.bin");
+        QImage reconstructed;
+        int changedTiles = 0;
+        int totalTiles = 0;
+        QVERIFY(createDeltaBinFile(m_imagePath, m_auxPath, deltaSettings(), base, binPath, 41,
+                                   &reconstructed, &changedTiles, &totalTiles));
+        // 64 边长切成 5 × 4 个瓦片，只有两个目标所在的瓦片有变化
+        QCOMPARE(totalTiles, 5 * 4);
+        QCOMPARE(changedTiles, 2);
+
+        DeltaMessage message;
+        QVERIFY(readDeltaMessage(binPath, &message));
+        QCOMPARE(message.imageNumber, quint16(41));
+        QCOMPARE(message.dataInfo.message_type, DELTA_MESSAGE_TYPE);
+        QCOMPARE(message.dataInfo.message_count, uint16_t(41));
+        QCOMPARE(message.dataInfo.image_rows, uint16_t(200));
+        QCOMPARE(message.dataInfo.image_cols, uint16_t(300));
+        QCOMPARE(message.dataInfo.checksum, headerChecksum(message.dataInfo));
+
+        QCOMPARE(message.deltaInfo.base_image_number, uint16_t(40));
+        QCOMPARE(message.deltaInfo.full_rows, uint16_t(200));
+        QCOMPARE(message.deltaInfo.full_cols, uint16_t(300));
+        QCOMPARE(message.deltaInfo.tile_size, uint16_t(64));
+        QCOMPARE(message.deltaInfo.changed_tiles, uint16_t(2));
+        QCOMPARE(message.deltaInfo.total_tiles, uint16_t(20));
+
+        // 瓦片按行优先排列，右侧边缘瓦片只有 300 - 256 = 44 列
+        QCOMPARE(message.tiles.size(), 2);
+        QCOMPARE(message.trailingBytes, qsizetype(0));
+        const QList<QRect> expected = {QRect(128, 64, 64, 64), QRect(256, 128, 44, 64)};
+        for (int i = 0; i < message.tiles.size(); ++i) {
+            const DeltaTile& tile = message.tiles.at(i);
+            QCOMPARE(QRect(tile.header.x, tile.header.y, tile.header.width, tile.header.height), expected.at(i));
+            QCOMPARE(tile.image.size(), expected.at(i).size());
+        }
+
+        // 接收端在基准上覆盖各瓦片，结果与记下的基准候选完全一致；未变化的瓦片保持基准原样
+        QImage rebuilt = base.image.copy();
+        for (const DeltaTile& tile : std::as_const(message.tiles)) {
+            for (int y = 0; y < tile.image.height(); ++y) {
+                memcpy(rebuilt.scanLine(tile.header.y + y) + tile.header.x, tile.image.constScanLine(y), size_t(tile.image.width()));
+            }
+        }
+        QCOMPARE(reconstructed.format(), QImage::Format_Grayscale8);
+        QCOMPARE(reconstructed, rebuilt);
+        QCOMPARE(reconstructed.copy(0, 0, 128, 200), base.image.copy(0, 0, 128, 200));
+
+        // 重建图像与本幅图像只差 JPEG 的有损误差
+        const QImage current = changedImage(300, 200);
+        qint64 error = 0;
+        for (int y = 0; y < 200; ++y) {
+            for (int x = 0; x < 300; ++x) {
+                error += qAbs(int(reconstructed.constScanLine(y)[x]) - int(current.constScanLine(y)[x]));
+            }
+        }
+        QVERIFY2(error / (300 * 200) < 4, qPrintable(QString("mean error %1").arg(double(error) / (300 * 200))));
+    }
+
+    void fallsBackToFullProduct_data() {
+        QTest::addColumn<bool>("hasBase");
+        QTest::addColumn<QSize>("baseSize");
+        QTest::addColumn<int>("chainLength");
+        QTest::addColumn<double>("maxChangedFraction");
+        QTest::addColumn<int>("expected");
+        QTest::newRow("delta applies") << true << QSize(300, 200) << 9 << 0.5 << 2;
+        QTest::newRow("no base") << false << QSize(300, 200) << 0 << 0.5 << -1;
+        QTest::newRow("size changed") << true << QSize(300, 100) << 0 << 0.5 << -1;
+        // 基准之前已有 keyframeInterval 个连续增量产品
+        QTest::newRow("keyframe interval") << true << QSize(300, 200) << 10 << 0.5 << -1;
+        // 2 / 20 个瓦片有变化，超过 0.05
+        QTest::newRow("too many changes") << true << QSize(300, 200) << 0 << 0.05 << -1;
+    }
+
+    void fallsBackToFullProduct() {
+        QFETCH(bool, hasBase);
+        QFETCH(QSize, baseSize);
+        QFETCH(int, chainLength);
+        QFETCH(double, maxChangedFraction);
+        QFETCH(int, expected);
+        DeltaSettings settings = deltaSettings();
+        settings.maxChangedFraction = maxChangedFraction;
+        DeltaBase base;
+        base.imageNumber = 7;
+        if (hasBase) {
+            base.image = gradientImage(baseSize.width(), baseSize.height());
+        }
+        base.chainLength = chainLength;
+        const QString binPath = m_dir.filePath(QString("fallback_%1.bin").arg(QTest::currentDataTag()).replace(' ', '_'));
+        QImage reconstructed;
+        int changedTiles = 0;
+        int totalTiles = 0;
+        QVERIFY(createDeltaBinFile(m_imagePath, m_auxPath, settings, base, binPath, 8,
+                                   &reconstructed, &changedTiles, &totalTiles));
+        QCOMPARE(changedTiles, expected);
+        QCOMPARE(totalTiles, 20);
+        // 需要完整产品时不写文件，也不给出基准候选
+        QCOMPARE(QFile::exists(binPath), expected >= 0);
+        QCOMPARE(reconstructed.isNull(), expected < 0);
+    }
+
+    void packDeltaImageReportsPackedPath() {
+        // 打包接口按 .tif 改名得到 bin 路径；文件内容为 PNG，读取时按内容识别格式
+        const QString tifPath = m_dir.filePath("IMG_pass2.tif");
+        QVERIFY(QFile::copy(m_imagePath, tifPath));
+        DeltaBase base;
+        base.imageNumber = 40;
+        base.image = gradientImage(300, 200);
+
+        QImage reconstructed;
+        int changedTiles = 0;
+        int totalTiles = 0;
+        QString packedPath;
+        ImageTransferResult result = packDeltaImage(tifPath, m_auxPath, deltaSettings(), base, 41,
+                                                    &reconstructed, &changedTiles, &totalTiles, &packedPath);
+        QVERIFY2(result.success, qPrintable(result.message));
+        QCOMPARE(changedTiles, 2);
+        QCOMPARE(packedPath, m_dir.filePath("IMG_pass2.bin"));
+        QVERIFY(QFile::exists(packedPath));
+
+        // 没有基准：成功返回但不给出 bin 路径，由调用方打包完整产品
+        packedPath.clear();
+        result = packDeltaImage(tifPath, m_auxPath, deltaSettings(), DeltaBase(), 42,
+                                &reconstructed, &changedTiles, &totalTiles, &packedPath);
+        QVERIFY(result.success);
+        QCOMPARE(changedTiles, -1);
+        QVERIFY(packedPath.isEmpty());
+    }
+
+private:
+    QTemporaryDir m_dir;
+    QString m_imagePath;
+    QString m_auxPath;
+};
+
+QTEST_GUILESS_MAIN(DeltaProductTest)
+#include "delta_product_test.moc"
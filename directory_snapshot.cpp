@@ -0,0 +1,159 @@
+#include "directory_snapshot.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#ifdef Q_OS_UNIX
+#include <dirent.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#else
+#include <QDirIterator>
+#include <QDateTime>
+#endif
+
+DirectorySnapshot::DirectorySnapshot(const QString& dirPath) {
+    reset(dirPath);
+}
+
+void DirectorySnapshot::reset(const QString& dirPath) {
+    m_path = QDir::cleanPath(dirPath);
+    m_entries.clear();
+    m_generation = 0;
+}
+
+QString DirectorySnapshot::path() const {
+    return m_path;
+}
+
+int DirectorySnapshot::size() const {
+    return m_entries.size();
+}
+
+const DirectorySnapshot::Entry* DirectorySnapshot::entry(const QString& name) const {
+    auto it = m_entries.constFind(name);
+    return it == m_entries.constEnd() ? nullptr : &it.value();
+}
+
+bool DirectorySnapshot::accept(const QString& name, const QStringList& nameFilters) const {
+    if (nameFilters.isEmpty()) {
+        return true;
+    }
+    for (const QString& filter : nameFilters) {
+        // 常见的 "*.ext" 形式直接比较后缀，避免为每个新文件构造正则
+        if (filter.startsWith(QLatin1String("*.")) && filter.indexOf(QLatin1Char('*'), 1) < 0 && filter.indexOf(QLatin1Char('?')) < 0) {
+            if (name.endsWith(filter.mid(1), Qt::CaseInsensitive)) {
+                return true;
+            }
+            continue;
+        }
+        const QRegularExpression re(QRegularExpression::wildcardToRegularExpression(filter), QRegularExpression::CaseInsensitiveOption);
+        if (re.match(name).hasMatch()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+DirectorySnapshot::Diff DirectorySnapshot::update(const QStringList& nameFilters) {
+    Diff diff;
+    if (m_path.isEmpty()) {
+        return diff;
+    }
+    const quint32 generation = ++m_generation;
+    const QString prefix = m_path + QLatin1Char('/');
+    int seen = 0;
+
+#ifdef Q_OS_UNIX
+    DIR* dir = ::opendir(QFile::encodeName(m_path).constData());
+    if (!dir) {
+        // 目录已不存在：所有条目视为删除
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            diff.removed << prefix + it.key();
+        }
+        m_entries.clear();
+        return diff;
+    }
+    const int dirFd = ::dirfd(dir);
+
+    while (struct dirent* ent = ::readdir(dir)) {
+        const char* rawName = ent->d_name;
+        if (rawName[0] == '.' && (rawName[1] == '\0' || (rawName[1] == '.' && rawName[2] == '\0'))) {
+            continue;
+        }
+        const QString name = QFile::decodeName(rawName);
+        auto it = m_entries.find(name);
+        if (it != m_entries.end() && it->inode == static_cast<quint64>(ent->d_ino)) {
+            // 已知条目：只打上本轮标记，不做任何 stat
+            it->generation = generation;
+            ++seen;
+            continue;
+        }
+
+        struct stat st;
+        if (::fstatat(dirFd, rawName, &st, 0) != 0) {
+            continue; // 遍历期间被删除
+        }
+        Entry entry;
+        entry.inode = static_cast<quint64>(st.st_ino);
+        entry.size = static_cast<qint64>(st.st_size);
+        entry.mtimeMs = static_cast<qint64>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+        entry.isDir = S_ISDIR(st.st_mode);
+        entry.generation = generation;
+        m_entries.insert(name, entry);
+        ++seen;
+
+        if (entry.isDir) {
+            diff.addedDirs << prefix + name;
+        } else if (S_ISREG(st.st_mode) && accept(name, nameFilters)) {
+            diff.addedFiles << prefix + name;
+        }
+    }
+    ::closedir(dir);
+#else
+    QDirIterator iterator(m_path, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::Hidden);
+    while (iterator.hasNext()) {
+        iterator.next();
+        const QFileInfo info = iterator.fileInfo();
+        const QString name = info.fileName();
+        const qint64 mtimeMs = info.lastModified().toMSecsSinceEpoch();
+        auto it = m_entries.find(name);
+        // 无 inode 可用时以大小+修改时间作为身份
+        if (it != m_entries.end() && it->size == info.size() && it->mtimeMs == mtimeMs) {
+            it->generation = generation;
+            ++seen;
+            continue;
+        }
+        const bool known = it != m_entries.end();
+        Entry entry;
+        entry.size = info.size();
+        entry.mtimeMs = mtimeMs;
+        entry.isDir = info.isDir();
+        entry.generation = generation;
+        m_entries.insert(name, entry);
+        ++seen;
+        if (known) {
+            continue;
+        }
+        if (entry.isDir) {
+            diff.addedDirs << prefix + name;
+        } else if (accept(name, nameFilters)) {
+            diff.addedFiles << prefix + name;
+        }
+    }
+#endif
+
+    // 本轮未见到的条目即为已删除；全部见到时跳过清扫
+    if (seen != m_entries.size()) {
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (it->generation != generation) {
+                diff.removed << prefix + it.key();
+                it = m_entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    return diff;
+}
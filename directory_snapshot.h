@@ -0,0 +1,54 @@
+#ifndef DIRECTORY_SNAPSHOT_H
+#define DIRECTORY_SNAPSHOT_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QtGlobal>
+
+/**
+ * @class DirectorySnapshot
+ * @brief 目录快照，用于增量比对。
+ *
+ * 记录目录中每个条目的 inode、大小与修改时间。update() 只遍历一次目录项，
+ * 已知且 inode 未变的条目直接跳过（不做 stat，也不做过滤匹配），
+ * 只有新出现或被替换（同名不同 inode）的条目才会被 stat 并上报。
+ * 一次变化通知中到达的一批文件在同一次遍历中全部得到处理。
+ */
+class DirectorySnapshot {
+public:
+    struct Entry {
+        quint64 inode = 0;
+        qint64 size = 0;
+        qint64 mtimeMs = 0;
+        bool isDir = false;
+        quint32 generation = 0;
+    };
+
+    struct Diff {
+        QStringList addedFiles;   // 新增文件的完整路径
+        QStringList addedDirs;    // 新增子目录的完整路径
+        QStringList removed;      // 已消失条目的完整路径
+    };
+
+    explicit DirectorySnapshot(const QString& dirPath = QString());
+
+    void reset(const QString& dirPath);
+    QString path() const;
+    int size() const;
+
+    // 与上次快照比对，nameFilters 只作用于新增文件（通配符，如 "*.tif"）
+    Diff update(const QStringList& nameFilters = QStringList());
+
+    // 查询已记录条目，未找到返回 nullptr
+    const Entry* entry(const QString& name) const;
+
+private:
+    bool accept(const QString& name, const QStringList& nameFilters) const;
+
+    QString m_path;
+    QHash<QString, Entry> m_entries;
+    quint32 m_generation = 0;
+};
+
+#endif // DIRECTORY_SNAPSHOT_H
@@ -0,0 +1,379 @@
+#include "durable_queue.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#endif
+
+// 单个段文件写满后切换到新段
+static const qint64 DEFAULT_SEGMENT_SIZE = 4 * 1024 * 1024;
+// 攒够多少条记录强制落盘一次（其余由调用方定时 sync）
+static const int DEFAULT_SYNC_BATCH = 64;
+// 段数超过该值时尝试把队首段的存活任务搬到最新段
+static const int MAX_SEGMENTS = 16;
+static const int MAX_RELOCATE_JOBS = 256;
+
+namespace {
+
+QByteArray escapeField(const QString& value) {
+    QByteArray bytes = value.toUtf8();
+    bytes.replace('%', "%25");
+    bytes.replace('\t', "%09");
+    bytes.replace('\n', "%0A");
+    return bytes;
+}
+
+QString unescapeField(const QByteArray& bytes) {
+    return QString::fromUtf8(QByteArray::fromPercentEncoding(bytes));
+}
+
+bool fsyncFile(QFile& file) {
+#if defined(Q_OS_UNIX)
+    return ::fsync(file.handle()) == 0;
+#elif defined(Q_OS_WIN)
+    return ::_commit(file.handle()) == 0;
+#else
+    return true;
+#endif
+}
+
+QByteArray enqueueRecord(const TransferJob& job) {
+    const ProductJob& product = job.product;
+    QByteArray record = "E\t";
+    record += QByteArray::number(job.queueId) + '\t';
+    record += QByteArray::number(job.attempts) + '\t';
+    record += QByteArray::number(job.notBeforeMs) + '\t';
+    record += QByteArray::number(job.priority) + '\t';
+    record += QByteArray::number(job.imageNumber) + '\t';
+    record += QByteArray::number(job.detectedMs) + '\t';
+    record += (product.type == ProductType::GMTI ? "G" : "S");
+    record += '\t' + QByteArray::number(job.port);
+    record += '\t' + escapeField(job.rootName);
+    record += '\t' + escapeField(job.host);
+    record += '\t' + escapeField(product.key);
+    record += '\t' + escapeField(product.imagePath);
+    record += '\t' + escapeField(product.auxPath);
+    record += '\t' + escapeField(product.txtPath);
+    record += '\t' + escapeField(product.binPath);
+    record += '\t' + escapeField(job.packedPath);
+    record += '\n';
+    return record;
+}
+
+} // namespace
+
+DurableQueue::DurableQueue()
+    : m_segmentSize(DEFAULT_SEGMENT_SIZE),
+    m_syncBatchSize(DEFAULT_SYNC_BATCH)
+{
+}
+
+DurableQueue::~DurableQueue() {
+    close();
+}
+
+void DurableQueue::setSegmentSize(qint64 bytes) {
+    QMutexLocker locker(&m_mutex);
+    m_segmentSize = qMax<qint64>(4096, bytes);
+}
+
+void DurableQueue::setSyncBatchSize(int records) {
+    QMutexLocker locker(&m_mutex);
+    m_syncBatchSize = qMax(1, records);
+}
+
+QString DurableQueue::segmentPath(quint32 seq) const {
+    return QDir(m_dirPath).filePath(QString("seg-%1.q").arg(seq, 8, 10, QLatin1Char('0')));
+}
+
+bool DurableQueue::open(const QString& dirPath) {
+    QMutexLocker locker(&m_mutex);
+    if (m_active.isOpen()) {
+        m_active.close();
+    }
+    m_dirPath = dirPath;
+    m_buffer.clear();
+    m_bufferedRecords = 0;
+    m_segments.clear();
+    m_jobs.clear();
+    m_jobSegment.clear();
+    m_nextId = 1;
+
+    QDir dir(dirPath);
+    if (!dir.mkpath(".")) {
+        qWarning() << "Failed to create queue directory:" << dirPath;
+        return false;
+    }
+
+    // 1. 按段序号重放
+    const QStringList names = dir.entryList(QStringList{"seg-*.q"}, QDir::Files, QDir::Name);
+    quint32 lastSeq = 0;
+    for (const QString& name : names) {
+        bool ok = false;
+        const quint32 seq = name.mid(4, name.length() - 6).toUInt(&ok);
+        if (!ok) {
+            continue;
+        }
+        QFile file(dir.filePath(name));
+        if (!file.open(QIODevice::ReadWrite)) {
+            qWarning() << "Failed to read queue segment:" << file.fileName() << file.errorString();
+            continue;
+        }
+        QByteArray content = file.readAll();
+        const int tail = content.lastIndexOf('\n') + 1;
+        if (tail < content.size()) {
+            qWarning() << "Queue segment" << file.fileName() << "has a truncated tail record, discarding" << content.size() - tail << "bytes.";
+            file.resize(tail);
+            content.truncate(tail);
+        }
+        file.close();
+        m_segments[seq].path = file.fileName();
+        replaySegment(seq, content);
+        lastSeq = seq;
+    }
+
+    // 2. 续写最后一段，写满则新开一段
+    quint32 activeSeq = lastSeq;
+    if (activeSeq == 0 || QFileInfo(segmentPath(activeSeq)).size() >= m_segmentSize) {
+        ++activeSeq;
+    }
+    if (!openActiveSegmentLocked(activeSeq)) {
+        return false;
+    }
+    reclaimSegmentsLocked();
+    qDebug() << "Durable queue recovered:" << m_jobs.size() << "pending jobs in" << m_segments.size() << "segments, from" << dirPath;
+    return true;
+}
+
+void DurableQueue::close() {
+    QMutexLocker locker(&m_mutex);
+    if (m_active.isOpen()) {
+        syncLocked();
+        m_active.close();
+    }
+}
+
+bool DurableQueue::isOpen() const {
+    QMutexLocker locker(&m_mutex);
+    return m_active.isOpen();
+}
+
+bool DurableQueue::openActiveSegmentLocked(quint32 seq) {
+    if (m_active.isOpen()) {
+        m_active.close();
+    }
+    m_active.setFileName(segmentPath(seq));
+    if (!m_active.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Failed to open queue segment:" << m_active.fileName() << m_active.errorString();
+        return false;
+    }
+    m_activeSeq = seq;
+    m_segments[seq].path = m_active.fileName();
+    return true;
+}
+
+void DurableQueue::replaySegment(quint32 seq, const QByteArray& content) {
+    int lineStart = 0;
+    for (int pos = content.indexOf('\n'); pos >= 0; pos = content.indexOf('\n', lineStart)) {
+        const QList<QByteArray> fields = content.mid(lineStart, pos - lineStart).split('\t');
+        lineStart = pos + 1;
+        if (fields.size() < 2) {
+            continue;
+        }
+        bool ok = false;
+        const quint64 id = fields.at(1).toULongLong(&ok);
+        if (!ok || id == 0) {
+            continue;
+        }
+        m_nextId = qMax(m_nextId, id + 1);
+        const QByteArray& tag = fields.at(0);
+        if (tag == "E" && fields.size() >= 16) {
+            TransferJob job;
+            job.queueId = id;
+            job.attempts = fields.at(2).toInt();
+            job.notBeforeMs = fields.at(3).toLongLong();
+            job.priority = fields.at(4).toInt();
+            job.imageNumber = static_cast<quint16>(fields.at(5).toUInt());
+            job.detectedMs = fields.at(6).toLongLong();
+            job.product.type = fields.at(7) == "G" ? ProductType::GMTI : ProductType::SAR;
+            job.port = static_cast<quint16>(fields.at(8).toUInt());
+            job.rootName = unescapeField(fields.at(9));
+            job.host = unescapeField(fields.at(10));
+            job.product.key = unescapeField(fields.at(11));
+            job.product.imagePath = unescapeField(fields.at(12));
+            job.product.auxPath = unescapeField(fields.at(13));
+            job.product.txtPath = unescapeField(fields.at(14));
+            job.product.binPath = unescapeField(fields.at(15));
+            if (fields.size() >= 17) {
+                job.packedPath = unescapeField(fields.at(16));
+            }
+            // 同一任务可能因搬迁在后续段中再次出现，以最新位置为准
+            auto segIt = m_jobSegment.find(id);
+            if (segIt != m_jobSegment.end()) {
+                m_segments[*segIt].live--;
+            }
+            m_jobSegment[id] = seq;
+            m_segments[seq].live++;
+            m_jobs[id] = job;
+        } else if (tag == "R" && fields.size() >= 4) {
+            auto it = m_jobs.find(id);
+            if (it != m_jobs.end()) {
+                it->attempts = fields.at(2).toInt();
+                it->notBeforeMs = fields.at(3).toLongLong();
+            }
+        } else if (tag == "D") {
+            releaseLocked(id);
+        }
+    }
+}
+
+bool DurableQueue::append(TransferJob* job) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_active.isOpen()) {
+        return false;
+    }
+    job->queueId = m_nextId++;
+    m_jobs.insert(job->queueId, *job);
+    m_jobSegment.insert(job->queueId, m_activeSeq);
+    m_segments[m_activeSeq].live++;
+    return appendRecordLocked(enqueueRecord(*job));
+}
+
+bool DurableQueue::markRetry(const TransferJob& job) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_jobs.find(job.queueId);
+    if (it == m_jobs.end()) {
+        return false;
+    }
+    it->attempts = job.attempts;
+    it->notBeforeMs = job.notBeforeMs;
+    QByteArray record = "R\t";
+    record += QByteArray::number(job.queueId) + '\t';
+    record += QByteArray::number(job.attempts) + '\t';
+    record += QByteArray::number(job.notBeforeMs) + '\n';
+    return appendRecordLocked(record);
+}
+
+bool DurableQueue::markDone(quint64 queueId) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_jobs.contains(queueId)) {
+        return false;
+    }
+    releaseLocked(queueId);
+    return appendRecordLocked("D\t" + QByteArray::number(queueId) + '\n');
+}
+
+void DurableQueue::releaseLocked(quint64 queueId) {
+    m_jobs.remove(queueId);
+    auto segIt = m_jobSegment.find(queueId);
+    if (segIt != m_jobSegment.end()) {
+        auto it = m_segments.find(*segIt);
+        if (it != m_segments.end()) {
+            it->live--;
+        }
+        m_jobSegment.erase(segIt);
+    }
+}
+
+bool DurableQueue::appendRecordLocked(const QByteArray& record) {
+    if (!m_active.isOpen()) {
+        return false;
+    }
+    m_buffer += record;
+    ++m_bufferedRecords;
+    if (m_bufferedRecords >= m_syncBatchSize) {
+        return syncLocked();
+    }
+    return true;
+}
+
+bool DurableQueue::sync() {
+    QMutexLocker locker(&m_mutex);
+    return syncLocked();
+}
+
+bool DurableQueue::hasUnsyncedRecords() const {
+    QMutexLocker locker(&m_mutex);
+    return m_bufferedRecords > 0;
+}
+
+bool DurableQueue::syncLocked() {
+    if (!m_active.isOpen()) {
+        return false;
+    }
+    if (m_bufferedRecords == 0) {
+        return true;
+    }
+    if (m_active.write(m_buffer) != m_buffer.size() || !m_active.flush() || !fsyncFile(m_active)) {
+        qWarning() << "Failed to sync queue segment:" << m_active.fileName() << m_active.errorString();
+        return false;
+    }
+    m_buffer.clear();
+    m_bufferedRecords = 0;
+
+    if (m_active.size() >= m_segmentSize) {
+        openActiveSegmentLocked(m_activeSeq + 1);
+    }
+    reclaimSegmentsLocked();
+    return true;
+}
+
+/**
+ * @brief 回收旧段。
+ * 只能从队首开始删除：后面段里的完成记录对应前面段的入队记录，
+ * 先删后面的段会让前面段中已完成的任务在重放时“复活”。
+ */
+void DurableQueue::reclaimSegmentsLocked() {
+    while (!m_segments.isEmpty()) {
+        auto head = m_segments.begin();
+        if (head.key() == m_activeSeq || head->live > 0) {
+            break;
+        }
+        QFile::remove(head->path);
+        m_segments.erase(head);
+    }
+
+    // 队首被少量长期失败的任务占住时，把它们搬到最新段，释放队首段
+    if (m_segments.size() <= MAX_SEGMENTS) {
+        return;
+    }
+    auto head = m_segments.begin();
+    if (head.key() == m_activeSeq || head->live > MAX_RELOCATE_JOBS) {
+        return;
+    }
+    const quint32 headSeq = head.key();
+    QByteArray relocated;
+    QList<quint64> relocatedIds;
+    for (auto it = m_jobs.cbegin(); it != m_jobs.cend(); ++it) {
+        if (m_jobSegment.value(it.key()) == headSeq) {
+            relocated += enqueueRecord(it.value());
+            relocatedIds.append(it.key());
+        }
+    }
+    // 搬迁记录必须先落盘，才能删除队首段
+    if (m_active.write(relocated) != relocated.size() || !m_active.flush() || !fsyncFile(m_active)) {
+        qWarning() << "Failed to relocate queue segment:" << head->path << m_active.errorString();
+        return;
+    }
+    for (quint64 id : relocatedIds) {
+        m_jobSegment[id] = m_activeSeq;
+    }
+    m_segments[m_activeSeq].live += relocatedIds.size();
+    QFile::remove(m_segments.value(headSeq).path);
+    m_segments.remove(headSeq);
+}
+
+QList<TransferJob> DurableQueue::pendingJobs() const {
+    QMutexLocker locker(&m_mutex);
+    return m_jobs.values();
+}
+
+int DurableQueue::pendingCount() const {
+    QMutexLocker locker(&m_mutex);
+    return m_jobs.size();
+}
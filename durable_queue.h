@@ -0,0 +1,77 @@
+#ifndef DURABLE_QUEUE_H
+#define DURABLE_QUEUE_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QHash>
+#include <QFile>
+#include <QMutex>
+#include "transfer_scheduler.h"
+
+/**
+ * @class DurableQueue
+ * @brief 基于分段文件的持久化待发送队列。
+ *
+ * 队列目录下按序号存放若干段文件（seg-00000001.q ...），只在最新一段末尾追加记录：
+ *   E  入队（完整任务信息）
+ *   R  重试（更新尝试次数与下次可发送时间）
+ *   D  完成（成功或最终放弃）
+ * 写入先进入缓冲，攒够一批或调用 sync() 时才 flush + fsync，多条记录共用一次落盘。
+ * 打开时按序重放所有段恢复未完成任务；队首连续的、已无存活任务的段直接删除，
+ * 段数过多时把队首段中仍存活的少量任务重新写入最新段，以便回收旧段。
+ * 所有接口线程安全。
+ */
+class DurableQueue {
+public:
+    DurableQueue();
+    ~DurableQueue();
+
+    bool open(const QString& dirPath);
+    void close();
+    bool isOpen() const;
+
+    // 追加任务，分配并写回 job->queueId
+    bool append(TransferJob* job);
+    bool markRetry(const TransferJob& job);
+    bool markDone(quint64 queueId);
+    // 把缓冲中的记录写盘并 fsync
+    bool sync();
+    bool hasUnsyncedRecords() const;
+
+    // 按入队顺序返回全部未完成任务（重放结果 + 运行期追加）
+    QList<TransferJob> pendingJobs() const;
+    int pendingCount() const;
+
+    void setSegmentSize(qint64 bytes);
+    void setSyncBatchSize(int records);
+
+private:
+    struct Segment {
+        QString path;
+        int live = 0;  // 入队记录位于本段且尚未完成的任务数
+    };
+
+    bool appendRecordLocked(const QByteArray& record);
+    bool openActiveSegmentLocked(quint32 seq);
+    bool syncLocked();
+    void replaySegment(quint32 seq, const QByteArray& content);
+    void releaseLocked(quint64 queueId);
+    void reclaimSegmentsLocked();
+    QString segmentPath(quint32 seq) const;
+
+    mutable QMutex m_mutex;
+    QString m_dirPath;
+    QFile m_active;
+    quint32 m_activeSeq = 0;
+    QByteArray m_buffer;
+    int m_bufferedRecords = 0;
+    QMap<quint32, Segment> m_segments;
+    QMap<quint64, TransferJob> m_jobs;       // 未完成任务，按 id 即入队顺序
+    QHash<quint64, quint32> m_jobSegment;    // 任务入队记录所在段
+    quint64 m_nextId = 1;
+    qint64 m_segmentSize;
+    int m_syncBatchSize;
+};
+
+#endif // DURABLE_QUEUE_H
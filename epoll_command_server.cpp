@@ -0,0 +1,357 @@
+#include "epoll_command_server.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+
+static const int MAX_EVENTS = 256;
+static const int LISTEN_BACKLOG = 1024;
+// 描述符耗尽且备用描述符也拿不回来时，暂停监听的最长时间
+static const int ACCEPT_PAUSE_MS = 100;
+
+struct EpollCommandServer::Reactor {
+    int epollFd = -1;
+    int listenFd = -1;
+    int wakeFd = -1;
+    // 备用描述符：进程描述符用尽（EMFILE/ENFILE）时先释放它，接受并立即关闭排队的连接，
+    // 否则电平触发的监听事件会一直就绪，I/O 线程空转
+    int spareFd = -1;
+    bool listenPaused = false;
+
+    struct Connection {
+        quint64 id = 0;
+        CommandFrameParser parser;
+    };
+    // 只由所属 I/O 线程访问
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+
+    ~Reactor() {
+        for (auto& entry : connections) {
+            ::close(entry.first);
+        }
+        if (listenFd >= 0) ::close(listenFd);
+        if (spareFd >= 0) ::close(spareFd);
+        if (wakeFd >= 0) ::close(wakeFd);
+        if (epollFd >= 0) ::close(epollFd);
+    }
+};
+
+static std::string systemError(const char* what) {
+    return std::string(what) + ": " + strerror(errno);
+}
+
+static int openSpareFd() {
+    return ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+static void setListenEvents(int epollFd, int listenFd, uint32_t events) {
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.fd = listenFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_MOD, listenFd, &event);
+}
+
+static int openListener(const sockaddr_in& address, std::string* error) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        *error = systemError("socket");
+        return -1;
+    }
+    const int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+        *error = systemError("SO_REUSEPORT");
+        ::close(fd);
+        return -1;
+    }
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        *error = systemError("bind");
+        ::close(fd);
+        return -1;
+    }
+    if (::listen(fd, LISTEN_BACKLOG) < 0) {
+        *error = systemError("listen");
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+EpollCommandServer::EpollCommandServer(FrameHandler handler)
+    : m_handler(std::move(handler))
+{
+}
+
+EpollCommandServer::~EpollCommandServer() {
+    stop();
+}
+
+bool EpollCommandServer::start(const std::string& address, uint16_t port, int ioThreads, std::string* error) {
+    std::string localError;
+    std::string& err = error ? *error : localError;
+    if (m_running) {
+        err = "already running";
+        return false;
+    }
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        err = "invalid IPv4 address: " + address;
+        return false;
+    }
+
+    const int threadCount = ioThreads > 0 ? ioThreads : int(qMax(1u, std::thread::hardware_concurrency()));
+    for (int i = 0; i < threadCount; ++i) {
+        auto reactor = std::make_unique<Reactor>();
+        reactor->listenFd = openListener(addr, &err);
+        if (reactor->listenFd < 0) {
+            m_reactors.clear();
+            return false;
+        }
+        if (i == 0 && port == 0) {
+            // 系统分配端口后，其余监听套接字绑定到同一端口
+            socklen_t length = sizeof(addr);
+            ::getsockname(reactor->listenFd, reinterpret_cast<sockaddr*>(&addr), &length);
+        }
+        reactor->epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        reactor->wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        reactor->spareFd = openSpareFd();
+        if (reactor->epollFd < 0 || reactor->wakeFd < 0 || reactor->spareFd < 0) {
+            err = systemError("epoll/eventfd/spare fd");
+            m_reactors.clear();
+            return false;
+        }
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = reactor->listenFd;
+        ::epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, reactor->listenFd, &event);
+        event.data.fd = reactor->wakeFd;
+        ::epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, reactor->wakeFd, &event);
+        m_reactors.push_back(std::move(reactor));
+    }
+    m_port = ntohs(addr.sin_port);
+
+    m_running = true;
+    for (const std::unique_ptr<Reactor>& reactor : m_reactors) {
+        m_threads.emplace_back([this, r = reactor.get()]() { run(r); });
+    }
+    return true;
+}
+
+void EpollCommandServer::stop() {
+    if (!m_running) {
+        return;
+    }
+    for (const std::unique_ptr<Reactor>& reactor : m_reactors) {
+        const uint64_t one = 1;
+        ssize_t written = ::write(reactor->wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+    m_reactors.clear();
+    m_activeConnections.store(0);
+    m_running = false;
+}
+
+bool EpollCommandServer::isRunning() const {
+    return m_running;
+}
+
+uint16_t EpollCommandServer::port() const {
+    return m_port;
+}
+
+void EpollCommandServer::setMaxConnections(int maxConnections) {
+    m_maxConnections = qMax(1, maxConnections);
+}
+
+EpollCommandServer::Stats EpollCommandServer::stats() const {
+    Stats stats;
+    stats.activeConnections = m_activeConnections.load(std::memory_order_relaxed);
+    stats.acceptedConnections = m_acceptedConnections.load(std::memory_order_relaxed);
+    stats.rejectedConnections = m_rejectedConnections.load(std::memory_order_relaxed);
+    stats.frames = m_frames.load(std::memory_order_relaxed);
+    stats.bytesReceived = m_bytesReceived.load(std::memory_order_relaxed);
+    stats.discardedBytes = m_discardedBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void EpollCommandServer::run(Reactor* reactor) {
+    epoll_event events[MAX_EVENTS];
+    for (;;) {
+        const int timeout = reactor->listenPaused ? ACCEPT_PAUSE_MS : -1;
+        const int count = ::epoll_wait(reactor->epollFd, events, MAX_EVENTS, timeout);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (count == 0 && reactor->listenPaused) {
+            resumeAccept(reactor);
+            continue;
+        }
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == reactor->wakeFd) {
+                return;
+            }
+            if (fd == reactor->listenFd) {
+                acceptAll(reactor);
+                continue;
+            }
+            if (!readAll(reactor, fd) || (events[i].events & (EPOLLHUP | EPOLLERR))) {
+                closeConnection(reactor, fd);
+            }
+        }
+    }
+}
+
+void EpollCommandServer::acceptAll(Reactor* reactor) {
+    for (;;) {
+        const int fd = ::accept4(reactor->listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno == EMFILE || errno == ENFILE) {
+                // 内核先分配描述符再查看队列，队列为空时同样报 EMFILE，所以以是否真的取到连接为准
+                const bool rejected = rejectWithSpareFd(reactor);
+                if (reactor->spareFd < 0) {
+                    // 备用描述符无法重新打开：暂停监听，待有连接关闭或超时后再恢复
+                    reactor->listenPaused = true;
+                    setListenEvents(reactor->epollFd, reactor->listenFd, 0);
+                    return;
+                }
+                if (!rejected) {
+                    return;
+                }
+                continue;
+            }
+            // EAGAIN：已取完；其他错误留待下次事件再试
+            return;
+        }
+        if (m_activeConnections.load(std::memory_order_relaxed) >= quint64(m_maxConnections)) {
+            m_rejectedConnections.fetch_add(1, std::memory_order_relaxed);
+            ::close(fd);
+            continue;
+        }
+        const int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        auto connection = std::make_unique<Reactor::Connection>();
+        connection->id = m_nextConnectionId.fetch_add(1, std::memory_order_relaxed);
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        event.data.fd = fd;
+        if (::epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            ::close(fd);
+            continue;
+        }
+        reactor->connections.emplace(fd, std::move(connection));
+        m_activeConnections.fetch_add(1, std::memory_order_relaxed);
+        m_acceptedConnections.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool EpollCommandServer::readAll(Reactor* reactor, int fd) {
+    const auto it = reactor->connections.find(fd);
+    if (it == reactor->connections.end()) {
+        return false;
+    }
+    Reactor::Connection& connection = *it->second;
+    CommandFrameParser& parser = connection.parser;
+    CommandFrame frame;
+    quint64 frames = 0;
+    quint64 bytes = 0;
+    bool open = true;
+
+    // 边沿触发：必须读到 EAGAIN 为止
+    for (;;) {
+        qint64 available = 0;
+        char* dst = parser.writePointer(&available);
+        if (available == 0) {
+            // 缓冲满且无法解析出完整帧，只可能是协议错误
+            open = false;
+            break;
+        }
+        const ssize_t received = ::recv(fd, dst, size_t(available), 0);
+        if (received > 0) {
+            parser.commitWrite(received);
+            bytes += quint64(received);
+            while (parser.next(&frame)) {
+                ++frames;
+                if (m_handler) {
+                    m_handler(connection.id, frame);
+                }
+            }
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        open = received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        break;
+    }
+
+    m_frames.fetch_add(frames, std::memory_order_relaxed);
+    m_bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+    m_discardedBytes.fetch_add(parser.takeDiscardedBytes(), std::memory_order_relaxed);
+    return open;
+}
+
+// 用备用描述符接受一个排队连接并立即关闭，客户端会收到连接断开而不是一直挂在队列里
+bool EpollCommandServer::rejectWithSpareFd(Reactor* reactor) {
+    if (reactor->spareFd < 0) {
+        reactor->spareFd = openSpareFd();
+        if (reactor->spareFd < 0) {
+            return false;
+        }
+    }
+    ::close(reactor->spareFd);
+    const int fd = ::accept4(reactor->listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    const bool rejected = fd >= 0;
+    if (rejected) {
+        ::close(fd);
+        m_rejectedConnections.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 别的线程可能抢先拿走了刚释放的描述符，这时 spareFd 为 -1，由调用方暂停监听
+    reactor->spareFd = openSpareFd();
+    return rejected;
+}
+
+void EpollCommandServer::resumeAccept(Reactor* reactor) {
+    if (reactor->spareFd < 0) {
+        reactor->spareFd = openSpareFd();
+    }
+    reactor->listenPaused = false;
+    setListenEvents(reactor->epollFd, reactor->listenFd, EPOLLIN);
+}
+
+void EpollCommandServer::closeConnection(Reactor* reactor, int fd) {
+    if (reactor->connections.erase(fd) == 0) {
+        return;
+    }
+    ::epoll_ctl(reactor->epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    m_activeConnections.fetch_sub(1, std::memory_order_relaxed);
+    if (reactor->listenPaused) {
+        resumeAccept(reactor);
+    }
+}
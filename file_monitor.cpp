@@ -2,18 +2,66 @@
 #include <QFileInfo>
 #include <QDebug>
 #include <QSet>
-#include <QThread>
 #include "file_monitor.h"
+#include "product_correlator.h"
+#ifdef Q_OS_LINUX
+#include "inotify_watcher.h"
+#endif
+
+// 候选文件大小/修改时间保持不变多久后视为写完（仅用于无法获得关闭写事件的情况）
+static const int SETTLE_INTERVAL_MS = 300;
+// 回退模式下等待 result/ID1 出现的重试参数
+static const int SUBDIR_RETRY_INTERVAL_MS = 500;
+static const int SUBDIR_MAX_RETRIES = 10;
 
 FileMonitor::FileMonitor(QObject* parent) : QObject(parent) {
     m_mainWatcher = new QFileSystemWatcher(this);
     m_subWatcher = new QFileSystemWatcher(this);
     connect(m_mainWatcher, &QFileSystemWatcher::directoryChanged, this, &FileMonitor::onMainDirectoryChanged);
     connect(m_subWatcher, &QFileSystemWatcher::directoryChanged, this, &FileMonitor::onSubdirectoryChanged);
+
+#ifdef Q_OS_LINUX
+    // Linux 下优先使用 inotify：文件关闭写句柄时才上报，无需轮询等待
+    m_inotify = new InotifyWatcher(this);
+    if (m_inotify->isValid()) {
+        connect(m_inotify, &InotifyWatcher::fileCompleted, this, &FileMonitor::onFileCompleted);
+        connect(m_inotify, &InotifyWatcher::fileFound, this, &FileMonitor::onFileFound);
+        connect(m_inotify, &InotifyWatcher::directoryCreated, this, &FileMonitor::onDirectoryCreated);
+        connect(m_inotify, &InotifyWatcher::overflowed, this, [this]() {
+            // 事件丢失时对当前目录做一次补扫，快照中已有的文件会被跳过
+            scanCandidates(m_isGMTIMonitoring ? m_mainFolderPath : m_currentSubDir);
+        });
+    } else {
+        qWarning() << "inotify unavailable, falling back to QFileSystemWatcher.";
+    }
+#endif
+
+    m_settleTimer = new QTimer(this);
+    m_settleTimer->setSingleShot(true);
+    m_settleTimer->setInterval(SETTLE_INTERVAL_MS);
+    connect(m_settleTimer, &QTimer::timeout, this, &FileMonitor::onSettleTimeout);
+
+    m_subDirRetryTimer = new QTimer(this);
+    m_subDirRetryTimer->setSingleShot(true);
+    m_subDirRetryTimer->setInterval(SUBDIR_RETRY_INTERVAL_MS);
+    connect(m_subDirRetryTimer, &QTimer::timeout, this, &FileMonitor::onSubDirRetryTimeout);
+
+    m_dirtyDirsTimer = new QTimer(this);
+    m_dirtyDirsTimer->setSingleShot(true);
+    m_dirtyDirsTimer->setInterval(0);
+    connect(m_dirtyDirsTimer, &QTimer::timeout, this, &FileMonitor::onDirtyDirsTimeout);
 }
 
 void FileMonitor::setMainFolder(const QString& folderPath) {
-    m_mainFolderPath = folderPath;
+    m_mainFolderPath = QDir::cleanPath(folderPath);
+}
+
+bool FileMonitor::useInotify() const {
+#ifdef Q_OS_LINUX
+    return m_inotify && m_inotify->isValid();
+#else
+    return false;
+#endif
 }
 
 void FileMonitor::start(bool isGMTIMonitoring) { // ✅ 修改: 接收一个bool参数
@@ -26,59 +74,32 @@ void FileMonitor::start(bool isGMTIMonitoring) { // ✅ 修改: 接收一个bool
 
     if (m_isGMTIMonitoring) {
         // GMTI 模式：只监控主文件夹
-        m_mainWatcher->addPath(m_mainFolderPath);
-        m_processedBinFiles.clear();
-        QDir mainDir(m_mainFolderPath);
-        // QStringList binFiles = mainDir.entryList(QStringList("*.bin"), QDir::Files | QDir::NoDotAndDotDot);
-        // for (const QString& fileName : binFiles) {
-        //     QString fullPath = mainDir.filePath(fileName);
-        //     m_processedBinFiles.insert(fullPath);
-        //     qDebug() << "Found existing .bin file:" << fullPath;
-        // }
-        qDebug() << "Watching main folder for .bin files:" << m_mainFolderPath;
+#ifdef Q_OS_LINUX
+        if (useInotify()) {
+            m_inotify->addPath(m_mainFolderPath);
+        } else
+#endif
+        {
+            m_mainWatcher->addPath(m_mainFolderPath);
+        }
+        // 启动前已存在的文件同样作为候选，确认写完后派发
+        scanCandidates(m_mainFolderPath);
+        qDebug() << "Watching main folder for GMTI products:" << m_mainFolderPath;
     } else {
         // SAR/ISAR 模式：监控子文件夹
-        m_mainWatcher->addPath(m_mainFolderPath);
+#ifdef Q_OS_LINUX
+        if (useInotify()) {
+            m_inotify->addPath(m_mainFolderPath);
+        } else
+#endif
+        {
+            m_mainWatcher->addPath(m_mainFolderPath);
+        }
         qDebug() << "Watching main folder for sub-directories:" << m_mainFolderPath;
 
-        QDir mainDir(m_mainFolderPath);
-        QStringList subDirs = mainDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Time);
-
-        if (!subDirs.isEmpty()) {
-            QString latestSubDir = mainDir.filePath(subDirs.first());
-            QString filePathToMonitor = QDir(latestSubDir).filePath("result/ID1");
-            const int maxRetries = 10;
-            const int retryDelayMs = 500;
-            bool fileExists = false;
-
-            for (int i = 0; i < maxRetries; ++i) {
-                if (QFileInfo::exists(filePathToMonitor)) {
-                    fileExists = true;
-                    break;
-                }
-                qDebug() << "File" << filePathToMonitor << "not found. Retrying in" << retryDelayMs << "ms... (Attempt" << i + 1 << "/" << maxRetries << ")";
-                QThread::msleep(retryDelayMs);
-            }
-
-            if (!fileExists) {
-                qCritical() << "Error: File" << filePathToMonitor << "still not found after" << maxRetries << "attempts. Aborting start().";
-                return;
-            }
-
-            m_currentSubDir = filePathToMonitor;
-            m_subWatcher->addPath(m_currentSubDir);
-            qDebug() << "Watching newest sub-directory:" << m_currentSubDir;
-            emit subDirChanged(m_currentSubDir);
-
-            m_processedFiles.clear();
-            // QDir subDir(m_currentSubDir);
-            // QStringList tifFiles = subDir.entryList(QStringList("*.tif"), QDir::Files | QDir::NoDotAndDotDot);
-            // for (const QString& fileName : tifFiles) {
-            //     QString fullPath = subDir.filePath(fileName);
-            //     m_processedFiles.insert(fullPath);
-            //     qDebug() << "Found existing .tif file:" << fullPath;
-            // }
-        } else {
+        m_mainSnapshot.reset(m_mainFolderPath);
+        scanMainFolder();
+        if (m_currentSubDir.isEmpty()) {
             qDebug() << "No sub-directories found in main folder.";
         }
     }
@@ -86,11 +107,34 @@ void FileMonitor::start(bool isGMTIMonitoring) { // ✅ 修改: 接收一个bool
 }
 
 void FileMonitor::stop() {
-    if (m_mainWatcher->directories().isEmpty() && m_subWatcher->directories().isEmpty()) {
+    m_settleTimer->stop();
+    m_subDirRetryTimer->stop();
+    m_dirtyDirsTimer->stop();
+    m_dirtyDirs.clear();
+    m_candidates.clear();
+    m_snapshots.clear();
+    m_mainSnapshot.reset(QString());
+    m_currentSubDirMtimeMs = -1;
+    m_pendingSubDirRoot.clear();
+    m_currentSubDirRoot.clear();
+    m_currentSubDir.clear();
+
+    bool wasWatching = !m_mainWatcher->directories().isEmpty() || !m_subWatcher->directories().isEmpty();
+#ifdef Q_OS_LINUX
+    if (m_inotify && !m_inotify->directories().isEmpty()) {
+        m_inotify->removeAll();
+        wasWatching = true;
+    }
+#endif
+    if (!wasWatching) {
         return;
     }
-    m_mainWatcher->removePaths(m_mainWatcher->directories());
-    m_subWatcher->removePaths(m_subWatcher->directories());
+    if (!m_mainWatcher->directories().isEmpty()) {
+        m_mainWatcher->removePaths(m_mainWatcher->directories());
+    }
+    if (!m_subWatcher->directories().isEmpty()) {
+        m_subWatcher->removePaths(m_subWatcher->directories());
+    }
     qDebug() << "停止监控文件夹...";
 }
 
@@ -98,71 +142,229 @@ QString FileMonitor::getCurrentSubDir() const {
     return m_currentSubDir;
 }
 
-void FileMonitor::onMainDirectoryChanged(const QString& path) {
+/**
+ * @brief 切换到新的最新子文件夹。
+ * inotify 模式下递归监控整个子文件夹树，result/ID1 即使尚未创建也无需等待，
+ * 它出现时会收到 directoryCreated；回退模式下用定时器重试，不阻塞事件循环。
+ */
+void FileMonitor::switchToSubDir(const QString& subDirRoot) {
+    const QString root = QDir::cleanPath(subDirRoot);
+    const QString filePathToMonitor = QDir(root).filePath("result/ID1");
+    if (m_currentSubDir == filePathToMonitor) {
+        return;
+    }
+
+    qDebug() << "Detected new newest sub-directory:" << root;
+    m_candidates.clear();
+    m_snapshots.clear();
+    m_currentSubDir = filePathToMonitor;
+
+#ifdef Q_OS_LINUX
+    if (useInotify()) {
+        if (!m_currentSubDirRoot.isEmpty()) {
+            m_inotify->removeRecursive(m_currentSubDirRoot);
+        }
+        m_currentSubDirRoot = root;
+        m_inotify->addRecursive(root);
+        if (QFileInfo::exists(filePathToMonitor)) {
+            qDebug() << "Watching newest sub-directory:" << m_currentSubDir;
+            emit subDirChanged(m_currentSubDir);
+            scanCandidates(m_currentSubDir);
+        } else {
+            qDebug() << "Waiting for" << filePathToMonitor << "to be created.";
+        }
+        return;
+    }
+#endif
+
+    m_currentSubDirRoot = root;
+    if (!m_subWatcher->directories().isEmpty()) {
+        m_subWatcher->removePaths(m_subWatcher->directories());
+    }
+    m_pendingSubDirRoot = root;
+    m_subDirRetries = 0;
+    onSubDirRetryTimeout();
+}
+
+void FileMonitor::onSubDirRetryTimeout() {
+    if (m_pendingSubDirRoot.isEmpty()) {
+        return;
+    }
+    const QString filePathToMonitor = QDir(m_pendingSubDirRoot).filePath("result/ID1");
+    if (QFileInfo::exists(filePathToMonitor)) {
+        m_pendingSubDirRoot.clear();
+        m_subWatcher->addPath(filePathToMonitor);
+        qDebug() << "Watching newest sub-directory:" << filePathToMonitor;
+        emit subDirChanged(filePathToMonitor);
+        scanCandidates(filePathToMonitor);
+        return;
+    }
+    if (++m_subDirRetries > SUBDIR_MAX_RETRIES) {
+        qCritical() << "Error: File" << filePathToMonitor << "still not found after" << SUBDIR_MAX_RETRIES << "attempts. Aborting.";
+        m_pendingSubDirRoot.clear();
+        return;
+    }
+    qDebug() << "File" << filePathToMonitor << "not found. Retrying in" << SUBDIR_RETRY_INTERVAL_MS << "ms... (Attempt" << m_subDirRetries << "/" << SUBDIR_MAX_RETRIES << ")";
+    m_subDirRetryTimer->start();
+}
+
+bool FileMonitor::isWantedFile(const QString& filePath) const {
+    const QFileInfo info(filePath);
+    const QString dirPath = QDir::cleanPath(info.path());
+    // 上报产品组的全部成员文件，由 ProductCorrelator 负责按组关联
     if (m_isGMTIMonitoring) {
-        // GMTI 模式：检查主文件夹中的新 .bin 文件
-        QDir dir(path);
-        QStringList currentFiles = dir.entryList(QStringList("*.bin"), QDir::Files | QDir::NoDotAndDotDot);
-
-        for (const QString& fileName : currentFiles) {
-            QString fullPath = dir.filePath(fileName);
-            if (!m_processedBinFiles.contains(fullPath)) {
-                qDebug() << "New .bin file detected:" << fullPath;
-                emit newFileDetected(fullPath);
-                m_processedBinFiles.insert(fullPath);
-            }
+        return dirPath == m_mainFolderPath && ProductCorrelator::isMemberFile(ProductType::GMTI, filePath);
+    }
+    return dirPath == m_currentSubDir && ProductCorrelator::isMemberFile(ProductType::SAR, filePath);
+}
+
+// 已处理过的产品由 ProductCorrelator 查询持久化日志过滤，这里不再维护无上限的已处理集合
+void FileMonitor::dispatchFile(const QString& filePath) {
+    qDebug() << "New file detected:" << filePath;
+    emit newFileDetected(filePath);
+}
+
+void FileMonitor::addCandidate(const QString& filePath) {
+    if (!isWantedFile(filePath) || m_candidates.contains(filePath)) {
+        return;
+    }
+    QFileInfo info(filePath);
+    Candidate candidate;
+    candidate.size = info.size();
+    candidate.lastModified = info.lastModified();
+    m_candidates.insert(filePath, candidate);
+    if (!m_settleTimer->isActive()) {
+        m_settleTimer->start();
+    }
+}
+
+/**
+ * @brief 增量扫描目录：只有快照中没有的新条目才会成为候选，
+ * 已知文件不再 stat，检测开销与目录中已有文件数量无关。
+ */
+void FileMonitor::scanCandidates(const QString& dirPath) {
+    if (dirPath.isEmpty()) {
+        return;
+    }
+    auto it = m_snapshots.find(dirPath);
+    if (it == m_snapshots.end()) {
+        it = m_snapshots.insert(dirPath, DirectorySnapshot(dirPath));
+    }
+    const QStringList nameFilters = ProductCorrelator::memberNameFilters(m_isGMTIMonitoring ? ProductType::GMTI : ProductType::SAR);
+    const DirectorySnapshot::Diff diff = it->update(nameFilters);
+    for (const QString& filePath : diff.addedFiles) {
+        addCandidate(filePath);
+    }
+}
+
+/**
+ * @brief 增量扫描主文件夹，只在新出现的子文件夹中挑选最新的一个。
+ * 替代每次变化都按时间排序全部子文件夹的做法。
+ */
+void FileMonitor::scanMainFolder() {
+    const DirectorySnapshot::Diff diff = m_mainSnapshot.update();
+    QString newest;
+    qint64 newestMtimeMs = m_currentSubDirMtimeMs;
+    for (const QString& dirPath : diff.addedDirs) {
+        const DirectorySnapshot::Entry* entry = m_mainSnapshot.entry(QFileInfo(dirPath).fileName());
+        if (entry && entry->mtimeMs >= newestMtimeMs) {
+            newest = dirPath;
+            newestMtimeMs = entry->mtimeMs;
         }
-    } else {
-        // SAR/ISAR 模式：检查是否有新子文件夹
-        QDir dir(path);
-        QStringList subDirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Time);
-
-        if (!subDirs.isEmpty()) {
-            QString latestSubDir = dir.filePath(subDirs.first());
-            QString filePathToMonitor = QDir(latestSubDir).filePath("result/ID1");
-            const int maxRetries = 10;
-            const int retryDelayMs = 500;
-            bool fileExists = false;
-
-            for (int i = 0; i < maxRetries; ++i) {
-                if (QFileInfo::exists(filePathToMonitor)) {
-                    fileExists = true;
-                    break;
-                }
-                QThread::msleep(retryDelayMs);
-            }
+    }
+    if (!newest.isEmpty()) {
+        m_currentSubDirMtimeMs = newestMtimeMs;
+        switchToSubDir(newest);
+    }
+}
 
-            if (!fileExists) {
-                qCritical() << "Error: File" << filePathToMonitor << "still not found after" << maxRetries << "attempts. Aborting.";
-                return;
+void FileMonitor::onDirtyDirsTimeout() {
+    const QSet<QString> dirtyDirs = m_dirtyDirs;
+    m_dirtyDirs.clear();
+    for (const QString& path : dirtyDirs) {
+        if (path == m_mainFolderPath) {
+            if (m_isGMTIMonitoring) {
+                // GMTI 模式：检查主文件夹中的新文件，确认写完后再派发
+                scanCandidates(path);
+            } else {
+                // SAR/ISAR 模式：检查是否有新子文件夹
+                scanMainFolder();
             }
+            emit mainDirChanged(path);
+        } else if (!m_isGMTIMonitoring) {
+            scanCandidates(path);
+        }
+    }
+}
 
-            if (m_currentSubDir != filePathToMonitor) {
-                qDebug() << "Detected new newest sub-directory:" << filePathToMonitor;
-                m_subWatcher->removePaths(m_subWatcher->directories());
-                m_subWatcher->addPath(filePathToMonitor);
-                m_currentSubDir = filePathToMonitor;
-                m_processedFiles.clear();
-                emit subDirChanged(filePathToMonitor);
-            }
+/**
+ * @brief 确认候选文件是否已经写完。
+ * 两次检查之间大小与修改时间都未变化才派发，否则继续等待下一个周期；
+ * 若期间收到了该文件的关闭写事件，onFileCompleted 会直接派发并移除候选。
+ */
+void FileMonitor::onSettleTimeout() {
+    for (auto it = m_candidates.begin(); it != m_candidates.end();) {
+        QFileInfo info(it.key());
+        if (!info.exists()) {
+            it = m_candidates.erase(it);
+            continue;
+        }
+        const qint64 size = info.size();
+        const QDateTime lastModified = info.lastModified();
+        if (size == it->size && lastModified == it->lastModified) {
+            const QString filePath = it.key();
+            it = m_candidates.erase(it);
+            dispatchFile(filePath);
+        } else {
+            it->size = size;
+            it->lastModified = lastModified;
+            ++it;
         }
     }
-    emit mainDirChanged(path);
+    if (!m_candidates.isEmpty()) {
+        m_settleTimer->start();
+    }
 }
 
-void FileMonitor::onSubdirectoryChanged(const QString& path) {
+void FileMonitor::onFileCompleted(const QString& filePath) {
+    if (!isWantedFile(filePath)) {
+        return;
+    }
+    m_candidates.remove(filePath);
+    dispatchFile(filePath);
+}
+
+void FileMonitor::onFileFound(const QString& filePath) {
+    addCandidate(filePath);
+}
+
+void FileMonitor::onDirectoryCreated(const QString& dirPath) {
+    const QString path = QDir::cleanPath(dirPath);
     if (m_isGMTIMonitoring) {
-        return; // GMTI模式不处理子文件夹变化
+        return;
+    }
+    if (QDir::cleanPath(QFileInfo(path).path()) == m_mainFolderPath) {
+        // 主文件夹下新建的子文件夹即为最新子文件夹
+        m_currentSubDirMtimeMs = QFileInfo(path).lastModified().toMSecsSinceEpoch();
+        switchToSubDir(path);
+        emit mainDirChanged(m_mainFolderPath);
+    } else if (path == m_currentSubDir) {
+        qDebug() << "Watching newest sub-directory:" << m_currentSubDir;
+        emit subDirChanged(m_currentSubDir);
+        scanCandidates(m_currentSubDir);
     }
-    QDir dir(path);
-    QStringList currentFiles = dir.entryList(QStringList("*.tif"), QDir::Files | QDir::NoDotAndDotDot);
+}
 
-    for (const QString& fileName : currentFiles) {
-        QString fullPath = dir.filePath(fileName);
-        if (!m_processedFiles.contains(fullPath)) {
-            qDebug() << "New .tif file detected:" << fullPath;
-            emit newFileDetected(fullPath);
-            m_processedFiles.insert(fullPath);
-        }
+// 回退模式：QFileSystemWatcher 的变化通知先合并，再在同一轮中一次性处理整批新文件
+void FileMonitor::onMainDirectoryChanged(const QString& path) {
+    m_dirtyDirs.insert(QDir::cleanPath(path));
+    m_dirtyDirsTimer->start();
+}
+
+void FileMonitor::onSubdirectoryChanged(const QString& path) {
+    if (m_isGMTIMonitoring) {
+        return; // GMTI模式不处理子文件夹变化
     }
+    m_dirtyDirs.insert(QDir::cleanPath(path));
+    m_dirtyDirsTimer->start();
 }
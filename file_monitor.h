@@ -6,6 +6,12 @@
 #include <QString>
 #include <QDir>
 #include <QSet>
+#include <QHash>
+#include <QDateTime>
+#include <QTimer>
+#include "directory_snapshot.h"
+
+class InotifyWatcher;
 
 class FileMonitor : public QObject {
     Q_OBJECT
@@ -24,14 +30,46 @@ signals:
 private slots:
     void onMainDirectoryChanged(const QString& path);
     void onSubdirectoryChanged(const QString& path);
+    void onFileCompleted(const QString& filePath);
+    void onFileFound(const QString& filePath);
+    void onDirectoryCreated(const QString& dirPath);
+    void onSettleTimeout();
+    void onSubDirRetryTimeout();
+    void onDirtyDirsTimeout();
 
 private:
+    bool useInotify() const;
+    bool isWantedFile(const QString& filePath) const;
+    void switchToSubDir(const QString& subDirRoot);
+    void addCandidate(const QString& filePath);
+    void scanCandidates(const QString& dirPath);
+    void scanMainFolder();
+    void dispatchFile(const QString& filePath);
+
+    // 候选文件：无法从事件得知是否写完，需确认大小与修改时间稳定后才派发
+    struct Candidate {
+        qint64 size = -1;
+        QDateTime lastModified;
+    };
+
     QFileSystemWatcher* m_mainWatcher;
     QFileSystemWatcher* m_subWatcher;
+    InotifyWatcher* m_inotify = nullptr;
+    QTimer* m_settleTimer;
+    QTimer* m_subDirRetryTimer;
+    QTimer* m_dirtyDirsTimer;
     QString m_mainFolderPath;
     QString m_currentSubDir;
-    QSet<QString> m_processedFiles;
-    QSet<QString> m_processedBinFiles; // ✅ 新增：用于跟踪GMTI模式下已处理的bin文件
+    QString m_currentSubDirRoot;
+    QString m_pendingSubDirRoot;
+    int m_subDirRetries = 0;
+    QHash<QString, Candidate> m_candidates;
+    // 每个被扫描目录的快照，只比对新增条目，避免每次变化都全量 entryList
+    QHash<QString, DirectorySnapshot> m_snapshots;
+    DirectorySnapshot m_mainSnapshot;
+    qint64 m_currentSubDirMtimeMs = -1;
+    // 回退模式下合并同一轮事件循环内的多次目录变化通知
+    QSet<QString> m_dirtyDirs;
     bool m_isGMTIMonitoring = false; // ✅ 新增：用于区分监控模式
 };
 
@@ -0,0 +1,16 @@
+# 高动态范围直方图的分桶边界、百分位与固定上界计数测试：qmake hdr-histogram-test.pro && make check
+
+TARGET = hdr-histogram-test
+TEMPLATE = app
+
+QT = core testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    hdr_histogram.cpp \
+    hdr_histogram_test.cpp
+
+HEADERS += \
+    hdr_histogram.h
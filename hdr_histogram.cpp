@@ -0,0 +1,111 @@
+#include "hdr_histogram.h"
+#include <bit>
+#include <limits>
+
+static const int SUB_BUCKET_COUNT = 1 << HdrHistogram::SUB_BUCKET_BITS;
+static const qint64 MAX_TRACKABLE = (qint64(1) << HdrHistogram::MAX_VALUE_BITS) - 1;
+
+HdrHistogram::HdrHistogram()
+    : m_counts(new std::atomic<quint64>[BUCKET_COUNT]),
+    m_min(std::numeric_limits<qint64>::max())
+{
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        m_counts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+int HdrHistogram::bucketIndex(qint64 value) {
+    value = qBound<qint64>(0, value, MAX_TRACKABLE);
+    if (value < 2 * SUB_BUCKET_COUNT) {
+        return int(value);
+    }
+    // 最高位决定所在的 2 的幂区间，其下 6 位决定子桶
+    const int msb = 63 - std::countl_zero(quint64(value));
+    const int shift = msb - SUB_BUCKET_BITS;
+    return shift * SUB_BUCKET_COUNT + int(value >> shift);
+}
+
+qint64 HdrHistogram::bucketLowest(int index) {
+    if (index < 2 * SUB_BUCKET_COUNT) {
+        return index;
+    }
+    const int shift = index / SUB_BUCKET_COUNT - 1;
+    const qint64 sub = index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+    return sub << shift;
+}
+
+qint64 HdrHistogram::bucketHighest(int index) {
+    if (index < 2 * SUB_BUCKET_COUNT) {
+        return index;
+    }
+    const int shift = index / SUB_BUCKET_COUNT - 1;
+    return bucketLowest(index) + (qint64(1) << shift) - 1;
+}
+
+void HdrHistogram::record(qint64 value) {
+    value = qBound<qint64>(0, value, MAX_TRACKABLE);
+    m_counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_total.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    qint64 current = m_min.load(std::memory_order_relaxed);
+    while (value < current && !m_min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+    current = m_max.load(std::memory_order_relaxed);
+    while (value > current && !m_max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+quint64 HdrHistogram::count() const {
+    return m_total.load(std::memory_order_relaxed);
+}
+
+qint64 HdrHistogram::min() const {
+    return count() == 0 ? 0 : m_min.load(std::memory_order_relaxed);
+}
+
+qint64 HdrHistogram::max() const {
+    return m_max.load(std::memory_order_relaxed);
+}
+
+qint64 HdrHistogram::sum() const {
+    return m_sum.load(std::memory_order_relaxed);
+}
+
+double HdrHistogram::mean() const {
+    const quint64 total = count();
+    return total == 0 ? 0.0 : double(m_sum.load(std::memory_order_relaxed)) / double(total);
+}
+
+quint64 HdrHistogram::countAtOrBelow(qint64 value) const {
+    if (value < 0) {
+        return 0;
+    }
+    const int last = bucketIndex(value);
+    quint64 total = 0;
+    for (int i = 0; i <= last; ++i) {
+        total += m_counts[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+qint64 HdrHistogram::valueAtPercentile(double p) const {
+    const quint64 total = count();
+    if (total == 0) {
+        return 0;
+    }
+    p = qBound(0.0, p, 100.0);
+    const quint64 target = qMax<quint64>(1, quint64(p / 100.0 * double(total) + 0.5));
+    if (target >= total) {
+        return max();
+    }
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += m_counts[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            const qint64 mid = (bucketLowest(i) + bucketHighest(i)) / 2;
+            return qBound(min(), mid, max());
+        }
+    }
+    return max();
+}
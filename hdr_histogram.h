@@ -0,0 +1,48 @@
+#ifndef HDR_HISTOGRAM_H
+#define HDR_HISTOGRAM_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+/**
+ * @class HdrHistogram
+ * @brief 高动态范围直方图（对数-线性分桶），记录耗时等非负整数。
+ *
+ * 分环节耗时按微秒、传输统计的各阶段延迟按毫秒记录。0~127 逐值计数，更大的值在每个 2 的幂区间内再分 64 个子桶，相对误差不超过 1/64，
+ * 覆盖 1 µs 到约 12 天。记录为 O(1) 的位运算加原子计数，可在任意线程并发调用；
+ * 百分位查询需要遍历全部桶，只在导出报告时使用。
+ */
+class HdrHistogram {
+public:
+    HdrHistogram();
+
+    void record(qint64 value);
+
+    quint64 count() const;
+    qint64 min() const;
+    qint64 max() const;
+    qint64 sum() const;
+    double mean() const;
+    // 不大于 value 的记录数，用于输出固定上界的分桶；value 所在的桶整体计入，误差不超过一个桶宽
+    quint64 countAtOrBelow(qint64 value) const;
+    // p 取 0~100，返回所在桶的中值（限制在最小/最大值之间，取到最后一条记录时即最大值）；无记录时返回 0
+    qint64 valueAtPercentile(double p) const;
+
+    static int bucketIndex(qint64 value);
+    static qint64 bucketLowest(int index);
+    static qint64 bucketHighest(int index);
+
+    static const int SUB_BUCKET_BITS = 6;
+    static const int MAX_VALUE_BITS = 40;
+    static const int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS) * (1 << SUB_BUCKET_BITS) + (1 << SUB_BUCKET_BITS);
+
+private:
+    std::unique_ptr<std::atomic<quint64>[]> m_counts;
+    std::atomic<quint64> m_total{0};
+    std::atomic<qint64> m_sum{0};
+    std::atomic<qint64> m_min;
+    std::atomic<qint64> m_max{0};
+};
+
+#endif // HDR_HISTOGRAM_H
@@ -0,0 +1,116 @@
+// hdr_histogram_test.cpp
+// HdrHistogram 分桶：桶首尾相接、0~127 逐值计数、更大的值桶宽不超过所在值的 1/64；
+// 百分位落在真实值的一个桶宽之内，p0/p100 即最小/最大值；countAtOrBelow 按整桶计入。
+#include <QtTest>
+#include <limits>
+#include "hdr_histogram.h"
+
+class HdrHistogramTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void bucketsAreContiguous() {
+        QCOMPARE(HdrHistogram::bucketLowest(0), qint64(0));
+        for (int i = 0; i < HdrHistogram::BUCKET_COUNT; ++i) {
+            const qint64 lowest = HdrHistogram::bucketLowest(i);
+            const qint64 highest = HdrHistogram::bucketHighest(i);
+            QVERIFY(lowest <= highest);
+            QCOMPARE(HdrHistogram::bucketIndex(lowest), i);
+            QCOMPARE(HdrHistogram::bucketIndex(highest), i);
+            if (i + 1 < HdrHistogram::BUCKET_COUNT) {
+                QCOMPARE(HdrHistogram::bucketLowest(i + 1), highest + 1);
+            }
+        }
+    }
+
+    void smallValuesAreExact() {
+        for (qint64 value = 0; value < 128; ++value) {
+            const int index = HdrHistogram::bucketIndex(value);
+            QCOMPARE(HdrHistogram::bucketLowest(index), value);
+            QCOMPARE(HdrHistogram::bucketHighest(index), value);
+        }
+        QVERIFY(HdrHistogram::bucketHighest(HdrHistogram::bucketIndex(128)) > 128);
+    }
+
+    void bucketWidthIsBoundedRelativeToValue() {
+        for (int i = HdrHistogram::bucketIndex(128); i < HdrHistogram::BUCKET_COUNT; ++i) {
+            const qint64 width = HdrHistogram::bucketHighest(i) - HdrHistogram::bucketLowest(i) + 1;
+            QVERIFY2(width * 64 <= HdrHistogram::bucketLowest(i),
+                     qPrintable(QString("bucket %1 width %2").arg(i).arg(width)));
+        }
+    }
+
+    void outOfRangeValuesAreClamped() {
+        HdrHistogram histogram;
+        histogram.record(-5);
+        QCOMPARE(histogram.count(), quint64(1));
+        QCOMPARE(histogram.min(), qint64(0));
+        QCOMPARE(histogram.max(), qint64(0));
+        QCOMPARE(HdrHistogram::bucketIndex(std::numeric_limits<qint64>::max()), HdrHistogram::BUCKET_COUNT - 1);
+    }
+
+    void emptyHistogramReportsZero() {
+        HdrHistogram histogram;
+        QCOMPARE(histogram.count(), quint64(0));
+        QCOMPARE(histogram.min(), qint64(0));
+        QCOMPARE(histogram.max(), qint64(0));
+        QCOMPARE(histogram.mean(), 0.0);
+        QCOMPARE(histogram.valueAtPercentile(50), qint64(0));
+        QCOMPARE(histogram.countAtOrBelow(1000), quint64(0));
+    }
+
+    void summaryStatistics() {
+        HdrHistogram histogram;
+        histogram.record(10);
+        histogram.record(20);
+        histogram.record(3000);
+        QCOMPARE(histogram.count(), quint64(3));
+        QCOMPARE(histogram.min(), qint64(10));
+        QCOMPARE(histogram.max(), qint64(3000));
+        QCOMPARE(histogram.sum(), qint64(3030));
+        QCOMPARE(histogram.mean(), 1010.0);
+    }
+
+    void percentilesOfUniformValues() {
+        HdrHistogram histogram;
+        for (qint64 value = 1; value <= 100000; ++value) {
+            histogram.record(value);
+        }
+        QCOMPARE(histogram.valueAtPercentile(0), qint64(1));
+        QCOMPARE(histogram.valueAtPercentile(100), qint64(100000));
+        for (double p : {1.0, 25.0, 50.0, 90.0, 99.0, 99.9}) {
+            const double expected = p / 100.0 * 100000.0;
+            const qint64 actual = histogram.valueAtPercentile(p);
+            QVERIFY2(qAbs(double(actual) - expected) <= expected / 64.0 + 1.0,
+                     qPrintable(QString("p%1: %2, expected %3").arg(p).arg(actual).arg(expected)));
+        }
+    }
+
+    void percentileOfSingleValueIsThatValue() {
+        HdrHistogram histogram;
+        histogram.record(123456);
+        QCOMPARE(histogram.valueAtPercentile(50), qint64(123456));
+        QCOMPARE(histogram.valueAtPercentile(99), qint64(123456));
+    }
+
+    void countAtOrBelowCountsWholeBuckets() {
+        HdrHistogram histogram;
+        for (qint64 value : {5, 100, 127, 128, 1000, 1010, 60000}) {
+            histogram.record(value);
+        }
+        QCOMPARE(histogram.countAtOrBelow(-1), quint64(0));
+        QCOMPARE(histogram.countAtOrBelow(4), quint64(0));
+        QCOMPARE(histogram.countAtOrBelow(5), quint64(1));
+        QCOMPARE(histogram.countAtOrBelow(127), quint64(3));
+        QCOMPARE(histogram.countAtOrBelow(128), quint64(4));
+        // 1000 所在桶为 [1000, 1007]、1010 所在桶为 [1008, 1015]；59999 与 60000 同桶，上界 59999 整桶计入 60000
+        QCOMPARE(histogram.countAtOrBelow(1000), quint64(5));
+        QCOMPARE(histogram.countAtOrBelow(1007), quint64(5));
+        QCOMPARE(histogram.countAtOrBelow(1008), quint64(6));
+        QCOMPARE(histogram.countAtOrBelow(59999), quint64(7));
+        QCOMPARE(histogram.countAtOrBelow(300000), quint64(7));
+    }
+};
+
+QTEST_GUILESS_MAIN(HdrHistogramTest)
+#include "hdr_histogram_test.moc"
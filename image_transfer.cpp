@@ -1,9 +1,10 @@
 #include <QTimer>
-#include <QFileDialog>
 #include <QElapsedTimer>
 #include "image_utils.h"
 #include "image_transfer.h"
 #include "package_sar_data.h"
+#include "product_correlator.h"
+#include "trace_recorder.h"
 #include <QFileInfo>
 #include <QDebug>
 #include <QFileInfo>
@@ -14,19 +15,18 @@
 #include <QThread>
 
 /**
- * @brief Processes and transfers GMTI data.
+ * @brief Packs GMTI data for transfer.
  *
- * This function takes a GMTI-related .bin file and orchestrates its processing and transfer.
- * It finds corresponding .txt (for coordinates) and .png (for image) files,
- * packages them into a new structured .bin file, and then transfers it over TCP.
+ * This function takes a GMTI base image and finds the corresponding .txt
+ * (for coordinates) and .bin (for target information) files, then packages
+ * them into a new structured .bin file ready for transferPackedFileAsync().
  *
- * @param filePath Path to the input .bin file.
- * @param ipAddress The destination IP address for the transfer.
- * @param port The destination port.
+ * @param filePath Path to the GMTI base image (png/jpg/tif).
  * @param image_num A sequential number for the image packet.
+ * @param packedPath Receives the path of the generated package file.
  * @return An ImageTransferResult indicating the success or failure of the operation.
  */
-ImageTransferResult processAndTransferGMTI(const QString &filePath, const QString &ipAddress, quint16 port, uint16_t image_num)
+ImageTransferResult packGMTI(const QString &filePath, uint16_t image_num, QString *packedPath)
 {
     ImageTransferResult result;
     result.success = false;
@@ -44,36 +44,41 @@ ImageTransferResult processAndTransferGMTI(const QString &filePath, const QStrin
     QString txtPath = dirPath + QDir::separator() + baseName + ".txt";
     QString binPath = dirPath + QDir::separator() + baseName + ".bin";
 
-    // 新增：为 .txt 和 .png 文件添加等待和重试机制
-    const int MAX_RETRIES = 10;
-    const int RETRY_DELAY_MS = 500;
-    int retries = 0;
-
-    // 等待 .txt 文件
-    while (!QFileInfo::exists(txtPath) && retries < MAX_RETRIES) {
-        // qDebug() << QString("Required .txt file not found: %1. Retrying... (%2/%3)").arg(txtPath).arg(retries + 1).arg(MAX_RETRIES);
-        QThread::msleep(RETRY_DELAY_MS);
-        retries++;
-    }
+    // 兄弟文件由 ProductCorrelator 负责等待，这里只做一次存在性检查，不阻塞线程
     if (!QFileInfo::exists(txtPath)) {
-        result.message = QString("Required .txt file not found after %1 retries: %2").arg(MAX_RETRIES).arg(txtPath);
+        result.message = QString("Required .txt file not found: %1").arg(txtPath);
         qWarning() << result.message;
         return result;
     }
-
-    // 重置重试计数器并等待 .bin 文件
-    retries = 0;
-    while (!QFileInfo::exists(binPath) && retries < MAX_RETRIES) {
-        // qDebug() << QString("Required .bin file not found: %1. Retrying... (%2/%3)").arg(binPath).arg(retries + 1).arg(MAX_RETRIES);
-        QThread::msleep(RETRY_DELAY_MS);
-        retries++;
-    }
     if (!QFileInfo::exists(binPath)) {
-        result.message = QString("Required .bin file not found after %1 retries: %2").arg(MAX_RETRIES).arg(binPath);
+        result.message = QString("Required .bin file not found: %1").arg(binPath);
         qWarning() << result.message;
         return result;
     }
 
+    return packGMTI(filePath, txtPath, binPath, image_num, packedPath);
+}
+
+/**
+ * @brief Packs a complete GMTI product group into a transmittable BIN file.
+ *
+ * Steps 2-6 of the GMTI flow: parse the corner coordinates, read the target
+ * information and base image, and write SAR_Frame packets. No network I/O.
+ *
+ * @param packedPath Receives the path of the generated *_gmti_packaged.bin file.
+ */
+ImageTransferResult packGMTI(const QString &filePath, const QString &txtPath, const QString &binPath, uint16_t image_num, QString *packedPath)
+{
+    ImageTransferResult result;
+    result.success = false;
+
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+
+    QFileInfo imageFileInfo(filePath);
+    QString baseName = imageFileInfo.baseName();
+    QString dirPath = imageFileInfo.path();
+
     // 2. Parse the TXT file for coordinates
     QMap<QString, double> coords;
     QFile txtFile(txtPath);
@@ -128,6 +133,8 @@ ImageTransferResult processAndTransferGMTI(const QString &filePath, const QStrin
     }
     QByteArray pngData = pngFile.readAll();
     pngFile.close();
+    // GMTI 底图原样转发，没有重采样与编码环节
+    markStage(&result.timing, TimingStage::Decode, stageTimer, image_num);
 
     // 4. Populate SAR_DataInfo structure
     SAR_DataInfo dataInfo;
@@ -194,37 +201,21 @@ ImageTransferResult processAndTransferGMTI(const QString &filePath, const QStrin
         currentOffset += payloadSize;
     }
     transmitBinFile.close();
+    markStage(&result.timing, TimingStage::Frame, stageTimer, image_num);
     qDebug() << "Successfully created GMTI package file:" << outputBinFilePath;
 
-    // 7. Start the online transfer
-    SarPacketTransferManager transferManager;
-    QEventLoop loop;
-    bool transferSuccess = false;
-    QString transferMessage;
-
-    QObject::connect(&transferManager, &SarPacketTransferManager::finished,
-                     [&](bool success) {
-                         transferSuccess = success;
-                         transferMessage = success ? "GMTI transfer completed successfully." : "GMTI transfer failed.";
-                         loop.quit();
-                     });
-
-    qDebug() << "Starting GMTI online transfer...";
-    transferManager.startTransfer(outputBinFilePath, ipAddress, port);
-    loop.exec();
-
-    result.success = transferSuccess;
-    result.message = transferMessage;
-
-    // Optional: clean up the temporary file
-    if (QFile::exists(outputBinFilePath)) {
-        QFile::remove(outputBinFilePath);
+    if (packedPath) {
+        *packedPath = outputBinFilePath;
     }
-
+    result.success = true;
+    result.message = "GMTI packing completed successfully.";
     return result;
 }
 
-ImageTransferResult processAndTransferImage(const QString &filePath, const QString &ipAddress, quint16 port, uint16_t image_num)
+/**
+ * @brief 按命名规则（IMG→AUX，.tif→.dat）找到 AUX 文件后打包 SAR 产品。
+ */
+ImageTransferResult packImage(const QString &filePath, uint16_t image_num, QString *packedPath)
 {
     ImageTransferResult result;
     result.success = false;
@@ -235,16 +226,11 @@ ImageTransferResult processAndTransferImage(const QString &filePath, const QStri
         return result;
     }
 
-    if (!waitForFileRelease(filePath)) {
-        result.message = QString("File %1 is locked for too long, give up processing.").arg(filePath);
-        qDebug() << result.message;
-        return result;
-    }
+    // FileMonitor 只在文件关闭写句柄（或大小稳定）后才派发，这里无需再轮询 open() 等待释放
 
     // 1. 离线打包阶段：按规则生成AUX文件路径（替换IMG为AUX，后缀为.dat）
     QFileInfo tifFileInfo(filePath);
     // 解析TIF文件的关键信息：路径、不含后缀的文件名（baseName）
-    QString tifDir = tifFileInfo.path();          // TIF文件所在目录（AUX文件默认在同一目录）
     QString tifBaseName = tifFileInfo.baseName(); // TIF文件名（不含路径和后缀，如"IMG_20240908_1234"）
     QString tifSuffix = tifFileInfo.suffix();     // TIF后缀（用于验证是否为tif文件）
 
@@ -270,72 +256,111 @@ ImageTransferResult processAndTransferImage(const QString &filePath, const QStri
 
     // 第二步：按规则生成AUX文件路径
     // 规则：前3个字符"IMG"→"AUX"，后缀".tif"→".dat"
-    QString auxBaseName = "AUX" + tifBaseName.mid(3); // 重构AUX文件名（如"IMG_2024"→"AUX_2024"）
-    QString auxPath = QString("%1%2%3.dat").arg(
-        tifDir,                  // AUX与TIF同目录
-        QDir::separator(),       // 系统兼容的路径分隔符（Windows\，Linux/）
-        auxBaseName              // 按规则生成的AUX文件名
-    );
-
-    // 第三步：原有AUX文件等待重试逻辑（不变，复用原逻辑）
-    const int MAX_AUX_RETRIES = 10;
-    const int AUX_RETRY_DELAY_MS = 500;
-    int auxRetries = 0;
-    while (!QFileInfo::exists(auxPath) && auxRetries < MAX_AUX_RETRIES) {
-        // qDebug() << QString("AUX file %1 not found. Retrying... (%2/%3)").arg(auxPath).arg(auxRetries + 1).arg(MAX_AUX_RETRIES);
-        QThread::msleep(AUX_RETRY_DELAY_MS);
-        auxRetries++;
-    }
+    QString auxPath = ProductCorrelator::auxPathForImage(filePath);
 
-    // 第四步：AUX文件存在性最终校验
+    // 第三步：AUX文件存在性校验（等待兄弟文件由 ProductCorrelator 负责，这里不再重试）
     if (!QFileInfo::exists(auxPath)) {
-        result.message = QString("Failed to find AUX file %1 after %2 retries. Give up.").arg(auxPath).arg(MAX_AUX_RETRIES);
+        result.message = QString("AUX file %1 not found. Give up.").arg(auxPath);
         qWarning() << result.message;
         return result;
     }
 
     qDebug() << "AUX file found (generated by rule: IMG→AUX, .tif→.dat):" << auxPath;
+    return packImage(filePath, auxPath, image_num, packedPath);
+}
+
+/**
+ * @brief 离线打包一组 SAR 产品（TIF + AUX），生成与 TIF 同名的 .bin 文件。
+ * 两个文件均已由监控端确认写完，本函数不做任何等待。
+ */
+ImageTransferResult packImage(const QString &filePath, const QString &auxPath, uint16_t image_num, QString *packedPath)
+{
+    ImageTransferResult result;
+    result.success = false;
 
     // 后续BIN文件生成逻辑（不变，复用原逻辑）
     QString binPath = filePath;
     binPath.replace(".tif", ".bin", Qt::CaseInsensitive);
 
     qDebug() << "Starting offline packing...";
-    if (!createBinFileFromTifAndAux(filePath, auxPath, binPath, image_num)) {
+    if (!createBinFileFromTifAndAux(filePath, auxPath, binPath, image_num, &result.timing)) {
         result.message = "Failed to create bin file.";
         return result;
     }
     qDebug() << "Offline packing completed successfully.";
 
-    // 2. 在线传输阶段
-    SarPacketTransferManager transferManager;
-    QEventLoop loop;
-
-    // 关键修正：使用一个局部变量来捕获传输结果
-    bool transferSuccess = false;
-    QString transferMessage;
+    if (packedPath) {
+        *packedPath = binPath;
+    }
+    result.success = true;
+    result.message = "Offline packing completed successfully.";
+    return result;
+}
 
-    QObject::connect(&transferManager, &SarPacketTransferManager::finished,
-                     [&](bool success) {
-                         transferSuccess = success;
-                         transferMessage = success ? "Transfer completed successfully." : "Transfer failed due to an error.";
-                         loop.quit(); // 退出事件循环
-                     });
+ImageTransferResult packTiledImage(const QString &filePath, const QString &auxPath, const TileSettings &settings,
+                                   uint16_t image_num, const QList<uint16_t> &tileNumbers, QString *packedPath)
+{
+    trace::Span span("pack_tiled", image_num);
+    ImageTransferResult result;
+    result.success = false;
 
-    qDebug() << "Starting online transfer...";
-    transferManager.startTransfer(binPath, ipAddress, port);
-    loop.exec(); // 阻塞等待传输完成
+    QString binPath = filePath;
+    binPath.replace(".tif", ".bin", Qt::CaseInsensitive);
+    if (!createTiledBinFile(filePath, auxPath, settings, image_num, tileNumbers, binPath, &result.timing)) {
+        result.message = "Failed to create tiled bin file.";
+        return result;
+    }
+    if (packedPath) {
+        *packedPath = binPath;
+    }
+    result.success = true;
+    result.message = QString("Packed %1 tiles.").arg(tileNumbers.size());
+    return result;
+}
 
-    // 关键修正：从局部变量中获取并设置最终结果
-    result.success = transferSuccess;
-    result.message = transferMessage;
+ImageTransferResult packDeltaImage(const QString &filePath, const QString &auxPath, const DeltaSettings &settings,
+                                   const DeltaBase &base, uint16_t image_num, QImage *reconstructed,
+                                   int *changedTiles, int *totalTiles, QString *packedPath)
+{
+    trace::Span span("pack_delta", image_num);
+    ImageTransferResult result;
+    result.success = false;
 
+    QString binPath = filePath;
+    binPath.replace(".tif", ".bin", Qt::CaseInsensitive);
+    if (!createDeltaBinFile(filePath, auxPath, settings, base, binPath, image_num, reconstructed,
+                            changedTiles, totalTiles, &result.timing)) {
+        result.message = "Failed to create delta bin file.";
+        return result;
+    }
+    result.success = true;
+    if (*changedTiles < 0) {
+        result.message = "Delta not applicable, full product required.";
+        return result;
+    }
+    if (packedPath) {
+        *packedPath = binPath;
+    }
+    result.message = QString("Packed %1 of %2 tiles against image %3.").arg(*changedTiles).arg(*totalTiles).arg(base.imageNumber);
     return result;
 }
 
+ImageTransferResult packProduct(const ProductJob &job, uint16_t image_num, QString *packedPath)
+{
+    trace::Span span("pack", image_num);
+    if (job.type == ProductType::GMTI) {
+        return packGMTI(job.imagePath, job.txtPath, job.binPath, image_num, packedPath);
+    }
+    return packImage(job.imagePath, job.auxPath, image_num, packedPath);
+}
 
-ImageTransferResult processAndTransferManualImage(const QString &tifFilePath, const QString &auxFilePath, const QString &ipAddress, quint16 port, uint16_t image_num)
+/**
+ * @brief 手动发送的打包：AUX 路径为空时按 ISAR 只打包 TIF。
+ * 手动选择的文件可能仍被其他程序占用，这里保留等待文件释放的逻辑（在工作线程中执行）。
+ */
+ImageTransferResult packManualImage(const QString &tifFilePath, const QString &auxFilePath, uint16_t image_num, QString *packedPath)
 {
+    trace::Span span("pack_manual", image_num);
     ImageTransferResult result;
     result.success = false;
 
@@ -396,169 +421,10 @@ ImageTransferResult processAndTransferManualImage(const QString &tifFilePath, co
 
     qDebug() << "Offline packing completed successfully.";
 
-    // 3. 在线传输阶段（与原函数逻辑完全相同）
-    SarPacketTransferManager transferManager;
-    QEventLoop loop;
-    bool transferSuccess = false;
-    QString transferMessage;
-
-    QObject::connect(&transferManager, &SarPacketTransferManager::finished,
-                     [&](bool success) {
-                         transferSuccess = success;
-                         transferMessage = success ? "Transfer completed successfully." : "Transfer failed due to an error.";
-                         loop.quit();
-                     });
-
-    qDebug() << "Starting online transfer...";
-    transferManager.startTransfer(binPath, ipAddress, port);
-    loop.exec();
-
-    result.success = transferSuccess;
-    result.message = transferMessage;
-
-    return result;
-}
-
-/**
- * @brief SarPacketTransferManager的构造函数
- * @param packetizer 负责提供数据包的打包器实例
- * @param parent 父QObject，用于自动内存管理
- */
-SarPacketTransferManager::SarPacketTransferManager(QObject *parent)
-    : QObject(parent),
-    m_socket(new QTcpSocket(this)),
-    m_timeoutTimer(new QTimer(this))
-{
-    m_transferSuccessful = false;
-    connect(m_socket, &QTcpSocket::connected, this, &SarPacketTransferManager::onConnected);
-    connect(m_socket, &QTcpSocket::disconnected, this, &SarPacketTransferManager::onSocketDisconnected);
-#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
-    // Qt 5.15 及以上版本使用 errorOccurred 信号
-    connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::errorOccurred), this, &SarPacketTransferManager::onSocketError);
-#else
-    // 旧版本 Qt 使用 error 信号
-    connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error), this, &SarPacketTransferManager::onSocketError);
-#endif
-    connect(m_socket, &QTcpSocket::bytesWritten, this, &SarPacketTransferManager::onBytesWritten);
-    connect(m_socket, &QTcpSocket::readyRead, this, &SarPacketTransferManager::onReadyRead);
-    connect(m_timeoutTimer, &QTimer::timeout, this, &SarPacketTransferManager::onTimeout);
-
-    m_timeoutTimer->setInterval(5000);
-    m_timeoutTimer->setSingleShot(true);
-}
-
-/**
- * @brief 启动数据传输
- * @param ip 目标主机的IP地址
- * @param port 目标主机的端口号
- */
-void SarPacketTransferManager::startTransfer(const QString& binFilePath, const QString& ipAddress, quint16 port)
-{
-    // 在这里创建 SarPacketizer，负责从bin文件中读取
-    m_packetizer = new SarPacketizer(binFilePath);
-    m_transferSuccessful = false;
-    m_socket->connectToHost(ipAddress, port);
-}
-
-/**
- * @brief 套接字成功连接时的槽函数
- * 启动第一个数据包的发送
- */
-void SarPacketTransferManager::onConnected()
-{
-    qDebug() << "Connected to host. Starting transfer...";
-    // 连接成功后，立即开始发送第一个数据包
-    sendNextPacket();
-}
-
-/**
- * @brief 写入字节后的槽函数
- * 继续发送下一个数据包，直到所有包都发送完毕
- * @param bytes 已经写入套接字的字节数
- */
-void SarPacketTransferManager::onBytesWritten(qint64 bytes)
-{
-    Q_UNUSED(bytes);
-    // 每次写入数据后，继续发送下一个数据包
-    sendNextPacket();
-}
-
-/**
- * @brief 套接字断开连接时的槽函数
- * 告知外部传输已完成
- */
-void SarPacketTransferManager::onSocketDisconnected()
-{
-    qDebug() << "Disconnected from host.";
-    if (!m_transferSuccessful) {
-        emit finished(false);
-    }
-}
-
-/**
- * @brief 套接字发生错误时的槽函数
- * 告知外部传输失败
- * @param socketError 发生的错误类型
- */
-void SarPacketTransferManager::onSocketError(QAbstractSocket::SocketError socketError)
-{
-    qWarning() << "Socket error:" << m_socket->errorString() << "Error code:" << socketError;
-    // 发生错误时，传输失败
-    m_transferSuccessful = false;
-    m_timeoutTimer->stop();
-    emit finished(false);
-}
-
-/**
- * @brief 发送下一个数据包的私有辅助函数
- * 检查是否有更多数据包并写入套接字
- */
-void SarPacketTransferManager::sendNextPacket()
-{
-    if (m_packetizer && m_packetizer->hasNextPacket()) {
-        QByteArray packetData = m_packetizer->getNextPacket();
-        if (packetData.isEmpty()) {
-            qWarning() << "Failed to get next packet from bin file.";
-            m_transferSuccessful = false;
-            m_timeoutTimer->stop();
-            m_socket->disconnectFromHost();
-            emit finished(false);
-            return;
-        }
-
-        qint64 bytesWritten = m_socket->write(packetData);
-        if (bytesWritten == -1) {
-            qWarning() << "Failed to write data to socket:" << m_socket->errorString();
-            m_transferSuccessful = false;
-            m_timeoutTimer->stop();
-            m_socket->disconnectFromHost();
-            emit finished(false);
-        }
-    } else {
-//        qDebug() << "All packets sent. Waiting for acknowledgment...";
-        // 所有数据已发送，开始等待确认
-//        m_timeoutTimer->start();
-        emit finished(true);
-    }
-}
-
-void SarPacketTransferManager::onReadyRead()
-{
-    QByteArray ackMessage = m_socket->readAll();
-    // 假设接收端发送 "OK" 作为确认消息
-    if (ackMessage == "OK") {
-        qDebug() << "Received acknowledgment from receiver. Disconnecting...";
-        m_transferSuccessful = true;
-        m_timeoutTimer->stop();
-        m_socket->disconnectFromHost();
-        emit finished(true);
+    if (packedPath) {
+        *packedPath = binPath;
     }
-}
-
-void SarPacketTransferManager::onTimeout()
-{
-    qWarning() << "Timeout waiting for acknowledgment. Disconnecting...";
-    m_transferSuccessful = false;
-    m_socket->disconnectFromHost();
-    emit finished(false);
+    result.success = true;
+    result.message = "Offline packing completed successfully.";
+    return result;
 }
@@ -16,6 +16,8 @@
 
 // 业务通用类型
 #include "package_sar_data.h"
+#include "product_correlator.h"
+#include "product_timing.h"
 
 // ===================== 业务通用类型 =====================
 // 文件状态（主窗口和传输模块共用）
@@ -25,48 +27,32 @@ enum FileStatus {
     Failure
 };
 
-// ===================== 单文件处理接口 =====================
+// ===================== 处理结果 =====================
 struct ImageTransferResult {
     bool success;
     QString message;
+    qint64 bytesSent = 0;   // 已写入链路的字节数（传输失败时为中断前写出的部分）
+    ProductTiming timing;   // 打包或传输过程中经历的各环节耗时
 };
 
-ImageTransferResult processAndTransferGMTI(const QString &filePath, const QString &ipAddress, quint16 port, uint16_t image_num);
-
-ImageTransferResult processAndTransferImage(const QString &filePath, const QString &ipAddress, quint16 port, uint16_t image_num);
-
-ImageTransferResult processAndTransferManualImage(const QString &tifFilePath, const QString &auxFilePath, const QString &ipAddress, quint16 port, uint16_t image_num);
-
-
-// ===================== 高级批量传输类 =====================
-// 支持信号/槽的批量传输工具
-class SarPacketTransferManager : public QObject {
-    Q_OBJECT
-
-public:
-    explicit SarPacketTransferManager(QObject* parent = nullptr);
-    void startTransfer(const QString& binFilePath, const QString& ipAddress, quint16 port);
-
-signals:
-    void finished(bool success);
-    void disconnected(); // 新增信号：当套接字断开连接时发出
-
-private slots:
-    void onConnected();
-    void onBytesWritten(qint64 bytes);
-    void onSocketDisconnected();
-    void onSocketError(QAbstractSocket::SocketError socketError);
-    void onReadyRead(); // 新增槽函数：处理接收端发来的数据
-    void onTimeout();   // 新增槽函数：处理超时
-
-private:
-    void sendNextPacket();
-
-private:
-    QTcpSocket* m_socket;
-    SarPacketizer* m_packetizer = nullptr;
-    QTimer* m_timeoutTimer; // 超时定时器
-    bool m_transferSuccessful = false;
-};
+// ===================== 离线打包接口 =====================
+// 打包只占用 CPU，可在工作线程池中并行；生成的 bin 文件由 transferPackedFileAsync()（async_transfer.h）发送
+// GMTI：按底图同目录的同名 .txt/.bin 打包
+ImageTransferResult packGMTI(const QString &filePath, uint16_t image_num, QString *packedPath);
+ImageTransferResult packGMTI(const QString &filePath, const QString &txtPath, const QString &binPath, uint16_t image_num, QString *packedPath);
+// SAR：按命名规则 IMGxxx.tif → AUXxxx.dat 找到 AUX 文件
+ImageTransferResult packImage(const QString &filePath, uint16_t image_num, QString *packedPath);
+ImageTransferResult packImage(const QString &filePath, const QString &auxPath, uint16_t image_num, QString *packedPath);
+// SAR 瓦片模式：各瓦片使用 tileNumbers 中的图像编号，打包结果与 packImage 一样是与 TIF 同名的 .bin
+ImageTransferResult packTiledImage(const QString &filePath, const QString &auxPath, const TileSettings &settings,
+                                   uint16_t image_num, const QList<uint16_t> &tileNumbers, QString *packedPath);
+// SAR 场景增量：相对 base 只打包变化瓦片；不适合增量时不打包、changedTiles 为 -1，由调用方打包完整产品
+ImageTransferResult packDeltaImage(const QString &filePath, const QString &auxPath, const DeltaSettings &settings,
+                                   const DeltaBase &base, uint16_t image_num, QImage *reconstructed,
+                                   int *changedTiles, int *totalTiles, QString *packedPath);
+// 处理 ProductCorrelator 输出的齐全产品组
+ImageTransferResult packProduct(const ProductJob &job, uint16_t image_num, QString *packedPath);
+// 手动发送：auxFilePath 为空时按 ISAR 只打包 TIF
+ImageTransferResult packManualImage(const QString &tifFilePath, const QString &auxFilePath, uint16_t image_num, QString *packedPath);
 
 #endif // IMAGETRANSFER_H
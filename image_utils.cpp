@@ -6,6 +6,7 @@
 #include <QThread>
 #include <QDebug>
 #include <QMutex>
+#include "package_sar_data.h"
 
 bool convertTiffToJpg(const QString &inputPath, const QString &outputPath)
 {
@@ -26,7 +27,7 @@ bool convertTiffToJpg(const QString &inputPath, const QString &outputPath)
             return false;
         }
     }
-    if (!image.save(outputPath, "JPG", 80)) {
+    if (!image.save(outputPath, "JPG", imageCodecSettings().jpegQuality)) {
         qDebug() << "Failed to save JPG file:" << outputPath;
         return false;
     }
@@ -0,0 +1,171 @@
+#include "inotify_watcher.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+// 目录需要关心的事件：文件写完、文件移入、子目录创建/移入，以及目录自身被删除
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+InotifyWatcher::InotifyWatcher(QObject* parent) : QObject(parent) {
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        qWarning() << "inotify_init1 failed:" << strerror(errno);
+        return;
+    }
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &InotifyWatcher::onReadable);
+}
+
+InotifyWatcher::~InotifyWatcher() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+bool InotifyWatcher::isValid() const {
+    return m_fd >= 0;
+}
+
+bool InotifyWatcher::addPath(const QString& dirPath) {
+    return addWatch(QDir::cleanPath(dirPath), false);
+}
+
+bool InotifyWatcher::addRecursive(const QString& rootPath) {
+    const QString root = QDir::cleanPath(rootPath);
+    if (!addWatch(root, true)) {
+        return false;
+    }
+    // 已有的子目录同样加入监控（文件不上报，由调用方决定如何处理存量文件）
+    QDir dir(root);
+    const QStringList subDirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& name : subDirs) {
+        addRecursive(dir.filePath(name));
+    }
+    return true;
+}
+
+void InotifyWatcher::removeRecursive(const QString& rootPath) {
+    const QString root = QDir::cleanPath(rootPath);
+    const QString prefix = root + QLatin1Char('/');
+    const QList<QString> paths = m_pathToWd.keys();
+    for (const QString& path : paths) {
+        if (path == root || path.startsWith(prefix)) {
+            const int wd = m_pathToWd.take(path);
+            inotify_rm_watch(m_fd, wd);
+            m_wdToPath.remove(wd);
+            m_wdRecursive.remove(wd);
+        }
+    }
+}
+
+void InotifyWatcher::removeAll() {
+    for (auto it = m_wdToPath.constBegin(); it != m_wdToPath.constEnd(); ++it) {
+        inotify_rm_watch(m_fd, it.key());
+    }
+    m_wdToPath.clear();
+    m_pathToWd.clear();
+    m_wdRecursive.clear();
+}
+
+QStringList InotifyWatcher::directories() const {
+    return m_pathToWd.keys();
+}
+
+bool InotifyWatcher::addWatch(const QString& dirPath, bool recursive) {
+    if (m_fd < 0) {
+        return false;
+    }
+    const QByteArray nativePath = QFile::encodeName(dirPath);
+    const int wd = inotify_add_watch(m_fd, nativePath.constData(), WATCH_MASK);
+    if (wd < 0) {
+        qWarning() << "inotify_add_watch failed for" << dirPath << ":" << strerror(errno);
+        return false;
+    }
+    // 同一目录重复添加时内核返回同一个 wd，这里只需更新映射
+    m_wdToPath.insert(wd, dirPath);
+    m_pathToWd.insert(dirPath, wd);
+    m_wdRecursive.insert(wd, recursive);
+    return true;
+}
+
+/**
+ * @brief 新子目录加入监控后补扫一次。
+ * 在 mkdir 与 inotify_add_watch 之间的窗口里，生产者可能已经创建了下一级目录或文件，
+ * 这些对象不会再产生 IN_CREATE 事件，所以必须在加上监控之后立即扫描补齐。
+ */
+void InotifyWatcher::scanNewDirectory(const QString& dirPath) {
+    QDir dir(dirPath);
+    const QFileInfoList entries = dir.entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+    for (const QFileInfo& info : entries) {
+        const QString path = info.filePath();
+        if (info.isDir()) {
+            if (!m_pathToWd.contains(path) && addWatch(path, true)) {
+                emit directoryCreated(path);
+                scanNewDirectory(path);
+            }
+        } else {
+            emit fileFound(path);
+        }
+    }
+}
+
+void InotifyWatcher::onReadable() {
+    // inotify_event 需要按其自身对齐方式读取
+    alignas(struct inotify_event) char buffer[64 * 1024];
+
+    for (;;) {
+        const ssize_t length = ::read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            if (length < 0 && errno != EAGAIN && errno != EINTR) {
+                qWarning() << "inotify read failed:" << strerror(errno);
+            }
+            return;
+        }
+
+        for (const char* ptr = buffer; ptr < buffer + length;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                qWarning() << "inotify event queue overflowed, a rescan is required.";
+                emit overflowed();
+                continue;
+            }
+
+            if (event->mask & IN_IGNORED) {
+                // 监控被内核移除（目录被删除或被 rm_watch）
+                const QString path = m_wdToPath.take(event->wd);
+                m_pathToWd.remove(path);
+                m_wdRecursive.remove(event->wd);
+                continue;
+            }
+
+            const auto dirIt = m_wdToPath.constFind(event->wd);
+            if (dirIt == m_wdToPath.constEnd() || event->len == 0) {
+                continue;
+            }
+            const QString path = dirIt.value() + QLatin1Char('/') + QFile::decodeName(event->name);
+
+            if (event->mask & IN_ISDIR) {
+                if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && m_wdRecursive.value(event->wd)) {
+                    if (addWatch(path, true)) {
+                        emit directoryCreated(path);
+                        scanNewDirectory(path);
+                    }
+                } else if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    emit directoryCreated(path);
+                }
+                continue;
+            }
+
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                emit fileCompleted(path);
+            }
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef INOTIFY_WATCHER_H
+#define INOTIFY_WATCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+
+class QSocketNotifier;
+
+/**
+ * @class InotifyWatcher
+ * @brief Linux 原生 inotify 监控后端。
+ *
+ * 与 QFileSystemWatcher 只报告“目录变化”不同，这里直接把内核事件翻译成文件级信号：
+ * 只有在生产者关闭写句柄（IN_CLOSE_WRITE）或原子重命名到位（IN_MOVED_TO）时，
+ * 才会发出 fileCompleted，因此收到信号时文件一定已经写完，无需再轮询 open()。
+ * inotify fd 由 QSocketNotifier 接入事件循环，没有任何 sleep。
+ */
+class InotifyWatcher : public QObject {
+    Q_OBJECT
+public:
+    explicit InotifyWatcher(QObject* parent = nullptr);
+    ~InotifyWatcher();
+
+    bool isValid() const;
+
+    // 监控单个目录（不递归）
+    bool addPath(const QString& dirPath);
+    // 递归监控目录树，之后新建的子目录会自动加入监控
+    bool addRecursive(const QString& rootPath);
+    // 移除 dirPath 及其所有子目录的监控
+    void removeRecursive(const QString& rootPath);
+    void removeAll();
+    QStringList directories() const;
+
+signals:
+    // 文件已写完（关闭写句柄或被重命名到监控目录中）
+    void fileCompleted(const QString& filePath);
+    // 新子目录加入监控时，目录中已经存在的文件（无法确定是否写完，由调用方自行确认）
+    void fileFound(const QString& filePath);
+    void directoryCreated(const QString& dirPath);
+    // 内核事件队列溢出，调用方需要做一次全量校正
+    void overflowed();
+
+private slots:
+    void onReadable();
+
+private:
+    bool addWatch(const QString& dirPath, bool recursive);
+    void scanNewDirectory(const QString& dirPath);
+
+    int m_fd = -1;
+    QSocketNotifier* m_notifier = nullptr;
+    QHash<int, QString> m_wdToPath;
+    QHash<QString, int> m_pathToWd;
+    QHash<int, bool> m_wdRecursive;
+};
+
+#endif // INOTIFY_WATCHER_H
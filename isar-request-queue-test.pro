@@ -0,0 +1,19 @@
+# ISAR 请求队列合并、去重与限速的行为测试：qmake isar-request-queue-test.pro && make check
+# XML 写入临时目录，TIF 不需要真实存在
+
+TARGET = isar-request-queue-test
+TEMPLATE = app
+
+QT = core testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    isar_request_queue.cpp \
+    isar_request_queue_test.cpp \
+    log_categories.cpp
+
+HEADERS += \
+    isar_request_queue.h \
+    log_categories.h
@@ -0,0 +1,173 @@
+#include "isar_request_queue.h"
+#include "log_categories.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QXmlStreamWriter>
+
+// 合并重新计时的上限：从首个请求算起最多等待 holdMs 的这么多倍
+static const int MAX_HOLD_FACTOR = 4;
+
+IsarRequestQueue::IsarRequestQueue(PathResolver resolver, QObject* parent)
+    : QObject(parent),
+    m_resolver(std::move(resolver)),
+    m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &IsarRequestQueue::processNext);
+}
+
+void IsarRequestQueue::setSettings(const IsarQueueSettings& settings) {
+    m_settings = settings;
+    schedule();
+}
+
+IsarQueueSettings IsarRequestQueue::settings() const {
+    return m_settings;
+}
+
+int IsarRequestQueue::pendingCount() const {
+    return m_pending.size();
+}
+
+quint64 IsarRequestQueue::droppedDuplicates() const {
+    return m_droppedDuplicates;
+}
+
+// request 的中心是首个请求的中心，合并不会移动它
+bool IsarRequestQueue::overlaps(const IsarRequest& request, quint16 imageNumber, int offsetX, int offsetY) const {
+    return request.imageNumber == imageNumber
+           && qAbs(request.offsetX - offsetX) <= m_settings.mergeRangePx
+           && qAbs(request.offsetY - offsetY) <= m_settings.mergeAzimuthPx;
+}
+
+qint64 IsarRequestQueue::readyAtMs(const IsarRequest& request) const {
+    return qMin(request.lastReceivedMs + m_settings.holdMs,
+                request.firstReceivedMs + qint64(MAX_HOLD_FACTOR) * m_settings.holdMs);
+}
+
+quint32 IsarRequestQueue::submit(quint16 imageNumber, int offsetX, int offsetY) {
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+
+    // 尚未生成 XML 的重叠请求：合并，中心保持首个请求的值，等待重新计时
+    for (IsarRequest& request : m_pending) {
+        if (overlaps(request, imageNumber, offsetX, offsetY)) {
+            request.mergedCount++;
+            request.lastReceivedMs = nowMs;
+            emit requestChanged(request);
+            schedule();
+            return 0;
+        }
+    }
+
+    // 刚生成过 XML 的重叠请求：视为重复，不再生成
+    while (!m_recent.isEmpty() && nowMs - m_recent.first().lastReceivedMs > m_settings.dedupWindowMs) {
+        m_recent.removeFirst();
+    }
+    for (IsarRequest& request : m_recent) {
+        if (overlaps(request, imageNumber, offsetX, offsetY)) {
+            request.mergedCount++;
+            m_droppedDuplicates++;
+            emit requestChanged(request);
+            return 0;
+        }
+    }
+
+    IsarRequest request;
+    request.id = m_nextId++;
+    request.imageNumber = imageNumber;
+    request.offsetX = offsetX;
+    request.offsetY = offsetY;
+    request.firstReceivedMs = nowMs;
+    request.lastReceivedMs = nowMs;
+    m_pending.append(request);
+    emit requestChanged(request);
+    schedule();
+    return request.id;
+}
+
+void IsarRequestQueue::sourcePaths(const QString& tifPath, QString* slcPath, QString* auxPath) {
+    QFileInfo tifInfo(tifPath);
+    const QString baseName = tifInfo.completeBaseName().replace("IMG_", "");
+    const QDir directory(tifInfo.absolutePath());
+    *slcPath = directory.filePath("SLC_" + baseName + ".slc");
+    *auxPath = directory.filePath("AUX_" + baseName + ".dat");
+}
+
+void IsarRequestQueue::schedule() {
+    if (m_pending.isEmpty()) {
+        m_timer->stop();
+        return;
+    }
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    const qint64 readyAt = qMax(readyAtMs(m_pending.first()), m_lastWriteMs + m_settings.minIntervalMs);
+    m_timer->start(int(qBound<qint64>(0, readyAt - nowMs, MAX_HOLD_FACTOR * m_settings.holdMs + m_settings.minIntervalMs)));
+}
+
+void IsarRequestQueue::processNext() {
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    if (nowMs < readyAtMs(m_pending.first()) || nowMs < m_lastWriteMs + m_settings.minIntervalMs) {
+        schedule();
+        return;
+    }
+
+    IsarRequest request = m_pending.takeFirst();
+    writeXml(request);
+    m_lastWriteMs = nowMs;
+    if (request.state == IsarRequest::State::Written) {
+        request.lastReceivedMs = nowMs;
+        m_recent.append(request);
+    }
+    emit requestChanged(request);
+    schedule();
+}
+
+void IsarRequestQueue::writeXml(IsarRequest& request) {
+    const QString tifPath = m_resolver ? m_resolver(request.imageNumber) : QString();
+    if (tifPath.isEmpty()) {
+        request.state = IsarRequest::State::Failed;
+        request.message = QString("未找到图像编号 %1 对应的文件路径").arg(request.imageNumber);
+        qWarning() << request.message;
+        return;
+    }
+
+    // 构造SLC和AUX文件路径
+    QString slcPath;
+    QString auxPath;
+    sourcePaths(tifPath, &slcPath, &auxPath);
+    const QString xmlPath = QDir(QFileInfo(tifPath).absolutePath()).filePath(
+        QString("ISARConfig_IMG_%1_REQ_%2.xml").arg(request.imageNumber).arg(request.id));
+
+    QFile file(xmlPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        request.state = IsarRequest::State::Failed;
+        request.message = "无法写入 " + xmlPath + "：" + file.errorString();
+        qWarning() << request.message;
+        return;
+    }
+
+    QXmlStreamWriter xmlWriter(&file);
+    xmlWriter.setAutoFormatting(true);
+    xmlWriter.writeStartDocument();
+    xmlWriter.writeStartElement("ISARConfig");
+    xmlWriter.writeTextElement("file_slc", slcPath);
+    xmlWriter.writeTextElement("file_aux", auxPath);
+    xmlWriter.writeTextElement("rg_center", QString::number(request.offsetX));
+    xmlWriter.writeTextElement("az_center", QString::number(request.offsetY));
+    xmlWriter.writeTextElement("rg_win_len", QString::number(m_settings.rangeWindow));
+    xmlWriter.writeTextElement("az_win_len", QString::number(m_settings.azimuthWindow));
+    xmlWriter.writeTextElement("request_id", QString::number(request.id));
+    xmlWriter.writeEndElement(); // </ISARConfig>
+    xmlWriter.writeEndDocument();
+    file.close();
+
+    request.state = IsarRequest::State::Written;
+    request.xmlPath = xmlPath;
+    request.message.clear();
+    qCDebug(lcPipeline) << "XML配置文件已成功生成：" << xmlPath << "（合并请求" << request.mergedCount << "次）";
+}
@@ -0,0 +1,96 @@
+#ifndef ISAR_REQUEST_QUEUE_H
+#define ISAR_REQUEST_QUEUE_H
+
+#include <QObject>
+#include <QList>
+#include <QMetaType>
+#include <QString>
+#include <QTimer>
+#include <functional>
+
+// 一条（可能由多次重复请求合并而来的）ISAR 成像请求
+struct IsarRequest {
+    enum class State {
+        Pending,    // 等待生成 XML
+        Written,    // XML 已生成
+        Failed      // 找不到图像或写文件失败
+    };
+
+    quint32 id = 0;
+    quint16 imageNumber = 0;
+    int offsetX = 0;            // 距离向中心（首个请求的值，合并不改变）
+    int offsetY = 0;            // 方位向中心（同上）
+    int mergedCount = 1;        // 合并进来的请求数（含首个）
+    qint64 firstReceivedMs = 0;
+    qint64 lastReceivedMs = 0;
+    State state = State::Pending;
+    QString xmlPath;
+    QString message;
+};
+Q_DECLARE_METATYPE(IsarRequest)
+
+// 合并与限速参数
+struct IsarQueueSettings {
+    int mergeRangePx = 256;         // 同一图像、距离向中心相差不超过此值的请求视为重叠
+    int mergeAzimuthPx = 1024;      // 方位向容差
+    int holdMs = 200;               // 最后一次合并之后至少等待这么久再生成 XML，以便合并突发的重复请求
+    int minIntervalMs = 500;        // 两次生成 XML 之间的最小间隔
+    int dedupWindowMs = 10000;      // XML 生成后这段时间内的重叠请求直接丢弃
+    int rangeWindow = 1024;         // 写入 XML 的 rg_win_len
+    int azimuthWindow = 4096;       // 写入 XML 的 az_win_len
+};
+
+/**
+ * @class IsarRequestQueue
+ * @brief 非阻塞的 ISAR 请求队列：按图像编号合并重复/重叠请求，并限速生成 ISARConfig XML。
+ *
+ * submit() 只做合并与入队，立即返回；XML 由内部定时器在请求等待满 holdMs 后、按 minIntervalMs
+ * 的间隔逐个生成。请求的每次状态变化都通过 requestChanged 通知界面，界面只做被动展示。
+ *
+ * 合并规则：与首个请求的中心相差在容差内的请求并入该请求，中心始终取首个请求的值，
+ * 因此一串逐步偏移的请求不会把中心带离最初的位置，超出容差的请求另建新请求。
+ * 每次合并都重新开始 holdMs 的等待，但从首个请求算起最多等待 4 倍 holdMs，
+ * 持续不断的重复请求也不会无限推迟 XML 的生成。
+ */
+class IsarRequestQueue : public QObject {
+    Q_OBJECT
+public:
+    // 由图像编号查找已发送的 TIF 路径，找不到时返回空字符串
+    using PathResolver = std::function<QString(quint16 imageNumber)>;
+
+    explicit IsarRequestQueue(PathResolver resolver, QObject* parent = nullptr);
+
+    // 由 TIF 路径推出同目录下的 SLC_<名称>.slc 与 AUX_<名称>.dat
+    static void sourcePaths(const QString& tifPath, QString* slcPath, QString* auxPath);
+
+    void setSettings(const IsarQueueSettings& settings);
+    IsarQueueSettings settings() const;
+
+    // 返回新建请求的编号；被合并或视为重复时返回 0
+    quint32 submit(quint16 imageNumber, int offsetX, int offsetY);
+    int pendingCount() const;
+    quint64 droppedDuplicates() const;
+
+signals:
+    void requestChanged(const IsarRequest& request);
+
+private slots:
+    void processNext();
+
+private:
+    bool overlaps(const IsarRequest& request, quint16 imageNumber, int offsetX, int offsetY) const;
+    qint64 readyAtMs(const IsarRequest& request) const;
+    void writeXml(IsarRequest& request);
+    void schedule();
+
+    PathResolver m_resolver;
+    IsarQueueSettings m_settings;
+    QList<IsarRequest> m_pending;
+    QList<IsarRequest> m_recent;    // 最近生成过 XML 的请求，用于去重
+    QTimer* m_timer;
+    quint32 m_nextId = 1;
+    qint64 m_lastWriteMs = 0;
+    quint64 m_droppedDuplicates = 0;
+};
+
+#endif // ISAR_REQUEST_QUEUE_H
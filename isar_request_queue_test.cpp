@@ -0,0 +1,138 @@
+// isar_request_queue_test.cpp
+// IsarRequestQueue：容差按首个请求的中心判断，逐步偏移的请求不会拖动中心；合并重新开始等待；
+// XML 生成后窗口内的重叠请求作为重复丢弃，不同图像或超出容差的请求各自生成；找不到图像时记为失败。
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+#include <memory>
+#include "isar_request_queue.h"
+
+namespace {
+
+IsarQueueSettings testSettings() {
+    IsarQueueSettings settings;
+    settings.mergeRangePx = 100;
+    settings.mergeAzimuthPx = 100;
+    settings.holdMs = 50;
+    settings.minIntervalMs = 0;
+    settings.dedupWindowMs = 60000;
+    return settings;
+}
+
+} // namespace
+
+class IsarRequestQueueTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init() {
+        QVERIFY(m_dir.isValid());
+        m_queue.reset(new IsarRequestQueue([this](quint16 imageNumber) {
+            return imageNumber == 404 ? QString() : m_dir.filePath(QString("IMG_%1.tif").arg(imageNumber));
+        }));
+        m_queue->setSettings(testSettings());
+        m_written.clear();
+        m_finishedIds.clear();
+        // 每个请求只记第一次离开 Pending 的通知，之后丢弃重复时的计数更新不算
+        connect(m_queue.get(), &IsarRequestQueue::requestChanged, this, [this](const IsarRequest& request) {
+            if (request.state != IsarRequest::State::Pending && !m_finishedIds.contains(request.id)) {
+                m_finishedIds.insert(request.id);
+                m_written.append(request);
+            }
+        });
+    }
+
+    void mergesAroundFirstCentre() {
+        QVERIFY(m_queue->submit(1, 1000, 2000) != 0);
+        // 并入已有请求时不新建请求
+        QCOMPARE(m_queue->submit(1, 1080, 2050), quint32(0));
+        QCOMPARE(m_queue->pendingCount(), 1);
+        // 距首个中心 160，超出容差；若以合并后的中心（1080）比较则会被并入
+        m_queue->submit(1, 1160, 2000);
+        // 其他图像的同一位置是独立请求
+        m_queue->submit(2, 1000, 2000);
+        QCOMPARE(m_queue->pendingCount(), 3);
+
+        QTRY_COMPARE_WITH_TIMEOUT(m_written.size(), 3, 5000);
+        const IsarRequest merged = m_written.at(0);
+        QCOMPARE(merged.state, IsarRequest::State::Written);
+        QCOMPARE(merged.mergedCount, 2);
+        QCOMPARE(merged.offsetX, 1000);
+        QCOMPARE(merged.offsetY, 2000);
+        QCOMPARE(xmlValue(merged.xmlPath, "rg_center"), QString("1000"));
+        QCOMPARE(xmlValue(merged.xmlPath, "az_center"), QString("2000"));
+        QCOMPARE(m_written.at(1).mergedCount, 1);
+        QCOMPARE(xmlValue(m_written.at(1).xmlPath, "rg_center"), QString("1160"));
+        QCOMPARE(m_written.at(2).imageNumber, quint16(2));
+    }
+
+    void mergeRestartsHold() {
+        IsarQueueSettings settings = testSettings();
+        settings.holdMs = 400;
+        m_queue->setSettings(settings);
+
+        QElapsedTimer timer;
+        timer.start();
+        m_queue->submit(1, 1000, 2000);
+        QTest::qWait(250);
+        m_queue->submit(1, 1010, 2000);
+        QCOMPARE(m_queue->pendingCount(), 1);
+        const qint64 mergedAt = timer.elapsed();
+
+        QTRY_COMPARE_WITH_TIMEOUT(m_written.size(), 1, 5000);
+        // 从合并时刻重新等待 holdMs，而不是从首个请求起算
+        QVERIFY2(timer.elapsed() >= mergedAt + 350, qPrintable(QString::number(timer.elapsed())));
+        QCOMPARE(m_written.first().mergedCount, 2);
+    }
+
+    void dropsDuplicatesAfterWrite() {
+        m_queue->submit(1, 1000, 2000);
+        QTRY_COMPARE_WITH_TIMEOUT(m_written.size(), 1, 5000);
+
+        QCOMPARE(m_queue->submit(1, 1050, 1950), quint32(0));
+        QCOMPARE(m_queue->droppedDuplicates(), quint64(1));
+        QCOMPARE(m_queue->pendingCount(), 0);
+
+        // 超出容差的新位置照常生成
+        m_queue->submit(1, 3000, 2000);
+        QCOMPARE(m_queue->pendingCount(), 1);
+        QTRY_COMPARE_WITH_TIMEOUT(m_written.size(), 2, 5000);
+        QCOMPARE(m_queue->droppedDuplicates(), quint64(1));
+    }
+
+    void failedRequestIsNotDeduplicated() {
+        m_queue->submit(404, 1000, 2000);
+        QTRY_COMPARE_WITH_TIMEOUT(m_written.size(), 1, 5000);
+        QCOMPARE(m_written.first().state, IsarRequest::State::Failed);
+
+        // 失败的请求不进入去重窗口，重新请求会再次尝试
+        m_queue->submit(404, 1000, 2000);
+        QCOMPARE(m_queue->pendingCount(), 1);
+        QCOMPARE(m_queue->droppedDuplicates(), quint64(0));
+    }
+
+private:
+    static QString xmlValue(const QString& xmlPath, const QString& element) {
+        QFile file(xmlPath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return QString();
+        }
+        QXmlStreamReader reader(&file);
+        while (!reader.atEnd()) {
+            if (reader.readNext() == QXmlStreamReader::StartElement && reader.name() == element) {
+                return reader.readElementText();
+            }
+        }
+        return QString();
+    }
+
+    QTemporaryDir m_dir;
+    std::unique_ptr<IsarRequestQueue> m_queue;
+    QList<IsarRequest> m_written;
+    QSet<quint32> m_finishedIds;
+};
+
+QTEST_GUILESS_MAIN(IsarRequestQueueTest)
+#include "isar_request_queue_test.moc"
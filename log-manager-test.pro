@@ -0,0 +1,19 @@
+# 日志环形队列与按类别限速的行为测试：qmake log-manager-test.pro && make check
+# LogManager 内部使用 QTimer，测试以 QCoreApplication 运行
+
+TARGET = log-manager-test
+TEMPLATE = app
+
+QT = core testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    log_manager_test.cpp \
+    log_ring_buffer.cpp \
+    logmanager.cpp
+
+HEADERS += \
+    log_ring_buffer.h \
+    logmanager.h
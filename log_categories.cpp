@@ -0,0 +1,7 @@
+#include "log_categories.h"
+
+Q_LOGGING_CATEGORY(lcPacking, "aerolink.packing")
+Q_LOGGING_CATEGORY(lcPipeline, "aerolink.pipeline")
+Q_LOGGING_CATEGORY(lcCommand, "aerolink.command")
+Q_LOGGING_CATEGORY(lcMetrics, "aerolink.metrics")
+Q_LOGGING_CATEGORY(lcUi, "aerolink.ui")
@@ -0,0 +1,13 @@
+#ifndef LOG_CATEGORIES_H
+#define LOG_CATEGORIES_H
+
+#include <QLoggingCategory>
+
+// 各模块的日志类别。LogManager 按类别名限速（[log_rate_limits]），也可用 QT_LOGGING_RULES 单独开关
+Q_DECLARE_LOGGING_CATEGORY(lcPacking)   // aerolink.packing：解码、校正、编码与分帧
+Q_DECLARE_LOGGING_CATEGORY(lcPipeline)  // aerolink.pipeline：调度、队列、日志与重发
+Q_DECLARE_LOGGING_CATEGORY(lcCommand)   // aerolink.command：指令接收与 ISAR/ROI 请求
+Q_DECLARE_LOGGING_CATEGORY(lcMetrics)   // aerolink.metrics：指标与跟踪导出
+Q_DECLARE_LOGGING_CATEGORY(lcUi)        // aerolink.ui：界面与守护进程的操作记录
+
+#endif // LOG_CATEGORIES_H
@@ -0,0 +1,168 @@
+// log_manager_test.cpp
+// 环形队列：容量取整、满队时丢弃并计数、多个生产者并发入队时各自的记录保持顺序；
+// LogManager：限额按完整类别名计算（父子类别互不影响），warning 不限速，被抑制的条数在下一秒补记。
+#include <QtTest>
+#include <QDateTime>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include <QThread>
+#include <thread>
+#include <vector>
+#include "logmanager.h"
+
+Q_LOGGING_CATEGORY(lcTestNoisy, "aerolink.test.noisy")
+Q_LOGGING_CATEGORY(lcTestNoisyChild, "aerolink.test.noisy.child")
+Q_LOGGING_CATEGORY(lcTestParent, "aerolink.test")
+
+namespace {
+
+LogRecord record(const QString& message) {
+    LogRecord result;
+    result.message = message;
+    return result;
+}
+
+int countLines(const QStringList& lines, const QString& text) {
+    int count = 0;
+    for (const QString& line : lines) {
+        if (line.contains(text)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// 限速窗口按整秒划分：等到下一秒开始后再发，保证一批消息落在同一窗口内
+void waitForNextSecond() {
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    QThread::msleep(unsigned(1000 - nowMs % 1000 + 20));
+}
+
+} // namespace
+
+class LogManagerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void capacityRoundsUpToPowerOfTwo() {
+        QCOMPARE(LogRingBuffer(0).capacity(), 2);
+        QCOMPARE(LogRingBuffer(5).capacity(), 8);
+        QCOMPARE(LogRingBuffer(64).capacity(), 64);
+        QCOMPARE(LogRingBuffer(65).capacity(), 128);
+    }
+
+    void popsInOrderAndCountsDrops() {
+        LogRingBuffer ring(4);
+        for (int i = 0; i < 4; ++i) {
+            QVERIFY(ring.tryPush(record(QString::number(i))));
+        }
+        // 队列满时丢弃而不是阻塞
+        QVERIFY(!ring.tryPush(record("overflow")));
+        QVERIFY(!ring.tryPush(record("overflow")));
+        QCOMPARE(ring.approximateSize(), 4);
+        QCOMPARE(ring.takeDroppedCount(), quint64(2));
+        QCOMPARE(ring.takeDroppedCount(), quint64(0));
+
+        LogRecord popped;
+        for (int i = 0; i < 4; ++i) {
+            QVERIFY(ring.tryPop(&popped));
+            QCOMPARE(popped.message, QString::number(i));
+        }
+        QVERIFY(!ring.tryPop(&popped));
+
+        // 取空后槽位可以再次使用
+        for (int round = 0; round < 10; ++round) {
+            QVERIFY(ring.tryPush(record(QString::number(round))));
+            QVERIFY(ring.tryPop(&popped));
+            QCOMPARE(popped.message, QString::number(round));
+        }
+    }
+
+    void keepsPerProducerOrderUnderContention() {
+        const int producers = 4;
+        const int perProducer = 20000;
+        LogRingBuffer ring(256);
+        std::atomic<int> finished{0};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&ring, &finished, p] {
+                for (int i = 0; i < perProducer; ++i) {
+                    // 满了就让出 CPU 重试，使队列反复绕圈
+                    for (;;) {
+                        LogRecord item;
+                        item.timestampMs = qint64(p) * perProducer + i;
+                        if (ring.tryPush(std::move(item))) {
+                            break;
+                        }
+                        std::this_thread::yield();
+                    }
+                }
+                finished.fetch_add(1);
+            });
+        }
+
+        // 单消费者：每个生产者的记录按入队顺序出队且一条不少
+        std::vector<qint64> last(producers, -1);
+        quint64 popped = 0;
+        bool ordered = true;
+        LogRecord item;
+        for (;;) {
+            const bool done = finished.load() == producers;
+            while (ring.tryPop(&item)) {
+                const int p = int(item.timestampMs / perProducer);
+                const qint64 i = item.timestampMs % perProducer;
+                ordered = ordered && i > last[p];
+                last[p] = i;
+                ++popped;
+            }
+            if (done) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        QVERIFY(ordered);
+        QCOMPARE(popped, quint64(producers) * perProducer);
+    }
+
+    void rateLimitsByExactCategoryName() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        LogManager& manager = LogManager::instance();
+        manager.setUiForwarding(false);
+        manager.setLogFile(dir.path(), 1024 * 1024, 1);
+        manager.setDefaultRateLimit(0);
+        manager.setRateLimit("aerolink.test.noisy", 5);
+
+        waitForNextSecond();
+        for (int i = 0; i < 30; ++i) {
+            qCDebug(lcTestNoisy) << "noisy-debug" << i;
+            qCDebug(lcTestNoisyChild) << "child-debug" << i;
+            qCDebug(lcTestParent) << "parent-debug" << i;
+        }
+        // warning 不受限速影响，也不计入被抑制的条数
+        for (int i = 0; i < 3; ++i) {
+            qCWarning(lcTestNoisy) << "noisy-warning" << i;
+        }
+        // 下一个窗口的第一条消息带出上一秒的抑制统计
+        waitForNextSecond();
+        qCDebug(lcTestNoisy) << "noisy-debug next";
+        manager.shutdown();
+
+        QFile file(QDir(dir.path()).filePath("aerolink.log"));
+        QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+        const QStringList lines = QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+        QCOMPARE(countLines(lines, "noisy-debug"), 5 + 1);
+        QCOMPARE(countLines(lines, "noisy-warning"), 3);
+        // 前缀相同的父/子类别不共用限额
+        QCOMPARE(countLines(lines, "child-debug"), 30);
+        QCOMPARE(countLines(lines, "parent-debug"), 30);
+        QCOMPARE(countLines(lines, "[aerolink.test.noisy] 25 messages suppressed by rate limit (5/s)"), 1);
+        QCOMPARE(countLines(lines, "suppressed by rate limit"), 1);
+    }
+};
+
+QTEST_GUILESS_MAIN(LogManagerTest)
+#include "log_manager_test.moc"
@@ -0,0 +1,70 @@
+#include "log_ring_buffer.h"
+
+LogRingBuffer::LogRingBuffer(int capacity) {
+    quint64 size = 2;
+    while (size < static_cast<quint64>(qMax(2, capacity))) {
+        size <<= 1;
+    }
+    m_cells.reset(new Cell[size]);
+    m_mask = size - 1;
+    for (quint64 i = 0; i < size; ++i) {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool LogRingBuffer::tryPush(LogRecord&& record) {
+    quint64 pos = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = m_cells[pos & m_mask];
+        const quint64 sequence = cell.sequence.load(std::memory_order_acquire);
+        const qint64 diff = static_cast<qint64>(sequence) - static_cast<qint64>(pos);
+        if (diff == 0) {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.record = std::move(record);
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // 写线程还没取走一整圈之前的记录：队列已满
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool LogRingBuffer::tryPop(LogRecord* record) {
+    quint64 pos = m_dequeuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = m_cells[pos & m_mask];
+        const quint64 sequence = cell.sequence.load(std::memory_order_acquire);
+        const qint64 diff = static_cast<qint64>(sequence) - static_cast<qint64>(pos + 1);
+        if (diff == 0) {
+            if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                *record = std::move(cell.record);
+                cell.record.message = QString();
+                cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = m_dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+int LogRingBuffer::capacity() const {
+    return static_cast<int>(m_mask + 1);
+}
+
+int LogRingBuffer::approximateSize() const {
+    const quint64 enqueued = m_enqueuePos.load(std::memory_order_relaxed);
+    const quint64 dequeued = m_dequeuePos.load(std::memory_order_relaxed);
+    return enqueued > dequeued ? static_cast<int>(enqueued - dequeued) : 0;
+}
+
+quint64 LogRingBuffer::takeDroppedCount() {
+    return m_dropped.exchange(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,50 @@
+#ifndef LOG_RING_BUFFER_H
+#define LOG_RING_BUFFER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+// 一条待写出的日志
+struct LogRecord {
+    qint64 timestampMs = 0;
+    QtMsgType type = QtDebugMsg;
+    QString message;
+};
+
+/**
+ * @class LogRingBuffer
+ * @brief 有界无锁环形队列（多生产者，后台写线程消费）。
+ *
+ * 每个槽带序号，生产者用 CAS 抢占写位置，不持有任何锁；
+ * 队列满时直接丢弃并计数，打日志的线程永远不会因为磁盘或界面变慢而阻塞。
+ */
+class LogRingBuffer {
+public:
+    // capacity 向上取整为 2 的幂
+    explicit LogRingBuffer(int capacity);
+
+    bool tryPush(LogRecord&& record);
+    bool tryPop(LogRecord* record);
+
+    int capacity() const;
+    // 近似的当前条数（并发下仅供参考）
+    int approximateSize() const;
+    // 取出并清零因队列满被丢弃的条数
+    quint64 takeDroppedCount();
+
+private:
+    struct Cell {
+        std::atomic<quint64> sequence{0};
+        LogRecord record;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    quint64 m_mask;
+    alignas(64) std::atomic<quint64> m_enqueuePos{0};
+    alignas(64) std::atomic<quint64> m_dequeuePos{0};
+    std::atomic<quint64> m_dropped{0};
+};
+
+#endif // LOG_RING_BUFFER_H
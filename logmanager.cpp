@@ -1,11 +1,24 @@
 #include "logmanager.h"
 #include <QDebug>
-#include <QMutex>
-#include <QDateTime> // 新增：包含 QDateTime 头文件
+#include <QDateTime>
+#include <QDir>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
 
 // 原始消息处理函数指针
 static QtMessageHandler originalMessageHandler = nullptr;
 
+// 环形队列容量；写线程每 50 ms 至少醒来一次，队列过半时提前唤醒
+static const int RING_CAPACITY = 16384;
+static const int WRITER_IDLE_WAIT_MS = 50;
+static const int DEFAULT_RATE_LIMIT = 200;
+static const int DEFAULT_UI_REFRESH_MS = 100;
+static const int DEFAULT_UI_MAX_LINES = 5000;
+static const qint64 DEFAULT_MAX_FILE_BYTES = 8 * 1024 * 1024;
+static const int DEFAULT_MAX_FILES = 5;
+
 LogManager& LogManager::instance()
 {
     static LogManager logManager;
@@ -16,7 +29,8 @@ void LogManager::messageHandler(QtMsgType type, const QMessageLogContext &contex
 {
     // 使用线程本地变量来保护，避免同一个线程内的递归调用
     static thread_local bool isInsideHandler = false;
-    if (isInsideHandler) {
+    LogManager &manager = LogManager::instance();
+    if (isInsideHandler || !manager.m_running.load(std::memory_order_acquire)) {
         if (originalMessageHandler) {
             originalMessageHandler(type, context, msg);
         }
@@ -24,26 +38,336 @@ void LogManager::messageHandler(QtMsgType type, const QMessageLogContext &contex
     }
 
     isInsideHandler = true;
+    if (type == QtFatalMsg) {
+        // 进程即将终止：先把队列中的日志写出，再交给原处理函数
+        manager.enqueue(type, context.category, msg);
+        manager.shutdown();
+        isInsideHandler = false;
+        if (originalMessageHandler) {
+            originalMessageHandler(type, context, msg);
+        }
+        return;
+    }
+    manager.enqueue(type, context.category, msg);
+    isInsideHandler = false;
+}
+
+LogManager::LogManager(QObject *parent)
+    : QObject(parent),
+    m_ring(RING_CAPACITY),
+    m_defaultRateLimit(DEFAULT_RATE_LIMIT),
+    m_maxFileBytes(DEFAULT_MAX_FILE_BYTES),
+    m_maxFiles(DEFAULT_MAX_FILES),
+    m_uiMaxLines(DEFAULT_UI_MAX_LINES),
+    m_uiTimer(new QTimer(this))
+{
+    connect(m_uiTimer, &QTimer::timeout, this, &LogManager::flushToUi);
+    m_uiTimer->start(DEFAULT_UI_REFRESH_MS);
+
+    m_writer = QThread::create([this]() { writerLoop(); });
+    m_writer->setObjectName("log-writer");
+    m_running.store(true, std::memory_order_release);
+    m_writer->start();
+
+    // 保存原始的消息处理函数，然后安装我们自己的
+    originalMessageHandler = qInstallMessageHandler(messageHandler);
+}
+
+LogManager::~LogManager()
+{
+    shutdown();
+}
+
+void LogManager::configure(QSettings &settings)
+{
+    settings.beginGroup("log");
+    QString dir = settings.value("dir").toString();
+    if (dir.isEmpty()) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/logs";
+    }
+    const qint64 maxFileBytes = qMax<qint64>(1, settings.value("max_file_mb", DEFAULT_MAX_FILE_BYTES / (1024 * 1024)).toLongLong()) * 1024 * 1024;
+    setLogFile(dir, maxFileBytes, settings.value("max_files", DEFAULT_MAX_FILES).toInt());
+    setUiRefreshInterval(settings.value("ui_refresh_ms", DEFAULT_UI_REFRESH_MS).toInt());
+    setUiMaxLines(settings.value("ui_max_lines", DEFAULT_UI_MAX_LINES).toInt());
+    setDefaultRateLimit(settings.value("rate_limit", DEFAULT_RATE_LIMIT).toInt());
+    settings.endGroup();
+
+    settings.beginGroup("log_rate_limits");
+    const QStringList categories = settings.childKeys();
+    for (const QString &category : categories) {
+        setRateLimit(category, settings.value(category).toInt());
+    }
+    settings.endGroup();
+}
+
+void LogManager::setLogFile(const QString &dirPath, qint64 maxFileBytes, int maxFiles)
+{
+    QMutexLocker locker(&m_fileMutex);
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_logDir = dirPath;
+    m_maxFileBytes = qMax<qint64>(64 * 1024, maxFileBytes);
+    m_maxFiles = qMax(1, maxFiles);
+    openLogFileLocked();
+}
 
-    // --- 新增：获取当前时间并格式化为字符串 ---
-    QString formattedTime = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
-    // --- 新增：拼接时间戳和原始消息 ---
-    QString formattedMessage = QString("[%1] %2").arg(formattedTime).arg(msg);
+void LogManager::setUiRefreshInterval(int intervalMs)
+{
+    m_uiTimer->setInterval(qMax(10, intervalMs));
+}
+
+void LogManager::setUiMaxLines(int maxLines)
+{
+    m_uiMaxLines.store(qMax(100, maxLines));
+}
 
-    // 将带时间戳的消息转发给主窗口
-    LogManager::instance().logMessage(formattedMessage);
+void LogManager::setUiForwarding(bool enabled)
+{
+    m_uiForwarding.store(enabled);
+    if (enabled) {
+        m_uiTimer->start();
+    } else {
+        m_uiTimer->stop();
+        QMutexLocker locker(&m_uiMutex);
+        m_uiPending.clear();
+        m_uiOmitted = 0;
+    }
+}
+
+int LogManager::uiMaxLines() const
+{
+    return m_uiMaxLines.load();
+}
+
+void LogManager::setDefaultRateLimit(int messagesPerSecond)
+{
+    m_defaultRateLimit.store(qMax(0, messagesPerSecond));
+}
+
+void LogManager::setRateLimit(const QString &category, int messagesPerSecond)
+{
+    const QByteArray name = category.toUtf8();
+    rateState(name.constData())->limit.store(qMax(0, messagesPerSecond));
+}
+
+void LogManager::shutdown()
+{
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    qInstallMessageHandler(originalMessageHandler);
+    m_stopping.store(true);
+    {
+        QMutexLocker locker(&m_writerMutex);
+        m_wakeup.wakeAll();
+    }
+    if (QThread::currentThread() != m_writer) {
+        m_writer->wait();
+        delete m_writer;
+        m_writer = nullptr;
+    }
+    QMutexLocker locker(&m_fileMutex);
+    m_file.close();
+}
+
+// 按类别名精确查找；首次出现的类别在锁内加入新表，此后的查找不加锁也不分配内存
+LogManager::RateState *LogManager::rateState(const char *category)
+{
+    const char *name = category ? category : "default";
+    const QByteArray key = QByteArray::fromRawData(name, qstrlen(name));
+    const RateTable *table = m_rateTable.load(std::memory_order_acquire);
+    if (table) {
+        RateState *state = table->value(key);
+        if (state) {
+            return state;
+        }
+    }
+
+    QMutexLocker locker(&m_rateMutex);
+    table = m_rateTable.load(std::memory_order_acquire);
+    if (table) {
+        RateState *state = table->value(key);
+        if (state) {
+            return state;
+        }
+    }
+    m_rateStates.push_back(std::make_unique<RateState>());
+    RateState *state = m_rateStates.back().get();
+    auto updated = std::make_unique<RateTable>(table ? *table : RateTable());
+    updated->insert(QByteArray(name), state);
+    m_rateTable.store(updated.get(), std::memory_order_release);
+    m_rateTables.push_back(std::move(updated));
+    return state;
+}
+
+// 每个类别每秒最多放行 limit 条 debug/info；warning 及以上不限速
+bool LogManager::allowMessage(QtMsgType type, const char *category, qint64 nowMs)
+{
+    if (type != QtDebugMsg && type != QtInfoMsg) {
+        return true;
+    }
+    RateState &slot = *rateState(category);
+    const int slotLimit = slot.limit.load(std::memory_order_relaxed);
+    const int limit = slotLimit >= 0 ? slotLimit : m_defaultRateLimit.load(std::memory_order_relaxed);
+    if (limit == 0) {
+        return true;
+    }
+
+    const qint64 second = nowMs / 1000;
+    qint64 window = slot.windowSecond.load(std::memory_order_relaxed);
+    if (window != second && slot.windowSecond.compare_exchange_strong(window, second)) {
+        slot.count.store(0, std::memory_order_relaxed);
+        const int suppressed = slot.suppressed.exchange(0);
+        if (suppressed > 0) {
+            LogRecord note;
+            note.timestampMs = nowMs;
+            note.type = QtWarningMsg;
+            note.message = QString("[%1] %2 messages suppressed by rate limit (%3/s)")
+                               .arg(QString::fromUtf8(category ? category : "default")).arg(suppressed).arg(limit);
+            m_ring.tryPush(std::move(note));
+        }
+    }
+    if (slot.count.fetch_add(1, std::memory_order_relaxed) >= limit) {
+        slot.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void LogManager::enqueue(QtMsgType type, const char *category, const QString &msg)
+{
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    if (!allowMessage(type, category, nowMs)) {
+        return;
+    }
+    LogRecord record;
+    record.timestampMs = nowMs;
+    record.type = type;
+    record.message = msg;
+    m_ring.tryPush(std::move(record));
+    if (m_ring.approximateSize() > m_ring.capacity() / 2) {
+        // 不持锁唤醒：偶尔错过也只是等到下一次定时醒来
+        m_wakeup.wakeOne();
+    }
+}
+
+void LogManager::writerLoop()
+{
+    LogRecord record;
+    for (;;) {
+        int written = 0;
+        while (m_ring.tryPop(&record)) {
+            writeRecord(record);
+            ++written;
+        }
+        const quint64 dropped = m_ring.takeDroppedCount();
+        if (dropped > 0) {
+            LogRecord note;
+            note.timestampMs = QDateTime::currentMSecsSinceEpoch();
+            note.type = QtWarningMsg;
+            note.message = QString("%1 log messages dropped, log queue full").arg(dropped);
+            writeRecord(note);
+            ++written;
+        }
+        if (written > 0) {
+            QMutexLocker locker(&m_fileMutex);
+            if (m_file.isOpen()) {
+                m_file.flush();
+            }
+            continue;
+        }
+        if (m_stopping.load()) {
+            break;
+        }
+        QMutexLocker locker(&m_writerMutex);
+        m_wakeup.wait(&m_writerMutex, WRITER_IDLE_WAIT_MS);
+    }
+}
+
+void LogManager::writeRecord(const LogRecord &record)
+{
+    // 时间戳在写线程中格式化，不占用打日志线程的时间
+    const QString formattedTime = QDateTime::fromMSecsSinceEpoch(record.timestampMs).toString("yyyy-MM-dd hh:mm:ss.zzz");
+    const QString formattedMessage = QString("[%1] %2").arg(formattedTime, record.message);
+
+    writeLine(formattedMessage);
 
     // 调用原始的消息处理函数，将消息打印到终端
     if (originalMessageHandler) {
-        originalMessageHandler(type, context, msg);
+        originalMessageHandler(record.type, QMessageLogContext(), record.message);
     }
 
-    isInsideHandler = false;
+    if (!m_uiForwarding.load(std::memory_order_relaxed)) {
+        return;
+    }
+    QMutexLocker locker(&m_uiMutex);
+    m_uiPending.append(formattedMessage);
+    // 界面跟不上时只保留最新的行，与显示区的滚动上限一致
+    const int maxLines = m_uiMaxLines.load(std::memory_order_relaxed);
+    if (m_uiPending.size() > maxLines) {
+        const int excess = m_uiPending.size() - maxLines;
+        m_uiPending.erase(m_uiPending.begin(), m_uiPending.begin() + excess);
+        m_uiOmitted += excess;
+    }
 }
 
-LogManager::LogManager(QObject *parent)
-    : QObject(parent)
+void LogManager::writeLine(const QString &line)
 {
-    // 保存原始的消息处理函数，然后安装我们自己的
-    originalMessageHandler = qInstallMessageHandler(messageHandler);
+    QMutexLocker locker(&m_fileMutex);
+    if (!m_file.isOpen()) {
+        return;
+    }
+    m_file.write(line.toUtf8());
+    m_file.write("\n", 1);
+    if (m_file.size() >= m_maxFileBytes) {
+        rotateLocked();
+    }
+}
+
+void LogManager::openLogFileLocked()
+{
+    if (m_logDir.isEmpty() || !QDir().mkpath(m_logDir)) {
+        return;
+    }
+    m_file.setFileName(QDir(m_logDir).filePath("aerolink.log"));
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return;
+    }
+    if (m_file.size() >= m_maxFileBytes) {
+        rotateLocked();
+    }
+}
+
+// aerolink.log → aerolink.log.1 → … → aerolink.log.N，超出保留数的最旧文件删除
+void LogManager::rotateLocked()
+{
+    const QString basePath = m_file.fileName();
+    m_file.close();
+    QFile::remove(QString("%1.%2").arg(basePath).arg(m_maxFiles));
+    for (int i = m_maxFiles - 1; i >= 1; --i) {
+        QFile::rename(QString("%1.%2").arg(basePath).arg(i), QString("%1.%2").arg(basePath).arg(i + 1));
+    }
+    QFile::rename(basePath, basePath + ".1");
+    m_file.setFileName(basePath);
+    m_file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+void LogManager::flushToUi()
+{
+    QStringList lines;
+    int omitted = 0;
+    {
+        QMutexLocker locker(&m_uiMutex);
+        if (m_uiPending.isEmpty()) {
+            return;
+        }
+        lines.swap(m_uiPending);
+        omitted = m_uiOmitted;
+        m_uiOmitted = 0;
+    }
+    if (omitted > 0) {
+        lines.prepend(QString("... %1 earlier log lines not shown, see log file ...").arg(omitted));
+    }
+    emit logBatch(lines);
 }
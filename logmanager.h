@@ -3,7 +3,29 @@
 
 #include <QObject>
 #include <QMessageLogContext>
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "log_ring_buffer.h"
 
+class QSettings;
+class QThread;
+class QTimer;
+
+/**
+ * @class LogManager
+ * @brief 异步日志：消息处理函数只把记录放入无锁环形队列，后台写线程负责
+ * 格式化、写入滚动日志文件并转发到终端；界面按固定帧率批量取走新行。
+ * debug/info 级别按类别名限速（每秒条数），超出部分丢弃并在下一秒补记被抑制的条数；
+ * 各模块的日志使用 log_categories.h 中的命名类别，可在 [log_rate_limits] 中分别设置；
+ * 队列满时同样丢弃计数，打日志的线程不会因为磁盘或界面而阻塞。
+ */
 class LogManager : public QObject
 {
     Q_OBJECT
@@ -12,12 +34,91 @@ public:
     static LogManager& instance();
     static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg);
 
+    /**
+     * @brief 从配置文件读取日志参数。
+     *   [log]
+     *   dir=                 ; 为空时写到 AppLocalDataLocation/logs
+     *   max_file_mb=8
+     *   max_files=5
+     *   ui_refresh_ms=100
+     *   ui_max_lines=5000
+     *   rate_limit=200       ; 每个类别每秒最多的 debug/info 条数，0 为不限
+     *   [log_rate_limits]
+     *   qt.network=20        ; 单独设置某个类别（按完整类别名匹配）
+     *   aerolink.packing=50
+     */
+    void configure(QSettings &settings);
+    // dirPath 为空时只转发到终端与界面
+    void setLogFile(const QString &dirPath, qint64 maxFileBytes, int maxFiles);
+    void setUiRefreshInterval(int intervalMs);
+    void setUiMaxLines(int maxLines);
+    // 无界面运行时关闭，写线程不再缓存待显示行
+    void setUiForwarding(bool enabled);
+    int uiMaxLines() const;
+    void setDefaultRateLimit(int messagesPerSecond);
+    void setRateLimit(const QString &category, int messagesPerSecond);
+
+    // 写出队列中剩余的日志并停止写线程；之后的日志直接交给原处理函数
+    void shutdown();
+
 signals:
-    void logMessage(const QString &message);
+    // 界面线程中按固定间隔发出，每批为上次之后的全部新行
+    void logBatch(const QStringList &lines);
+
+private slots:
+    void flushToUi();
 
 private:
     explicit LogManager(QObject *parent = nullptr);
+    ~LogManager();
     Q_DISABLE_COPY(LogManager)
+
+    // 单个类别的每秒计数；创建后不再释放，表中只保存指针
+    struct RateState {
+        std::atomic<qint64> windowSecond{0};
+        std::atomic<int> count{0};
+        std::atomic<int> suppressed{0};
+        std::atomic<int> limit{-1};   // -1 表示使用默认限速
+    };
+    // 类别名 → 计数。表本身只读，新增类别时复制一份再原子替换，打日志的线程无锁查找
+    using RateTable = QHash<QByteArray, RateState *>;
+
+    void enqueue(QtMsgType type, const char *category, const QString &msg);
+    bool allowMessage(QtMsgType type, const char *category, qint64 nowMs);
+    RateState *rateState(const char *category);
+    void writerLoop();
+    void writeRecord(const LogRecord &record);
+    void writeLine(const QString &line);
+    void openLogFileLocked();
+    void rotateLocked();
+
+    LogRingBuffer m_ring;
+    std::atomic<const RateTable *> m_rateTable{nullptr};
+    QMutex m_rateMutex;     // 新增类别（替换表）时互斥
+    std::vector<std::unique_ptr<RateState>> m_rateStates;
+    // 被替换的旧表可能仍有线程在读，保留到进程结束；类别数量有限，占用可以忽略
+    std::vector<std::unique_ptr<const RateTable>> m_rateTables;
+    std::atomic<int> m_defaultRateLimit;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_stopping{false};
+    QThread *m_writer = nullptr;
+    QMutex m_writerMutex;
+    QWaitCondition m_wakeup;
+
+    // 以下由写线程使用，m_fileMutex 仅在重新配置文件时与界面线程互斥
+    QMutex m_fileMutex;
+    QFile m_file;
+    QString m_logDir;
+    qint64 m_maxFileBytes;
+    int m_maxFiles;
+
+    // 写线程与界面线程之间的待显示行
+    QMutex m_uiMutex;
+    QStringList m_uiPending;
+    int m_uiOmitted = 0;
+    std::atomic<int> m_uiMaxLines;
+    std::atomic<bool> m_uiForwarding{true};
+    QTimer *m_uiTimer;
 };
 
 #endif // LOGMANAGER_H
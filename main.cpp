@@ -8,14 +8,33 @@
  */
 #include <QApplication>
 #include <QImage>
+#include <QSettings>
 #include "mainwindow.h"
 #include "logmanager.h"
+#include "pipeline_config.h"
+#include "trace_recorder.h"
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
-    LogManager::instance();
-    MainWindow w;
-    w.show();
-    return a.exec();
+    QSettings settings(defaultConfigPath(), QSettings::IniFormat);
+    LogManager::instance().configure(settings);
+    const TraceConfig traceConfig = loadTraceConfig(settings);
+    if (traceConfig.enabled) {
+        TraceRecorder::instance().setBufferCapacity(traceConfig.bufferEvents);
+        TraceRecorder::instance().start();
+    }
+    int ret;
+    {
+        MainWindow w;
+        w.show();
+        ret = a.exec();
+    }
+    if (TraceRecorder::instance().isRecording()) {
+        const QString traceDir = traceConfig.dir.isEmpty() ? QCoreApplication::applicationDirPath() : traceConfig.dir;
+        TraceRecorder::instance().stop(TraceRecorder::timestampedPath(traceDir));
+    }
+    // 退出前写出队列中剩余的日志
+    LogManager::instance().shutdown();
+    return ret;
 }
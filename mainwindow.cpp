@@ -4,19 +4,29 @@
 #include <QDir>
 #include <QCoreApplication>
 #include <QFileInfo>
+#include <QDateTime>
 #include <QFileDialog>
 #include <QTimer>
 #include <QButtonGroup>
 #include <QImageReader>
 #include <QThread>
 #include <QXmlStreamWriter>
+#include <QStandardPaths>
+#include <QSettings>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QTextDocument>
+#include "log_categories.h"
 #include "logmanager.h"
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include <QListWidget>
 #include "radar_protocol.h"
 #include "image_transfer.h"
-#include "file_monitor.h"
 #include "message_transfer.h"
+#include "pipeline_config.h"
+#include "metrics_server.h"
+#include "worker_pool.h"
 
 QString mainFolderPath = "E:/AIR/小长ISAR/实时数据回传/data";
 
@@ -26,11 +36,34 @@ quint16 port = 65432;
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , m_imageCounter(0)
-    , m_isarRequestCounter(0)
 {
-    fileMonitor = new FileMonitor(this);
-    connect(fileMonitor, &FileMonitor::newFileDetected, this, &MainWindow::processAndTransferFile);
+    m_pipeline = new TransferPipeline(this);
+    connect(m_pipeline, &TransferPipeline::productFinished, this, &MainWindow::onProductFinished);
+    connect(m_pipeline, &TransferPipeline::productProgress, this, &MainWindow::onProductProgress);
+    connect(m_pipeline, &TransferPipeline::statisticsChanged, this, &MainWindow::updateStatistics);
+
+    // 打开产品状态日志并恢复：图像编号、编号→路径映射在重启后延续
+    const QString journalDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    m_pipeline->openJournal(QDir(journalDir).filePath("product_journal.log"));
+    m_pipeline->openQueue(QDir(journalDir).filePath("transfer_queue"));
+
+    // 本机指标端口，供 Prometheus 抓取，不经过界面
+    QSettings settings(defaultConfigPath(), QSettings::IniFormat);
+    const quint16 metricsPort = loadMetricsPort(settings);
+    m_metricsServer = new MetricsServer([this]() { return m_pipeline->renderMetrics(); }, this);
+    m_metricsServer->addRoute("/timings", [this]() { return m_pipeline->renderTimings(); });
+    if (metricsPort != 0) {
+        m_metricsServer->listen(metricsPort);
+    }
+
+    // ISAR 请求：合并重复请求后限速生成 XML，界面只被动展示
+    m_isarQueue = new IsarRequestQueue([this](quint16 imageNumber) { return getImagePath(imageNumber); }, this);
+    m_isarQueue->setSettings(loadIsarQueueSettings(settings));
+    connect(m_isarQueue, &IsarRequestQueue::requestChanged, this, &MainWindow::onIsarRequestChanged);
+    m_slcChips.setSettings(loadSlcSettings(settings));
+    m_slcChips.setWorkerPool(m_pipeline->workerPool());
+    m_roiSettings = loadRoiSettings(settings);
+    m_pipeline->productCache()->setCapacity(loadProductCacheBytes(settings));
     // 可选：连接 mainDirChanged、subDirChanged 信号做UI更新
     ui->setupUi(this);
     ui->ipAddressLineEdit->setPlaceholderText("请输入 IP 地址");
@@ -50,7 +83,9 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->isarCheckBox, &QCheckBox::checkStateChanged, this, &MainWindow::on_isarCheckBox_stateChanged);
     connect(ui->GMTICheckBox, &QCheckBox::checkStateChanged, this, &MainWindow::on_GMTICheckBox_stateChanged);
 
-    connect(&LogManager::instance(), &LogManager::logMessage, this, &MainWindow::onLogMessage);
+    // 日志按批次刷新到界面，显示区只保留最近的若干行
+    ui->textEdit_Log->document()->setMaximumBlockCount(LogManager::instance().uiMaxLines());
+    connect(&LogManager::instance(), &LogManager::logBatch, this, &MainWindow::onLogBatch);
 
     updateStatistics();
 
@@ -63,6 +98,7 @@ MainWindow::MainWindow(QWidget *parent)
     // 设置TCP服务器线程
     m_serverThread = new QThread(this);
     m_tcpServerThreadObject = new TcpServerThread();
+    m_tcpServerThreadObject->setConfig(loadCommandServerConfig(settings));
     m_tcpServerThreadObject->moveToThread(m_serverThread);
 
     // 连接主窗口的槽函数到服务器状态变化信号
@@ -71,6 +107,8 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_tcpServerThreadObject, &TcpServerThread::serverStopped, this, &MainWindow::onServerStopped);
     connect(m_tcpServerThreadObject, &TcpServerThread::logMessage, this, &MainWindow::onLogMessage);
     connect(m_tcpServerThreadObject, &TcpServerThread::receivedIsarRequest, this, &MainWindow::onReceivedIsarRequest);
+    connect(m_tcpServerThreadObject, &TcpServerThread::receivedRoiRequest, this, &MainWindow::onReceivedRoiRequest);
+    connect(m_tcpServerThreadObject, &TcpServerThread::receivedRetransmitRequest, this, &MainWindow::onReceivedRetransmitRequest);
 
     // 启动线程
     m_serverThread->start();
@@ -84,6 +122,8 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // 先停止流水线并等待线程池任务结束，之后界面对象才可销毁
+    delete m_pipeline;
     // 安全地停止线程
     m_serverThread->quit();
     m_serverThread->wait();
@@ -93,63 +133,177 @@ MainWindow::~MainWindow()
 
 void MainWindow::onReceivedIsarRequest(quint16 imageNumber, quint16 offsetX, quint16 offsetY)
 {
-    // 1. 递增请求计数器，并使用它的新值
-    m_isarRequestCounter++;
-    quint16 requestId = m_isarRequestCounter;
-
-    // 2. 在主线程中安全地创建和显示弹窗
-    QMessageBox::information(this,
-                             "收到ISAR成像请求",
-                             QString("请求编号：%1\n图像编号：%2\n像素偏移x：%3\n像素偏移y：%4")
-                                 .arg(requestId)
-                                 .arg(imageNumber)
-                                 .arg(offsetX)
-                                 .arg(offsetY));
-
-    // 3. 获取TIF文件路径
-    QString tifPath = getImagePath(imageNumber);
-    if (tifPath.isEmpty()) {
-        qWarning() << "未找到图像编号 " << imageNumber << " 对应的文件路径。无法生成XML文件。";
+    // 不弹窗、不阻塞：交给队列合并与限速，结果显示在请求列表中
+    const quint32 requestId = m_isarQueue->submit(imageNumber, qint16(offsetX), qint16(offsetY));
+    const SlcSettings slcSettings = m_slcChips.settings();
+    if (requestId == 0 || (!slcSettings.directChip && !slcSettings.quicklook.enabled)) {
         return;
     }
 
-    // 4. 构造SLC和AUX文件路径
-    QFileInfo tifInfo(tifPath);
-    QString baseName = tifInfo.completeBaseName();
-    QString directory = tifInfo.absolutePath();
-
-    QString slcPath = QDir(directory).filePath("SLC_" + baseName.replace("IMG_", "") + ".slc");
-    QString auxPath = QDir(directory).filePath("AUX_" + baseName.replace("IMG_", "") + ".dat");
-
-    // 5. 构造XML文件名，现在包含请求编号
-    QString xmlPath = QDir(directory).filePath(QString("ISARConfig_IMG_%1_REQ_%2.xml").arg(imageNumber).arg(requestId));
-
-    // 6. 使用 QXmlStreamWriter 写入XML文件
-    QFile file(xmlPath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        qWarning() << "无法打开文件 " << xmlPath << " 进行写入。错误：" << file.errorString();
+    // SLC 直传：不等 ISAR 成像，立即从映射的 SLC 中切出请求窗口（及快视图）回传给数传目的地址
+    const QString tifPath = getImagePath(imageNumber);
+    if (tifPath.isEmpty()) {
         return;
     }
+    QString slcPath;
+    QString auxPath;
+    IsarRequestQueue::sourcePaths(tifPath, &slcPath, &auxPath);
+    const IsarQueueSettings isarSettings = m_isarQueue->settings();
+    const QString host = ui->ipAddressLineEdit->text();
+    const quint16 destPort = ui->portLineEdit->text().toUShort();
+    const int rangeCenter = qint16(offsetX);
+    const int azimuthCenter = qint16(offsetY);
+
+    if (slcSettings.directChip) {
+        // 芯片是独立消息，占用新的图像编号，源图像编号写在 SlcChipInfo 中，避免接收端把芯片帧混入原图
+        const uint16_t chipNumber = m_pipeline->allocateImageNumber();
+        m_pipeline->workerPool()->submit([this, slcPath, auxPath, imageNumber, chipNumber, requestId, rangeCenter, azimuthCenter, isarSettings, host, destPort]() {
+            QString error;
+            const std::shared_ptr<SlcChipPacketizer> chip = m_slcChips.createChip(
+                slcPath, auxPath, chipNumber, imageNumber, requestId, rangeCenter, azimuthCenter,
+                isarSettings.rangeWindow, isarSettings.azimuthWindow, &error);
+            if (!chip) {
+                qWarning() << QString("ISAR 请求 %1 的 SLC 芯片生成失败：%2").arg(requestId).arg(error);
+                return;
+            }
+            m_pipeline->transferPackets(chip, host, destPort, this, [requestId, imageNumber, chipNumber](const ImageTransferResult& result) {
+                if (result.success) {
+                    qCDebug(lcUi) << QString("ISAR 请求 %1 的 SLC 芯片已回传。图片编号: %2（源图像 %3）, %4 字节")
+                                .arg(requestId).arg(chipNumber).arg(imageNumber).arg(result.bytesSent);
+                } else {
+                    qCDebug(lcUi) << QString("ISAR 请求 %1 的 SLC 芯片回传失败：%2").arg(requestId).arg(result.message);
+                }
+            });
+        });
+    }
 
-    QXmlStreamWriter xmlWriter(&file);
-    xmlWriter.setAutoFormatting(true);
-    xmlWriter.writeStartDocument();
-    xmlWriter.writeStartElement("ISARConfig");
+    if (slcSettings.quicklook.enabled) {
+        // 快视图作为一幅普通 SAR 图像打包发送，占用新的图像编号
+        const uint16_t quicklookNumber = m_pipeline->allocateImageNumber();
+        m_pipeline->workerPool()->submit([this, slcPath, auxPath, imageNumber, requestId, quicklookNumber, rangeCenter, azimuthCenter, isarSettings, host, destPort]() {
+            QString error;
+            QImage quicklook;
+            AuxHeader quicklookAux;
+            if (!m_slcChips.renderQuicklook(slcPath, auxPath, rangeCenter, azimuthCenter,
+                                            isarSettings.rangeWindow, isarSettings.azimuthWindow,
+                                            &quicklook, &quicklookAux, &error)) {
+                qWarning() << QString("ISAR 请求 %1 的快视图生成失败：%2").arg(requestId).arg(error);
+                return;
+            }
+            const QString packedPath = QDir::temp().filePath(
+                QString("ISAR_QL_IMG_%1_REQ_%2_packaged.bin").arg(imageNumber).arg(requestId));
+            if (!createBinFileFromImageAndAux(quicklook, quicklookAux, packedPath, quicklookNumber)) {
+                qWarning() << QString("ISAR 请求 %1 的快视图打包失败").arg(requestId);
+                return;
+            }
+            m_pipeline->transferFile(packedPath, host, destPort, this, [packedPath, requestId, imageNumber, quicklookNumber](const ImageTransferResult& result) {
+                QFile::remove(packedPath);
+                if (result.success) {
+                    qCDebug(lcUi) << QString("ISAR 请求 %1 的快视图已回传。图片编号: %2（源图像 %3）")
+                                .arg(requestId).arg(quicklookNumber).arg(imageNumber);
+                } else {
+                    qCDebug(lcUi) << QString("ISAR 请求 %1 的快视图回传失败：%2").arg(requestId).arg(result.message);
+                }
+            });
+        });
+    }
+}
 
-    xmlWriter.writeTextElement("file_slc", slcPath);
-    xmlWriter.writeTextElement("file_aux", auxPath);
-    xmlWriter.writeTextElement("rg_center", QString::number(offsetX));
-    xmlWriter.writeTextElement("az_center", QString::number(offsetY));
-    xmlWriter.writeTextElement("rg_win_len", "1024");
-    xmlWriter.writeTextElement("az_win_len", "4096");
-    xmlWriter.writeTextElement("request_id", QString::number(requestId)); // 将请求编号写入XML
+void MainWindow::onReceivedRoiRequest(quint16 imageNumber, qint16 x, qint16 y, quint16 width, quint16 height, quint8 jpegQuality)
+{
+    const QString tifPath = getImagePath(imageNumber);
+    if (tifPath.isEmpty()) {
+        qCDebug(lcUi) << QString("ROI 请求失败：未找到图像编号 %1 对应的文件路径。").arg(imageNumber);
+        return;
+    }
+    const QString auxPath = ProductCorrelator::auxPathForImage(tifPath);
+    const QRect region(x, y,
+                       qMin<int>(width > 0 ? width : m_roiSettings.defaultWidth, m_roiSettings.maxSide),
+                       qMin<int>(height > 0 ? height : m_roiSettings.defaultHeight, m_roiSettings.maxSide));
+    const int quality = jpegQuality > 0 ? jpegQuality : m_roiSettings.jpegQuality;
+    const QString host = ui->ipAddressLineEdit->text();
+    const quint16 destPort = ui->portLineEdit->text().toUShort();
+    // 裁剪结果作为独立产品发送，占用新的图像编号，源图像编号写在 SAR_DataInfo 扩展中
+    const uint16_t roiNumber = m_pipeline->allocateImageNumber();
+
+    m_pipeline->workerPool()->submit([this, tifPath, auxPath, region, quality, imageNumber, roiNumber, host, destPort]() {
+        const QString packedPath = QDir::temp().filePath(
+            QString("ROI_IMG_%1_%2_packaged.bin").arg(imageNumber).arg(roiNumber));
+        QRect actualRegion;
+        if (!createBinFileFromTifRegion(tifPath, auxPath, region, quality, packedPath, roiNumber, imageNumber, &actualRegion)) {
+            qWarning() << QString("图像 %1 的 ROI 裁剪失败。").arg(imageNumber);
+            return;
+        }
+        m_pipeline->transferFile(packedPath, host, destPort, this, [packedPath, imageNumber, roiNumber, actualRegion](const ImageTransferResult& result) {
+            QFile::remove(packedPath);
+            if (result.success) {
+                qCDebug(lcUi) << QString("ROI 已回传。图片编号: %1（源图像 %2，区域 %3,%4 %5×%6），%7 字节")
+                            .arg(roiNumber).arg(imageNumber)
+                            .arg(actualRegion.x()).arg(actualRegion.y()).arg(actualRegion.width()).arg(actualRegion.height())
+                            .arg(result.bytesSent);
+            } else {
+                qCDebug(lcUi) << QString("ROI 回传失败：%1").arg(result.message);
+            }
+        });
+    });
+}
 
-    xmlWriter.writeEndElement(); // </ISARConfig>
-    xmlWriter.writeEndDocument();
+// 接收端按缺包列表请求补发：只重发列出的帧，产品在缓存中时不重新打包
+void MainWindow::onReceivedRetransmitRequest(quint16 imageNumber, const QList<quint16> &packets)
+{
+    const QString host = ui->ipAddressLineEdit->text();
+    const quint16 destPort = ui->portLineEdit->text().toUShort();
+    const int requested = packets.size();
+    m_pipeline->resendPackets(imageNumber, packets, host, destPort, this, [imageNumber, requested](const ImageTransferResult& result) {
+        if (result.success) {
+            qCDebug(lcUi) << QString("补发完成。图片编号: %1，%2，%3 字节")
+                        .arg(imageNumber)
+                        .arg(requested > 0 ? QString("%1 个包").arg(requested) : QString("整图"))
+                        .arg(result.bytesSent);
+        } else {
+            qCDebug(lcUi) << QString("补发图像 %1 失败：%2").arg(imageNumber).arg(result.message);
+        }
+    });
+}
 
-    file.close();
+void MainWindow::onIsarRequestChanged(const IsarRequest &request)
+{
+    static const int MAX_LIST_ITEMS = 200;
 
-    qDebug() << "XML配置文件已成功生成：" << xmlPath;
+    QString state;
+    switch (request.state) {
+    case IsarRequest::State::Pending: state = "等待生成"; break;
+    case IsarRequest::State::Written: state = "已生成 " + QFileInfo(request.xmlPath).fileName(); break;
+    case IsarRequest::State::Failed:  state = "失败：" + request.message; break;
+    }
+    const QString text = QString("[%1] 请求 %2  图像 %3  偏移 (%4, %5)  合并 %6 次  %7")
+                             .arg(QDateTime::fromMSecsSinceEpoch(request.lastReceivedMs).toString("hh:mm:ss"))
+                             .arg(request.id)
+                             .arg(request.imageNumber)
+                             .arg(request.offsetX)
+                             .arg(request.offsetY)
+                             .arg(request.mergedCount)
+                             .arg(state);
+
+    QListWidgetItem* item = m_isarItems.value(request.id);
+    if (item) {
+        item->setText(text);
+        return;
+    }
+    item = new QListWidgetItem(text);
+    ui->isarRequestList->insertItem(0, item);
+    m_isarItems.insert(request.id, item);
+    // 只保留最近的请求
+    while (ui->isarRequestList->count() > MAX_LIST_ITEMS) {
+        QListWidgetItem* oldest = ui->isarRequestList->takeItem(ui->isarRequestList->count() - 1);
+        for (auto it = m_isarItems.begin(); it != m_isarItems.end(); ++it) {
+            if (it.value() == oldest) {
+                m_isarItems.erase(it);
+                break;
+            }
+        }
+        delete oldest;
+    }
 }
 
 void MainWindow::on_sendTestDataButton_clicked()
@@ -290,46 +444,60 @@ void MainWindow::on_manualSendButton_clicked()
     QString ipAddress = ui->ipAddressLineEdit->text();
     quint16 port = ui->portLineEdit->text().toUShort();
 
-    uint16_t currentImageNum = m_imageCounter;
-    m_imageCounter++;
-
-    ImageTransferResult result;
-
     QString imageFilePath = ui->imagePathLineEdit->text();
     if (imageFilePath.isEmpty()) {
         QMessageBox::warning(this, "警告", "请选择一个图像文件！");
         return;
     }
 
-    if (ui->GMTICheckBox->isChecked()) {
-        qDebug() << "发送GMTI图像以及目标信息包。";
-        result = processAndTransferGMTI(imageFilePath, ipAddress, port, currentImageNum);
+    const bool isGMTI = ui->GMTICheckBox->isChecked();
+    const bool isISAR = ui->isarCheckBox->isChecked();
+    QString auxFilePath;
+    if (!isGMTI && !isISAR) {
+        auxFilePath = ui->auxPathLineEdit->text();
+        if (auxFilePath.isEmpty()) {
+            QMessageBox::warning(this, "警告", "请选择一个AUX文件！");
+            return;
+        }
     }
-    else {
-        // 根据复选框状态决定是否传递AUX文件路径
-        if (ui->isarCheckBox->isChecked()) {
+
+    uint16_t currentImageNum = m_pipeline->allocateImageNumber();
+
+    // 打包在线程池中执行，传输交给流水线的 I/O 线程，界面线程只接收结果
+    m_pipeline->workerPool()->submit([this, isGMTI, isISAR, imageFilePath, auxFilePath, ipAddress, port, currentImageNum]() {
+        ImageTransferResult result;
+        QString packedPath;
+        if (isGMTI) {
+            qDebug() << "发送GMTI图像以及目标信息包。";
+            result = packGMTI(imageFilePath, currentImageNum, &packedPath);
+        } else if (isISAR) {
+            // 根据复选框状态决定是否传递AUX文件路径
             qDebug() << "发送ISAR图像，仅发送TIF文件。";
-            result = processAndTransferManualImage(imageFilePath, QString(), ipAddress, port, currentImageNum);
+            result = packManualImage(imageFilePath, QString(), currentImageNum, &packedPath);
         } else {
-            QString auxFilePath = ui->auxPathLineEdit->text();
-            if (auxFilePath.isEmpty()) {
-                QMessageBox::warning(this, "警告", "请选择一个AUX文件！");
-                return;
-            }
             qDebug() << "发送SAR图像，打包TIF和AUX文件。";
-            result = processAndTransferManualImage(imageFilePath, auxFilePath, ipAddress, port, currentImageNum);
+            result = packManualImage(imageFilePath, auxFilePath, currentImageNum, &packedPath);
         }
-    }
 
-    // 处理传输结果并更新日志
-    if (result.success) {
-        m_fileStatusMutex.lock();
-        m_imageLog[currentImageNum] = imageFilePath;
-        m_fileStatusMutex.unlock();
-        qDebug() << QString("手动数传成功。图片编号: %1, 文件路径: %2").arg(currentImageNum).arg(imageFilePath);
-    } else {
-        qDebug() << ("手动数传失败：" + result.message);
-    }
+        // 处理传输结果并更新日志
+        auto finished = [this, isGMTI, packedPath, imageFilePath, currentImageNum](const ImageTransferResult& result) {
+            if (isGMTI && !packedPath.isEmpty()) {
+                QFile::remove(packedPath);
+            }
+            if (result.success) {
+                m_pipeline->recordImagePath(currentImageNum, imageFilePath);
+                qDebug() << QString("手动数传成功。图片编号: %1, 文件路径: %2").arg(currentImageNum).arg(imageFilePath);
+            } else {
+                qDebug() << ("手动数传失败：" + result.message);
+            }
+        };
+        if (!result.success) {
+            QMetaObject::invokeMethod(this, [finished, result]() { finished(result); }, Qt::QueuedConnection);
+            return;
+        }
+        m_pipeline->productCache()->insertFile(currentImageNum, packedPath);
+        m_pipeline->transferFile(packedPath, ipAddress, port, this, finished);
+    });
 }
 
 // 槽函数：SAR复选框状态改变
@@ -392,16 +560,38 @@ void MainWindow::on_toggleMonitorButton_clicked()
             return;
         }
 
-        bool isGMTI = ui->GMTICheckBox->isChecked();
-        fileMonitor->setMainFolder(mainFolderPath);
-        fileMonitor->start(isGMTI); // ✅ 调用新的 start 函数
+        // 界面上填写的根目录，加上配置文件中的其他根目录，共用同一条链路
+        MonitorRootConfig mainRoot;
+        mainRoot.name = "main";
+        mainRoot.path = mainFolderPath;
+        mainRoot.productType = ui->GMTICheckBox->isChecked() ? ProductType::GMTI : ProductType::SAR;
+        mainRoot.destinationHost = ipAddress;
+        mainRoot.destinationPort = port;
+        QList<MonitorRootConfig> roots{mainRoot};
+        QSettings settings(defaultConfigPath(), QSettings::IniFormat);
+        roots += loadMonitorRoots(settings);
+        m_pipeline->journal()->setSyncOnAppend(loadJournalSync(settings));
+        m_pipeline->scheduler()->setOverloadPolicy(loadOverloadPolicy(settings));
+        const LinkConfig link = loadLinkConfig(settings);
+        m_pipeline->scheduler()->setMaxInFlight(link.maxInFlight);
+        m_pipeline->setTransferOptions(link.transfer);
+        m_pipeline->setProgressiveSettings(loadProgressiveSettings(settings));
+        m_pipeline->setTileSettings(loadTileSettings(settings));
+        m_pipeline->setDeltaSettings(loadDeltaSettings(settings));
+        setImageCodecSettings(loadCodecSettings(settings));
+
+        m_pipeline->setRoots(roots);
+        if (!m_pipeline->start()) {
+            QMessageBox::warning(this, "警告", "启动监控失败。");
+            return;
+        }
 
         m_isMonitoring = true;
         ui->toggleMonitorButton->setText("停止监控");
         qDebug() << "开始监控文件夹：" << mainFolderPath;
     } else {
         // 当前为运行状态，执行停止操作
-        fileMonitor->stop();
+        m_pipeline->stop();
         m_isMonitoring = false;
         ui->toggleMonitorButton->setText("开始监控");
         qDebug() << "停止监控。";
@@ -417,72 +607,54 @@ void MainWindow::on_browseButton_clicked()
     }
 }
 
-// ✅ 修改后的 processAndTransferFile 槽函数
-void MainWindow::processAndTransferFile(const QString &filePath)
+// 自动传输完成后由流水线通知，界面只负责展示
+void MainWindow::onProductFinished(const TransferJob &job, bool success, const QString &message)
 {
-    QMutexLocker locker(&m_fileStatusMutex);
-    if (m_fileStatus.contains(filePath) && m_fileStatus.value(filePath) != Success && m_fileStatus.value(filePath) != Failure) {
-        qDebug() << "File" << filePath << "is already being processed. Skipping duplicate signal.";
-        return;
-    }
-    m_fileStatus[filePath] = Pending;
-
-    uint16_t currentImageNum = m_imageCounter++;
-    locker.unlock();
-
-    qDebug() << "Processing new file:" << filePath;
-    ipAddress = ui->ipAddressLineEdit->text();
-    port = ui->portLineEdit->text().toUShort();
-
-    ImageTransferResult result;
-
-    if (QFileInfo(filePath).suffix().toLower() == "bin") {
-        qDebug() << "Detected a .bin file. Processing in GMTI mode.";
-        result = processAndTransferGMTI(filePath, ipAddress, port, currentImageNum);
-    } else if (QFileInfo(filePath).suffix().toLower() == "tif") {
-        qDebug() << "Detected a .tif file. Processing in SAR/ISAR mode.";
-        result = processAndTransferImage(filePath, ipAddress, port, currentImageNum);
-    } else {
-        qWarning() << "Unsupported file type detected:" << filePath;
-        result.success = false;
-        result.message = "Unsupported file type";
-    }
+    Q_UNUSED(message);
+    qDebug() << "File" << job.product.imagePath << (success ? "processed successfully." : "failed to process.");
+}
 
-    locker.relock();
-    m_fileStatus[filePath] = result.success ? Success : Failure;
-    if (result.success) {
-        m_imageLog[currentImageNum] = filePath;
-        qDebug() << QString("自动数传成功。图片编号: %1, 文件路径: %2").arg(currentImageNum).arg(filePath);
-    } else {
-        qDebug() << ("自动数传失败：" + result.message);
+void MainWindow::onProductProgress(const TransferJob &job, const QString &stage)
+{
+    if (ui->label_currentFile) {
+        ui->label_currentFile->setText(QString("[%1] %2 %3")
+                                           .arg(job.rootName, stage, QFileInfo(job.product.imagePath).fileName()));
     }
-    locker.unlock();
-    updateStatistics();
-    qDebug() << "File" << filePath << (result.success ? "processed successfully." : "failed to process.");
 }
 
-// 接收日志消息的槽函数
+// 其他模块通过信号上报的日志，统一交给 LogManager 限速、落盘并批量显示
 void MainWindow::onLogMessage(const QString &message)
 {
-    if (ui->textEdit_Log) {
-        ui->textEdit_Log->append(message);
+    qInfo().noquote() << message;
+}
+
+// 接收一批日志行，一次性追加到显示区
+void MainWindow::onLogBatch(const QStringList &lines)
+{
+    QTextEdit *log = ui->textEdit_Log;
+    QScrollBar *scrollBar = log->verticalScrollBar();
+    const bool atBottom = scrollBar->value() == scrollBar->maximum();
+    QTextCursor cursor(log->document());
+    cursor.movePosition(QTextCursor::End);
+    if (!log->document()->isEmpty()) {
+        cursor.insertBlock();
+    }
+    cursor.insertText(lines.join(QLatin1Char('\n')));
+    // 用户向上翻看历史时不强制滚动到底部
+    if (atBottom) {
+        scrollBar->setValue(scrollBar->maximum());
     }
 }
 
 // 更新统计标签的槽函数
 void MainWindow::updateStatistics()
 {
-    int totalFiles = m_fileStatus.size();
-    int successFiles = 0;
-    int failedFiles = 0;
-
-    for (FileStatus status : m_fileStatus.values()) {
-        if (status == Success) {
-            successFiles++;
-        } else if (status == Failure) {
-            failedFiles++;
-        }
-    }
+    // 计数由日志索引增量维护，无需遍历全部记录
+    const ProductJournal* journal = m_pipeline->journal();
+    int totalFiles = journal->size();
+    int successFiles = journal->countInState(ProductState::Sent) + journal->countInState(ProductState::Acked);
+    int failedFiles = journal->countInState(ProductState::Failed);
+    const TransferScheduler* scheduler = m_pipeline->scheduler();
 
     if (ui->label_total) {
         ui->label_total->setText(QString("总文件数：%1").arg(totalFiles));
@@ -491,7 +663,19 @@ void MainWindow::updateStatistics()
         ui->label_success->setText(QString("成功发送：%1").arg(successFiles));
     }
     if (ui->label_failed) {
-        ui->label_failed->setText(QString("发送失败：%1").arg(failedFiles));
+        ui->label_failed->setText(QString("发送失败：%1  丢弃：%2  延后：%3")
+                                      .arg(failedFiles)
+                                      .arg(journal->countInState(ProductState::Dropped))
+                                      .arg(scheduler->deferredCount()));
+    }
+    if (ui->label_speed) {
+        const TransferMetrics* metrics = m_pipeline->metrics();
+        ui->label_speed->setText(QString("传输速度：%1M/s  %2 个/分钟  排队：%3  在途：%4  端到端 P95：%5 s")
+                                     .arg(metrics->bytesPerSecond() / (1024.0 * 1024.0), 0, 'f', 2)
+                                     .arg(metrics->productsPerSecond() * 60.0, 0, 'f', 1)
+                                     .arg(scheduler->queuedCount())
+                                     .arg(scheduler->inFlightCount())
+                                     .arg(metrics->latency(TransferStage::EndToEnd).valueAtPercentile(95) / 1000.0, 0, 'f', 1));
     }
 }
 
@@ -502,11 +686,7 @@ void MainWindow::updateStatistics()
  */
 QString MainWindow::getImagePath(uint16_t imageNum)
 {
-    QMutexLocker locker(&m_fileStatusMutex); // 使用互斥锁确保线程安全
-    if (m_imageLog.contains(imageNum)) {
-        return m_imageLog.value(imageNum);
-    }
-    return QString(); // 如果未找到，返回一个空的 QString
+    return m_pipeline->imagePath(imageNum); // 未找到时返回空的 QString
 }
 
 // 槽函数：演示查询功能
@@ -529,5 +709,25 @@ void MainWindow::on_queryImageButton_clicked()
     }
 }
 
+// 槽函数：按图像编号重发，缓存命中时不重新打包
+void MainWindow::on_resendImageButton_clicked()
+{
+    bool ok;
+    const uint16_t imageNum = ui->imageNumLineEdit->text().toUInt(&ok);
+    if (!ok) {
+        qCDebug(lcUi) << "重发失败：请输入一个有效的图像编号。";
+        return;
+    }
+    const QString host = ui->ipAddressLineEdit->text();
+    const quint16 destPort = ui->portLineEdit->text().toUShort();
+    m_pipeline->resendImage(imageNum, host, destPort, this, [imageNum](const ImageTransferResult& result) {
+        if (result.success) {
+            qCDebug(lcUi) << QString("重发成功。图片编号: %1，%2 字节").arg(imageNum).arg(result.bytesSent);
+        } else {
+            qCDebug(lcUi) << QString("重发图像 %1 失败：%2").arg(imageNum).arg(result.message);
+        }
+    });
+}
+
 
 
@@ -5,14 +5,22 @@
 #include <QQueue>
 #include <QMap>
 #include <QSet>
+#include <QHash>
+#include <QStringList>
 #include <QMutex>
 #include <QPushButton>
 #include <QCheckBox>
 #include <QLineEdit>
+#include <QFileSystemWatcher>
 #include "tcp_server_thread.h"
-#include "file_monitor.h"
 #include "message_transfer.h"
 #include "image_transfer.h"
+#include "transfer_pipeline.h"
+#include "metrics_server.h"
+#include "isar_request_queue.h"
+#include "slc_chip.h"
+
+class QListWidgetItem;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -28,13 +36,16 @@ public:
     ~MainWindow();
 
 private:
-    FileMonitor* fileMonitor;
+    TransferPipeline* m_pipeline;
+    MetricsServer* m_metricsServer;
 
 private slots:
     void on_browseButton_clicked();
     void on_sendMessageButton_clicked();
     void onLogMessage(const QString &message);
-    void processAndTransferFile(const QString &filePath);
+    void onLogBatch(const QStringList &lines);
+    void onProductFinished(const TransferJob &job, bool success, const QString &message);
+    void onProductProgress(const TransferJob &job, const QString &stage);
     void on_selectImageButton_clicked();
     void on_selectAuxButton_clicked();
     void on_manualSendButton_clicked();
@@ -46,7 +57,11 @@ private slots:
     void onServerStopped(); // 新增：服务器成功停止时更新UI的槽
     void on_sendTestDataButton_clicked();
     void onReceivedIsarRequest(quint16 imageNumber, quint16 offsetX, quint16 offsetY);
+    void onIsarRequestChanged(const IsarRequest &request);
+    void onReceivedRoiRequest(quint16 imageNumber, qint16 x, qint16 y, quint16 width, quint16 height, quint8 jpegQuality);
+    void onReceivedRetransmitRequest(quint16 imageNumber, const QList<quint16> &packets);
     void on_queryImageButton_clicked();
+    void on_resendImageButton_clicked();
     void on_toggleMonitorButton_clicked();
 
 
@@ -59,7 +74,6 @@ private:
     QFileSystemWatcher* m_mainWatcher; // 新增：主文件夹监控器
     QFileSystemWatcher* m_subWatcher;  // 新增：子文件夹监控器
 
-    QMap<QString, FileStatus> m_fileStatus; // 文件状态映射
     QMutex m_mutex;
 
     qint64 m_fileSize;
@@ -77,11 +91,10 @@ private:
     QPushButton* manualSendButton;
     QButtonGroup* imageTypeButtonGroup;
 
-    // 全局计数器和日志记录器
-    uint16_t m_imageCounter = 1;
-    QMap<uint16_t, QString> m_imageLog;
-    QMutex m_fileStatusMutex;
-    quint16 m_isarRequestCounter;
+    IsarRequestQueue* m_isarQueue;
+    SlcChipService m_slcChips;      // ISAR 请求的 SLC 芯片直传，未启用时不使用
+    RoiSettings m_roiSettings;
+    QHash<quint32, QListWidgetItem*> m_isarItems;  // 请求编号 → 列表项
 
     TcpServerThread* m_tcpServerThreadObject;
     QThread* m_serverThread;
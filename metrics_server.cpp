@@ -0,0 +1,95 @@
+#include "metrics_server.h"
+#include "log_categories.h"
+#include <QDebug>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QVariant>
+
+// 请求头最大长度与空闲超时：只服务本机的抓取程序，超出即断开
+static const int MAX_REQUEST_BYTES = 8 * 1024;
+static const int REQUEST_TIMEOUT_MS = 5000;
+static const char* const REQUEST_BUFFER_PROPERTY = "metricsRequest";
+
+MetricsServer::MetricsServer(Provider provider, QObject* parent)
+    : QObject(parent),
+    m_server(new QTcpServer(this))
+{
+    addRoute("/metrics", std::move(provider), "text/plain; version=0.0.4; charset=utf-8");
+    connect(m_server, &QTcpServer::newConnection, this, &MetricsServer::onNewConnection);
+}
+
+MetricsServer::~MetricsServer() {
+    close();
+}
+
+void MetricsServer::addRoute(const QByteArray& path, Provider provider, const QByteArray& contentType) {
+    m_routes.insert(path, Route{std::move(provider), contentType});
+}
+
+bool MetricsServer::listen(quint16 port) {
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        qWarning() << "Metrics endpoint failed to listen on 127.0.0.1:" << port << ":" << m_server->errorString();
+        return false;
+    }
+    qCDebug(lcMetrics) << "Metrics endpoint listening on http://127.0.0.1:" << m_server->serverPort() << "/metrics";
+    return true;
+}
+
+void MetricsServer::close() {
+    m_server->close();
+}
+
+quint16 MetricsServer::port() const {
+    return m_server->serverPort();
+}
+
+void MetricsServer::onNewConnection() {
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { handleReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QTimer::singleShot(REQUEST_TIMEOUT_MS, socket, [socket]() { socket->abort(); });
+    }
+}
+
+void MetricsServer::handleReadyRead(QTcpSocket* socket) {
+    QByteArray request = socket->property(REQUEST_BUFFER_PROPERTY).toByteArray() + socket->readAll();
+    if (!request.contains("\r\n\r\n")) {
+        if (request.size() > MAX_REQUEST_BYTES) {
+            socket->abort();
+            return;
+        }
+        socket->setProperty(REQUEST_BUFFER_PROPERTY, request);
+        return;
+    }
+    socket->setProperty(REQUEST_BUFFER_PROPERTY, QVariant());
+
+    const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+    const QByteArray method = requestLine.value(0);
+    QByteArray path = requestLine.value(1);
+    const int query = path.indexOf('?');
+    if (query >= 0) {
+        path.truncate(query);
+    }
+
+    const auto route = m_routes.constFind(path);
+    if (method != "GET") {
+        respond(socket, "405 Method Not Allowed", "text/plain", "method not allowed\n");
+    } else if (route != m_routes.constEnd()) {
+        const QByteArray body = route->provider ? route->provider() : QByteArray();
+        respond(socket, "200 OK", route->contentType, body);
+    } else {
+        respond(socket, "404 Not Found", "text/plain", "see /metrics\n");
+    }
+}
+
+void MetricsServer::respond(QTcpSocket* socket, const QByteArray& status, const QByteArray& contentType, const QByteArray& body) {
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+    socket->write(response);
+    socket->disconnectFromHost();
+}
@@ -0,0 +1,51 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <functional>
+
+class QTcpServer;
+class QTcpSocket;
+
+/**
+ * @class MetricsServer
+ * @brief 只监听本机回环地址的极简 HTTP 服务，GET /metrics 返回 Prometheus 文本格式。
+ *
+ * 运行在创建它的线程（界面线程或守护进程主线程）的事件循环中，每个请求应答后即关闭连接；
+ * 指标内容由 provider 在请求到达时生成。其他只读页面（如 /timings）通过 addRoute() 挂载。
+ */
+class MetricsServer : public QObject {
+    Q_OBJECT
+public:
+    using Provider = std::function<QByteArray()>;
+
+    explicit MetricsServer(Provider provider, QObject* parent = nullptr);
+    ~MetricsServer();
+
+    // 挂载额外的 GET 路径，例如 "/timings"
+    void addRoute(const QByteArray& path, Provider provider, const QByteArray& contentType = "text/plain; charset=utf-8");
+
+    // 绑定 127.0.0.1:port
+    bool listen(quint16 port);
+    void close();
+    quint16 port() const;
+
+private slots:
+    void onNewConnection();
+
+private:
+    void handleReadyRead(QTcpSocket* socket);
+    void respond(QTcpSocket* socket, const QByteArray& status, const QByteArray& contentType, const QByteArray& body);
+
+    struct Route {
+        Provider provider;
+        QByteArray contentType;
+    };
+
+    QHash<QByteArray, Route> m_routes;
+    QTcpServer* m_server;
+};
+
+#endif // METRICS_SERVER_H
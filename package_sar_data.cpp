@@ -1,15 +1,41 @@
 #include "package_sar_data.h"
+#include "log_categories.h"
 #include "AuxFileReader.h"
+#include "product_timing.h"
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <cmath>
 #include <cstring>
 #include <QDebug>
 #include <QImage>
 #include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
 #include <QBuffer>
 #include <QImageReader>
 #include <QImageWriter>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+static std::atomic<int> s_jpegQuality{80};
+static std::atomic<int> s_allocationLimitMB{1024};
+static std::atomic<bool> s_progressiveJpeg{false};
+
+void setImageCodecSettings(const ImageCodecSettings& settings) {
+    s_jpegQuality.store(qBound(0, settings.jpegQuality, 100));
+    s_allocationLimitMB.store(qMax(0, settings.allocationLimitMB));
+    s_progressiveJpeg.store(settings.progressiveJpeg);
+}
+
+ImageCodecSettings imageCodecSettings() {
+    ImageCodecSettings settings;
+    settings.jpegQuality = s_jpegQuality.load();
+    settings.allocationLimitMB = s_allocationLimitMB.load();
+    settings.progressiveJpeg = s_progressiveJpeg.load();
+    return settings;
+}
 
 // 计算校验和的辅助函数
 uint8_t calculate_checksum(const uint8_t* data, size_t length) {
@@ -112,21 +138,125 @@ SAR_DataInfo createSarDataInfo(const AuxHeader& auxHeader, uint32_t imageSize, u
     // 侧视方向 (164d): 协议指定 0x00 为左侧视，此处假设为左侧视
     dataInfo.side_look_dir = 0x00;
 
-    // 校验和字段先置零
-    dataInfo.checksum = 0;
+    finalizeSarDataInfoChecksum(dataInfo);
 
-    // 计算并填充校验和
+    return dataInfo;
+}
+
+void finalizeSarDataInfoChecksum(SAR_DataInfo& dataInfo) {
     // 校验和从第三字节开始（消息地址字）到校验和字段前一位
     // 即从地址 2d 到 168d，对应字节索引 2 到 168
-    uint8_t* ptr = reinterpret_cast<uint8_t*>(&dataInfo);
+    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&dataInfo);
     dataInfo.checksum = calculate_checksum(ptr + sizeof(uint16_t), sizeof(SAR_DataInfo) - sizeof(uint16_t) - sizeof(uint8_t));
+}
 
-    return dataInfo;
+// 将 SAR_DataInfo 与图像数据组成完整消息，按 4096 字节拆分为 SAR_Frame 追加写入 out
+static bool writeFramedMessage(QIODevice* out, const SAR_DataInfo& dataInfo, const QByteArray& imageData, uint16_t image_num)
+{
+    QByteArray fullMessage;
+    fullMessage.append(reinterpret_cast<const char*>(&dataInfo), sizeof(SAR_DataInfo));
+    fullMessage.append(imageData);
+
+    qint64 totalPackets = (fullMessage.size() + 4096 - 1) / 4096;
+    qint64 currentOffset = 0;
+
+    for (int i = 0; i < totalPackets; ++i) {
+        SAR_Frame header;
+        memset(&header, 0, sizeof(SAR_Frame));
+
+        qint64 payloadSize = qMin(static_cast<qint64>(4096), fullMessage.size() - currentOffset);
+        QByteArray payload = fullMessage.mid(currentOffset, payloadSize);
+
+        header.fixed_value = 0x90E9;
+        header.image_number = image_num;
+        header.image_size = imageData.size(); // 图像数据（JPG）大小，不含 SAR_DataInfo
+        header.current_packet = i + 1;
+        header.total_packets = totalPackets;
+        header.data_length = payloadSize;
+        header.checksum = calculate_checksum(reinterpret_cast<const uint8_t*>(payload.constData()), payload.size());
+
+        if (out->write(reinterpret_cast<const char*>(&header), sizeof(SAR_Frame)) != sizeof(SAR_Frame)
+            || out->write(payload) != payload.size()) {
+            qWarning() << "Failed to write frame" << i + 1 << "of image" << image_num << ":" << out->errorString();
+            return false;
+        }
+
+        currentOffset += payloadSize;
+    }
+    return true;
+}
+
+// 单个消息写成一个bin文件
+static bool writeFramedBinFile(const QString& outputBinFilePath, const SAR_DataInfo& dataInfo, const QByteArray& imageData, uint16_t image_num)
+{
+    QFile binFile(outputBinFilePath);
+    if (!binFile.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open bin file for writing:" << outputBinFilePath;
+        return false;
+    }
+    const bool written = writeFramedMessage(&binFile, dataInfo, imageData, image_num);
+    binFile.close();
+    return written;
+}
+
+// 在打包线程与至多 threads-1 个临时线程上按序号领取并执行 body(0..count-1)。
+// 打包本身已在 WorkerPool 中并行，单个产品的线程数由调用方配置给出上限，避免多个产品同时打包时线程成倍超出核数
+static void parallelEncode(int count, int threads, const std::function<void(int)>& body)
+{
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            body(i);
+        }
+    };
+    const int hardware = int(qMax(1u, std::thread::hardware_concurrency()));
+    const int total = qMin(qBound(1, threads, hardware), count);
+    std::vector<std::thread> pool;
+    for (int i = 1; i < total; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+// 整幅图像四角经纬度双线性插值到 (row, col)
+static void interpolateCorner(const AuxHeader& aux, double row, double col, double* lat, double* lng) {
+    const double v = aux.pulse_num > 1 ? row / double(aux.pulse_num - 1) : 0.0;
+    const double u = aux.pulse_len > 1 ? col / double(aux.pulse_len - 1) : 0.0;
+    *lat = (1 - v) * ((1 - u) * aux.lat11 + u * aux.lat1N) + v * ((1 - u) * aux.latM1 + u * aux.latMN);
+    *lng = (1 - v) * ((1 - u) * aux.lng11 + u * aux.lng1N) + v * ((1 - u) * aux.lngM1 + u * aux.lngMN);
+}
+
+// 整图产品的尺寸：行数按 Xbin/Rbin 做方位向校正（与 createBinFileFromImageAndAux 一致）
+static QSize correctedImageSize(const QSize& sourceSize, const AuxHeader& auxHeader) {
+    double scaleFactor = 1.0;
+    if (!qFuzzyCompare(auxHeader.Xbin, auxHeader.Rbin) && auxHeader.Rbin != 0) {
+        scaleFactor = auxHeader.Xbin / auxHeader.Rbin;
+    }
+    return QSize(sourceSize.width(), qRound(sourceSize.height() * scaleFactor));
+}
+
+AuxHeader auxHeaderForRegion(const AuxHeader& auxHeader, qint64 row0, qint64 col0, qint64 rows, qint64 cols) {
+    AuxHeader result = auxHeader;
+    result.pulse_num = rows;
+    result.pulse_len = cols;
+    const qint64 lastRow = row0 + rows - 1;
+    const qint64 lastCol = col0 + cols - 1;
+    interpolateCorner(auxHeader, row0, col0, &result.lat11, &result.lng11);
+    interpolateCorner(auxHeader, row0, lastCol, &result.lat1N, &result.lng1N);
+    interpolateCorner(auxHeader, lastRow, col0, &result.latM1, &result.lngM1);
+    interpolateCorner(auxHeader, lastRow, lastCol, &result.latMN, &result.lngMN);
+    return result;
 }
 
 // =================== 新增离线打包函数 ===================
-bool createBinFileFromTifAndAux(const QString& tifFilePath, const QString& auxFilePath, const QString& outputBinFilePath, uint16_t image_num)
+bool createBinFileFromTifAndAux(const QString& tifFilePath, const QString& auxFilePath, const QString& outputBinFilePath, uint16_t image_num, ProductTiming* timing)
 {
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+
     // 1. 读取AUX文件，获取SAR数据和bin值
     AuxFileReader auxReader;
     if (!auxReader.read(auxFilePath)) {
@@ -134,8 +264,6 @@ bool createBinFileFromTifAndAux(const QString& tifFilePath, const QString& auxFi
         return false;
     }
     const AuxHeader& auxHeader = auxReader.getHeader();
-    double xBin = auxHeader.Xbin;
-    double rBin = auxHeader.Rbin;
 
     // 2. 加载TIF文件到QImage
     QImageReader reader(tifFilePath);
@@ -144,7 +272,7 @@ bool createBinFileFromTifAndAux(const QString& tifFilePath, const QString& auxFi
         return false;
     }
 
-    const int newMemoryLimitMB = 1024;
+    const int newMemoryLimitMB = s_allocationLimitMB.load();
     qDebug() << "Setting QImageReader allocation limit to" << newMemoryLimitMB << "MB.";
     reader.setAllocationLimit(newMemoryLimitMB);
 
@@ -154,6 +282,17 @@ bool createBinFileFromTifAndAux(const QString& tifFilePath, const QString& auxFi
         qWarning() << "Reader error:" << reader.errorString();
         return false;
     }
+    markStage(timing, TimingStage::Decode, stageTimer, image_num);
+
+    return createBinFileFromImageAndAux(originalTifImage, auxHeader, outputBinFilePath, image_num, timing);
+}
+
+bool createBinFileFromImageAndAux(const QImage& originalTifImage, const AuxHeader& auxHeader, const QString& outputBinFilePath, uint16_t image_num, ProductTiming* timing)
+{
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+    const double xBin = auxHeader.Xbin;
+    const double rBin = auxHeader.Rbin;
 
     // --- 3. 图像校正核心逻辑（在内存中进行） ---
     QImage correctedTifImage = originalTifImage; // 默认值，如果不需要校正则使用原始图像
@@ -173,6 +312,7 @@ bool createBinFileFromTifAndAux(const QString& tifFilePath, const QString& auxFi
             Qt::IgnoreAspectRatio,
             Qt::SmoothTransformation
             );
+        markStage(timing, TimingStage::Resample, stageTimer, image_num);
     } else {
         qDebug() << "Xbin and Rbin are equal or Rbin is zero. Skipping image correction.";
     }
@@ -183,11 +323,13 @@ bool createBinFileFromTifAndAux(const QString& tifFilePath, const QString& auxFi
     buffer.open(QIODevice::WriteOnly);
 
     QImageWriter writer(&buffer, "JPG");
-    writer.setQuality(80); // 设置JPG质量
+    writer.setQuality(s_jpegQuality.load()); // 设置JPG质量
+    writer.setProgressiveScanWrite(s_progressiveJpeg.load());
     if (!writer.write(correctedTifImage)) {
         qWarning() << "Failed to save corrected QImage to JPG buffer.";
         return false;
     }
+    markStage(timing, TimingStage::Encode, stageTimer, image_num);
 
     // 5. 准备SAR_DataInfo，使用校正后的图像尺寸
     // 注意：SAR_DataInfo中的图像行数和列数应该反映校正后的尺寸
@@ -197,49 +339,20 @@ bool createBinFileFromTifAndAux(const QString& tifFilePath, const QString& auxFi
 
     SAR_DataInfo dataInfo = createSarDataInfo(correctedAuxHeader, jpgData.size(), image_num);
 
-    // 6. 将 SAR_DataInfo 和 JPG 数据组合成完整数据包
-    QByteArray fullMessage;
-    fullMessage.append(reinterpret_cast<const char*>(&dataInfo), sizeof(SAR_DataInfo));
-    fullMessage.append(jpgData);
-
-    // 7. 将完整数据包拆分为帧并写入bin文件
-    QFile binFile(outputBinFilePath);
-    if (!binFile.open(QIODevice::WriteOnly)) {
-        qWarning() << "Failed to open bin file for writing:" << outputBinFilePath;
+    // 6. 将 SAR_DataInfo 和 JPG 数据组合成完整消息，拆分为帧写入bin文件
+    if (!writeFramedBinFile(outputBinFilePath, dataInfo, jpgData, image_num)) {
         return false;
     }
-
-    qint64 totalPackets = (fullMessage.size() + 4096 - 1) / 4096;
-    qint64 currentOffset = 0;
-
-    for (int i = 0; i < totalPackets; ++i) {
-        SAR_Frame header;
-        memset(&header, 0, sizeof(SAR_Frame));
-
-        qint64 payloadSize = qMin(static_cast<qint64>(4096), fullMessage.size() - currentOffset);
-        QByteArray payload = fullMessage.mid(currentOffset, payloadSize);
-
-        header.fixed_value = 0x90E9;
-        header.image_number = image_num;
-        header.image_size = jpgData.size(); // 仍然使用 JPG 数据大小
-        header.current_packet = i + 1;
-        header.total_packets = totalPackets;
-        header.data_length = payloadSize;
-        header.checksum = calculate_checksum(reinterpret_cast<const uint8_t*>(payload.constData()), payload.size());
-
-        binFile.write(reinterpret_cast<const char*>(&header), sizeof(SAR_Frame));
-        binFile.write(payload);
-
-        currentOffset += payloadSize;
-    }
-
-    binFile.close();
+    markStage(timing, TimingStage::Frame, stageTimer, image_num);
     qDebug() << "Successfully created bin file at:" << outputBinFilePath;
     return true;
 }
 
-bool createBinFileFromTifOnly(const QString& tifFilePath, const QString& outputBinFilePath, uint16_t image_num)
+bool createBinFileFromTifOnly(const QString& tifFilePath, const QString& outputBinFilePath, uint16_t image_num, ProductTiming* timing)
 {
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+
     // 1. 使用QImageReader来安全地读取TIF文件并转换为JPG数据
     QImageReader reader(tifFilePath);
     if (!reader.canRead()) {
@@ -247,7 +360,7 @@ bool createBinFileFromTifOnly(const QString& tifFilePath, const QString& outputB
         return false;
     }
 
-    const int newMemoryLimitMB = 1024;
+    const int newMemoryLimitMB = s_allocationLimitMB.load();
     qDebug() << "Setting QImageReader allocation limit to" << newMemoryLimitMB << "MB.";
     reader.setAllocationLimit(newMemoryLimitMB);
 
@@ -257,6 +370,7 @@ bool createBinFileFromTifOnly(const QString& tifFilePath, const QString& outputB
         qWarning() << "Reader error:" << reader.errorString();
         return false;
     }
+    markStage(timing, TimingStage::Decode, stageTimer, image_num);
 
     // 将读取的QImage数据保存为JPG格式到QByteArray
     QByteArray jpgData;
@@ -264,11 +378,12 @@ bool createBinFileFromTifOnly(const QString& tifFilePath, const QString& outputB
     buffer.open(QIODevice::WriteOnly);
 
     QImageWriter writer(&buffer, "JPG");
-    writer.setQuality(80); // 设置JPG质量
+    writer.setQuality(s_jpegQuality.load()); // 设置JPG质量
     if (!writer.write(tifImage)) {
         qWarning() << "Failed to save QImage to JPG buffer.";
         return false;
     }
+    markStage(timing, TimingStage::Encode, stageTimer, image_num);
 
     // 2. 准备 SAR_DataInfo，将所有AUX相关参数设置为0
     SAR_DataInfo dataInfo;
@@ -289,44 +404,569 @@ bool createBinFileFromTifOnly(const QString& tifFilePath, const QString& outputB
     uint8_t* ptr = reinterpret_cast<uint8_t*>(&dataInfo);
     dataInfo.checksum = calculate_checksum(ptr + sizeof(uint16_t), sizeof(SAR_DataInfo) - sizeof(uint16_t) - sizeof(uint8_t));
 
-    // 3. 将 SAR_DataInfo 和 JPG 数据组合成完整数据包
-    QByteArray fullMessage;
-    fullMessage.append(reinterpret_cast<const char*>(&dataInfo), sizeof(SAR_DataInfo));
-    fullMessage.append(jpgData);
+    // 3. 将 SAR_DataInfo 和 JPG 数据组合成完整消息，拆分为帧写入bin文件
+    if (!writeFramedBinFile(outputBinFilePath, dataInfo, jpgData, image_num)) {
+        return false;
+    }
+    markStage(timing, TimingStage::Frame, stageTimer, image_num);
+    qCDebug(lcPacking) << "Successfully created bin file from TIF only at:" << outputBinFilePath;
+    return true;
+}
+
+bool createPreviewBinFile(const QString& tifFilePath, const QString& auxFilePath, int scale, int jpegQuality,
+                          const QString& outputBinFilePath, uint16_t image_num, uint16_t full_image_num,
+                          ProductTiming* timing)
+{
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+
+    AuxFileReader auxReader;
+    if (!auxReader.read(auxFilePath)) {
+        qWarning() << "Failed to read AUX file:" << auxFilePath;
+        return false;
+    }
+    const AuxHeader& auxHeader = auxReader.getHeader();
+
+    QImageReader reader(tifFilePath);
+    if (!reader.canRead()) {
+        qWarning() << "QImageReader cannot read file:" << tifFilePath;
+        return false;
+    }
+    const QSize sourceSize = reader.size();
+    if (!sourceSize.isValid()) {
+        qWarning() << "Cannot determine image size of" << tifFilePath;
+        return false;
+    }
+
+    // 预览按整图产品（含方位向校正）的尺寸缩小
+    const QSize fullSize = correctedImageSize(sourceSize, auxHeader);
+    const int factor = qMax(2, scale);
+    const QSize previewSize(qMax(1, fullSize.width() / factor), qMax(1, fullSize.height() / factor));
+
+    reader.setAllocationLimit(s_allocationLimitMB.load());
+    reader.setScaledSize(previewSize);
+    QImage preview = reader.read();
+    if (preview.isNull()) {
+        qWarning() << "Failed to read preview of" << tifFilePath << ":" << reader.errorString();
+        return false;
+    }
+    if (preview.size() != previewSize) {
+        preview = preview.scaled(previewSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    markStage(timing, TimingStage::Decode, stageTimer, image_num);
+
+    QByteArray jpgData;
+    QBuffer buffer(&jpgData);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, "JPG");
+    writer.setQuality(qBound(0, jpegQuality, 100));
+    if (!writer.write(preview)) {
+        qWarning() << "Failed to save preview to JPG buffer.";
+        return false;
+    }
+    markStage(timing, TimingStage::Encode, stageTimer, image_num);
+
+    AuxHeader previewAux = auxHeader;
+    previewAux.pulse_num = preview.height();
+    previewAux.pulse_len = preview.width();
+    previewAux.Rbin = auxHeader.Rbin * double(fullSize.width()) / preview.width();
+    // 缩放时已按整图做过方位向校正，预览像素是方形的：Xbin 取与 Rbin 相同的值，
+    // previewAux 描述的就是预览本身，交给按 Xbin/Rbin 校正的代码时不会被再拉伸一次
+    previewAux.Xbin = previewAux.Rbin;
+    SAR_DataInfo dataInfo = createSarDataInfo(previewAux, jpgData.size(), image_num);
+    dataInfo.message_type = PREVIEW_MESSAGE_TYPE;
+    PreviewInfo previewInfo;
+    previewInfo.full_image_number = full_image_num;
+    previewInfo.full_rows = static_cast<uint16_t>(fullSize.height());
+    previewInfo.full_cols = static_cast<uint16_t>(fullSize.width());
+    previewInfo.scale = static_cast<uint8_t>(qMin(factor, 255));
+    memcpy(dataInfo.reserved2, &previewInfo, sizeof(PreviewInfo));
+    finalizeSarDataInfoChecksum(dataInfo);
+
+    if (!writeFramedBinFile(outputBinFilePath, dataInfo, jpgData, image_num)) {
+        return false;
+    }
+    markStage(timing, TimingStage::Frame, stageTimer, image_num);
+    qCDebug(lcPacking) << "Successfully created preview bin file at:" << outputBinFilePath << preview.size()
+             << "of" << fullSize << "," << jpgData.size() << "bytes";
+    return true;
+}
+
+// 瓦片边长不小于 64；按配置边长切出的瓦片超过 maxTiles 时放大边长，直到瓦片数不超过上限
+static int tileSizeFor(const QSize& fullSize, const TileSettings& settings)
+{
+    const int maxTiles = qBound(1, settings.maxTiles, 0xFFFF);
+    auto tileCount = [&](int size) {
+        return qint64((fullSize.width() + size - 1) / size) * ((fullSize.height() + size - 1) / size);
+    };
+    int tileSize = qMax(64, settings.tileSize);
+    if (tileCount(tileSize) > maxTiles) {
+        // 从按面积估计的边长开始逐步加大，瓦片数随边长单调不增
+        tileSize = qMax(tileSize, int(std::ceil(std::sqrt(double(fullSize.width()) * fullSize.height() / maxTiles))));
+        while (tileCount(tileSize) > maxTiles) {
+            ++tileSize;
+        }
+    }
+    return tileSize;
+}
+
+int tiledProductTileCount(const QString& tifFilePath, const QString& auxFilePath, const TileSettings& settings,
+                          int* tileSize)
+{
+    if (!settings.enabled) {
+        return 0;
+    }
+    AuxFileReader auxReader;
+    if (!auxReader.read(auxFilePath)) {
+        return 0;
+    }
+    const QSize sourceSize = QImageReader(tifFilePath).size();
+    if (!sourceSize.isValid()) {
+        return 0;
+    }
+    const QSize fullSize = correctedImageSize(sourceSize, auxReader.getHeader());
+    if (qMax(fullSize.width(), fullSize.height()) <= settings.minSide) {
+        return 0;
+    }
+    const int size = tileSizeFor(fullSize, settings);
+    if (tileSize) {
+        *tileSize = size;
+    }
+    return ((fullSize.width() + size - 1) / size) * ((fullSize.height() + size - 1) / size);
+}
+
+bool createTiledBinFile(const QString& tifFilePath, const QString& auxFilePath, const TileSettings& settings,
+                        uint16_t parent_image_num, const QList<uint16_t>& tileNumbers,
+                        const QString& outputBinFilePath, ProductTiming* timing)
+{
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+
+    AuxFileReader auxReader;
+    if (!auxReader.read(auxFilePath)) {
+        qWarning() << "Failed to read AUX file:" << auxFilePath;
+        return false;
+    }
+    const AuxHeader& auxHeader = auxReader.getHeader();
+
+    QImageReader reader(tifFilePath);
+    if (!reader.canRead()) {
+        qWarning() << "QImageReader cannot read file:" << tifFilePath;
+        return false;
+    }
+    reader.setAllocationLimit(s_allocationLimitMB.load());
+    QImage corrected = reader.read();
+    if (corrected.isNull()) {
+        qWarning() << "Failed to load TIF image into QImage:" << reader.errorString();
+        return false;
+    }
+    markStage(timing, TimingStage::Decode, stageTimer, parent_image_num);
+
+    const QSize fullSize = correctedImageSize(corrected.size(), auxHeader);
+    if (corrected.size() != fullSize) {
+        corrected = corrected.scaled(fullSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        markStage(timing, TimingStage::Resample, stageTimer, parent_image_num);
+    }
+
+    const int tileSize = tileSizeFor(fullSize, settings);
+    const int tileCols = (fullSize.width() + tileSize - 1) / tileSize;
+    const int tileRows = (fullSize.height() + tileSize - 1) / tileSize;
+    const int tileCount = tileCols * tileRows;
+    if (tileNumbers.size() != tileCount) {
+        qWarning() << "Tiled product needs" << tileCount << "image numbers, got" << tileNumbers.size();
+        return false;
+    }
+    auto tileRect = [&](int index) {
+        const int x = (index % tileCols) * tileSize;
+        const int y = (index / tileCols) * tileSize;
+        return QRect(x, y, qMin(tileSize, fullSize.width() - x), qMin(tileSize, fullSize.height() - y));
+    };
+
+    // 各瓦片互不依赖，按序号并行编码；写文件仍按行优先顺序进行
+    std::vector<QByteArray> encoded(static_cast<size_t>(tileCount));
+    const int quality = s_jpegQuality.load();
+    const bool progressive = s_progressiveJpeg.load();
+    parallelEncode(tileCount, settings.threads, [&](int t) {
+        QByteArray& jpgData = encoded[size_t(t)];
+        QBuffer buffer(&jpgData);
+        buffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&buffer, "JPG");
+        writer.setQuality(quality);
+        writer.setProgressiveScanWrite(progressive);
+        if (!writer.write(corrected.copy(tileRect(t)))) {
+            jpgData.clear();
+        }
+    });
+    markStage(timing, TimingStage::Encode, stageTimer, parent_image_num);
+
+    // 瓦片四角按校正后整图的行列插值（整图四角不变，只是行数变为校正后的行数）
+    AuxHeader correctedAux = auxHeader;
+    correctedAux.pulse_num = fullSize.height();
+    correctedAux.pulse_len = fullSize.width();
 
-    // 4. 将完整数据包拆分为帧并写入bin文件
     QFile binFile(outputBinFilePath);
     if (!binFile.open(QIODevice::WriteOnly)) {
         qWarning() << "Failed to open bin file for writing:" << outputBinFilePath;
         return false;
     }
+    qint64 totalBytes = 0;
+    for (int t = 0; t < tileCount; ++t) {
+        const QByteArray& jpgData = encoded[size_t(t)];
+        if (jpgData.isEmpty()) {
+            qWarning() << "Failed to encode tile" << t << "of" << tifFilePath;
+            return false;
+        }
+        const QRect rect = tileRect(t);
+        const uint16_t tileNumber = tileNumbers.at(t);
+        const AuxHeader tileAux = auxHeaderForRegion(correctedAux, rect.y(), rect.x(), rect.height(), rect.width());
+        SAR_DataInfo dataInfo = createSarDataInfo(tileAux, jpgData.size(), tileNumber);
+        dataInfo.message_type = TILE_MESSAGE_TYPE;
+        TileInfo tileInfo;
+        tileInfo.parent_image_number = parent_image_num;
+        tileInfo.tile_index = static_cast<uint16_t>(t);
+        tileInfo.tile_count = static_cast<uint16_t>(tileCount);
+        tileInfo.x = static_cast<uint16_t>(rect.x());
+        tileInfo.y = static_cast<uint16_t>(rect.y());
+        tileInfo.full_rows = static_cast<uint16_t>(fullSize.height());
+        tileInfo.full_cols = static_cast<uint16_t>(fullSize.width());
+        memcpy(dataInfo.reserved2, &tileInfo, sizeof(TileInfo));
+        finalizeSarDataInfoChecksum(dataInfo);
+        if (!writeFramedMessage(&binFile, dataInfo, jpgData, tileNumber)) {
+            return false;
+        }
+        totalBytes += jpgData.size();
+    }
+    binFile.close();
+    markStage(timing, TimingStage::Frame, stageTimer, parent_image_num);
+    qCDebug(lcPacking) << "Successfully created tiled bin file at:" << outputBinFilePath << tileCols << "x" << tileRows
+             << "tiles of" << fullSize << "," << totalBytes << "bytes";
+    return true;
+}
 
-    qint64 totalPackets = (fullMessage.size() + 4096 - 1) / 4096;
-    qint64 currentOffset = 0;
+// 把 8 位灰度图 src 拷到 dst 的 at 处，超出 dst 的部分截掉
+static void copyGrayRegion(const QImage& src, QImage* dst, const QPoint& at)
+{
+    const QRect target = QRect(at, src.size()).intersected(dst->rect());
+    for (int y = target.top(); y <= target.bottom(); ++y) {
+        memcpy(dst->scanLine(y) + target.x(), src.constScanLine(y - at.y()) + (target.x() - at.x()), size_t(target.width()));
+    }
+}
 
-    for (int i = 0; i < totalPackets; ++i) {
-        SAR_Frame header;
-        memset(&header, 0, sizeof(SAR_Frame));
+QImage decodePackedSarImage(const QString& binFilePath)
+{
+    QFile binFile(binFilePath);
+    if (!binFile.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open bin file for decoding:" << binFilePath;
+        return QImage();
+    }
+    const QByteArray frames = binFile.readAll();
+
+    // 与接收端一样按帧头重组各消息：图像编号变化或包序号回到 1 即为新消息
+    QList<QByteArray> messages;
+    qint64 offset = 0;
+    while (offset + qint64(sizeof(SAR_Frame)) <= frames.size()) {
+        const SAR_Frame* header = reinterpret_cast<const SAR_Frame*>(frames.constData() + offset);
+        if (offset + qint64(sizeof(SAR_Frame)) + header->data_length > frames.size()) {
+            qWarning() << "Bin file is truncated at offset" << offset << ":" << binFilePath;
+            return QImage();
+        }
+        const bool newMessage = messages.isEmpty() || header->current_packet == 1;
+        if (newMessage) {
+            messages.append(QByteArray());
+        }
+        messages.last().append(frames.constData() + offset + sizeof(SAR_Frame), header->data_length);
+        offset += qint64(sizeof(SAR_Frame)) + header->data_length;
+    }
 
-        qint64 payloadSize = qMin(static_cast<qint64>(4096), fullMessage.size() - currentOffset);
-        QByteArray payload = fullMessage.mid(currentOffset, payloadSize);
+    QImage result;
+    for (const QByteArray& message : messages) {
+        if (message.size() < qsizetype(sizeof(SAR_DataInfo))) {
+            return QImage();
+        }
+        SAR_DataInfo dataInfo;
+        memcpy(&dataInfo, message.constData(), sizeof(SAR_DataInfo));
+        const QImage image = QImage::fromData(message.mid(qsizetype(sizeof(SAR_DataInfo))), "JPG").convertToFormat(QImage::Format_Grayscale8);
+        if (image.isNull()) {
+            qWarning() << "Failed to decode message of type" << dataInfo.message_type << "in" << binFilePath;
+            return QImage();
+        }
+        if (dataInfo.message_type != TILE_MESSAGE_TYPE) {
+            result = image;
+            continue;
+        }
+        TileInfo tileInfo;
+        memcpy(&tileInfo, dataInfo.reserved2, sizeof(TileInfo));
+        if (result.isNull()) {
+            result = QImage(tileInfo.full_cols, tileInfo.full_rows, QImage::Format_Grayscale8);
+            result.fill(0);
+        }
+        copyGrayRegion(image, &result, QPoint(tileInfo.x, tileInfo.y));
+    }
+    return result;
+}
 
-        header.fixed_value = 0x90E9;
-        header.image_number = image_num;
-        header.image_size = jpgData.size();
-        header.current_packet = i + 1;
-        header.total_packets = totalPackets;
-        header.data_length = payloadSize;
-        header.checksum = calculate_checksum(reinterpret_cast<const uint8_t*>(payload.constData()), payload.size());
+bool createDeltaBinFile(const QString& tifFilePath, const QString& auxFilePath, const DeltaSettings& settings,
+                        const DeltaBase& base, const QString& outputBinFilePath, uint16_t image_num,
+                        QImage* reconstructed, int* changedTiles, int* totalTiles, ProductTiming* timing)
+{
+    QElapsedTimer stageTimer;
+    stageTimer.start();
 
-        binFile.write(reinterpret_cast<const char*>(&header), sizeof(SAR_Frame));
-        binFile.write(payload);
+    AuxFileReader auxReader;
+    if (!auxReader.read(auxFilePath)) {
+        qWarning() << "Failed to read AUX file:" << auxFilePath;
+        return false;
+    }
+    const AuxHeader& auxHeader = auxReader.getHeader();
 
-        currentOffset += payloadSize;
+    QImageReader reader(tifFilePath);
+    if (!reader.canRead()) {
+        qWarning() << "QImageReader cannot read file:" << tifFilePath;
+        return false;
+    }
+    reader.setAllocationLimit(s_allocationLimitMB.load());
+    QImage gray = reader.read();
+    if (gray.isNull()) {
+        qWarning() << "Failed to load TIF image into QImage:" << reader.errorString();
+        return false;
     }
+    markStage(timing, TimingStage::Decode, stageTimer, image_num);
 
-    binFile.close();
-    qDebug() << "Successfully created bin file from TIF only at:" << outputBinFilePath;
+    const QSize fullSize = correctedImageSize(gray.size(), auxHeader);
+    if (gray.size() != fullSize) {
+        gray = gray.scaled(fullSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        markStage(timing, TimingStage::Resample, stageTimer, image_num);
+    }
+    gray = gray.convertToFormat(QImage::Format_Grayscale8);
+
+    AuxHeader correctedAux = auxHeader;
+    correctedAux.pulse_num = fullSize.height();
+    correctedAux.pulse_len = fullSize.width();
+
+    const int tileSize = qMax(DELTA_BLOCK_SIZE, settings.tileSize / DELTA_BLOCK_SIZE * DELTA_BLOCK_SIZE);
+    const int tileCols = (fullSize.width() + tileSize - 1) / tileSize;
+    const int tileRows = (fullSize.height() + tileSize - 1) / tileSize;
+    const int tileCount = tileCols * tileRows;
+    *totalTiles = tileCount;
+
+    // 需要完整产品时不写文件，由调用方按未开启增量时的方式（整图或瓦片）打包
+    auto needFullProduct = [&]() {
+        *changedTiles = -1;
+        return true;
+    };
+
+    const bool canDelta = !base.image.isNull() && base.image.size() == fullSize
+        && base.image.format() == QImage::Format_Grayscale8
+        && base.chainLength < qMax(1, settings.keyframeInterval) && tileCount <= 0xFFFF;
+    if (!canDelta) {
+        return needFullProduct();
+    }
+
+    // 逐 16×16 块求绝对差之和，块平均差超过阈值即认为所在瓦片有变化
+    const int blockCols = (fullSize.width() + DELTA_BLOCK_SIZE - 1) / DELTA_BLOCK_SIZE;
+    const int blockRows = (fullSize.height() + DELTA_BLOCK_SIZE - 1) / DELTA_BLOCK_SIZE;
+    std::vector<quint32> sums(size_t(blockCols) * size_t(blockRows));
+    blockAbsDiffSums(gray.constBits(), gray.bytesPerLine(), base.image.constBits(), base.image.bytesPerLine(),
+                     fullSize.width(), fullSize.height(), sums.data());
+
+    const int blocksPerTile = tileSize / DELTA_BLOCK_SIZE;
+    const quint32 threshold = quint32(qMax(0, settings.blockThreshold));
+    std::vector<char> tileChanged(size_t(tileCount), 0);
+    for (int by = 0; by < blockRows; ++by) {
+        const int rows = qMin(DELTA_BLOCK_SIZE, fullSize.height() - by * DELTA_BLOCK_SIZE);
+        for (int bx = 0; bx < blockCols; ++bx) {
+            const int cols = qMin(DELTA_BLOCK_SIZE, fullSize.width() - bx * DELTA_BLOCK_SIZE);
+            if (sums[size_t(by) * blockCols + bx] > threshold * quint32(rows * cols)) {
+                tileChanged[size_t(by / blocksPerTile) * tileCols + bx / blocksPerTile] = 1;
+            }
+        }
+    }
+    QList<int> changed;
+    for (int t = 0; t < tileCount; ++t) {
+        if (tileChanged[size_t(t)]) {
+            changed.append(t);
+        }
+    }
+    if (changed.size() > settings.maxChangedFraction * tileCount) {
+        qCDebug(lcPacking) << "Delta of image" << image_num << "changes" << changed.size() << "of" << tileCount
+                 << "tiles, sending full product";
+        return needFullProduct();
+    }
+
+    auto tileRect = [&](int index) {
+        const int x = (index % tileCols) * tileSize;
+        const int y = (index / tileCols) * tileSize;
+        return QRect(x, y, qMin(tileSize, fullSize.width() - x), qMin(tileSize, fullSize.height() - y));
+    };
+
+    // 变化瓦片互不依赖，与 createTiledBinFile 一样并行编码，线程数由 settings.threads 限定（变化检测耗时计入 Encode）；
+    // 编码后随即解码，基准使用接收端实际看到的 JPEG 解码结果，有损误差不会在多次增量间累积
+    std::vector<QByteArray> encoded(static_cast<size_t>(changed.size()));
+    std::vector<QImage> decoded(static_cast<size_t>(changed.size()));
+    const int quality = s_jpegQuality.load();
+    const int changedCount = int(changed.size());
+    parallelEncode(changedCount, settings.threads, [&](int i) {
+        QByteArray& jpgData = encoded[size_t(i)];
+        QBuffer buffer(&jpgData);
+        buffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&buffer, "JPG");
+        writer.setQuality(quality);
+        if (!writer.write(gray.copy(tileRect(changed.at(i))))) {
+            jpgData.clear();
+            return;
+        }
+        decoded[size_t(i)] = QImage::fromData(jpgData, "JPG").convertToFormat(QImage::Format_Grayscale8);
+    });
+
+    // 接收端看到的图像：基准上覆盖解码后的变化瓦片（未变化瓦片的微小差异不累积，下一幅仍与此图比较）
+    QImage result = base.image.copy();
+    QByteArray imageData;
+    for (int i = 0; i < changedCount; ++i) {
+        const QByteArray& jpgData = encoded[size_t(i)];
+        if (jpgData.isEmpty()) {
+            qWarning() << "Failed to encode delta tile" << changed.at(i) << "of" << tifFilePath;
+            return false;
+        }
+        const QRect rect = tileRect(changed.at(i));
+        if (decoded[size_t(i)].size() != rect.size()) {
+            qWarning() << "Failed to decode delta tile" << changed.at(i) << "of" << tifFilePath;
+            return false;
+        }
+        DeltaTileHeader tileHeader;
+        tileHeader.x = static_cast<uint16_t>(rect.x());
+        tileHeader.y = static_cast<uint16_t>(rect.y());
+        tileHeader.width = static_cast<uint16_t>(rect.width());
+        tileHeader.height = static_cast<uint16_t>(rect.height());
+        tileHeader.jpeg_size = static_cast<uint32_t>(jpgData.size());
+        imageData.append(reinterpret_cast<const char*>(&tileHeader), sizeof(DeltaTileHeader));
+        imageData.append(jpgData);
+        copyGrayRegion(decoded[size_t(i)], &result, rect.topLeft());
+    }
+    markStage(timing, TimingStage::Encode, stageTimer, image_num);
+
+    SAR_DataInfo dataInfo = createSarDataInfo(correctedAux, imageData.size(), image_num);
+    dataInfo.message_type = DELTA_MESSAGE_TYPE;
+    DeltaInfo deltaInfo;
+    deltaInfo.base_image_number = base.imageNumber;
+    deltaInfo.full_rows = static_cast<uint16_t>(fullSize.height());
+    deltaInfo.full_cols = static_cast<uint16_t>(fullSize.width());
+    deltaInfo.tile_size = static_cast<uint16_t>(tileSize);
+    deltaInfo.changed_tiles = static_cast<uint16_t>(changedCount);
+    deltaInfo.total_tiles = static_cast<uint16_t>(tileCount);
+    memcpy(dataInfo.reserved2, &deltaInfo, sizeof(DeltaInfo));
+    finalizeSarDataInfoChecksum(dataInfo);
+    if (!writeFramedBinFile(outputBinFilePath, dataInfo, imageData, image_num)) {
+        return false;
+    }
+    markStage(timing, TimingStage::Frame, stageTimer, image_num);
+
+    *changedTiles = changedCount;
+    *reconstructed = result;
+    qCDebug(lcPacking) << "Successfully created delta bin file at:" << outputBinFilePath << changedCount << "of" << tileCount
+             << "tiles changed against image" << base.imageNumber << "," << imageData.size() << "bytes";
+    return true;
+}
+
+bool createBinFileFromTifRegion(const QString& tifFilePath, const QString& auxFilePath, const QRect& region, int jpegQuality,
+                                const QString& outputBinFilePath, uint16_t image_num, uint16_t source_image_num,
+                                QRect* actualRegion)
+{
+    QImageReader reader(tifFilePath);
+    if (!reader.canRead()) {
+        qWarning() << "QImageReader cannot read file:" << tifFilePath;
+        return false;
+    }
+    const QSize sourceSize = reader.size();
+    if (!sourceSize.isValid()) {
+        qWarning() << "Cannot determine image size of" << tifFilePath;
+        return false;
+    }
+
+    // 1. 整图发送时的方位向校正系数：接收端坐标的行号 = 源行号 × scaleFactor
+    bool hasAux = false;
+    AuxHeader auxHeader;
+    double scaleFactor = 1.0;
+    if (!auxFilePath.isEmpty() && QFileInfo::exists(auxFilePath)) {
+        AuxFileReader auxReader;
+        if (!auxReader.read(auxFilePath)) {
+            qWarning() << "Failed to read AUX file:" << auxFilePath;
+            return false;
+        }
+        auxHeader = auxReader.getHeader();
+        hasAux = true;
+        if (!qFuzzyCompare(auxHeader.Xbin, auxHeader.Rbin) && auxHeader.Rbin != 0) {
+            scaleFactor = auxHeader.Xbin / auxHeader.Rbin;
+        }
+    }
+    const QSize sentSize(sourceSize.width(), qRound(sourceSize.height() * scaleFactor));
+    const QRect sentRegion = region.intersected(QRect(QPoint(0, 0), sentSize));
+    if (sentRegion.isEmpty()) {
+        qWarning() << "ROI" << region << "is outside image" << sentSize;
+        return false;
+    }
+
+    // 2. 换算回源 TIF 的行范围，只解码这一块
+    const int sourceTop = qBound(0, int(std::floor(sentRegion.top() / scaleFactor)), sourceSize.height() - 1);
+    const int sourceBottom = qBound(sourceTop + 1, int(std::ceil((sentRegion.bottom() + 1) / scaleFactor)), sourceSize.height());
+    const QRect clipRect(sentRegion.left(), sourceTop, sentRegion.width(), sourceBottom - sourceTop);
+    reader.setAllocationLimit(s_allocationLimitMB.load());
+    reader.setClipRect(clipRect);
+    QImage crop = reader.read();
+    if (crop.isNull()) {
+        qWarning() << "Failed to read ROI" << clipRect << "from" << tifFilePath << ":" << reader.errorString();
+        return false;
+    }
+    if (scaleFactor != 1.0) {
+        crop = crop.scaled(crop.width(), qMax(1, qRound(crop.height() * scaleFactor)),
+                           Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    // 3. 高质量编码
+    QByteArray jpgData;
+    QBuffer buffer(&jpgData);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, "JPG");
+    writer.setQuality(qBound(0, jpegQuality, 100));
+    if (!writer.write(crop)) {
+        qWarning() << "Failed to save ROI to JPG buffer.";
+        return false;
+    }
+
+    // 4. SAR_DataInfo：有 AUX 时四角坐标取区域本身，区域与源图像编号写入 reserved2
+    const QRect cropInSent(sentRegion.left(), qRound(sourceTop * scaleFactor), crop.width(), crop.height());
+    SAR_DataInfo dataInfo;
+    if (hasAux) {
+        AuxHeader regionAux = auxHeaderForRegion(auxHeader, sourceTop, cropInSent.left(), sourceBottom - sourceTop, cropInSent.width());
+        regionAux.pulse_num = crop.height();
+        dataInfo = createSarDataInfo(regionAux, jpgData.size(), image_num);
+    } else {
+        memset(&dataInfo, 0, sizeof(SAR_DataInfo));
+        dataInfo.frame_header = 0x55AA;
+        dataInfo.data_length = sizeof(SAR_DataInfo) + jpgData.size();
+        dataInfo.message_count = image_num;
+        dataInfo.image_rows = static_cast<uint16_t>(crop.height());
+        dataInfo.image_cols = static_cast<uint16_t>(crop.width());
+        dataInfo.image_available_flag = 0xFFFF;
+    }
+    dataInfo.message_type = ROI_CROP_MESSAGE_TYPE;
+    RoiCropInfo roiInfo;
+    roiInfo.source_image_number = source_image_num;
+    roiInfo.x = static_cast<uint16_t>(cropInSent.left());
+    roiInfo.y = static_cast<uint16_t>(cropInSent.top());
+    roiInfo.width = static_cast<uint16_t>(cropInSent.width());
+    roiInfo.height = static_cast<uint16_t>(cropInSent.height());
+    roiInfo.jpeg_quality = static_cast<uint8_t>(qBound(0, jpegQuality, 100));
+    memcpy(dataInfo.reserved2, &roiInfo, sizeof(RoiCropInfo));
+    finalizeSarDataInfoChecksum(dataInfo);
+
+    if (!writeFramedBinFile(outputBinFilePath, dataInfo, jpgData, image_num)) {
+        return false;
+    }
+    if (actualRegion) {
+        *actualRegion = cropInSent;
+    }
+    qCDebug(lcPacking) << "Successfully created ROI bin file at:" << outputBinFilePath << "region" << cropInSent
+             << "from image" << source_image_num << "," << jpgData.size() << "bytes";
     return true;
 }
 
@@ -6,9 +6,15 @@
 #include <string>
 #include <cstdint>
 #include <QByteArray>
+#include <QList>
 #include "AuxFileReader.h"
+#include "scene_delta.h"
 #include <QFile>
 
+struct ProductTiming;
+class QImage;
+class QRect;
+
 // 确保结构体按照1字节对齐，以匹配协议的字节布局
 #pragma pack(1)
 
@@ -105,25 +111,118 @@ struct TargetInfo {
     int16_t   heading_direction;// 目标前进方向
 };
 
+// 2.3 ROI 裁剪产品写入 SAR_DataInfo::reserved2 的扩展信息（坐标为已发送整图的像素坐标）
+struct RoiCropInfo {
+    uint16_t source_image_number;   // 被裁剪的整图编号
+    uint16_t x;                     // 区域左上角列
+    uint16_t y;                     // 区域左上角行
+    uint16_t width;
+    uint16_t height;
+    uint8_t  jpeg_quality;
+};
+
+// 2.4 预览产品写入 SAR_DataInfo::reserved2 的扩展信息；预览有自己的图像编号，接收端按 full_image_number 与整图对应
+struct PreviewInfo {
+    uint16_t full_image_number;     // 随后发送的整图产品的编号
+    uint16_t full_rows;             // 整图产品（校正后）的行数
+    uint16_t full_cols;             // 整图产品的列数
+    uint8_t  scale;                 // 缩小倍数
+};
+
+// 2.5 瓦片产品写入 SAR_DataInfo::reserved2 的扩展信息（坐标为校正后整图的像素坐标）
+struct TileInfo {
+    uint16_t parent_image_number;   // 整图产品的图像编号
+    uint16_t tile_index;            // 按行优先的瓦片序号，从 0 开始
+    uint16_t tile_count;
+    uint16_t x;                     // 瓦片左上角列
+    uint16_t y;                     // 瓦片左上角行
+    uint16_t full_rows;             // 校正后整图行数
+    uint16_t full_cols;             // 校正后整图列数
+};
+
+// 2.6 增量产品写入 SAR_DataInfo::reserved2 的扩展信息：接收端在基准图像上覆盖各变化瓦片即得到本幅图像
+struct DeltaInfo {
+    uint16_t base_image_number;     // 基准图像编号（完整产品或上一幅增量产品）
+    uint16_t full_rows;             // 校正后整图行数
+    uint16_t full_cols;
+    uint16_t tile_size;
+    uint16_t changed_tiles;
+    uint16_t total_tiles;
+};
+
+// 增量产品的图像数据依次为各变化瓦片：DeltaTileHeader 后接该瓦片的 JPG 数据
+struct DeltaTileHeader {
+    uint16_t x;                     // 瓦片左上角列（校正后整图像素坐标）
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+    uint32_t jpeg_size;
+};
+
 #pragma pack()
 
+// SAR_DataInfo::message_type：0x0001 SAR 图像，0x0002 仅 TIF 图像，0x0003 GMTI，0x0004 SLC 芯片（见 slc_chip.h），
+// 0x0005 低分辨率预览，0x0006 瓦片，0x0007 场景增量，0x0008 ROI 裁剪
+constexpr uint16_t PREVIEW_MESSAGE_TYPE = 0x0005;
+constexpr uint16_t TILE_MESSAGE_TYPE = 0x0006;
+constexpr uint16_t DELTA_MESSAGE_TYPE = 0x0007;
+constexpr uint16_t ROI_CROP_MESSAGE_TYPE = 0x0008;
+
+// 图像编码参数：打包时统一使用，可在运行中修改（线程安全）
+struct ImageCodecSettings {
+    int jpegQuality = 80;          // JPG 质量 0~100
+    int allocationLimitMB = 1024;  // QImageReader 单张图像的内存上限
+    bool progressiveJpeg = false;  // 整图按渐进式 JPEG 编码，支持流式解码的接收端可边收边显示
+};
+void setImageCodecSettings(const ImageCodecSettings& settings);
+ImageCodecSettings imageCodecSettings();
+
+// 大幅 SAR 产品的瓦片模式
+struct TileSettings {
+    bool enabled = false;
+    int tileSize = 1024;           // 瓦片边长（校正后像素），边缘瓦片可能更小
+    int minSide = 4096;            // 校正后宽或高超过此值才切瓦片
+    int maxTiles = 256;            // 单个产品的瓦片数上限（每个瓦片占一个图像编号），超出时放大瓦片边长
+    int threads = 2;               // 单个产品并行编码的线程数（含打包线程本身），不超过硬件线程数；
+                                   // 多个产品已在线程池中并行打包，取小值以免线程数成倍超出核数
+};
+
 // 计算校验和的私有辅助函数
 uint8_t calculate_checksum(const uint8_t* data, size_t length);
 
 // 封装 SAR_DataInfo 的核心函数
-SAR_DataInfo createSarDataInfo(const AuxHeader& auxHeader, uint32_t imageSize);
+SAR_DataInfo createSarDataInfo(const AuxHeader& auxHeader, uint32_t imageSize, uint16_t image_num);
+
+// 重新计算 SAR_DataInfo 的校验和（帧头之后到校验和字段之前）；改写消息类型或 reserved2 后调用
+void finalizeSarDataInfoChecksum(SAR_DataInfo& dataInfo);
+
+// 子区域的 AUX 头：尺寸为区域本身，四角经纬度由整幅图像四角双线性插值得到
+AuxHeader auxHeaderForRegion(const AuxHeader& auxHeader, qint64 row0, qint64 col0, qint64 rows, qint64 cols);
+
+/**
+ * @class PacketSource
+ * @brief 按顺序提供待发送的 SAR_Frame 数据包（每个包含帧头、有效载荷与校验和）。
+ */
+class PacketSource {
+public:
+    virtual ~PacketSource() = default;
+
+    virtual bool hasNextPacket() = 0;
+    // 出错时返回空 QByteArray
+    virtual QByteArray getNextPacket() = 0;
+};
 
 /**
  * @class SarPacketizer
  * @brief 负责从预先生成的bin文件中读取数据包。
  */
-class SarPacketizer {
+class SarPacketizer : public PacketSource {
 public:
     SarPacketizer(const QString& binFilePath);
-    ~SarPacketizer();
+    ~SarPacketizer() override;
 
-    bool hasNextPacket();
-    QByteArray getNextPacket();
+    bool hasNextPacket() override;
+    QByteArray getNextPacket() override;
 
 private:
     QFile m_binFile;
@@ -134,10 +233,65 @@ private:
  * @param tifFilePath TIF文件路径
  * @param auxFilePath AUX文件路径
  * @param outputBinFilePath 输出bin文件路径
+ * @param timing 非空时填入解码/重采样/编码/分帧各环节耗时
  * @return 成功返回true，失败返回false
  */
-bool createBinFileFromTifAndAux(const QString& tifFilePath, const QString& auxFilePath, const QString& outputBinFilePath, uint16_t image_num);
-bool createBinFileFromTifOnly(const QString& tifFilePath, const QString& outputBinFilePath, uint16_t image_num);
+bool createBinFileFromTifAndAux(const QString& tifFilePath, const QString& auxFilePath, const QString& outputBinFilePath, uint16_t image_num, ProductTiming* timing = nullptr);
+/**
+ * @brief 与 createBinFileFromTifAndAux 相同的校正、编码与分帧，图像已在内存中（如由 SLC 生成的快视图）。
+ */
+bool createBinFileFromImageAndAux(const QImage& image, const AuxHeader& auxHeader, const QString& outputBinFilePath, uint16_t image_num, ProductTiming* timing = nullptr);
+/**
+ * @brief 从源 TIF 中裁剪 region 并按 jpegQuality 编码为独立的 ROI 产品（message_type 0x0008）。
+ * region 是接收端看到的整图像素坐标：有 AUX 时整图曾按 Xbin/Rbin 做过方位向校正，
+ * 这里先换算回源 TIF 的行号，裁剪后再做同样的校正。只解码所需区域（QImageReader::setClipRect）。
+ * @param auxFilePath 为空或文件不存在时按仅 TIF 处理
+ * @param actualRegion 非空时填入裁剪到图像范围内的实际区域
+ */
+bool createBinFileFromTifRegion(const QString& tifFilePath, const QString& auxFilePath, const QRect& region, int jpegQuality,
+                                const QString& outputBinFilePath, uint16_t image_num, uint16_t source_image_num,
+                                QRect* actualRegion = nullptr);
+/**
+ * @brief 生成整图的低分辨率预览产品（message_type 0x0005），先于整图发送以缩短出图时间。
+ * 解码时直接按目标尺寸缩小（QImageReader::setScaledSize，解码器支持时不生成全分辨率图像），
+ * 方位向校正在同一次缩放中完成；四角坐标与整图相同，像素间距按倍数放大。
+ * @param scale 缩小倍数（≥ 2）
+ * @param full_image_num 整图产品的编号，写入 PreviewInfo
+ */
+bool createPreviewBinFile(const QString& tifFilePath, const QString& auxFilePath, int scale, int jpegQuality,
+                          const QString& outputBinFilePath, uint16_t image_num, uint16_t full_image_num,
+                          ProductTiming* timing = nullptr);
+/**
+ * @brief 按瓦片模式打包时的瓦片数；不满足 settings 的切分条件时返回 0（按整图打包）。
+ * 瓦片数不超过 settings.maxTiles，按配置边长切出的瓦片过多时放大边长，实际边长填入 tileSize。
+ * 只读取图像尺寸与 AUX，不解码图像。
+ */
+int tiledProductTileCount(const QString& tifFilePath, const QString& auxFilePath, const TileSettings& settings,
+                          int* tileSize = nullptr);
+/**
+ * @brief 瓦片打包：校正后的整图按 tileSize（受 maxTiles 限制，与 tiledProductTileCount 相同）切成瓦片并行编码，每个瓦片是独立的消息（message_type 0x0006），
+ * 使用 tileNumbers 中对应的图像编号，四角经纬度由整图四角插值得到。各瓦片的帧按行优先依次写入同一个 bin 文件。
+ * @param tileNumbers 个数须等于 tiledProductTileCount 的结果
+ */
+bool createTiledBinFile(const QString& tifFilePath, const QString& auxFilePath, const TileSettings& settings,
+                        uint16_t parent_image_num, const QList<uint16_t>& tileNumbers,
+                        const QString& outputBinFilePath, ProductTiming* timing = nullptr);
+/**
+ * @brief 按接收端的方式解码打包好的整图或瓦片产品（bin 文件），返回校正后整图的 8 位灰度图，失败时返回空图。
+ */
+QImage decodePackedSarImage(const QString& binFilePath);
+/**
+ * @brief 场景增量打包：校正后的图像与 base 逐 16×16 块比较（SSE2 PSADBW），
+ * 只把含变化块的瓦片编码进增量产品（message_type 0x0007），四角坐标仍为整图。
+ * base 为空、尺寸不同、连续增量数达到 keyframeInterval 或变化瓦片比例超过 maxChangedFraction 时
+ * 不写文件并返回 true、changedTiles 填 -1，由调用方打包完整产品（可按瓦片模式），再用 decodePackedSarImage 取基准。
+ * @param reconstructed 增量产品填入接收端收到后看到的灰度图（由实际发出的 JPEG 解码得到），作为同一场景下一幅的基准
+ * @param changedTiles 增量产品填入变化瓦片数，需要完整产品时填 -1；totalTiles 填瓦片总数
+ */
+bool createDeltaBinFile(const QString& tifFilePath, const QString& auxFilePath, const DeltaSettings& settings,
+                        const DeltaBase& base, const QString& outputBinFilePath, uint16_t image_num,
+                        QImage* reconstructed, int* changedTiles, int* totalTiles, ProductTiming* timing = nullptr);
+bool createBinFileFromTifOnly(const QString& tifFilePath, const QString& outputBinFilePath, uint16_t image_num, ProductTiming* timing = nullptr);
 bool unpackage_sar_data(const std::string& input_filename, const std::string& output_image_filename);
 
 #endif // PACKAGE_SAR_DATA_H
@@ -0,0 +1,224 @@
+#include "pipeline_config.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+
+QString defaultConfigPath() {
+    return QDir(QCoreApplication::applicationDirPath()).filePath("aerolink.ini");
+}
+
+QString productTypeName(ProductType type) {
+    return type == ProductType::GMTI ? QStringLiteral("GMTI") : QStringLiteral("SAR");
+}
+
+ProductType productTypeFromName(const QString& name) {
+    return name.compare("GMTI", Qt::CaseInsensitive) == 0 ? ProductType::GMTI : ProductType::SAR;
+}
+
+QList<MonitorRootConfig> loadMonitorRoots(QSettings& settings) {
+    QList<MonitorRootConfig> roots;
+    const int size = settings.beginReadArray("roots");
+    for (int i = 0; i < size; ++i) {
+        settings.setArrayIndex(i);
+        MonitorRootConfig root;
+        root.path = settings.value("path").toString();
+        if (root.path.isEmpty()) {
+            qWarning() << "Monitor root" << i + 1 << "has no path, skipped.";
+            continue;
+        }
+        root.name = settings.value("name", QString("root%1").arg(i + 1)).toString();
+        root.productType = productTypeFromName(settings.value("type", "SAR").toString());
+        root.destinationHost = settings.value("host").toString();
+        root.destinationPort = static_cast<quint16>(settings.value("port", 0).toUInt());
+        root.priority = settings.value("priority", 0).toInt();
+        roots.append(root);
+    }
+    settings.endArray();
+    return roots;
+}
+
+void saveMonitorRoots(QSettings& settings, const QList<MonitorRootConfig>& roots) {
+    settings.beginWriteArray("roots", roots.size());
+    for (int i = 0; i < roots.size(); ++i) {
+        const MonitorRootConfig& root = roots.at(i);
+        settings.setArrayIndex(i);
+        settings.setValue("name", root.name);
+        settings.setValue("path", root.path);
+        settings.setValue("type", productTypeName(root.productType));
+        settings.setValue("host", root.destinationHost);
+        settings.setValue("port", root.destinationPort);
+        settings.setValue("priority", root.priority);
+    }
+    settings.endArray();
+}
+
+OverloadPolicy loadOverloadPolicy(QSettings& settings) {
+    OverloadPolicy policy;
+    settings.beginGroup("overload");
+    const QString mode = settings.value("mode", "fifo").toString().toLower();
+    if (mode == "newest_first" || mode == "lifo") {
+        policy.mode = OverloadMode::NewestFirst;
+    } else if (mode == "drop_older_than") {
+        policy.mode = OverloadMode::DropOlderThan;
+    } else if (mode == "keep_every_kth") {
+        policy.mode = OverloadMode::KeepEveryKth;
+    } else if (mode != "fifo") {
+        qWarning() << "Unknown overload mode" << mode << ", falling back to fifo.";
+    }
+    policy.maxAgeSeconds = settings.value("max_age_seconds", policy.maxAgeSeconds).toInt();
+    policy.keepEveryK = settings.value("keep_every_k", policy.keepEveryK).toInt();
+    policy.maxDrainSeconds = settings.value("max_drain_seconds", policy.maxDrainSeconds).toInt();
+    policy.maxDepth = settings.value("max_depth", policy.maxDepth).toInt();
+    settings.endGroup();
+    return policy;
+}
+
+LinkConfig loadLinkConfig(QSettings& settings) {
+    LinkConfig link;
+    settings.beginGroup("link");
+    link.maxInFlight = qMax(1, settings.value("max_in_flight", link.maxInFlight).toInt());
+    TransferOptions& transfer = link.transfer;
+    transfer.connectTimeoutMs = settings.value("connect_timeout_ms", transfer.connectTimeoutMs).toInt();
+    transfer.stallTimeoutMs = settings.value("stall_timeout_ms", transfer.stallTimeoutMs).toInt();
+    transfer.maxBufferedBytes = qMax<qint64>(1, settings.value("max_buffered_kb", transfer.maxBufferedBytes / 1024).toLongLong()) * 1024;
+    transfer.waitForAck = settings.value("wait_for_ack", transfer.waitForAck).toBool();
+    transfer.ackTimeoutMs = settings.value("ack_timeout_ms", transfer.ackTimeoutMs).toInt();
+    settings.endGroup();
+    return link;
+}
+
+ImageCodecSettings loadCodecSettings(QSettings& settings) {
+    ImageCodecSettings codec;
+    settings.beginGroup("codec");
+    codec.jpegQuality = qBound(0, settings.value("jpeg_quality", codec.jpegQuality).toInt(), 100);
+    codec.allocationLimitMB = qMax(0, settings.value("allocation_limit_mb", codec.allocationLimitMB).toInt());
+    codec.progressiveJpeg = settings.value("progressive", codec.progressiveJpeg).toBool();
+    settings.endGroup();
+    return codec;
+}
+
+bool loadJournalSync(QSettings& settings) {
+    settings.beginGroup("journal");
+    const bool sync = settings.value("sync", true).toBool();
+    settings.endGroup();
+    return sync;
+}
+
+quint16 loadMetricsPort(QSettings& settings) {
+    settings.beginGroup("metrics");
+    const int port = settings.value("port", 9464).toInt();
+    settings.endGroup();
+    return static_cast<quint16>(qBound(0, port, 65535));
+}
+
+qint64 loadProductCacheBytes(QSettings& settings) {
+    settings.beginGroup("cache");
+    const qint64 megabytes = qBound<qint64>(0, settings.value("max_mb", 256).toLongLong(), 64 * 1024);
+    settings.endGroup();
+    return megabytes * 1024 * 1024;
+}
+
+TraceConfig loadTraceConfig(QSettings& settings) {
+    TraceConfig config;
+    settings.beginGroup("trace");
+    config.enabled = settings.value("enabled", config.enabled).toBool();
+    config.dir = settings.value("dir").toString();
+    config.bufferEvents = qMax(1024, settings.value("buffer_events", config.bufferEvents).toInt());
+    settings.endGroup();
+    return config;
+}
+
+CommandServerConfig loadCommandServerConfig(QSettings& settings) {
+    CommandServerConfig config;
+    settings.beginGroup("command_server");
+    config.useEpoll = settings.value("backend", "qt").toString().compare("epoll", Qt::CaseInsensitive) == 0;
+    config.ioThreads = qBound(1, settings.value("io_threads", config.ioThreads).toInt(), 64);
+    config.maxConnections = qMax(1, settings.value("max_connections", config.maxConnections).toInt());
+    settings.endGroup();
+    return config;
+}
+
+IsarQueueSettings loadIsarQueueSettings(QSettings& settings) {
+    IsarQueueSettings config;
+    settings.beginGroup("isar");
+    config.mergeRangePx = qMax(0, settings.value("merge_range_px", config.mergeRangePx).toInt());
+    config.mergeAzimuthPx = qMax(0, settings.value("merge_azimuth_px", config.mergeAzimuthPx).toInt());
+    config.holdMs = qMax(0, settings.value("hold_ms", config.holdMs).toInt());
+    config.minIntervalMs = qMax(0, settings.value("min_interval_ms", config.minIntervalMs).toInt());
+    config.dedupWindowMs = qMax(0, settings.value("dedup_window_ms", config.dedupWindowMs).toInt());
+    config.rangeWindow = qMax(1, settings.value("rg_win_len", config.rangeWindow).toInt());
+    config.azimuthWindow = qMax(1, settings.value("az_win_len", config.azimuthWindow).toInt());
+    settings.endGroup();
+    return config;
+}
+
+SlcSettings loadSlcSettings(QSettings& settings) {
+    SlcSettings config;
+    settings.beginGroup("slc");
+    config.directChip = settings.value("direct_chip", config.directChip).toBool();
+    const QString format = settings.value("sample_format", "cf32").toString();
+    config.format = format.compare("ci16", Qt::CaseInsensitive) == 0 ? SlcSampleFormat::ComplexInt16
+                                                                     : SlcSampleFormat::ComplexFloat32;
+    config.headerBytes = qMax<qint64>(0, settings.value("header_bytes", config.headerBytes).toLongLong());
+    config.cachedFiles = qBound(1, settings.value("cached_files", config.cachedFiles).toInt(), 64);
+    SlcQuicklookSettings& quicklook = config.quicklook;
+    quicklook.enabled = settings.value("quicklook", quicklook.enabled).toBool();
+    quicklook.span = qBound(1, settings.value("quicklook_span", quicklook.span).toInt(), 64);
+    quicklook.azimuthLooks = qMax(0, settings.value("quicklook_azimuth_looks", quicklook.azimuthLooks).toInt());
+    quicklook.rangeLooks = qMax(0, settings.value("quicklook_range_looks", quicklook.rangeLooks).toInt());
+    quicklook.power = settings.value("quicklook_detect", "amplitude").toString().compare("power", Qt::CaseInsensitive) == 0;
+    quicklook.dynamicRangeDb = qBound(1.0f, settings.value("quicklook_dynamic_range_db", quicklook.dynamicRangeDb).toFloat(), 120.0f);
+    quicklook.clipPercentile = qBound(50.0f, settings.value("quicklook_clip_percentile", quicklook.clipPercentile).toFloat(), 100.0f);
+    quicklook.threads = qMax(0, settings.value("quicklook_threads", quicklook.threads).toInt());
+    settings.endGroup();
+    return config;
+}
+
+RoiSettings loadRoiSettings(QSettings& settings) {
+    RoiSettings config;
+    settings.beginGroup("roi");
+    config.defaultWidth = qBound(1, settings.value("default_width", config.defaultWidth).toInt(), 65535);
+    config.defaultHeight = qBound(1, settings.value("default_height", config.defaultHeight).toInt(), 65535);
+    config.jpegQuality = qBound(1, settings.value("jpeg_quality", config.jpegQuality).toInt(), 100);
+    config.maxSide = qBound(1, settings.value("max_side", config.maxSide).toInt(), 65535);
+    settings.endGroup();
+    return config;
+}
+
+ProgressiveSettings loadProgressiveSettings(QSettings& settings) {
+    ProgressiveSettings config;
+    settings.beginGroup("progressive");
+    config.enabled = settings.value("enabled", config.enabled).toBool();
+    config.scale = qBound(2, settings.value("scale", config.scale).toInt(), 64);
+    config.jpegQuality = qBound(1, settings.value("jpeg_quality", config.jpegQuality).toInt(), 100);
+    settings.endGroup();
+    return config;
+}
+
+TileSettings loadTileSettings(QSettings& settings) {
+    TileSettings config;
+    settings.beginGroup("tiling");
+    config.enabled = settings.value("enabled", config.enabled).toBool();
+    config.tileSize = qBound(64, settings.value("tile_size", config.tileSize).toInt(), 8192);
+    config.minSide = qMax(0, settings.value("min_side", config.minSide).toInt());
+    config.maxTiles = qBound(1, settings.value("max_tiles", config.maxTiles).toInt(), 4096);
+    config.threads = qBound(1, settings.value("threads", config.threads).toInt(), 64);
+    settings.endGroup();
+    return config;
+}
+
+DeltaSettings loadDeltaSettings(QSettings& settings) {
+    DeltaSettings config;
+    settings.beginGroup("delta");
+    config.enabled = settings.value("enabled", config.enabled).toBool();
+    config.cellDegrees = qBound(1e-6, settings.value("cell_degrees", config.cellDegrees).toDouble(), 1.0);
+    config.blockThreshold = qBound(0, settings.value("block_threshold", config.blockThreshold).toInt(), 255);
+    const int tileSize = qBound(DELTA_BLOCK_SIZE, settings.value("tile_size", config.tileSize).toInt(), 4096);
+    config.tileSize = tileSize / DELTA_BLOCK_SIZE * DELTA_BLOCK_SIZE;
+    config.maxChangedFraction = qBound(0.0, settings.value("max_changed_fraction", config.maxChangedFraction).toDouble(), 1.0);
+    config.keyframeInterval = qMax(1, settings.value("keyframe_interval", config.keyframeInterval).toInt());
+    config.maxScenes = qMax(1, settings.value("max_scenes", config.maxScenes).toInt());
+    config.threads = qBound(1, settings.value("threads", config.threads).toInt(), 64);
+    settings.endGroup();
+    return config;
+}
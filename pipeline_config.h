@@ -0,0 +1,227 @@
+#ifndef PIPELINE_CONFIG_H
+#define PIPELINE_CONFIG_H
+
+#include <QString>
+#include <QList>
+#include <QSettings>
+#include "product_correlator.h"
+#include "transfer_scheduler.h"
+#include "async_transfer.h"
+#include "package_sar_data.h"
+#include "isar_request_queue.h"
+#include "slc_chip.h"
+
+// 单个监控根目录的配置：每个根目录有独立的产品类型、目的地址与优先级
+struct MonitorRootConfig {
+    QString name;                      // 根目录名称（日志与统计中使用）
+    QString path;                      // 监控的主文件夹
+    ProductType productType = ProductType::SAR;
+    QString destinationHost;           // 传输目的 IP
+    quint16 destinationPort = 0;       // 传输目的端口
+    int priority = 0;                  // 链路调度优先级，数值越大越优先
+};
+
+// 默认配置文件：可执行文件同目录下的 aerolink.ini
+QString defaultConfigPath();
+
+// 链路参数：同时进行的传输数与单次传输的超时设置
+struct LinkConfig {
+    int maxInFlight = 1;
+    TransferOptions transfer;
+};
+
+/**
+ * @brief 从配置文件读取监控根目录列表。
+ * 格式（QSettings INI 数组）：
+ *   [roots]
+ *   size=2
+ *   1\name=sar
+ *   1\path=/data/sar
+ *   1\type=SAR            ; SAR 或 GMTI
+ *   1\host=192.168.1.10
+ *   1\port=65432
+ *   1\priority=10
+ */
+QList<MonitorRootConfig> loadMonitorRoots(QSettings& settings);
+void saveMonitorRoots(QSettings& settings, const QList<MonitorRootConfig>& roots);
+
+/**
+ * @brief 读取链路过载策略。
+ *   [overload]
+ *   mode=newest_first      ; fifo / newest_first / drop_older_than / keep_every_kth
+ *   max_age_seconds=60
+ *   keep_every_k=2
+ *   max_drain_seconds=30
+ *   max_depth=16
+ */
+OverloadPolicy loadOverloadPolicy(QSettings& settings);
+
+/**
+ * @brief 读取链路参数。
+ *   [link]
+ *   max_in_flight=4        ; 同时进行的传输数，全部在同一个 I/O 线程中以协程执行
+ *   connect_timeout_ms=5000
+ *   stall_timeout_ms=10000
+ *   max_buffered_kb=256
+ *   wait_for_ack=false
+ *   ack_timeout_ms=5000
+ */
+LinkConfig loadLinkConfig(QSettings& settings);
+
+/**
+ * @brief 读取图像编码参数。
+ *   [codec]
+ *   jpeg_quality=80
+ *   allocation_limit_mb=1024
+ *   progressive=false      ; 整图按渐进式 JPEG 编码
+ */
+ImageCodecSettings loadCodecSettings(QSettings& settings);
+
+/**
+ * @brief 读取产品状态日志是否每条记录后同步落盘。
+ *   [journal]
+ *   sync=true              ; false 时只写入页缓存：进程崩溃不受影响，断电可能丢失最后几条记录，
+ *                          ; 重启后对应产品按未发送处理重新检测，适合磁盘同步很慢的存储
+ */
+bool loadJournalSync(QSettings& settings);
+
+/**
+ * @brief 读取本机指标端口（只绑定 127.0.0.1），0 表示不开启。
+ *   [metrics]
+ *   port=9464
+ */
+quint16 loadMetricsPort(QSettings& settings);
+
+/**
+ * @brief 读取已打包产品内存缓存的容量（字节），0 表示不缓存。
+ *   [cache]
+ *   max_mb=256            ; 重发、续传与接收端重传请求命中时直接从内存发送
+ */
+qint64 loadProductCacheBytes(QSettings& settings);
+
+/**
+ * @brief 读取 ISAR 请求合并与限速参数。
+ *   [isar]
+ *   merge_range_px=256
+ *   merge_azimuth_px=1024
+ *   hold_ms=200             ; 每合并一次重新计时，从首个请求算起最多 4 倍
+ *   min_interval_ms=500
+ *   dedup_window_ms=10000
+ *   rg_win_len=1024
+ *   az_win_len=4096
+ */
+IsarQueueSettings loadIsarQueueSettings(QSettings& settings);
+
+/**
+ * @brief 读取 ISAR 请求的 SLC 直传参数；窗口尺寸沿用 [isar] 的 rg_win_len/az_win_len。
+ *   [slc]
+ *   direct_chip=false
+ *   sample_format=cf32     ; cf32（2×float32）或 ci16（2×int16）
+ *   header_bytes=0
+ *   cached_files=4
+ *   quicklook=false            ; 同时回传请求区域的多视幅度快视图（走常规 SAR 打包）
+ *   quicklook_span=4           ; 快视范围为 ISAR 窗口的倍数
+ *   quicklook_azimuth_looks=0  ; 0 取 AUX 的 az_MLK_num
+ *   quicklook_range_looks=0    ; 0 按 Xbin/Rbin 取方形像素
+ *   quicklook_detect=amplitude ; amplitude（|z|）或 power（|z|²）
+ *   quicklook_dynamic_range_db=40
+ *   quicklook_clip_percentile=99.5
+ *   quicklook_threads=0        ; 多视计算的线程数上限（含请求所在线程），0 借用整个工作线程池
+ */
+SlcSettings loadSlcSettings(QSettings& settings);
+
+// 接收端按需请求的 ROI 高质量裁剪
+struct RoiSettings {
+    int defaultWidth = 512;         // 请求未附带尺寸时使用
+    int defaultHeight = 512;
+    int jpegQuality = 95;           // 请求未指定质量时使用
+    int maxSide = 4096;             // 单边上限，超出部分截掉
+};
+
+/**
+ * @brief 读取 ROI 裁剪参数。
+ *   [roi]
+ *   default_width=512
+ *   default_height=512
+ *   jpeg_quality=95
+ *   max_side=4096
+ */
+RoiSettings loadRoiSettings(QSettings& settings);
+
+// 渐进传输：SAR 产品先发低分辨率预览，再发整图；预览有自己的图像编号，头中带整图编号
+struct ProgressiveSettings {
+    bool enabled = false;
+    int scale = 8;                  // 预览缩小倍数
+    int jpegQuality = 60;           // 预览的 JPG 质量
+};
+
+/**
+ * @brief 读取渐进传输参数。
+ *   [progressive]
+ *   enabled=false
+ *   scale=8
+ *   jpeg_quality=60
+ */
+ProgressiveSettings loadProgressiveSettings(QSettings& settings);
+
+/**
+ * @brief 读取瓦片模式参数（TileSettings 见 package_sar_data.h）。
+ *   [tiling]
+ *   enabled=false
+ *   tile_size=1024
+ *   min_side=4096          ; 校正后宽或高超过此值的 SAR 产品才切瓦片
+ *   max_tiles=256          ; 单个产品的瓦片数上限（每个瓦片占一个图像编号），超出时放大瓦片边长
+ *   threads=2              ; 单个产品的编码线程数，与打包线程池的线程数相乘不宜超过核数
+ */
+TileSettings loadTileSettings(QSettings& settings);
+
+/**
+ * @brief 读取场景增量传输参数（DeltaSettings 见 scene_delta.h）。
+ *   [delta]
+ *   enabled=false
+ *   cell_degrees=0.01          ; 四角经纬度按此间隔取整后相同即为同一场景
+ *   block_threshold=12         ; 16×16 块平均绝对差超过此灰度级即为变化
+ *   tile_size=256              ; 取整为 16 的倍数
+ *   max_changed_fraction=0.5
+ *   keyframe_interval=10
+ *   max_scenes=4
+ *   threads=2
+ */
+DeltaSettings loadDeltaSettings(QSettings& settings);
+
+// 指令服务后端：qt 为单线程 QTcpServer，epoll 为多 I/O 线程的 EpollCommandServer（仅 Linux）
+struct CommandServerConfig {
+    bool useEpoll = false;
+    int ioThreads = 4;
+    int maxConnections = 1000;
+};
+
+/**
+ * @brief 读取指令服务参数。
+ *   [command_server]
+ *   backend=qt             ; qt 或 epoll
+ *   io_threads=4
+ *   max_connections=1000
+ */
+CommandServerConfig loadCommandServerConfig(QSettings& settings);
+
+// 流水线跟踪：开启后记录各环节区间，退出时写出 Chrome trace JSON（见 trace_recorder.h）
+struct TraceConfig {
+    bool enabled = false;
+    QString dir;              // 空表示由调用方决定（界面程序为可执行文件目录，守护进程为 state_dir）
+    int bufferEvents = 65536; // 每个线程的事件缓冲容量
+};
+
+/**
+ * @brief 读取跟踪参数。
+ *   [trace]
+ *   enabled=false
+ *   dir=/var/log/aerolink
+ *   buffer_events=65536
+ */
+TraceConfig loadTraceConfig(QSettings& settings);
+
+QString productTypeName(ProductType type);
+ProductType productTypeFromName(const QString& name);
+
+#endif // PIPELINE_CONFIG_H
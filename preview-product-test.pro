@@ -0,0 +1,15 @@
+# 预览产品（缩小尺寸、PreviewInfo、像素间距改写）的行为测试：qmake preview-product-test.pro && make check
+# 打包代码依赖较多公共模块，直接引用 aerolink_core.pri；QImage 需要 gui 模块（不创建 QGuiApplication）
+
+TARGET = preview-product-test
+TEMPLATE = app
+
+QT = core gui network testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+include(aerolink_core.pri)
+
+SOURCES += \
+    preview_product_test.cpp
@@ -0,0 +1,181 @@
+// preview_product_test.cpp
+// 预览产品：尺寸为校正后整图按倍数缩小（倍数不小于 2），消息类型为 0x0005，
+// reserved2 中的 PreviewInfo 给出整图编号、校正后尺寸与倍数；像素间距按倍数放大且为方形，
+// 四角坐标与整图相同，校验和覆盖改写后的 reserved2，解码出的 JPEG 与缩小后的整图一致
+#include <QtTest>
+#include <QDataStream>
+#include <QTemporaryDir>
+#include <cmath>
+#include <cstring>
+#include "AuxFileReader.h"
+#include "package_sar_data.h"
+
+namespace {
+
+// 按 AuxFileReader::read 的字段顺序写一个最小的 AUX 文件，其后附带足够长度的运动数据
+bool writeAux(const QString& path, qint64 rows, qint64 cols, double xbin, double rbin) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << qint64(0) << qint64(0) << qint64(1);                         // op_mode pp_mode Kr_sign
+    for (int i = 0; i < 8; ++i) {                                       // fc .. PRF
+        out << 0.0;
+    }
+    out << rows << cols << qint64(8);                                   // pulse_num pulse_len amp_bit
+    out << xbin << rbin;
+    out << qint64(2) << qint64(0) << qint64(0);                         // geo_mode look_mode flag_flat
+    for (int i = 0; i < 27; ++i) {                                      // fdc_ref .. lng_e
+        out << 0.0;
+    }
+    out << 30.0 << 120.0 << 30.0 << 120.1 << 29.9 << 120.0 << 29.9 << 120.1;   // 四角经纬度
+    out << 0.0 << qint64(1);                                            // IMG_TH az_MLK_num
+    for (qint64 i = 0; i < rows * 7 + 10; ++i) {
+        out << 0.0;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+QImage gradientImage(int width, int height) {
+    QImage image(width, height, QImage::Format_Grayscale8);
+    for (int y = 0; y < height; ++y) {
+        uchar* line = image.scanLine(y);
+        for (int x = 0; x < width; ++x) {
+            line[x] = uchar((x + 2 * y) * 255 / (width + 2 * height));
+        }
+    }
+    return image;
+}
+
+struct PreviewMessage {
+    quint16 imageNumber = 0;
+    SAR_DataInfo dataInfo;
+    PreviewInfo previewInfo;
+    QImage image;
+};
+
+// 按接收端的方式拼回 bin 中唯一的一条消息：SAR_DataInfo 之后为 JPEG
+bool readPreviewMessage(const QString& binPath, PreviewMessage* message) {
+    QFile file(binPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray frames = file.readAll();
+    QByteArray payload;
+    qint64 offset = 0;
+    while (offset + qint64(sizeof(SAR_Frame)) <= frames.size()) {
+        SAR_Frame header;
+        memcpy(&header, frames.constData() + offset, sizeof(SAR_Frame));
+        message->imageNumber = header.image_number;
+        payload.append(frames.mid(offset + sizeof(SAR_Frame), header.data_length));
+        offset += qint64(sizeof(SAR_Frame)) + header.data_length;
+    }
+    if (payload.size() < int(sizeof(SAR_DataInfo))) {
+        return false;
+    }
+    memcpy(&message->dataInfo, payload.constData(), sizeof(SAR_DataInfo));
+    memcpy(&message->previewInfo, message->dataInfo.reserved2, sizeof(PreviewInfo));
+    message->image = QImage::fromData(payload.mid(sizeof(SAR_DataInfo)), "JPG");
+    return true;
+}
+
+uint8_t headerChecksum(const SAR_DataInfo& dataInfo) {
+    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&dataInfo);
+    return calculate_checksum(ptr + sizeof(uint16_t), sizeof(SAR_DataInfo) - sizeof(uint16_t) - sizeof(uint8_t));
+}
+
+} // namespace
+
+class PreviewProductTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+        m_imagePath = m_dir.filePath("scene.png");
+        QVERIFY(gradientImage(300, 200).save(m_imagePath, "PNG"));
+    }
+
+    void previewFollowsCorrectedSize_data() {
+        QTest::addColumn<double>("xbin");
+        QTest::addColumn<int>("scale");
+        QTest::addColumn<QSize>("fullSize");
+        QTest::addColumn<QSize>("previewSize");
+        QTest::addColumn<int>("expectedScale");
+        // Rbin 为 0.1 m：预览的像素间距 = 0.1 × 整图宽 / 预览宽，pixel_gap 以 0.01 m 为单位
+        QTest::newRow("square pixels") << 0.1 << 4 << QSize(300, 200) << QSize(75, 50) << 4;
+        // 方位向像素是距离向的两倍，校正后高度为 400
+        QTest::newRow("stretched rows") << 0.2 << 4 << QSize(300, 400) << QSize(75, 100) << 4;
+        QTest::newRow("odd scale") << 0.1 << 7 << QSize(300, 200) << QSize(42, 28) << 7;
+        // 倍数不小于 2
+        QTest::newRow("scale clamped") << 0.1 << 1 << QSize(300, 200) << QSize(150, 100) << 2;
+    }
+
+    void previewFollowsCorrectedSize() {
+        QFETCH(double, xbin);
+        QFETCH(int, scale);
+        QFETCH(QSize, fullSize);
+        QFETCH(QSize, previewSize);
+        QFETCH(int, expectedScale);
+        const QString auxPath = m_dir.filePath(QString("preview_%1.aux").arg(QTest::currentDataTag()));
+        QVERIFY(writeAux(auxPath, 200, 300, xbin, 0.1));
+        const QString binPath = m_dir.filePath("preview.bin");
+        QVERIFY(createPreviewBinFile(m_imagePath, auxPath, scale, 80, binPath, 12, 11));
+
+        PreviewMessage message;
+        QVERIFY(readPreviewMessage(binPath, &message));
+        QCOMPARE(message.imageNumber, quint16(12));
+        QCOMPARE(message.dataInfo.message_type, PREVIEW_MESSAGE_TYPE);
+        QCOMPARE(message.dataInfo.message_count, uint16_t(12));
+        QCOMPARE(message.dataInfo.image_rows, uint16_t(previewSize.height()));
+        QCOMPARE(message.dataInfo.image_cols, uint16_t(previewSize.width()));
+        QCOMPARE(message.dataInfo.checksum, headerChecksum(message.dataInfo));
+
+        QCOMPARE(message.previewInfo.full_image_number, uint16_t(11));
+        QCOMPARE(message.previewInfo.full_rows, uint16_t(fullSize.height()));
+        QCOMPARE(message.previewInfo.full_cols, uint16_t(fullSize.width()));
+        QCOMPARE(message.previewInfo.scale, uint8_t(expectedScale));
+
+        // Rbin 按整图宽与预览宽之比放大，Xbin 改为同一值（预览已校正，像素为方形）
+        const double previewRbin = 0.1 * fullSize.width() / previewSize.width();
+        QCOMPARE(int(message.dataInfo.pixel_gap), int(std::lround(previewRbin / 0.01)));
+
+        // 四角坐标沿用整图
+        AuxFileReader auxReader;
+        QVERIFY(auxReader.read(auxPath));
+        const SAR_DataInfo full = createSarDataInfo(auxReader.getHeader(), 0, 11);
+        QCOMPARE(message.dataInfo.top_left_lat, full.top_left_lat);
+        QCOMPARE(message.dataInfo.top_left_lng, full.top_left_lng);
+        QCOMPARE(message.dataInfo.bottom_right_lat, full.bottom_right_lat);
+        QCOMPARE(message.dataInfo.bottom_right_lng, full.bottom_right_lng);
+
+        // 与整图先校正再缩小的结果一致（JPEG 有损，只比较平均误差）
+        QCOMPARE(message.image.size(), previewSize);
+        const QImage expected = gradientImage(300, 200)
+            .scaled(fullSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+            .scaled(previewSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        const QImage decoded = message.image.convertToFormat(QImage::Format_Grayscale8);
+        qint64 error = 0;
+        for (int y = 0; y < previewSize.height(); ++y) {
+            for (int x = 0; x < previewSize.width(); ++x) {
+                error += qAbs(int(decoded.constScanLine(y)[x]) - int(expected.constScanLine(y)[x]));
+            }
+        }
+        const double meanError = double(error) / (previewSize.width() * previewSize.height());
+        QVERIFY2(meanError < 8, qPrintable(QString("mean error %1").arg(meanError)));
+    }
+
+    void failsWithoutAux() {
+        QVERIFY(!createPreviewBinFile(m_imagePath, m_dir.filePath("missing.aux"), 4, 80,
+                                      m_dir.filePath("missing.bin"), 1, 0));
+    }
+
+private:
+    QTemporaryDir m_dir;
+    QString m_imagePath;
+};
+
+QTEST_GUILESS_MAIN(PreviewProductTest)
+#include "preview_product_test.moc"
@@ -0,0 +1,20 @@
+# ProductCache 与 CachedPacketSource 的行为测试：qmake product-cache-test.pro && make check
+# package_sar_data.h 经 scene_delta.h 引用 QImage，因此需要 gui 模块（不创建 QGuiApplication）
+
+TARGET = product-cache-test
+TEMPLATE = app
+
+QT = core gui testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    product_cache_test.cpp \
+    product_cache.cpp
+
+HEADERS += \
+    AuxFileReader.h \
+    package_sar_data.h \
+    product_cache.h \
+    scene_delta.h
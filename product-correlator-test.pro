@@ -0,0 +1,19 @@
+# 同组文件关联器的齐全判定与超时丢弃测试：qmake product-correlator-test.pro && make check
+# 关联器只按文件名归组，不需要真实文件；去重时查询产品日志，因此一并编译 product_journal
+
+TARGET = product-correlator-test
+TEMPLATE = app
+
+QT = core testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    product_correlator.cpp \
+    product_correlator_test.cpp \
+    product_journal.cpp
+
+HEADERS += \
+    product_correlator.h \
+    product_journal.h
@@ -0,0 +1,19 @@
+# 产品状态日志的重放、压缩、淘汰与编号水位线测试：qmake product-journal-test.pro && make check
+# 关联器与日志配合的去重规则也在这里验证（关联器只按文件名归组，不需要真实文件）
+
+TARGET = product-journal-test
+TEMPLATE = app
+
+QT = core testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    product_correlator.cpp \
+    product_journal.cpp \
+    product_journal_test.cpp
+
+HEADERS += \
+    product_correlator.h \
+    product_journal.h
@@ -0,0 +1,188 @@
+#include "product_cache.h"
+#include <QDebug>
+#include <QFile>
+
+ProductCache::ProductCache(qint64 capacityBytes)
+    : m_capacity(qMax<qint64>(0, capacityBytes))
+{
+}
+
+void ProductCache::setCapacity(qint64 capacityBytes) {
+    QMutexLocker locker(&m_mutex);
+    m_capacity = qMax<qint64>(0, capacityBytes);
+    evictToFit(m_capacity);
+}
+
+qint64 ProductCache::capacity() const {
+    QMutexLocker locker(&m_mutex);
+    return m_capacity;
+}
+
+void ProductCache::insert(quint16 imageNumber, const QByteArray& frames) {
+    QMutexLocker locker(&m_mutex);
+    // 同一编号回绕后会被新产品复用，旧内容无论如何都要去掉
+    const auto existing = m_entries.constFind(imageNumber);
+    if (existing != m_entries.constEnd()) {
+        m_stats.bytes -= existing->size();
+        m_entries.erase(existing);
+        m_order.removeOne(imageNumber);
+    }
+    if (frames.isEmpty() || frames.size() > m_capacity) {
+        m_stats.entries = m_entries.size();
+        return;
+    }
+    evictToFit(m_capacity - frames.size());
+    m_entries.insert(imageNumber, frames);
+    m_order.append(imageNumber);
+    m_stats.bytes += frames.size();
+    m_stats.entries = m_entries.size();
+    ++m_stats.insertions;
+}
+
+bool ProductCache::insertFile(quint16 imageNumber, const QString& binPath) {
+    if (capacity() <= 0) {
+        return false;
+    }
+    QFile file(binPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to read packed file for cache:" << binPath;
+        return false;
+    }
+    const QByteArray frames = file.readAll();
+
+    // 瓦片产品按帧头中的图像编号分别缓存，接收端可按瓦片编号补发
+    const QList<QPair<quint16, QByteArray>> messages = splitMessages(frames);
+    if (messages.size() <= 1) {
+        insert(imageNumber, frames);
+        return true;
+    }
+    for (const auto& message : messages) {
+        insert(message.first, message.second);
+    }
+    return true;
+}
+
+QList<QPair<quint16, QByteArray>> ProductCache::splitMessages(const QByteArray& frames) {
+    QList<QPair<quint16, qint64>> offsets;     // 各消息的图像编号与起始偏移
+    qint64 offset = 0;
+    while (offset + qint64(sizeof(SAR_Frame)) <= frames.size()) {
+        const SAR_Frame* header = reinterpret_cast<const SAR_Frame*>(frames.constData() + offset);
+        if (offsets.isEmpty() || offsets.last().first != header->image_number) {
+            offsets.append(qMakePair(quint16(header->image_number), offset));
+        }
+        offset += qint64(sizeof(SAR_Frame)) + header->data_length;
+    }
+    QList<QPair<quint16, QByteArray>> messages;
+    for (int i = 0; i < offsets.size(); ++i) {
+        const qint64 begin = offsets.at(i).second;
+        const qint64 end = i + 1 < offsets.size() ? offsets.at(i + 1).second : frames.size();
+        messages.append(qMakePair(offsets.at(i).first, frames.mid(begin, end - begin)));
+    }
+    return messages;
+}
+
+QByteArray ProductCache::lookup(quint16 imageNumber) {
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_entries.constFind(imageNumber);
+    if (it == m_entries.constEnd()) {
+        ++m_stats.misses;
+        return QByteArray();
+    }
+    ++m_stats.hits;
+    m_order.removeOne(imageNumber);
+    m_order.append(imageNumber);
+    return it.value();
+}
+
+void ProductCache::remove(quint16 imageNumber) {
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_entries.constFind(imageNumber);
+    if (it == m_entries.constEnd()) {
+        return;
+    }
+    m_stats.bytes -= it->size();
+    m_entries.erase(it);
+    m_order.removeOne(imageNumber);
+    m_stats.entries = m_entries.size();
+}
+
+void ProductCache::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_order.clear();
+    m_stats.bytes = 0;
+    m_stats.entries = 0;
+}
+
+ProductCache::Stats ProductCache::stats() const {
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+double ProductCache::hitRate() const {
+    QMutexLocker locker(&m_mutex);
+    const quint64 lookups = m_stats.hits + m_stats.misses;
+    return lookups > 0 ? double(m_stats.hits) / double(lookups) : 0.0;
+}
+
+// 调用方持有 m_mutex
+void ProductCache::evictToFit(qint64 capacityBytes) {
+    while (!m_order.isEmpty() && m_stats.bytes > capacityBytes) {
+        const quint16 oldest = m_order.takeFirst();
+        m_stats.bytes -= m_entries.take(oldest).size();
+        ++m_stats.evictions;
+    }
+    m_stats.entries = m_entries.size();
+}
+
+CachedPacketSource::CachedPacketSource(const QByteArray& frames, const QList<quint16>& packets)
+    : m_frames(frames),
+    m_packets(packets)
+{
+    skipUnselected();
+}
+
+bool CachedPacketSource::hasNextPacket() {
+    return m_offset < m_frames.size();
+}
+
+QByteArray CachedPacketSource::getNextPacket() {
+    if (m_offset + qint64(sizeof(SAR_Frame)) > m_frames.size()) {
+        m_offset = m_frames.size();
+        return QByteArray();
+    }
+    const SAR_Frame* header = reinterpret_cast<const SAR_Frame*>(m_frames.constData() + m_offset);
+    const qint64 packetSize = qint64(sizeof(SAR_Frame)) + header->data_length;
+    if (m_offset + packetSize > m_frames.size()) {
+        qWarning() << "Cached product is truncated at offset" << m_offset;
+        m_offset = m_frames.size();
+        return QByteArray();
+    }
+    const QByteArray packet = QByteArray::fromRawData(m_frames.constData() + m_offset, packetSize);
+    m_offset += packetSize;
+    skipUnselected();
+    return packet;
+}
+
+void CachedPacketSource::skipUnselected() {
+    if (m_packets.isEmpty()) {
+        return;
+    }
+    while (m_offset + qint64(sizeof(SAR_Frame)) <= m_frames.size()) {
+        if (m_nextSelected >= m_packets.size()) {
+            m_offset = m_frames.size();
+            return;
+        }
+        const SAR_Frame* header = reinterpret_cast<const SAR_Frame*>(m_frames.constData() + m_offset);
+        // 请求中超出本图像范围的包号直接略过
+        while (m_nextSelected < m_packets.size() && m_packets.at(m_nextSelected) < header->current_packet) {
+            ++m_nextSelected;
+        }
+        if (m_nextSelected < m_packets.size() && m_packets.at(m_nextSelected) == header->current_packet) {
+            ++m_nextSelected;
+            return;
+        }
+        m_offset += qint64(sizeof(SAR_Frame)) + header->data_length;
+    }
+    m_offset = m_frames.size();
+}
@@ -0,0 +1,83 @@
+#ifndef PRODUCT_CACHE_H
+#define PRODUCT_CACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include "package_sar_data.h"
+
+/**
+ * @class ProductCache
+ * @brief 最近打包产品的内存缓存：按图像编号保存整段 SAR_Frame 序列（即打包 bin 的内容）。
+ *
+ * 重发（手动重发、断线续传、接收端重传请求）命中时直接从内存发送，不再读盘或重新编码。
+ * 按总字节数限制容量，超出时淘汰最久未使用的产品；容量为 0 时不缓存。
+ * 缓存内容是隐式共享的 QByteArray，取出后即使被淘汰也可继续使用。线程安全。
+ */
+class ProductCache {
+public:
+    struct Stats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 insertions = 0;
+        quint64 evictions = 0;
+        qint64 bytes = 0;
+        int entries = 0;
+    };
+
+    explicit ProductCache(qint64 capacityBytes = 0);
+
+    void setCapacity(qint64 capacityBytes);
+    qint64 capacity() const;
+
+    // 放入一个产品的帧序列，替换同编号的旧内容；单个产品超过容量时不缓存
+    void insert(quint16 imageNumber, const QByteArray& frames);
+    // 读入打包好的 bin 文件后放入缓存，未启用缓存时不读文件；
+    // 含多个消息的 bin（瓦片产品）按各消息自己的图像编号分别缓存
+    bool insertFile(quint16 imageNumber, const QString& binPath);
+    // 按帧头中的图像编号把帧序列切成各个消息（瓦片产品的 bin 依次是各瓦片的独立消息）
+    static QList<QPair<quint16, QByteArray>> splitMessages(const QByteArray& frames);
+    // 命中时返回帧序列并刷新为最近使用，未命中返回空；计入命中率统计
+    QByteArray lookup(quint16 imageNumber);
+    void remove(quint16 imageNumber);
+    void clear();
+
+    Stats stats() const;
+    double hitRate() const;
+
+private:
+    void evictToFit(qint64 capacityBytes);
+
+    mutable QMutex m_mutex;
+    qint64 m_capacity;
+    QHash<quint16, QByteArray> m_entries;
+    QList<quint16> m_order;     // 最近使用的在末尾
+    Stats m_stats;
+};
+
+/**
+ * @class CachedPacketSource
+ * @brief 按帧头逐帧遍历缓存中的帧序列。返回的包直接引用缓存内容（QByteArray::fromRawData），
+ * 写入套接字时才拷贝一次，因此本对象须存活到传输结束（交给 transferPackets 即满足）。
+ * packets 非空时只发出 current_packet 在其中的帧（选择性重传），须为升序。
+ */
+class CachedPacketSource : public PacketSource {
+public:
+    explicit CachedPacketSource(const QByteArray& frames, const QList<quint16>& packets = QList<quint16>());
+
+    bool hasNextPacket() override;
+    QByteArray getNextPacket() override;
+
+private:
+    // 跳过未选中的帧，停在下一个要发送的帧（或末尾）
+    void skipUnselected();
+
+    QByteArray m_frames;
+    QList<quint16> m_packets;
+    qsizetype m_nextSelected = 0;
+    qint64 m_offset = 0;
+};
+
+#endif // PRODUCT_CACHE_H
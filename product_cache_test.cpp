@@ -0,0 +1,191 @@
+// product_cache_test.cpp
+// ProductCache：命中/未命中统计、按字节数 LRU 淘汰、同编号替换与缩容时淘汰，瓦片产品按瓦片编号拆分缓存；
+// CachedPacketSource：逐帧取包、按包号只取补发的帧（越界包号忽略），遇到截断的帧即停止
+#include <QtTest>
+#include <QFile>
+#include <QTemporaryDir>
+#include <cstring>
+#include "product_cache.h"
+
+namespace {
+
+const int PAYLOAD_SIZE = 8;
+
+// 一个消息的帧序列：每帧帧头之后是 PAYLOAD_SIZE 字节载荷，载荷填充包号便于核对
+QByteArray makeFrames(quint16 imageNumber, int packets) {
+    QByteArray frames;
+    for (int packet = 1; packet <= packets; ++packet) {
+        SAR_Frame header;
+        memset(&header, 0, sizeof(header));
+        header.fixed_value = 0x90E9;
+        header.image_number = imageNumber;
+        header.image_size = quint32(packets * PAYLOAD_SIZE);
+        header.current_packet = quint16(packet);
+        header.total_packets = quint16(packets);
+        header.data_length = PAYLOAD_SIZE;
+        frames.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        frames.append(QByteArray(PAYLOAD_SIZE, char(packet)));
+    }
+    return frames;
+}
+
+qint64 productSize(int packets) {
+    return qint64(packets) * (qint64(sizeof(SAR_Frame)) + PAYLOAD_SIZE);
+}
+
+QList<quint16> drainPackets(PacketSource* source) {
+    QList<quint16> packets;
+    while (source->hasNextPacket()) {
+        const QByteArray packet = source->getNextPacket();
+        if (packet.isEmpty()) {
+            packets.append(0);
+            continue;
+        }
+        const SAR_Frame* header = reinterpret_cast<const SAR_Frame*>(packet.constData());
+        packets.append(header->current_packet);
+        if (packet.size() != qint64(sizeof(SAR_Frame)) + PAYLOAD_SIZE
+            || packet.at(int(sizeof(SAR_Frame))) != char(header->current_packet)) {
+            packets.append(0);
+        }
+    }
+    return packets;
+}
+
+} // namespace
+
+class ProductCacheTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void countsHitsAndMisses() {
+        ProductCache cache(productSize(10));
+        const QByteArray frames = makeFrames(1, 3);
+        cache.insert(1, frames);
+        QCOMPARE(cache.lookup(1), frames);
+        QVERIFY(cache.lookup(2).isEmpty());
+
+        const ProductCache::Stats stats = cache.stats();
+        QCOMPARE(stats.hits, quint64(1));
+        QCOMPARE(stats.misses, quint64(1));
+        QCOMPARE(stats.insertions, quint64(1));
+        QCOMPARE(stats.entries, 1);
+        QCOMPARE(stats.bytes, productSize(3));
+        QCOMPARE(cache.hitRate(), 0.5);
+    }
+
+    void evictsLeastRecentlyUsed() {
+        ProductCache cache(productSize(6));
+        cache.insert(1, makeFrames(1, 2));
+        cache.insert(2, makeFrames(2, 2));
+        cache.insert(3, makeFrames(3, 2));
+        // 访问 1 之后，最久未使用的是 2
+        QVERIFY(!cache.lookup(1).isEmpty());
+        cache.insert(4, makeFrames(4, 2));
+
+        QVERIFY(cache.lookup(2).isEmpty());
+        QVERIFY(!cache.lookup(1).isEmpty());
+        QVERIFY(!cache.lookup(3).isEmpty());
+        QVERIFY(!cache.lookup(4).isEmpty());
+        const ProductCache::Stats stats = cache.stats();
+        QCOMPARE(stats.evictions, quint64(1));
+        QCOMPARE(stats.entries, 3);
+        QCOMPARE(stats.bytes, productSize(6));
+    }
+
+    void evictsAsManyAsNeeded() {
+        ProductCache cache(productSize(6));
+        cache.insert(1, makeFrames(1, 2));
+        cache.insert(2, makeFrames(2, 2));
+        cache.insert(3, makeFrames(3, 2));
+        cache.insert(4, makeFrames(4, 5));
+
+        QVERIFY(cache.lookup(1).isEmpty());
+        QVERIFY(cache.lookup(2).isEmpty());
+        QVERIFY(cache.lookup(3).isEmpty());
+        QVERIFY(!cache.lookup(4).isEmpty());
+        QCOMPARE(cache.stats().bytes, productSize(5));
+    }
+
+    void replacesSameImageNumber() {
+        ProductCache cache(productSize(10));
+        cache.insert(7, makeFrames(7, 2));
+        const QByteArray replacement = makeFrames(7, 4);
+        cache.insert(7, replacement);
+        QCOMPARE(cache.lookup(7), replacement);
+        QCOMPARE(cache.stats().entries, 1);
+        QCOMPARE(cache.stats().bytes, productSize(4));
+
+        // 放不下的新内容同样要把旧内容去掉，编号回绕后不能发出旧产品
+        cache.insert(7, makeFrames(7, 11));
+        QVERIFY(cache.lookup(7).isEmpty());
+        QCOMPARE(cache.stats().bytes, qint64(0));
+    }
+
+    void shrinkingCapacityEvicts() {
+        ProductCache cache(productSize(6));
+        cache.insert(1, makeFrames(1, 3));
+        cache.insert(2, makeFrames(2, 3));
+        cache.setCapacity(productSize(4));
+        QVERIFY(cache.lookup(1).isEmpty());
+        QVERIFY(!cache.lookup(2).isEmpty());
+
+        cache.setCapacity(0);
+        QCOMPARE(cache.stats().entries, 0);
+        cache.insert(3, makeFrames(3, 1));
+        QVERIFY(cache.lookup(3).isEmpty());
+    }
+
+    void splitsTiledMessages() {
+        const QByteArray first = makeFrames(10, 2);
+        const QByteArray second = makeFrames(11, 1);
+        const QByteArray third = makeFrames(12, 3);
+        const QList<QPair<quint16, QByteArray>> messages = ProductCache::splitMessages(first + second + third);
+        QCOMPARE(messages.size(), 3);
+        QCOMPARE(messages.at(0).first, quint16(10));
+        QCOMPARE(messages.at(0).second, first);
+        QCOMPARE(messages.at(1).first, quint16(11));
+        QCOMPARE(messages.at(1).second, second);
+        QCOMPARE(messages.at(2).first, quint16(12));
+        QCOMPARE(messages.at(2).second, third);
+    }
+
+    void cachesTiledFileByTileNumber() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath("tiled.bin");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(makeFrames(20, 2) + makeFrames(21, 2));
+        file.close();
+
+        ProductCache cache(productSize(10));
+        QVERIFY(cache.insertFile(19, path));
+        QVERIFY(cache.lookup(19).isEmpty());
+        QCOMPARE(cache.lookup(20), makeFrames(20, 2));
+        QCOMPARE(cache.lookup(21), makeFrames(21, 2));
+    }
+
+    void packetSourceReturnsAllFrames() {
+        CachedPacketSource source(makeFrames(1, 5));
+        QCOMPARE(drainPackets(&source), QList<quint16>({1, 2, 3, 4, 5}));
+    }
+
+    void packetSourceSelectsRequestedFrames() {
+        // 超出本图像范围的包号被忽略
+        CachedPacketSource source(makeFrames(1, 6), QList<quint16>({2, 4, 5, 9}));
+        QCOMPARE(drainPackets(&source), QList<quint16>({2, 4, 5}));
+
+        CachedPacketSource none(makeFrames(1, 3), QList<quint16>({7, 8}));
+        QVERIFY(!none.hasNextPacket());
+    }
+
+    void packetSourceStopsAtTruncatedFrame() {
+        QByteArray frames = makeFrames(1, 3);
+        frames.chop(3);
+        CachedPacketSource source(frames);
+        QCOMPARE(drainPackets(&source), QList<quint16>({1, 2, 0}));
+    }
+};
+
+QTEST_APPLESS_MAIN(ProductCacheTest)
+#include "product_cache_test.moc"
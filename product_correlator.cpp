@@ -0,0 +1,219 @@
+#include "product_correlator.h"
+#include "product_journal.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+
+// 默认组超时：原先单个兄弟文件最多等待 5 s，这里给整组留出同样的余量
+static const int DEFAULT_GROUP_TIMEOUT_MS = 10000;
+static const int EXPIRY_CHECK_INTERVAL_MS = 1000;
+// GMTI 打包输出与原始文件位于同一目录，需排除
+static const QLatin1String GMTI_PACKAGED_SUFFIX("_gmti_packaged");
+
+namespace {
+
+enum class MemberRole {
+    None,
+    Image,
+    Aux,
+    Txt,
+    Bin
+};
+
+bool isGmtiImageSuffix(const QString& suffix) {
+    return suffix.compare("png", Qt::CaseInsensitive) == 0
+        || suffix.compare("jpg", Qt::CaseInsensitive) == 0
+        || suffix.compare("tif", Qt::CaseInsensitive) == 0;
+}
+
+// 解析文件所属的组键与组内角色
+MemberRole classify(ProductType type, const QFileInfo& info, QString* key) {
+    const QString baseName = info.baseName();
+    const QString suffix = info.suffix();
+    const QString dirPath = QDir::cleanPath(info.path());
+
+    if (type == ProductType::SAR) {
+        if (baseName.length() < 3) {
+            return MemberRole::None;
+        }
+        const QString prefix = baseName.left(3);
+        MemberRole role = MemberRole::None;
+        if (prefix.compare("IMG", Qt::CaseInsensitive) == 0 && suffix.compare("tif", Qt::CaseInsensitive) == 0) {
+            role = MemberRole::Image;
+        } else if (prefix.compare("AUX", Qt::CaseInsensitive) == 0 && suffix.compare("dat", Qt::CaseInsensitive) == 0) {
+            role = MemberRole::Aux;
+        }
+        if (role != MemberRole::None && key) {
+            *key = dirPath + QLatin1Char('/') + baseName.mid(3);
+        }
+        return role;
+    }
+
+    if (baseName.endsWith(GMTI_PACKAGED_SUFFIX)) {
+        return MemberRole::None;
+    }
+    MemberRole role = MemberRole::None;
+    if (suffix.compare("txt", Qt::CaseInsensitive) == 0) {
+        role = MemberRole::Txt;
+    } else if (suffix.compare("bin", Qt::CaseInsensitive) == 0) {
+        role = MemberRole::Bin;
+    } else if (isGmtiImageSuffix(suffix)) {
+        role = MemberRole::Image;
+    }
+    if (role != MemberRole::None && key) {
+        *key = dirPath + QLatin1Char('/') + baseName;
+    }
+    return role;
+}
+
+} // namespace
+
+ProductCorrelator::ProductCorrelator(ProductType type, QObject* parent)
+    : QObject(parent),
+    m_type(type),
+    m_timeoutMs(DEFAULT_GROUP_TIMEOUT_MS),
+    m_expiryTimer(new QTimer(this))
+{
+    qRegisterMetaType<ProductJob>("ProductJob");
+    m_expiryTimer->setInterval(EXPIRY_CHECK_INTERVAL_MS);
+    connect(m_expiryTimer, &QTimer::timeout, this, &ProductCorrelator::onExpiryTimeout);
+}
+
+void ProductCorrelator::setProductType(ProductType type) {
+    if (m_type != type) {
+        clear();
+        m_type = type;
+    }
+}
+
+ProductType ProductCorrelator::productType() const {
+    return m_type;
+}
+
+void ProductCorrelator::setTimeout(int timeoutMs) {
+    m_timeoutMs = timeoutMs;
+}
+
+void ProductCorrelator::setJournal(ProductJournal* journal) {
+    m_journal = journal;
+}
+
+void ProductCorrelator::clear() {
+    m_groups.clear();
+    m_expiryTimer->stop();
+}
+
+int ProductCorrelator::pendingCount() const {
+    return m_groups.size();
+}
+
+QString ProductCorrelator::auxPathForImage(const QString& tifFilePath) {
+    QFileInfo tifFileInfo(tifFilePath);
+    const QString tifBaseName = tifFileInfo.baseName();
+    if (tifBaseName.length() < 3 || tifBaseName.left(3).compare("IMG", Qt::CaseInsensitive) != 0) {
+        return QString();
+    }
+    // 规则：前3个字符"IMG"→"AUX"，后缀".tif"→".dat"，与TIF同目录
+    return QString("%1%2%3.dat").arg(tifFileInfo.path(), QDir::separator(), "AUX" + tifBaseName.mid(3));
+}
+
+bool ProductCorrelator::isMemberFile(ProductType type, const QString& filePath) {
+    return classify(type, QFileInfo(filePath), nullptr) != MemberRole::None;
+}
+
+QStringList ProductCorrelator::memberNameFilters(ProductType type) {
+    if (type == ProductType::SAR) {
+        return QStringList{"*.tif", "*.dat"};
+    }
+    return QStringList{"*.bin", "*.txt", "*.png", "*.jpg", "*.tif"};
+}
+
+bool ProductCorrelator::isComplete(const ProductJob& job) const {
+    if (job.imagePath.isEmpty()) {
+        return false;
+    }
+    if (job.type == ProductType::SAR) {
+        return !job.auxPath.isEmpty();
+    }
+    return !job.txtPath.isEmpty() && !job.binPath.isEmpty();
+}
+
+void ProductCorrelator::addFile(const QString& filePath) {
+    QFileInfo info(filePath);
+    QString key;
+    const MemberRole role = classify(m_type, info, &key);
+    if (role == MemberRole::None) {
+        return;
+    }
+    // 已送达的产品不再重复检测，未结束的产品由 pendingProducts() 续传；
+    // 失败（或被丢弃）的产品重新出现时按新产品处理，失败的传输才能重试
+    if (m_journal) {
+        const ProductState state = m_journal->state(key);
+        const bool delivered = state == ProductState::Sent || state == ProductState::Acked;
+        const bool pending = state != ProductState::Unknown && !ProductJournal::isTerminal(state);
+        if (delivered || pending) {
+            return;
+        }
+    }
+
+    auto it = m_groups.find(key);
+    if (it == m_groups.end()) {
+        Group group;
+        group.job.type = m_type;
+        group.job.key = key;
+        group.firstSeenMs = QDateTime::currentMSecsSinceEpoch();
+        group.job.firstSeenMs = group.firstSeenMs;
+        group.job.fileReadyMs = info.lastModified().toMSecsSinceEpoch();
+        it = m_groups.insert(key, group);
+    }
+
+    ProductJob& job = it->job;
+    switch (role) {
+    case MemberRole::Image: job.imagePath = filePath; break;
+    case MemberRole::Aux:   job.auxPath = filePath;   break;
+    case MemberRole::Txt:   job.txtPath = filePath;   break;
+    case MemberRole::Bin:   job.binPath = filePath;   break;
+    case MemberRole::None:  break;
+    }
+
+    if (isComplete(job)) {
+        job.completedMs = QDateTime::currentMSecsSinceEpoch();
+        const ProductJob readyJob = job;
+        m_groups.erase(it);
+        if (m_groups.isEmpty()) {
+            m_expiryTimer->stop();
+        }
+        qDebug() << "Product group complete:" << readyJob.key;
+        emit productReady(readyJob);
+        return;
+    }
+
+    if (!m_expiryTimer->isActive()) {
+        m_expiryTimer->start();
+    }
+}
+
+void ProductCorrelator::onExpiryTimeout() {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = m_groups.begin(); it != m_groups.end();) {
+        if (now - it->firstSeenMs < m_timeoutMs) {
+            ++it;
+            continue;
+        }
+        const ProductJob& job = it->job;
+        QStringList presentFiles;
+        for (const QString& path : {job.imagePath, job.auxPath, job.txtPath, job.binPath}) {
+            if (!path.isEmpty()) {
+                presentFiles << path;
+            }
+        }
+        qWarning() << "Product group" << it.key() << "incomplete after" << m_timeoutMs << "ms, dropping. Present:" << presentFiles;
+        const QString key = it.key();
+        it = m_groups.erase(it);
+        emit productExpired(key, presentFiles);
+    }
+    if (m_groups.isEmpty()) {
+        m_expiryTimer->stop();
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef PRODUCT_CORRELATOR_H
+#define PRODUCT_CORRELATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMetaType>
+#include <QTimer>
+
+class ProductJournal;
+
+// 产品类型：SAR/ISAR 为 IMG*.tif + AUX*.dat，GMTI 为 图像 + .txt + .bin
+enum class ProductType {
+    SAR,
+    GMTI
+};
+
+// 一组齐全的产品文件，作为一次打包/传输的输入
+struct ProductJob {
+    ProductType type = ProductType::SAR;
+    QString key;        // 组键：目录 + 去掉前缀后的基名
+    QString imagePath;  // SAR: IMG*.tif；GMTI: png/jpg/tif 底图
+    QString auxPath;    // SAR: AUX*.dat
+    QString txtPath;    // GMTI: 角点坐标
+    QString binPath;    // GMTI: 目标信息
+    // 以下仅在内存中，用于分环节计时（毫秒时间戳）
+    qint64 fileReadyMs = 0;     // 首个成员文件的最后修改时刻
+    qint64 firstSeenMs = 0;     // 首个成员被发现的时刻
+    qint64 completedMs = 0;     // 组内文件到齐的时刻
+};
+Q_DECLARE_METATYPE(ProductJob)
+
+/**
+ * @class ProductCorrelator
+ * @brief 同组文件关联器。
+ *
+ * 文件到达顺序不确定（AUX 可能晚于 IMG），关联器按命名规则把到达的文件归入各自的组，
+ * 组内成员齐全时立即发出 productReady；超时仍不齐全的组发出 productExpired 并丢弃。
+ * 整个过程由事件驱动，没有任何线程阻塞等待兄弟文件。
+ */
+class ProductCorrelator : public QObject {
+    Q_OBJECT
+public:
+    explicit ProductCorrelator(ProductType type = ProductType::SAR, QObject* parent = nullptr);
+
+    void setProductType(ProductType type);
+    ProductType productType() const;
+    void setTimeout(int timeoutMs);
+    // 设置后，日志中已送达或仍待续传的产品会被直接忽略；失败的产品重新出现时照常关联，以便重试
+    void setJournal(ProductJournal* journal);
+    void addFile(const QString& filePath);
+    void clear();
+    int pendingCount() const;
+
+    // 命名规则：IMGxxx.tif → AUXxxx.dat（同目录）；不符合规则时返回空字符串
+    static QString auxPathForImage(const QString& tifFilePath);
+    // 文件是否属于该产品类型的组成文件（用于监控端过滤）
+    static bool isMemberFile(ProductType type, const QString& filePath);
+    static QStringList memberNameFilters(ProductType type);
+
+signals:
+    void productReady(const ProductJob& job);
+    void productExpired(const QString& key, const QStringList& presentFiles);
+
+private slots:
+    void onExpiryTimeout();
+
+private:
+    struct Group {
+        ProductJob job;
+        qint64 firstSeenMs = 0;
+    };
+
+    bool isComplete(const ProductJob& job) const;
+
+    ProductType m_type;
+    int m_timeoutMs;
+    ProductJournal* m_journal = nullptr;
+    QHash<QString, Group> m_groups;
+    QTimer* m_expiryTimer;
+};
+
+#endif // PRODUCT_CORRELATOR_H
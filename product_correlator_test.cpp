@@ -0,0 +1,96 @@
+// product_correlator_test.cpp
+// ProductCorrelator：SAR 的 IMG/AUX 与 GMTI 的图像/txt/bin 不论到达顺序都在最后一个成员到达时发出，
+// 打包输出与无关文件不参与关联；超时仍不齐全的组带着已到达的文件被丢弃，齐全的组不会再过期。
+#include <QtTest>
+#include <QSignalSpy>
+#include "product_correlator.h"
+
+class ProductCorrelatorTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void completesSarPairInEitherOrder() {
+        ProductCorrelator correlator(ProductType::SAR);
+        QSignalSpy ready(&correlator, &ProductCorrelator::productReady);
+
+        correlator.addFile("/data/run1/AUX_0001.dat");
+        QCOMPARE(ready.count(), 0);
+        QCOMPARE(correlator.pendingCount(), 1);
+        correlator.addFile("/data/run1/IMG_0001.tif");
+        QCOMPARE(ready.count(), 1);
+        QCOMPARE(correlator.pendingCount(), 0);
+
+        const ProductJob job = ready.takeFirst().at(0).value<ProductJob>();
+        QCOMPARE(job.type, ProductType::SAR);
+        QCOMPARE(job.key, QString("/data/run1/_0001"));
+        QCOMPARE(job.imagePath, QString("/data/run1/IMG_0001.tif"));
+        QCOMPARE(job.auxPath, QString("/data/run1/AUX_0001.dat"));
+
+        // 同名不同目录是不同的组
+        correlator.addFile("/data/run1/IMG_0002.tif");
+        correlator.addFile("/data/run2/AUX_0002.dat");
+        QCOMPARE(ready.count(), 0);
+        QCOMPARE(correlator.pendingCount(), 2);
+    }
+
+    void completesGmtiTripleAndIgnoresPackagedOutput() {
+        ProductCorrelator correlator(ProductType::GMTI);
+        QSignalSpy ready(&correlator, &ProductCorrelator::productReady);
+
+        correlator.addFile("/data/gmti/track_7.bin");
+        correlator.addFile("/data/gmti/track_7_gmti_packaged.bin");
+        correlator.addFile("/data/gmti/track_7.png");
+        correlator.addFile("/data/gmti/notes.doc");
+        QCOMPARE(ready.count(), 0);
+        QCOMPARE(correlator.pendingCount(), 1);
+        correlator.addFile("/data/gmti/track_7.txt");
+        QCOMPARE(ready.count(), 1);
+
+        const ProductJob job = ready.takeFirst().at(0).value<ProductJob>();
+        QCOMPARE(job.type, ProductType::GMTI);
+        QCOMPARE(job.imagePath, QString("/data/gmti/track_7.png"));
+        QCOMPARE(job.txtPath, QString("/data/gmti/track_7.txt"));
+        QCOMPARE(job.binPath, QString("/data/gmti/track_7.bin"));
+    }
+
+    void expiresIncompleteGroupAfterTimeout() {
+        ProductCorrelator correlator(ProductType::SAR);
+        correlator.setTimeout(100);
+        QSignalSpy ready(&correlator, &ProductCorrelator::productReady);
+        QSignalSpy expired(&correlator, &ProductCorrelator::productExpired);
+
+        correlator.addFile("/data/run1/IMG_0003.tif");
+        QVERIFY(expired.wait(5000));
+        QCOMPARE(expired.count(), 1);
+        QCOMPARE(expired.at(0).at(0).toString(), QString("/data/run1/_0003"));
+        QCOMPARE(expired.at(0).at(1).toStringList(), QStringList{"/data/run1/IMG_0003.tif"});
+        QCOMPARE(correlator.pendingCount(), 0);
+
+        // 迟到的兄弟文件开始一个新组，不会与已丢弃的成员拼成产品
+        correlator.addFile("/data/run1/AUX_0003.dat");
+        QCOMPARE(ready.count(), 0);
+        QCOMPARE(correlator.pendingCount(), 1);
+    }
+
+    void completedGroupDoesNotExpire() {
+        ProductCorrelator correlator(ProductType::SAR);
+        correlator.setTimeout(100);
+        QSignalSpy ready(&correlator, &ProductCorrelator::productReady);
+        QSignalSpy expired(&correlator, &ProductCorrelator::productExpired);
+
+        correlator.addFile("/data/run1/IMG_0004.tif");
+        correlator.addFile("/data/run1/IMG_0005.tif");
+        correlator.addFile("/data/run1/AUX_0004.dat");
+        QCOMPARE(ready.count(), 1);
+
+        // 检查间隔为 1 s，等过两次检查：只有仍不齐全的 _0005 过期
+        QTest::qWait(2500);
+        QCOMPARE(expired.count(), 1);
+        QCOMPARE(expired.at(0).at(0).toString(), QString("/data/run1/_0005"));
+        QCOMPARE(ready.count(), 1);
+        QCOMPARE(correlator.pendingCount(), 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(ProductCorrelatorTest)
+#include "product_correlator_test.moc"
@@ -0,0 +1,535 @@
+#include "product_journal.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QMutexLocker>
+#include <QByteArrayList>
+#include <QSet>
+#include <algorithm>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#endif
+
+// 默认最多保留的索引条目数（未结束的产品不受此限制）
+static const int DEFAULT_MAX_ENTRIES = 100000;
+// 追加记录数超过 max(该值, 2×索引大小) 时触发压缩
+static const int MIN_COMPACTION_APPENDS = 10000;
+
+namespace {
+
+// 字段中只需转义分隔符与百分号，其余字符（包括中文路径）保持可读
+QByteArray escapeField(const QString& value) {
+    QByteArray bytes = value.toUtf8();
+    bytes.replace('%', "%25");
+    bytes.replace('\t', "%09");
+    bytes.replace('\n', "%0A");
+    return bytes;
+}
+
+QString unescapeField(const QByteArray& bytes) {
+    return QString::fromUtf8(QByteArray::fromPercentEncoding(bytes));
+}
+
+// 追加记录只需数据与文件长度落盘，不必等待修改时间等元数据
+bool syncFile(QFile& file) {
+#if defined(Q_OS_LINUX)
+    return ::fdatasync(file.handle()) == 0;
+#elif defined(Q_OS_UNIX)
+    return ::fsync(file.handle()) == 0;
+#elif defined(Q_OS_WIN)
+    return ::_commit(file.handle()) == 0;
+#else
+    return true;
+#endif
+}
+
+QByteArray tiledProductLine(quint16 imageNumber, const ProductJournal::TiledProduct& product) {
+    QByteArrayList tiles;
+    for (quint16 tile : product.tileNumbers) {
+        tiles.append(QByteArray::number(tile));
+    }
+    return "T\t" + QByteArray::number(imageNumber) + '\t' + QByteArray::number(product.tileSize) + '\t'
+           + tiles.join(',') + '\t' + escapeField(product.filePath) + '\n';
+}
+
+} // namespace
+
+ProductJournal::ProductJournal()
+    : m_maxEntries(DEFAULT_MAX_ENTRIES)
+{
+}
+
+ProductJournal::~ProductJournal() {
+    close();
+}
+
+quint64 ProductJournal::keyHash(const QString& productKey) {
+    // FNV-1a 64 位哈希，索引中只保存哈希值以压缩内存占用
+    const QByteArray bytes = productKey.toUtf8();
+    quint64 hash = 14695981039346656037ULL;
+    for (char c : bytes) {
+        hash ^= static_cast<quint8>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool ProductJournal::isTerminal(ProductState state) {
+    return state == ProductState::Sent || state == ProductState::Acked || state == ProductState::Failed
+        || state == ProductState::Dropped;
+}
+
+bool ProductJournal::open(const QString& journalPath) {
+    close();
+    QMutexLocker locker(&m_mutex);
+    m_index.clear();
+    m_pending.clear();
+    m_imagePaths.clear();
+    m_tiledProducts.clear();
+    std::fill(std::begin(m_stateCounts), std::end(m_stateCounts), 0);
+    m_appendedSinceCompaction = 0;
+    m_lastImageNumber = -1;
+
+    QDir().mkpath(QFileInfo(journalPath).absolutePath());
+    m_file.setFileName(journalPath);
+
+    // 1. 重放已有日志
+    if (m_file.open(QIODevice::ReadWrite)) {
+        const QByteArray content = m_file.readAll();
+        int lineStart = 0;
+        int lines = 0;
+        for (int pos = content.indexOf('\n'); pos >= 0; pos = content.indexOf('\n', lineStart)) {
+            replayLine(content.mid(lineStart, pos - lineStart));
+            lineStart = pos + 1;
+            ++lines;
+        }
+        // 崩溃时可能留下半行，截掉以免与下一条记录粘连
+        if (lineStart < content.size()) {
+            qWarning() << "Journal" << journalPath << "has a truncated tail record, discarding" << content.size() - lineStart << "bytes.";
+            m_file.resize(lineStart);
+        }
+        m_appendedSinceCompaction = lines;
+        m_file.close();
+    }
+
+    // 2. 以追加方式打开
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Failed to open product journal:" << journalPath << m_file.errorString();
+        return false;
+    }
+    qDebug() << "Product journal recovered:" << m_index.size() << "products," << m_pending.size() << "unfinished, from" << journalPath;
+
+    if (m_appendedSinceCompaction > std::max(MIN_COMPACTION_APPENDS, 2 * static_cast<int>(m_index.size()))) {
+        compactLocked();
+    }
+    return true;
+}
+
+void ProductJournal::close() {
+    waitForCompaction();
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_file.isOpen()) {
+            m_file.flush();
+            m_file.close();
+        }
+    }
+    // 等待期间可能又触发了一次压缩；文件关闭后不会再有新的
+    waitForCompaction();
+}
+
+void ProductJournal::waitForCompaction() {
+    for (;;) {
+        std::thread worker;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_compactionThread.joinable()) {
+                return;
+            }
+            worker = std::move(m_compactionThread);
+        }
+        worker.join();
+    }
+}
+
+bool ProductJournal::isOpen() const {
+    QMutexLocker locker(&m_mutex);
+    return m_file.isOpen();
+}
+
+QString ProductJournal::path() const {
+    QMutexLocker locker(&m_mutex);
+    return m_file.fileName();
+}
+
+void ProductJournal::replayLine(const QByteArray& line) {
+    const QList<QByteArray> fields = line.split('\t');
+    if (fields.isEmpty()) {
+        return;
+    }
+    const QByteArray& tag = fields.at(0);
+    if (tag == "P" && fields.size() >= 11) {
+        bool ok = false;
+        const quint64 hash = fields.at(1).toULongLong(&ok, 16);
+        if (!ok) {
+            return;
+        }
+        const uint stateValue = fields.at(2).toUInt();
+        if (stateValue == 0 || stateValue > static_cast<uint>(ProductState::Dropped)) {
+            return;
+        }
+        Entry entry;
+        entry.state = static_cast<ProductState>(stateValue);
+        entry.imageNumber = static_cast<quint16>(fields.at(3).toUInt());
+        entry.timestampMs = fields.at(4).toLongLong();
+
+        ProductJob job;
+        job.type = fields.at(5) == "G" ? ProductType::GMTI : ProductType::SAR;
+        job.key = unescapeField(fields.at(6));
+        job.imagePath = unescapeField(fields.at(7));
+        job.auxPath = unescapeField(fields.at(8));
+        job.txtPath = unescapeField(fields.at(9));
+        job.binPath = unescapeField(fields.at(10));
+        applyLocked(hash, entry, job.key.isEmpty() ? nullptr : &job);
+    } else if (tag == "I" && fields.size() >= 3) {
+        m_imagePaths.insert(static_cast<quint16>(fields.at(1).toUInt()), unescapeField(fields.at(2)));
+    } else if (tag == "T" && fields.size() >= 5) {
+        const quint16 imageNumber = static_cast<quint16>(fields.at(1).toUInt());
+        TiledProduct product;
+        product.tileSize = fields.at(2).toInt();
+        for (const QByteArray& tile : fields.at(3).split(',')) {
+            if (!tile.isEmpty()) {
+                product.tileNumbers.append(static_cast<quint16>(tile.toUInt()));
+            }
+        }
+        product.filePath = unescapeField(fields.at(4));
+        if (product.tileNumbers.isEmpty()) {
+            m_tiledProducts.remove(imageNumber);
+        } else {
+            m_tiledProducts.insert(imageNumber, product);
+        }
+    } else if (tag == "N" && fields.size() >= 2) {
+        m_lastImageNumber = fields.at(1).toInt();
+    }
+}
+
+void ProductJournal::applyLocked(quint64 hash, const Entry& entry, const ProductJob* job) {
+    auto it = m_index.find(hash);
+    if (it != m_index.end()) {
+        m_stateCounts[static_cast<int>(it->state)]--;
+        *it = entry;
+    } else {
+        m_index.insert(hash, entry);
+    }
+    m_stateCounts[static_cast<int>(entry.state)]++;
+
+    if (isTerminal(entry.state)) {
+        m_pending.remove(hash);
+    } else if (job) {
+        PendingProduct& pending = m_pending[hash];
+        pending.job = *job;
+        pending.state = entry.state;
+        pending.imageNumber = entry.imageNumber;
+    } else {
+        auto pendingIt = m_pending.find(hash);
+        if (pendingIt != m_pending.end()) {
+            pendingIt->state = entry.state;
+            pendingIt->imageNumber = entry.imageNumber;
+        }
+    }
+}
+
+bool ProductJournal::appendLineLocked(const QByteArray& line) {
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    if (m_file.write(line) != line.size() || !m_file.flush() || (m_syncOnAppend && !syncFile(m_file))) {
+        qWarning() << "Failed to append to product journal:" << m_file.errorString();
+        return false;
+    }
+    ++m_appendedSinceCompaction;
+    if (m_compacting) {
+        m_compactionTail += line;
+        ++m_compactionTailLines;
+    } else if (m_appendedSinceCompaction > std::max(MIN_COMPACTION_APPENDS, 2 * static_cast<int>(m_index.size()))) {
+        startBackgroundCompactionLocked();
+    }
+    return true;
+}
+
+bool ProductJournal::record(const ProductJob& job, ProductState state, quint16 imageNumber) {
+    QMutexLocker locker(&m_mutex);
+    const quint64 hash = keyHash(job.key);
+    Entry entry;
+    entry.state = state;
+    entry.imageNumber = imageNumber;
+    entry.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    applyLocked(hash, entry, &job);
+
+    QByteArray line = "P\t" + QByteArray::number(hash, 16) + '\t'
+                      + QByteArray::number(static_cast<int>(state)) + '\t'
+                      + QByteArray::number(imageNumber) + '\t'
+                      + QByteArray::number(entry.timestampMs) + '\t'
+                      + (job.type == ProductType::GMTI ? "G" : "S") + '\t'
+                      + escapeField(job.key) + '\t'
+                      + escapeField(job.imagePath) + '\t'
+                      + escapeField(job.auxPath) + '\t'
+                      + escapeField(job.txtPath) + '\t'
+                      + escapeField(job.binPath) + '\n';
+    return appendLineLocked(line);
+}
+
+bool ProductJournal::recordImagePath(quint16 imageNumber, const QString& filePath) {
+    QMutexLocker locker(&m_mutex);
+    m_imagePaths.insert(imageNumber, filePath);
+    return appendLineLocked("I\t" + QByteArray::number(imageNumber) + '\t' + escapeField(filePath) + '\n');
+}
+
+bool ProductJournal::recordTiledProduct(quint16 imageNumber, const TiledProduct& product) {
+    QMutexLocker locker(&m_mutex);
+    if (product.tileNumbers.isEmpty()) {
+        if (!m_tiledProducts.remove(imageNumber)) {
+            return true;
+        }
+    } else {
+        m_tiledProducts.insert(imageNumber, product);
+    }
+    return appendLineLocked(tiledProductLine(imageNumber, product));
+}
+
+ProductState ProductJournal::state(const QString& productKey) const {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_index.constFind(keyHash(productKey));
+    return it == m_index.constEnd() ? ProductState::Unknown : it->state;
+}
+
+bool ProductJournal::contains(const QString& productKey) const {
+    QMutexLocker locker(&m_mutex);
+    return m_index.contains(keyHash(productKey));
+}
+
+QList<ProductJournal::PendingProduct> ProductJournal::pendingProducts() const {
+    QMutexLocker locker(&m_mutex);
+    QList<PendingProduct> products = m_pending.values();
+    // 按图像编号的先后顺序续传
+    std::sort(products.begin(), products.end(), [this](const PendingProduct& a, const PendingProduct& b) {
+        return m_index.value(keyHash(a.job.key)).timestampMs < m_index.value(keyHash(b.job.key)).timestampMs;
+    });
+    return products;
+}
+
+QMap<quint16, QString> ProductJournal::imagePaths() const {
+    QMutexLocker locker(&m_mutex);
+    return m_imagePaths;
+}
+
+QMap<quint16, ProductJournal::TiledProduct> ProductJournal::tiledProducts() const {
+    QMutexLocker locker(&m_mutex);
+    return m_tiledProducts;
+}
+
+// 水位线记录与其他记录一样先落盘，重启后重放到的最后一条 N 记录即最后发出的编号
+quint16 ProductJournal::allocateImageNumber() {
+    QMutexLocker locker(&m_mutex);
+    return allocateLocked(1).first();
+}
+
+// 一批编号回绕后可能落到未结束产品的整图编号或其瓦片编号上，这样的批次整批拒绝
+QList<quint16> ProductJournal::allocateImageNumbers(int count) {
+    QMutexLocker locker(&m_mutex);
+    if (count < 1 || count > MAX_BATCH) {
+        return {};
+    }
+    QSet<quint16> live;
+    for (const PendingProduct& product : std::as_const(m_pending)) {
+        live.insert(product.imageNumber);
+        const auto tiled = m_tiledProducts.constFind(product.imageNumber);
+        if (tiled != m_tiledProducts.constEnd()) {
+            for (quint16 tileNumber : tiled->tileNumbers) {
+                live.insert(tileNumber);
+            }
+        }
+    }
+    for (int i = 0; i < count; ++i) {
+        if (live.contains(static_cast<quint16>(m_lastImageNumber + 1 + i))) {
+            return {};
+        }
+    }
+    return allocateLocked(count);
+}
+
+// 一次分配的编号连续，只需一条记录本批最后一个编号的水位线
+QList<quint16> ProductJournal::allocateLocked(int count) {
+    QList<quint16> imageNumbers;
+    for (int i = 0; i < count; ++i) {
+        imageNumbers.append(static_cast<quint16>(m_lastImageNumber + 1 + i));
+    }
+    m_lastImageNumber = imageNumbers.last();
+    appendLineLocked("N\t" + QByteArray::number(m_lastImageNumber) + '\n');
+    return imageNumbers;
+}
+
+quint16 ProductJournal::nextImageNumber() const {
+    QMutexLocker locker(&m_mutex);
+    return static_cast<quint16>(m_lastImageNumber + 1);
+}
+
+int ProductJournal::countInState(ProductState state) const {
+    QMutexLocker locker(&m_mutex);
+    return m_stateCounts[static_cast<int>(state)];
+}
+
+int ProductJournal::size() const {
+    QMutexLocker locker(&m_mutex);
+    return m_index.size();
+}
+
+void ProductJournal::setMaxEntries(int maxEntries) {
+    QMutexLocker locker(&m_mutex);
+    m_maxEntries = maxEntries;
+}
+
+void ProductJournal::setSyncOnAppend(bool enabled) {
+    QMutexLocker locker(&m_mutex);
+    m_syncOnAppend = enabled;
+}
+
+bool ProductJournal::compact() {
+    QMutexLocker locker(&m_mutex);
+    return compactLocked();
+}
+
+// 淘汰超出上限的最旧已结束条目，一次多淘汰 10%，避免每次追加都触发压缩
+void ProductJournal::evictLocked() {
+    if (m_index.size() <= m_maxEntries) {
+        return;
+    }
+    QList<QPair<qint64, quint64>> terminal;
+    for (auto it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+        if (isTerminal(it->state)) {
+            terminal.append(qMakePair(it->timestampMs, it.key()));
+        }
+    }
+    std::sort(terminal.begin(), terminal.end());
+    const int target = m_maxEntries - m_maxEntries / 10;
+    for (int i = 0; i < terminal.size() && m_index.size() > target; ++i) {
+        auto it = m_index.find(terminal.at(i).second);
+        m_stateCounts[static_cast<int>(it->state)]--;
+        m_index.erase(it);
+    }
+}
+
+ProductJournal::Snapshot ProductJournal::snapshotLocked() const {
+    Snapshot snapshot;
+    snapshot.path = m_file.fileName();
+    snapshot.index = m_index;
+    snapshot.pending = m_pending;
+    snapshot.imagePaths = m_imagePaths;
+    snapshot.tiledProducts = m_tiledProducts;
+    snapshot.lastImageNumber = m_lastImageNumber;
+    return snapshot;
+}
+
+void ProductJournal::writeSnapshot(QIODevice* out, const Snapshot& snapshot) {
+    for (auto it = snapshot.index.constBegin(); it != snapshot.index.constEnd(); ++it) {
+        const auto pendingIt = snapshot.pending.constFind(it.key());
+        const ProductJob job = pendingIt != snapshot.pending.constEnd() ? pendingIt->job : ProductJob();
+        QByteArray line = "P\t" + QByteArray::number(it.key(), 16) + '\t'
+                          + QByteArray::number(static_cast<int>(it->state)) + '\t'
+                          + QByteArray::number(it->imageNumber) + '\t'
+                          + QByteArray::number(it->timestampMs) + '\t'
+                          + (job.type == ProductType::GMTI ? "G" : "S") + '\t'
+                          + escapeField(job.key) + '\t'
+                          + escapeField(job.imagePath) + '\t'
+                          + escapeField(job.auxPath) + '\t'
+                          + escapeField(job.txtPath) + '\t'
+                          + escapeField(job.binPath) + '\n';
+        out->write(line);
+    }
+    for (auto it = snapshot.imagePaths.constBegin(); it != snapshot.imagePaths.constEnd(); ++it) {
+        out->write("I\t" + QByteArray::number(it.key()) + '\t' + escapeField(it.value()) + '\n');
+    }
+    for (auto it = snapshot.tiledProducts.constBegin(); it != snapshot.tiledProducts.constEnd(); ++it) {
+        out->write(tiledProductLine(it.key(), it.value()));
+    }
+    out->write("N\t" + QByteArray::number(snapshot.lastImageNumber) + '\n');
+}
+
+// 补写快照之后追加的记录，原子地替换日志文件并重新以追加方式打开
+bool ProductJournal::replaceFileLocked(QSaveFile* out, const QByteArray& tail) {
+    out->write(tail);
+    m_file.close();
+    bool ok = out->commit();
+    if (!ok) {
+        qWarning() << "Failed to commit compacted product journal:" << out->errorString();
+    }
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Failed to reopen product journal after compaction:" << m_file.errorString();
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * @brief 同步压缩：淘汰超出上限的条目，再把当前索引原子地重写为新日志。
+ */
+bool ProductJournal::compactLocked() {
+    evictLocked();
+    const Snapshot snapshot = snapshotLocked();
+    QSaveFile out(snapshot.path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to compact product journal:" << out.errorString();
+        return false;
+    }
+    writeSnapshot(&out, snapshot);
+    m_appendedSinceCompaction = 0;
+    if (!replaceFileLocked(&out, QByteArray())) {
+        return false;
+    }
+    qDebug() << "Product journal compacted to" << m_index.size() << "products.";
+    return true;
+}
+
+// 在锁内取快照（容器隐式共享，代价是之后首次修改时的一次内存拷贝），磁盘重写交给后台线程
+void ProductJournal::startBackgroundCompactionLocked() {
+    if (m_compactionThread.joinable()) {
+        // 上一次压缩已经换完文件，线程只剩退出
+        m_compactionThread.join();
+    }
+    evictLocked();
+    m_compacting = true;
+    m_compactionTail.clear();
+    m_compactionTailLines = 0;
+    m_compactionThread = std::thread(&ProductJournal::runBackgroundCompaction, this, snapshotLocked());
+}
+
+void ProductJournal::runBackgroundCompaction(const Snapshot& snapshot) {
+    QSaveFile out(snapshot.path);
+    const bool written = out.open(QIODevice::WriteOnly);
+    if (written) {
+        writeSnapshot(&out, snapshot);
+    } else {
+        qWarning() << "Failed to compact product journal:" << out.errorString();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    // 压缩期间日志被关闭或换了路径时放弃这次结果
+    if (written && m_file.isOpen() && m_file.fileName() == snapshot.path) {
+        if (replaceFileLocked(&out, m_compactionTail)) {
+            qDebug() << "Product journal compacted to" << snapshot.index.size() << "products.";
+        }
+        m_appendedSinceCompaction = m_compactionTailLines;
+    } else {
+        out.cancelWriting();
+        // 失败时等再积累一轮追加后重试，避免每条记录都启动一次压缩
+        m_appendedSinceCompaction = 0;
+    }
+    m_compacting = false;
+    m_compactionTail.clear();
+    m_compactionTailLines = 0;
+}
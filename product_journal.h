@@ -0,0 +1,145 @@
+#ifndef PRODUCT_JOURNAL_H
+#define PRODUCT_JOURNAL_H
+
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QFile>
+#include <QMutex>
+#include <thread>
+#include "product_correlator.h"
+
+class QIODevice;
+class QSaveFile;
+
+// 产品在流水线中的状态，按推进顺序排列
+enum class ProductState : quint8 {
+    Unknown = 0,
+    Detected = 1,   // 产品组已齐全
+    Packed = 2,     // 已打包成待发送的 bin 文件
+    Sent = 3,       // 已全部写入套接字
+    Acked = 4,      // 接收端已确认
+    Failed = 5,     // 处理或传输失败
+    Dropped = 6     // 链路过载时按策略丢弃
+};
+
+/**
+ * @class ProductJournal
+ * @brief 只追加的产品状态日志。
+ *
+ * 每次状态变化追加一行到磁盘日志，默认追加后 fdatasync，断电后重放日志即可恢复到最后一次记录；
+ * 内存中只保留 “组键哈希 → 状态” 的紧凑索引，已结束产品不保留路径字符串。
+ * 图像编号也由日志分配：每次分配追加一条水位线记录，重启后从水位线之后继续编号，不会重复使用已发出的编号。
+ * 追加量超过阈值时在后台线程压缩（把当前索引的快照重写为新日志，期间的追加同时写入新旧两份），
+ * 记录状态的线程不等待磁盘重写；索引超过上限时淘汰最旧的已结束条目。
+ * 所有接口线程安全。
+ */
+class ProductJournal {
+public:
+    // 需要续传的未完成产品
+    struct PendingProduct {
+        ProductJob job;
+        ProductState state = ProductState::Unknown;
+        quint16 imageNumber = 0;
+    };
+
+    // 瓦片产品：整图编号对应的各瓦片编号与切分边长，重新打包时沿用
+    struct TiledProduct {
+        QString filePath;
+        int tileSize = 0;
+        QList<quint16> tileNumbers;
+    };
+
+    ProductJournal();
+    ~ProductJournal();
+
+    // 打开（必要时创建）日志文件并重放恢复
+    bool open(const QString& journalPath);
+    void close();
+    bool isOpen() const;
+    QString path() const;
+
+    // 记录状态变化；imageNumber 与 job 信息一并落盘，便于重启后续传
+    bool record(const ProductJob& job, ProductState state, quint16 imageNumber);
+    // 记录图像编号与文件路径的对应关系（供 ISAR 请求查询）
+    bool recordImagePath(quint16 imageNumber, const QString& filePath);
+    // 记录瓦片产品的瓦片编号；tileNumbers 为空表示该整图编号已不再是瓦片产品（编号被复用）
+    bool recordTiledProduct(quint16 imageNumber, const TiledProduct& product);
+
+    ProductState state(const QString& productKey) const;
+    bool contains(const QString& productKey) const;
+    QList<PendingProduct> pendingProducts() const;
+    QMap<quint16, QString> imagePaths() const;
+    QMap<quint16, TiledProduct> tiledProducts() const;
+
+    // 分配下一个图像编号（16 位循环），分配先落盘再返回，所有发出的编号都经过这里
+    quint16 allocateImageNumber();
+    // 一次分配 count 个连续编号（如瓦片产品的各瓦片），只追加一条水位线记录；
+    // count 不在 [1, MAX_BATCH] 内或这批编号会复用未结束产品（含其瓦片）的编号时返回空列表，水位线不变
+    QList<quint16> allocateImageNumbers(int count);
+    static constexpr int MAX_BATCH = 4096;
+    // 下一次分配将返回的编号
+    quint16 nextImageNumber() const;
+    int countInState(ProductState state) const;
+    int size() const;
+
+    void setMaxEntries(int maxEntries);
+    // 关闭后每条记录只写入页缓存：进程崩溃不丢记录，断电可能丢失最后几条（重启后相应产品会重新检测发送）
+    void setSyncOnAppend(bool enabled);
+    // 同步压缩，返回前新日志已落盘
+    bool compact();
+
+    static bool isTerminal(ProductState state);
+    static quint64 keyHash(const QString& productKey);
+
+private:
+    struct Entry {
+        qint64 timestampMs = 0;
+        quint16 imageNumber = 0;
+        ProductState state = ProductState::Unknown;
+    };
+
+    // 压缩时写出的索引快照；容器隐式共享，拷贝时不复制数据
+    struct Snapshot {
+        QString path;
+        QHash<quint64, Entry> index;
+        QHash<quint64, PendingProduct> pending;
+        QMap<quint16, QString> imagePaths;
+        QMap<quint16, TiledProduct> tiledProducts;
+        int lastImageNumber = -1;
+    };
+
+    void applyLocked(quint64 hash, const Entry& entry, const ProductJob* job);
+    bool appendLineLocked(const QByteArray& line);
+    QList<quint16> allocateLocked(int count);
+    bool compactLocked();
+    void evictLocked();
+    Snapshot snapshotLocked() const;
+    static void writeSnapshot(QIODevice* out, const Snapshot& snapshot);
+    bool replaceFileLocked(QSaveFile* out, const QByteArray& tail);
+    void startBackgroundCompactionLocked();
+    void runBackgroundCompaction(const Snapshot& snapshot);
+    void waitForCompaction();
+    void replayLine(const QByteArray& line);
+
+    mutable QMutex m_mutex;
+    QFile m_file;
+    QHash<quint64, Entry> m_index;
+    QHash<quint64, PendingProduct> m_pending;  // 只保存未结束产品的完整信息
+    QMap<quint16, QString> m_imagePaths;
+    QMap<quint16, TiledProduct> m_tiledProducts;
+    int m_stateCounts[7] = {0, 0, 0, 0, 0, 0, 0};
+    int m_maxEntries;
+    int m_appendedSinceCompaction = 0;
+    int m_lastImageNumber = -1;   // 最后分配的图像编号（水位线），-1 表示尚未分配
+    bool m_syncOnAppend = true;
+
+    // 后台压缩：进行中时追加的记录同时缓存在 m_compactionTail，换文件前补写到新日志末尾
+    std::thread m_compactionThread;
+    bool m_compacting = false;
+    QByteArray m_compactionTail;
+    int m_compactionTailLines = 0;
+};
+
+#endif // PRODUCT_JOURNAL_H
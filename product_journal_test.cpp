@@ -0,0 +1,194 @@
+// product_journal_test.cpp
+// ProductJournal 重启后重放状态、截断半行、压缩与按上限淘汰，以及图像编号水位线在重启后不回退；
+// 另外覆盖关联器按日志状态去重：已送达与待续传的产品被忽略，失败的产品可以再次检测。
+#include <QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include "product_correlator.h"
+#include "product_journal.h"
+
+namespace {
+
+ProductJob sarJob(const QString& dir, const QString& name) {
+    ProductJob job;
+    job.type = ProductType::SAR;
+    job.key = dir + "/" + name;
+    job.imagePath = dir + "/IMG" + name + ".tif";
+    job.auxPath = dir + "/AUX" + name + ".dat";
+    return job;
+}
+
+} // namespace
+
+class ProductJournalTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init() {
+        QVERIFY(m_dir.isValid());
+        m_journalPath = m_dir.filePath(QString("journal_%1.log").arg(QTest::currentTestFunction()));
+    }
+
+    void replaysStatesAndPendingProducts() {
+        const ProductJob sent = sarJob(m_dir.path(), "_001");
+        const ProductJob pending = sarJob(m_dir.path(), "_002");
+        {
+            ProductJournal journal;
+            QVERIFY(journal.open(m_journalPath));
+            journal.setSyncOnAppend(false);
+            const quint16 first = journal.allocateImageNumber();
+            QVERIFY(journal.record(sent, ProductState::Detected, first));
+            QVERIFY(journal.record(sent, ProductState::Sent, first));
+            QVERIFY(journal.recordImagePath(first, sent.imagePath));
+            QVERIFY(journal.record(pending, ProductState::Detected, journal.allocateImageNumber()));
+        }
+
+        ProductJournal journal;
+        QVERIFY(journal.open(m_journalPath));
+        QCOMPARE(journal.size(), 2);
+        QCOMPARE(journal.state(sent.key), ProductState::Sent);
+        QCOMPARE(journal.state(pending.key), ProductState::Detected);
+        QCOMPARE(journal.state(m_dir.path() + "/_003"), ProductState::Unknown);
+        QCOMPARE(journal.countInState(ProductState::Sent), 1);
+        QCOMPARE(journal.countInState(ProductState::Detected), 1);
+        QCOMPARE(journal.imagePaths().value(0), sent.imagePath);
+
+        // 只有未结束的产品带着完整路径与原编号等待续传
+        const QList<ProductJournal::PendingProduct> products = journal.pendingProducts();
+        QCOMPARE(products.size(), 1);
+        QCOMPARE(products.first().job.key, pending.key);
+        QCOMPARE(products.first().job.auxPath, pending.auxPath);
+        QCOMPARE(products.first().imageNumber, quint16(1));
+    }
+
+    void discardsTruncatedTailRecord() {
+        const ProductJob job = sarJob(m_dir.path(), "_010");
+        {
+            ProductJournal journal;
+            QVERIFY(journal.open(m_journalPath));
+            QVERIFY(journal.record(job, ProductState::Sent, journal.allocateImageNumber()));
+        }
+        {
+            QFile file(m_journalPath);
+            QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+            file.write("P\t12345");   // 崩溃时只写了半行
+        }
+        {
+            ProductJournal journal;
+            QVERIFY(journal.open(m_journalPath));
+            QCOMPARE(journal.size(), 1);
+            // 半行被截掉，新记录不会与它粘连
+            QVERIFY(journal.record(sarJob(m_dir.path(), "_011"), ProductState::Failed, journal.allocateImageNumber()));
+        }
+        ProductJournal journal;
+        QVERIFY(journal.open(m_journalPath));
+        QCOMPARE(journal.size(), 2);
+        QCOMPARE(journal.state(m_dir.path() + "/_011"), ProductState::Failed);
+    }
+
+    void allocationWatermarkSurvivesRestart() {
+        {
+            ProductJournal journal;
+            QVERIFY(journal.open(m_journalPath));
+            QCOMPARE(journal.nextImageNumber(), quint16(0));
+            const quint16 product = journal.allocateImageNumber();
+            QVERIFY(journal.record(sarJob(m_dir.path(), "_020"), ProductState::Detected, product));
+            // 不对应任何产品状态的分配（手动发送、回传的芯片等）同样要推进水位线
+            for (int i = 0; i < 4; ++i) {
+                journal.allocateImageNumber();
+            }
+            QCOMPARE(journal.nextImageNumber(), quint16(5));
+        }
+        {
+            ProductJournal journal;
+            QVERIFY(journal.open(m_journalPath));
+            QCOMPARE(journal.nextImageNumber(), quint16(5));
+            // 重启后再次记录旧产品的状态不会让水位线回退
+            QVERIFY(journal.record(sarJob(m_dir.path(), "_020"), ProductState::Detected, 0));
+            QCOMPARE(journal.allocateImageNumber(), quint16(5));
+            QVERIFY(journal.compact());
+        }
+        ProductJournal journal;
+        QVERIFY(journal.open(m_journalPath));
+        QCOMPARE(journal.nextImageNumber(), quint16(6));
+    }
+
+    void compactionKeepsLiveState() {
+        const ProductJob pending = sarJob(m_dir.path(), "_030");
+        {
+            ProductJournal journal;
+            QVERIFY(journal.open(m_journalPath));
+            journal.setSyncOnAppend(false);
+            // 同一产品反复改状态，压缩后只剩最后一条
+            for (int i = 0; i < 50; ++i) {
+                const ProductJob job = sarJob(m_dir.path(), QString("_%1").arg(100 + i % 5));
+                QVERIFY(journal.record(job, i < 45 ? ProductState::Detected : ProductState::Sent, quint16(i % 5)));
+            }
+            QVERIFY(journal.record(pending, ProductState::Detected, journal.allocateImageNumber()));
+            QVERIFY(journal.recordImagePath(7, m_dir.filePath("IMG_007.tif")));
+            QVERIFY(journal.compact());
+        }
+        QFile file(m_journalPath);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        // 6 个产品、1 条路径与 1 条水位线
+        QCOMPARE(file.readAll().count('\n'), 6 + 1 + 1);
+
+        ProductJournal journal;
+        QVERIFY(journal.open(m_journalPath));
+        QCOMPARE(journal.size(), 6);
+        QCOMPARE(journal.countInState(ProductState::Sent), 5);
+        QCOMPARE(journal.pendingProducts().size(), 1);
+        QCOMPARE(journal.pendingProducts().first().job.imagePath, pending.imagePath);
+        QCOMPARE(journal.imagePaths().value(7), m_dir.filePath("IMG_007.tif"));
+        QCOMPARE(journal.nextImageNumber(), quint16(1));
+    }
+
+    void evictsOldestFinishedEntries() {
+        ProductJournal journal;
+        QVERIFY(journal.open(m_journalPath));
+        journal.setSyncOnAppend(false);
+        journal.setMaxEntries(20);
+        const ProductJob pending = sarJob(m_dir.path(), "_200");
+        QVERIFY(journal.record(pending, ProductState::Detected, 0));
+        for (int i = 0; i < 30; ++i) {
+            QVERIFY(journal.record(sarJob(m_dir.path(), QString("_%1").arg(300 + i)), ProductState::Sent, quint16(i)));
+            QTest::qWait(1);   // 时间戳不同，淘汰顺序确定
+        }
+        QVERIFY(journal.compact());
+        // 淘汰到上限的 90%，未结束的产品不受影响
+        QCOMPARE(journal.size(), 18);
+        QCOMPARE(journal.state(pending.key), ProductState::Detected);
+        QCOMPARE(journal.state(m_dir.path() + "/_300"), ProductState::Unknown);
+        QCOMPARE(journal.state(m_dir.path() + "/_329"), ProductState::Sent);
+        QCOMPARE(journal.countInState(ProductState::Sent), 17);
+    }
+
+    void correlatorSkipsOnlySettledProducts() {
+        ProductJournal journal;
+        QVERIFY(journal.open(m_journalPath));
+        const QString dir = QDir::cleanPath(m_dir.path());
+        QVERIFY(journal.record(sarJob(dir, "_sent"), ProductState::Sent, 1));
+        QVERIFY(journal.record(sarJob(dir, "_pending"), ProductState::Detected, 2));
+        QVERIFY(journal.record(sarJob(dir, "_failed"), ProductState::Failed, 3));
+
+        ProductCorrelator correlator(ProductType::SAR);
+        correlator.setJournal(&journal);
+        QSignalSpy ready(&correlator, &ProductCorrelator::productReady);
+        for (const QString name : {"_sent", "_pending", "_failed", "_new"}) {
+            correlator.addFile(dir + "/IMG" + name + ".tif");
+            correlator.addFile(dir + "/AUX" + name + ".dat");
+        }
+        // 已送达的不再发送，待续传的交给 pendingProducts()，失败的和新产品照常关联
+        QCOMPARE(ready.count(), 2);
+        QCOMPARE(ready.at(0).at(0).value<ProductJob>().key, dir + "/_failed");
+        QCOMPARE(ready.at(1).at(0).value<ProductJob>().key, dir + "/_new");
+        QCOMPARE(correlator.pendingCount(), 0);
+    }
+
+private:
+    QTemporaryDir m_dir;
+    QString m_journalPath;
+};
+
+QTEST_GUILESS_MAIN(ProductJournalTest)
+#include "product_journal_test.moc"
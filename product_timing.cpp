@@ -0,0 +1,117 @@
+#include "product_timing.h"
+#include "trace_recorder.h"
+#include <QElapsedTimer>
+#include <QStringList>
+
+static const int STAGE_COUNT = static_cast<int>(TimingStage::Count);
+
+ProductTiming::ProductTiming() {
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        us[i] = -1;
+    }
+}
+
+void ProductTiming::set(TimingStage stage, qint64 micros) {
+    us[static_cast<int>(stage)] = qMax<qint64>(0, micros);
+}
+
+qint64 ProductTiming::get(TimingStage stage) const {
+    return us[static_cast<int>(stage)];
+}
+
+bool ProductTiming::has(TimingStage stage) const {
+    return get(stage) >= 0;
+}
+
+void ProductTiming::merge(const ProductTiming& other) {
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        if (other.us[i] >= 0) {
+            us[i] = other.us[i];
+        }
+    }
+}
+
+QString ProductTiming::summary() const {
+    QStringList parts;
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        if (us[i] >= 0) {
+            parts << QString("%1=%2ms").arg(stageName(static_cast<TimingStage>(i))).arg(us[i] / 1000.0, 0, 'f', 1);
+        }
+    }
+    return parts.join(' ');
+}
+
+const char* ProductTiming::stageName(TimingStage stage) {
+    switch (stage) {
+    case TimingStage::Detect:    return "detect";
+    case TimingStage::AuxWait:   return "aux_wait";
+    case TimingStage::Decode:    return "decode";
+    case TimingStage::Resample:  return "resample";
+    case TimingStage::Encode:    return "encode";
+    case TimingStage::Frame:     return "frame";
+    case TimingStage::FirstByte: return "first_byte";
+    case TimingStage::LastByte:  return "last_byte";
+    case TimingStage::Ack:       return "ack";
+    case TimingStage::Count:     break;
+    }
+    return "unknown";
+}
+
+void markStage(ProductTiming* timing, TimingStage stage, QElapsedTimer& timer, int imageNumber) {
+    const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+    if (timing) {
+        timing->set(stage, elapsedUs);
+    }
+    if (TraceRecorder::isEnabled()) {
+        TraceRecorder::recordComplete(ProductTiming::stageName(stage), TraceRecorder::nowUs() - elapsedUs, elapsedUs, imageNumber);
+    }
+    timer.restart();
+}
+
+void ProductTimingStats::record(ProductType type, const ProductTiming& timing) {
+    const int t = static_cast<int>(type);
+    if (t < 0 || t >= TYPE_COUNT) {
+        return;
+    }
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        if (timing.us[i] >= 0) {
+            m_histograms[t][i].record(timing.us[i]);
+        }
+    }
+}
+
+const HdrHistogram& ProductTimingStats::histogram(ProductType type, TimingStage stage) const {
+    return m_histograms[static_cast<int>(type)][static_cast<int>(stage)];
+}
+
+QByteArray ProductTimingStats::report() const {
+    static const char* const TYPE_NAMES[TYPE_COUNT] = {"SAR", "GMTI"};
+    auto ms = [](qint64 micros) { return QByteArray::number(micros / 1000.0, 'f', 2).rightJustified(10); };
+
+    QByteArray out;
+    out += "# per-product stage timing, milliseconds\n";
+    out += QByteArray("type").leftJustified(6) + QByteArray("stage").leftJustified(11) + QByteArray("count").rightJustified(7);
+    for (const char* column : {"p50", "p90", "p99", "p99.9", "max", "mean"}) {
+        out += QByteArray(column).rightJustified(10);
+    }
+    out += '\n';
+    for (int t = 0; t < TYPE_COUNT; ++t) {
+        for (int i = 0; i < STAGE_COUNT; ++i) {
+            const HdrHistogram& h = m_histograms[t][i];
+            if (h.count() == 0) {
+                continue;
+            }
+            out += QByteArray(TYPE_NAMES[t]).leftJustified(6);
+            out += QByteArray(ProductTiming::stageName(static_cast<TimingStage>(i))).leftJustified(11);
+            out += QByteArray::number(h.count()).rightJustified(7);
+            out += ms(h.valueAtPercentile(50.0));
+            out += ms(h.valueAtPercentile(90.0));
+            out += ms(h.valueAtPercentile(99.0));
+            out += ms(h.valueAtPercentile(99.9));
+            out += ms(h.max());
+            out += ms(qint64(h.mean()));
+            out += '\n';
+        }
+    }
+    return out;
+}
@@ -0,0 +1,70 @@
+#ifndef PRODUCT_TIMING_H
+#define PRODUCT_TIMING_H
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QString>
+#include "hdr_histogram.h"
+#include "product_correlator.h"
+
+// 单个产品从落盘到确认的各个环节，耗时单位均为微秒
+enum class TimingStage {
+    Detect,     // 首个成员文件写完（mtime）到被监控端发现
+    AuxWait,    // 首个成员被发现到同组文件到齐（等待 AUX/.txt/.bin）
+    Decode,     // 读取并解码原始图像与辅助文件
+    Resample,   // 按 Xbin/Rbin 比值重采样
+    Encode,     // JPEG 编码
+    Frame,      // 分帧并写出 bin 文件
+    FirstByte,  // 开始传输（含建连）到第一个字节发出
+    LastByte,   // 第一个字节到最后一个字节发出
+    Ack,        // 最后一个字节到收到接收端确认
+    Count
+};
+
+/**
+ * @struct ProductTiming
+ * @brief 单个产品的分环节耗时记录，随 ProductJob / TransferJob 在各线程间传递。
+ *
+ * 未经历的环节（例如 GMTI 没有编码、未开启确认时的 Ack）保持 -1，不计入统计。
+ */
+struct ProductTiming {
+    qint64 us[static_cast<int>(TimingStage::Count)];
+
+    ProductTiming();
+
+    void set(TimingStage stage, qint64 micros);
+    qint64 get(TimingStage stage) const;
+    bool has(TimingStage stage) const;
+    // 用 other 中已记录的环节覆盖本记录
+    void merge(const ProductTiming& other);
+    // 形如 "detect=12.3ms aux_wait=... "，用于逐产品日志
+    QString summary() const;
+
+    static const char* stageName(TimingStage stage);
+};
+Q_DECLARE_METATYPE(ProductTiming)
+
+class QElapsedTimer;
+
+// 记录自上次调用以来的耗时（开启跟踪时同时写入一个区间）并重新计时；timing 可为空
+void markStage(ProductTiming* timing, TimingStage stage, QElapsedTimer& timer, int imageNumber);
+
+/**
+ * @class ProductTimingStats
+ * @brief 按产品类型 × 环节聚合的耗时直方图。
+ *
+ * record() 只做原子计数，可在任意线程调用；report() 生成文本表格（各环节的样本数、
+ * P50/P90/P99/P99.9/最大值与均值），供 HTTP /timings 与守护进程 SIGUSR1 按需导出。
+ */
+class ProductTimingStats {
+public:
+    void record(ProductType type, const ProductTiming& timing);
+    const HdrHistogram& histogram(ProductType type, TimingStage stage) const;
+    QByteArray report() const;
+
+private:
+    static const int TYPE_COUNT = 2;
+    HdrHistogram m_histograms[TYPE_COUNT][static_cast<int>(TimingStage::Count)];
+};
+
+#endif // PRODUCT_TIMING_H
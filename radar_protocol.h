@@ -34,6 +34,26 @@ struct DataInfo {
     qint16  total_y;           // 图像总列数 (2 bytes)
 };
 
+// 0x02（ROI 裁剪）指令在 DataInfo 之后附带的区域尺寸，小端，计入 DataHeader::data_length 与校验和。
+// 区域左上角为 DataInfo 的 pixel_offset_x（列）/pixel_offset_y（行），坐标系为接收端收到的整图。
+struct RoiCropExtension {
+    quint16 width;          // 区域宽度（像素）
+    quint16 height;         // 区域高度（像素）
+    quint8  jpeg_quality;   // 0 表示使用本端配置的默认质量
+    quint8  reserved[3];
+};
+
+// 0x03（选择性重传）指令在 DataInfo 之后附带的缺包描述，小端，计入 DataHeader::data_length 与校验和。
+// DataInfo 的 image_number 为要补发的图像，包号与 SAR_Frame::current_packet 相同（从 1 开始）。
+// 紧随其后：区间列表为 count 组 {quint16 first, quint16 last}（闭区间）；
+// 位图为 count 字节，第 i 位（低位在前）为 1 表示包 first_packet + i 缺失。
+struct RetransmitExtension {
+    quint8  encoding;       // RetransmitEncoding
+    quint8  reserved;
+    quint16 first_packet;   // 位图第 0 位对应的包号，区间列表时忽略
+    quint16 count;          // 区间数或位图字节数
+};
+
 // 恢复默认的内存对齐方式
 #ifdef _MSC_VER
 #pragma pack(pop)
@@ -41,6 +61,20 @@ struct DataInfo {
 #pragma pack()
 #endif
 
+// 指令类型（DataInfo::command_type）
+enum CommandType : quint8 {
+    COMMAND_ISAR_REQUEST = 0x01,    // ISAR 成像请求，像素偏移为目标中心
+    COMMAND_ROI_CROP = 0x02,        // 已发送图像的区域高质量裁剪，附带 RoiCropExtension（可省略）
+    COMMAND_RETRANSMIT = 0x03       // 补发已发送图像的缺失包，附带 RetransmitExtension；不附带或 count 为 0 时整图重发，
+                                    // 附带了描述但未选中任何包时不补发
+};
+
+// 缺包描述的编码方式（RetransmitExtension::encoding）
+enum RetransmitEncoding : quint8 {
+    RETRANSMIT_RANGES = 0,
+    RETRANSMIT_BITMAP = 1
+};
+
 // 计算校验和函数
 inline quint8 calculateChecksum(const QByteArray& data) {
     quint8 sum = 0;
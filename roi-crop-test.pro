@@ -0,0 +1,15 @@
+# ROI 高质量裁剪产品（边缘截断、按 Xbin/Rbin 换算行号、RoiCropInfo 与源图像编号）的行为测试：qmake roi-crop-test.pro && make check
+# 打包代码依赖较多公共模块，直接引用 aerolink_core.pri；QImage 需要 gui 模块（不创建 QGuiApplication）
+
+TARGET = roi-crop-test
+TEMPLATE = app
+
+QT = core gui network testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+include(aerolink_core.pri)
+
+SOURCES += \
+    roi_crop_test.cpp
@@ -0,0 +1,200 @@
+// roi_crop_test.cpp
+// ROI 裁剪产品：区域按接收端整图坐标截断到图像范围内，完全在外时失败；
+// AUX 的 Xbin/Rbin 不等时按校正后的行号裁剪并对齐到源行边界；
+// 消息类型为 0x0008，reserved2 中的 RoiCropInfo 给出实际区域、编码质量与被裁剪的源图像编号，
+// 校验和覆盖改写后的 reserved2，解码出的 JPEG 与源图像对应区域一致
+#include <QtTest>
+#include <QDataStream>
+#include <QTemporaryDir>
+#include <cstring>
+#include "package_sar_data.h"
+
+namespace {
+
+// 按 AuxFileReader::read 的字段顺序写一个最小的 AUX 文件，其后附带足够长度的运动数据
+bool writeAux(const QString& path, qint64 rows, qint64 cols, double xbin, double rbin) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << qint64(0) << qint64(0) << qint64(1);                         // op_mode pp_mode Kr_sign
+    for (int i = 0; i < 8; ++i) {                                       // fc .. PRF
+        out << 0.0;
+    }
+    out << rows << cols << qint64(8);                                   // pulse_num pulse_len amp_bit
+    out << xbin << rbin;
+    out << qint64(2) << qint64(0) << qint64(0);                         // geo_mode look_mode flag_flat
+    for (int i = 0; i < 27; ++i) {                                      // fdc_ref .. lng_e
+        out << 0.0;
+    }
+    out << 30.0 << 120.0 << 30.0 << 120.1 << 29.9 << 120.0 << 29.9 << 120.1;   // 四角经纬度
+    out << 0.0 << qint64(1);                                            // IMG_TH az_MLK_num
+    for (qint64 i = 0; i < rows * 7 + 10; ++i) {
+        out << 0.0;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+QImage gradientImage(int width, int height) {
+    QImage image(width, height, QImage::Format_Grayscale8);
+    for (int y = 0; y < height; ++y) {
+        uchar* line = image.scanLine(y);
+        for (int x = 0; x < width; ++x) {
+            line[x] = uchar((x + 2 * y) * 255 / (width + 2 * height));
+        }
+    }
+    return image;
+}
+
+struct RoiMessage {
+    quint16 imageNumber = 0;
+    SAR_DataInfo dataInfo;
+    RoiCropInfo roiInfo;
+    QImage image;
+};
+
+// 按接收端的方式拼回 bin 中唯一的一条消息：SAR_DataInfo 之后为 JPEG
+bool readRoiMessage(const QString& binPath, RoiMessage* message) {
+    QFile file(binPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray frames = file.readAll();
+    QByteArray payload;
+    qint64 offset = 0;
+    while (offset + qint64(sizeof(SAR_Frame)) <= frames.size()) {
+        SAR_Frame header;
+        memcpy(&header, frames.constData() + offset, sizeof(SAR_Frame));
+        message->imageNumber = header.image_number;
+        payload.append(frames.mid(offset + sizeof(SAR_Frame), header.data_length));
+        offset += qint64(sizeof(SAR_Frame)) + header.data_length;
+    }
+    if (payload.size() < int(sizeof(SAR_DataInfo))) {
+        return false;
+    }
+    memcpy(&message->dataInfo, payload.constData(), sizeof(SAR_DataInfo));
+    memcpy(&message->roiInfo, message->dataInfo.reserved2, sizeof(RoiCropInfo));
+    message->image = QImage::fromData(payload.mid(sizeof(SAR_DataInfo)), "JPG");
+    return true;
+}
+
+uint8_t headerChecksum(const SAR_DataInfo& dataInfo) {
+    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&dataInfo);
+    return calculate_checksum(ptr + sizeof(uint16_t), sizeof(SAR_DataInfo) - sizeof(uint16_t) - sizeof(uint8_t));
+}
+
+// JPEG 有损，只比较平均误差
+double meanError(const QImage& decoded, const QImage& expected) {
+    const QImage a = decoded.convertToFormat(QImage::Format_Grayscale8);
+    const QImage b = expected.convertToFormat(QImage::Format_Grayscale8);
+    qint64 error = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        for (int x = 0; x < a.width(); ++x) {
+            error += qAbs(int(a.constScanLine(y)[x]) - int(b.constScanLine(y)[x]));
+        }
+    }
+    return double(error) / (a.width() * a.height());
+}
+
+} // namespace
+
+class RoiCropTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+        m_imagePath = m_dir.filePath("scene.png");
+        QVERIFY(gradientImage(300, 200).save(m_imagePath, "PNG"));
+    }
+
+    void clampsRegionToImage_data() {
+        QTest::addColumn<QRect>("region");
+        QTest::addColumn<QRect>("expected");
+        QTest::newRow("inside") << QRect(40, 30, 64, 48) << QRect(40, 30, 64, 48);
+        QTest::newRow("bottom right") << QRect(250, 150, 100, 100) << QRect(250, 150, 50, 50);
+        QTest::newRow("top left") << QRect(-10, -20, 50, 60) << QRect(0, 0, 40, 40);
+        QTest::newRow("larger than image") << QRect(-5, -5, 1000, 1000) << QRect(0, 0, 300, 200);
+    }
+
+    void clampsRegionToImage() {
+        QFETCH(QRect, region);
+        QFETCH(QRect, expected);
+        const QString binPath = m_dir.filePath("roi.bin");
+        QRect actual;
+        // 不带 AUX：按仅 TIF 处理
+        QVERIFY(createBinFileFromTifRegion(m_imagePath, QString(), region, 90, binPath, 501, 500, &actual));
+        QCOMPARE(actual, expected);
+
+        RoiMessage message;
+        QVERIFY(readRoiMessage(binPath, &message));
+        QCOMPARE(message.imageNumber, quint16(501));
+        QCOMPARE(message.dataInfo.message_type, ROI_CROP_MESSAGE_TYPE);
+        QCOMPARE(message.dataInfo.message_count, uint16_t(501));
+        QCOMPARE(message.dataInfo.image_rows, uint16_t(expected.height()));
+        QCOMPARE(message.dataInfo.image_cols, uint16_t(expected.width()));
+        QCOMPARE(message.dataInfo.checksum, headerChecksum(message.dataInfo));
+        QCOMPARE(message.roiInfo.source_image_number, uint16_t(500));
+        QCOMPARE(message.roiInfo.x, uint16_t(expected.x()));
+        QCOMPARE(message.roiInfo.y, uint16_t(expected.y()));
+        QCOMPARE(message.roiInfo.width, uint16_t(expected.width()));
+        QCOMPARE(message.roiInfo.height, uint16_t(expected.height()));
+        QCOMPARE(message.roiInfo.jpeg_quality, uint8_t(90));
+
+        QCOMPARE(message.image.size(), expected.size());
+        const double error = meanError(message.image, gradientImage(300, 200).copy(expected));
+        QVERIFY2(error < 4, qPrintable(QString("mean error %1").arg(error)));
+    }
+
+    void rejectsRegionOutsideImage() {
+        const QString binPath = m_dir.filePath("outside.bin");
+        QVERIFY(!createBinFileFromTifRegion(m_imagePath, QString(), QRect(300, 0, 10, 10), 90, binPath, 1, 0));
+        QVERIFY(!createBinFileFromTifRegion(m_imagePath, QString(), QRect(-20, -20, 10, 10), 90, binPath, 1, 0));
+    }
+
+    void mapsRowsThroughAzimuthCorrection_data() {
+        QTest::addColumn<QRect>("region");
+        QTest::addColumn<QRect>("expected");
+        // Xbin/Rbin = 2：接收端整图为 300 × 400，区域行号折半回到源行，再对齐到源行边界
+        QTest::newRow("inside") << QRect(10, 101, 40, 60) << QRect(10, 100, 40, 62);
+        QTest::newRow("aligned") << QRect(20, 40, 30, 20) << QRect(20, 40, 30, 20);
+        QTest::newRow("bottom edge") << QRect(0, 380, 20, 50) << QRect(0, 380, 20, 20);
+    }
+
+    void mapsRowsThroughAzimuthCorrection() {
+        QFETCH(QRect, region);
+        QFETCH(QRect, expected);
+        const QString auxPath = m_dir.filePath("stretched.aux");
+        QVERIFY(writeAux(auxPath, 200, 300, 2.0, 1.0));
+        const QString binPath = m_dir.filePath("stretched.bin");
+        QRect actual;
+        QVERIFY(createBinFileFromTifRegion(m_imagePath, auxPath, region, 95, binPath, 9, 8, &actual));
+        QCOMPARE(actual, expected);
+
+        RoiMessage message;
+        QVERIFY(readRoiMessage(binPath, &message));
+        QCOMPARE(message.dataInfo.message_type, ROI_CROP_MESSAGE_TYPE);
+        QCOMPARE(message.dataInfo.image_rows, uint16_t(expected.height()));
+        QCOMPARE(message.dataInfo.image_cols, uint16_t(expected.width()));
+        QCOMPARE(message.dataInfo.checksum, headerChecksum(message.dataInfo));
+        QCOMPARE(message.roiInfo.source_image_number, uint16_t(8));
+        QCOMPARE(message.roiInfo.y, uint16_t(expected.y()));
+        QCOMPARE(message.roiInfo.height, uint16_t(expected.height()));
+        QCOMPARE(message.roiInfo.jpeg_quality, uint8_t(95));
+        QCOMPARE(message.image.size(), expected.size());
+
+        // 与整图发送时相同的校正：源图像拉伸到两倍高度后取同一区域
+        const QImage stretched = gradientImage(300, 200).scaled(300, 400, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        const double error = meanError(message.image, stretched.copy(expected));
+        QVERIFY2(error < 6, qPrintable(QString("mean error %1").arg(error)));
+    }
+
+private:
+    QTemporaryDir m_dir;
+    QString m_imagePath;
+};
+
+QTEST_GUILESS_MAIN(RoiCropTest)
+#include "roi_crop_test.moc"
@@ -0,0 +1,18 @@
+# 增量传输块差分与场景基准的行为测试：qmake scene-delta-test.pro && make check
+# QImage 需要 gui 模块（不创建 QGuiApplication）
+
+TARGET = scene-delta-test
+TEMPLATE = app
+
+QT = core gui testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    scene_delta_test.cpp \
+    scene_delta.cpp
+
+HEADERS += \
+    AuxFileReader.h \
+    scene_delta.h
@@ -0,0 +1,170 @@
+#include "scene_delta.h"
+#include <QStringList>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DELTA_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// ---- 块绝对差 ----
+
+// 一个块（或边缘的部分块）的绝对差之和
+static quint32 blockSumScalar(const uchar* a, qint64 strideA, const uchar* b, qint64 strideB, int cols, int rows) {
+    quint32 sum = 0;
+    for (int r = 0; r < rows; ++r) {
+        const uchar* pa = a + r * strideA;
+        const uchar* pb = b + r * strideB;
+        for (int c = 0; c < cols; ++c) {
+            sum += quint32(std::abs(int(pa[c]) - int(pb[c])));
+        }
+    }
+    return sum;
+}
+
+void blockAbsDiffSumsScalar(const uchar* a, qint64 strideA, const uchar* b, qint64 strideB,
+                            int width, int height, quint32* out) {
+    const int blockCols = (width + DELTA_BLOCK_SIZE - 1) / DELTA_BLOCK_SIZE;
+    const int blockRows = (height + DELTA_BLOCK_SIZE - 1) / DELTA_BLOCK_SIZE;
+    for (int by = 0; by < blockRows; ++by) {
+        const int y = by * DELTA_BLOCK_SIZE;
+        const int rows = qMin(DELTA_BLOCK_SIZE, height - y);
+        for (int bx = 0; bx < blockCols; ++bx) {
+            const int x = bx * DELTA_BLOCK_SIZE;
+            out[by * blockCols + bx] = blockSumScalar(a + y * strideA + x, strideA, b + y * strideB + x, strideB,
+                                                      qMin(DELTA_BLOCK_SIZE, width - x), rows);
+        }
+    }
+}
+
+void blockAbsDiffSums(const uchar* a, qint64 strideA, const uchar* b, qint64 strideB,
+                      int width, int height, quint32* out) {
+#ifndef DELTA_HAVE_SSE2
+    blockAbsDiffSumsScalar(a, strideA, b, strideB, width, height, out);
+#else
+    const int blockCols = (width + DELTA_BLOCK_SIZE - 1) / DELTA_BLOCK_SIZE;
+    const int blockRows = (height + DELTA_BLOCK_SIZE - 1) / DELTA_BLOCK_SIZE;
+    const int fullCols = width / DELTA_BLOCK_SIZE;
+    for (int by = 0; by < blockRows; ++by) {
+        const int y = by * DELTA_BLOCK_SIZE;
+        const int rows = qMin(DELTA_BLOCK_SIZE, height - y);
+        quint32* dst = out + by * blockCols;
+        // 整块：逐行 PSADBW，两个 64 位部分和最后相加；块内按行读取，同一块带的各行依次经过缓存
+        for (int bx = 0; bx < fullCols; ++bx) {
+            const uchar* pa = a + y * strideA + bx * DELTA_BLOCK_SIZE;
+            const uchar* pb = b + y * strideB + bx * DELTA_BLOCK_SIZE;
+            __m128i acc = _mm_setzero_si128();
+            for (int r = 0; r < rows; ++r) {
+                const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + r * strideA));
+                const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + r * strideB));
+                acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+            }
+            dst[bx] = quint32(_mm_cvtsi128_si32(acc)) + quint32(_mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+        }
+        if (fullCols < blockCols) {
+            const int x = fullCols * DELTA_BLOCK_SIZE;
+            dst[fullCols] = blockSumScalar(a + y * strideA + x, strideA, b + y * strideB + x, strideB, width - x, rows);
+        }
+    }
+#endif
+}
+
+// ---- 场景基准 ----
+
+void SceneDeltaStore::setMaxScenes(int maxScenes) {
+    QMutexLocker locker(&m_mutex);
+    m_maxScenes = qMax(1, maxScenes);
+}
+
+QString SceneDeltaStore::sceneKey(const AuxHeader& auxHeader, double cellDegrees) {
+    const double cell = cellDegrees > 0.0 ? cellDegrees : 0.01;
+    auto q = [cell](double degrees) { return QString::number(qint64(std::floor(degrees / cell + 0.5))); };
+    return QStringList{q(auxHeader.lat11), q(auxHeader.lng11), q(auxHeader.lat1N), q(auxHeader.lng1N),
+                       q(auxHeader.latM1), q(auxHeader.lngM1), q(auxHeader.latMN), q(auxHeader.lngMN)}
+        .join(QLatin1Char(','));
+}
+
+DeltaBase SceneDeltaStore::base(const QString& scene) const {
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_scenes.constFind(scene);
+    return it == m_scenes.constEnd() ? DeltaBase() : it->base;
+}
+
+void SceneDeltaStore::setCandidate(quint16 imageNumber, const QString& scene, const QImage& reconstructed,
+                                   int chainLength, int changedTiles, int totalTiles) {
+    QMutexLocker locker(&m_mutex);
+    // 同一场景的较早候选不会再替换基准（提升只接受更新的序号），直接去掉；候选数超限时去掉最早的
+    for (auto it = m_candidates.begin(); it != m_candidates.end();) {
+        if (it->scene == scene || it.key() == imageNumber) {
+            it = m_candidates.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    while (m_candidates.size() >= m_maxScenes) {
+        auto oldest = m_candidates.begin();
+        for (auto it = m_candidates.begin(); it != m_candidates.end(); ++it) {
+            if (it->sequence < oldest->sequence) {
+                oldest = it;
+            }
+        }
+        m_candidates.erase(oldest);
+    }
+    Candidate candidate;
+    candidate.scene = scene;
+    candidate.base.imageNumber = imageNumber;
+    candidate.base.image = reconstructed;
+    candidate.base.chainLength = chainLength;
+    candidate.sequence = ++m_sequence;
+    m_candidates.insert(imageNumber, candidate);
+    if (changedTiles < 0) {
+        ++m_stats.fullProducts;
+    } else {
+        ++m_stats.deltaProducts;
+        m_stats.changedTiles += quint64(changedTiles);
+        m_stats.totalTiles += quint64(totalTiles);
+    }
+}
+
+void SceneDeltaStore::promote(quint16 imageNumber) {
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_candidates.constFind(imageNumber);
+    if (it == m_candidates.constEnd()) {
+        return;
+    }
+    const Candidate candidate = it.value();
+    m_candidates.erase(it);
+    Scene& scene = m_scenes[candidate.scene];
+    if (candidate.sequence > scene.sequence) {
+        scene.base = candidate.base;
+        scene.sequence = candidate.sequence;
+    }
+    scene.lastUsed = qMax(scene.lastUsed, candidate.sequence);
+    // 场景数超限时去掉最久未更新的
+    while (m_scenes.size() > m_maxScenes) {
+        auto oldest = m_scenes.begin();
+        for (auto s = m_scenes.begin(); s != m_scenes.end(); ++s) {
+            if (s->lastUsed < oldest->lastUsed) {
+                oldest = s;
+            }
+        }
+        m_scenes.erase(oldest);
+    }
+    m_stats.scenes = m_scenes.size();
+}
+
+void SceneDeltaStore::discard(quint16 imageNumber) {
+    QMutexLocker locker(&m_mutex);
+    m_candidates.remove(imageNumber);
+}
+
+void SceneDeltaStore::clearCandidates() {
+    QMutexLocker locker(&m_mutex);
+    m_candidates.clear();
+}
+
+SceneDeltaStore::Stats SceneDeltaStore::stats() const {
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
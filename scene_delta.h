@@ -0,0 +1,98 @@
+#ifndef SCENE_DELTA_H
+#define SCENE_DELTA_H
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include "AuxFileReader.h"
+
+// 重复过境的增量传输：同一场景只发送相对上一幅有变化的瓦片
+struct DeltaSettings {
+    bool enabled = false;
+    double cellDegrees = 0.01;          // 四角经纬度按此间隔取整后相同的图像视为同一场景
+    int blockThreshold = 12;            // 16×16 块的平均绝对差（灰度级）超过此值即为变化块
+    int tileSize = 256;                 // 以瓦片为单位发送变化区域，须为 16 的倍数
+    double maxChangedFraction = 0.5;    // 变化瓦片比例超过此值时改发完整产品
+    int keyframeInterval = 10;          // 连续增量产品数上限，之后发一次完整产品
+    int maxScenes = 4;                  // 保留基准图像的场景数
+    int threads = 2;                    // 单个产品编码变化瓦片的线程数（含打包线程本身），同 TileSettings::threads
+};
+
+// 某场景在接收端已有的图像
+struct DeltaBase {
+    quint16 imageNumber = 0;
+    QImage image;                       // 校正后的灰度图（Format_Grayscale8），空表示没有基准
+    int chainLength = 0;                // 基准之前连续的增量产品数
+};
+
+// 变化检测时的块边长（与 PSADBW 的 16 字节宽度一致）
+constexpr int DELTA_BLOCK_SIZE = 16;
+
+/**
+ * @brief 逐块绝对差之和：a、b 为同尺寸的 8 位图像，结果按行写入 out，
+ * 尺寸为 ceil(height/16) × ceil(width/16)，边缘不满的块只统计实际像素。
+ * x86 上每行 16 个像素用一条 SSE2 PSADBW（_mm_sad_epu8）计算。
+ */
+void blockAbsDiffSums(const uchar* a, qint64 strideA, const uchar* b, qint64 strideB,
+                      int width, int height, quint32* out);
+// 同上的标量实现，用于非 x86 平台与结果校验
+void blockAbsDiffSumsScalar(const uchar* a, qint64 strideA, const uchar* b, qint64 strideB,
+                            int width, int height, quint32* out);
+
+/**
+ * @class SceneDeltaStore
+ * @brief 各场景在接收端已有的图像，供增量打包取基准。线程安全。
+ *
+ * 打包后先把“接收端拼接后将看到的图像”记为候选，产品发送成功（开启确认时为已确认）后才提升为场景基准，
+ * 因此增量产品引用的基准一定已经送达；较早产品的迟到成功不会覆盖较新的基准。
+ * 每个场景只保留最新的一个候选（较早的候选即使送达也不会成为基准），候选总数不超过场景数上限，
+ * 排队产品再多，候选占用的内存也有界。
+ */
+class SceneDeltaStore {
+public:
+    struct Stats {
+        quint64 fullProducts = 0;
+        quint64 deltaProducts = 0;
+        quint64 changedTiles = 0;
+        quint64 totalTiles = 0;
+        int scenes = 0;
+    };
+
+    void setMaxScenes(int maxScenes);
+
+    // 场景键：四角经纬度按 cellDegrees 取整，覆盖范围基本一致的重复过境得到相同的键
+    static QString sceneKey(const AuxHeader& auxHeader, double cellDegrees);
+
+    DeltaBase base(const QString& scene) const;
+    // changedTiles < 0 表示完整产品；替换同一场景尚未提升的候选
+    void setCandidate(quint16 imageNumber, const QString& scene, const QImage& reconstructed,
+                      int chainLength, int changedTiles, int totalTiles);
+    void promote(quint16 imageNumber);
+    void discard(quint16 imageNumber);
+    // 去掉所有尚未提升的候选（流水线停止时），已有的场景基准保留
+    void clearCandidates();
+
+    Stats stats() const;
+
+private:
+    struct Candidate {
+        QString scene;
+        DeltaBase base;
+        quint64 sequence = 0;
+    };
+    struct Scene {
+        DeltaBase base;
+        quint64 sequence = 0;
+        quint64 lastUsed = 0;
+    };
+
+    mutable QMutex m_mutex;
+    int m_maxScenes = 4;
+    quint64 m_sequence = 0;
+    QHash<quint16, Candidate> m_candidates;
+    QHash<QString, Scene> m_scenes;
+    Stats m_stats;
+};
+
+#endif // SCENE_DELTA_H
@@ -0,0 +1,197 @@
+// scene_delta_test.cpp
+// 增量传输：块绝对差的 SSE2 与标量实现一致且只计图内像素；SceneDeltaStore 的候选提升与丢弃、
+// 较晚成功的旧候选不替换新基准、每个场景只保留一个候选且候选总数有界、停止时清除候选、
+// 按场景数淘汰、全量/增量计数，场景键容忍小幅位置偏移
+#include <QtTest>
+#include <QRandomGenerator>
+#include <vector>
+#include "scene_delta.h"
+
+namespace {
+
+QImage grayImage(int width, int height, int value) {
+    QImage image(width, height, QImage::Format_Grayscale8);
+    image.fill(QColor(value, value, value));
+    return image;
+}
+
+AuxHeader auxAt(double lat, double lng) {
+    AuxHeader header{};
+    header.lat11 = lat;
+    header.lng11 = lng;
+    header.lat1N = lat;
+    header.lng1N = lng + 0.1;
+    header.latM1 = lat + 0.1;
+    header.lngM1 = lng;
+    header.latMN = lat + 0.1;
+    header.lngMN = lng + 0.1;
+    return header;
+}
+
+} // namespace
+
+class SceneDeltaTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void blockSumsMatchScalar_data() {
+        QTest::addColumn<int>("width");
+        QTest::addColumn<int>("height");
+        QTest::addColumn<int>("padding");
+        QTest::newRow("one block") << 16 << 16 << 0;
+        QTest::newRow("partial edges") << 37 << 45 << 3;
+        QTest::newRow("narrow") << 5 << 40 << 11;
+        QTest::newRow("single pixel") << 1 << 1 << 0;
+        QTest::newRow("wide") << 1000 << 33 << 24;
+    }
+
+    void blockSumsMatchScalar() {
+        QFETCH(int, width);
+        QFETCH(int, height);
+        QFETCH(int, padding);
+        const qint64 strideA = width + padding;
+        const qint64 strideB = width + padding * 2 + 1;
+        std::vector<uchar> a(size_t(strideA * height));
+        std::vector<uchar> b(size_t(strideB * height));
+        QRandomGenerator random(quint32(width * 131 + height));
+        for (uchar& value : a) {
+            value = uchar(random.bounded(256));
+        }
+        for (uchar& value : b) {
+            value = uchar(random.bounded(256));
+        }
+
+        const int blocks = ((width + DELTA_BLOCK_SIZE - 1) / DELTA_BLOCK_SIZE)
+                           * ((height + DELTA_BLOCK_SIZE - 1) / DELTA_BLOCK_SIZE);
+        std::vector<quint32> fast(size_t(blocks), 0xFFFFFFFFu);
+        std::vector<quint32> scalar(size_t(blocks), 0u);
+        blockAbsDiffSums(a.data(), strideA, b.data(), strideB, width, height, fast.data());
+        blockAbsDiffSumsScalar(a.data(), strideA, b.data(), strideB, width, height, scalar.data());
+        QVERIFY(fast == scalar);
+    }
+
+    void blockSumsCountEdgePixelsOnly() {
+        // 20×18：右侧与下方的块只有 4 列、2 行实际像素
+        const QImage black = grayImage(20, 18, 0);
+        const QImage white = grayImage(20, 18, 255);
+        quint32 sums[4] = {};
+        blockAbsDiffSums(black.constBits(), black.bytesPerLine(), white.constBits(), white.bytesPerLine(), 20, 18, sums);
+        QCOMPARE(sums[0], quint32(16 * 16 * 255));
+        QCOMPARE(sums[1], quint32(4 * 16 * 255));
+        QCOMPARE(sums[2], quint32(16 * 2 * 255));
+        QCOMPARE(sums[3], quint32(4 * 2 * 255));
+    }
+
+    void promoteMakesCandidateTheBase() {
+        SceneDeltaStore store;
+        QVERIFY(store.base("scene").image.isNull());
+
+        store.setCandidate(5, "scene", grayImage(32, 32, 10), 0, -1, 0);
+        // 发送成功之前不能作为基准
+        QVERIFY(store.base("scene").image.isNull());
+
+        store.promote(5);
+        const DeltaBase base = store.base("scene");
+        QCOMPARE(base.imageNumber, quint16(5));
+        QCOMPARE(base.chainLength, 0);
+        QCOMPARE(base.image.pixelColor(0, 0).red(), 10);
+
+        // 候选只能提升一次
+        store.setCandidate(6, "scene", grayImage(32, 32, 20), 1, 2, 4);
+        store.promote(6);
+        store.promote(5);
+        QCOMPARE(store.base("scene").imageNumber, quint16(6));
+        QCOMPARE(store.base("scene").chainLength, 1);
+    }
+
+    void discardKeepsPreviousBase() {
+        SceneDeltaStore store;
+        store.setCandidate(1, "scene", grayImage(16, 16, 1), 0, -1, 0);
+        store.promote(1);
+        store.setCandidate(2, "scene", grayImage(16, 16, 2), 1, 1, 1);
+        store.discard(2);
+        store.promote(2);
+        QCOMPARE(store.base("scene").imageNumber, quint16(1));
+    }
+
+    void lateOlderSuccessDoesNotReplaceNewerBase() {
+        SceneDeltaStore store;
+        store.setCandidate(1, "scene", grayImage(16, 16, 1), 0, -1, 0);
+        store.setCandidate(2, "scene", grayImage(16, 16, 2), 0, -1, 0);
+        store.promote(2);
+        store.promote(1);
+        QCOMPARE(store.base("scene").imageNumber, quint16(2));
+    }
+
+    void keepsOneCandidatePerScene() {
+        SceneDeltaStore store;
+        store.setMaxScenes(2);
+        store.setCandidate(1, "a", grayImage(16, 16, 1), 0, -1, 0);
+        store.setCandidate(2, "a", grayImage(16, 16, 2), 0, -1, 0);
+        // 同一场景的较早候选被替换
+        store.promote(1);
+        QVERIFY(store.base("a").image.isNull());
+        store.promote(2);
+        QCOMPARE(store.base("a").imageNumber, quint16(2));
+
+        // 候选总数不超过场景数上限，超出时去掉最早的
+        store.setCandidate(3, "a", grayImage(16, 16, 3), 0, -1, 0);
+        store.setCandidate(4, "b", grayImage(16, 16, 4), 0, -1, 0);
+        store.setCandidate(5, "c", grayImage(16, 16, 5), 0, -1, 0);
+        store.promote(3);
+        QCOMPARE(store.base("a").imageNumber, quint16(2));
+        store.promote(4);
+        store.promote(5);
+        QCOMPARE(store.base("b").imageNumber, quint16(4));
+        QCOMPARE(store.base("c").imageNumber, quint16(5));
+    }
+
+    void clearCandidatesKeepsBases() {
+        SceneDeltaStore store;
+        store.setCandidate(1, "scene", grayImage(16, 16, 1), 0, -1, 0);
+        store.promote(1);
+        store.setCandidate(2, "scene", grayImage(16, 16, 2), 1, 1, 1);
+        store.clearCandidates();
+        store.promote(2);
+        QCOMPARE(store.base("scene").imageNumber, quint16(1));
+    }
+
+    void evictsLeastRecentlyUpdatedScene() {
+        SceneDeltaStore store;
+        store.setMaxScenes(2);
+        store.setCandidate(1, "a", grayImage(16, 16, 1), 0, -1, 0);
+        store.promote(1);
+        store.setCandidate(2, "b", grayImage(16, 16, 2), 0, -1, 0);
+        store.promote(2);
+        store.setCandidate(3, "a", grayImage(16, 16, 3), 0, -1, 0);
+        store.promote(3);
+        store.setCandidate(4, "c", grayImage(16, 16, 4), 0, -1, 0);
+        store.promote(4);
+
+        QVERIFY(store.base("b").image.isNull());
+        QCOMPARE(store.base("a").imageNumber, quint16(3));
+        QCOMPARE(store.base("c").imageNumber, quint16(4));
+        QCOMPARE(store.stats().scenes, 2);
+    }
+
+    void countsFullAndDeltaProducts() {
+        SceneDeltaStore store;
+        store.setCandidate(1, "scene", grayImage(16, 16, 1), 0, -1, 0);
+        store.setCandidate(2, "scene", grayImage(16, 16, 1), 1, 3, 16);
+        store.setCandidate(3, "scene", grayImage(16, 16, 1), 2, 1, 16);
+        const SceneDeltaStore::Stats stats = store.stats();
+        QCOMPARE(stats.fullProducts, quint64(1));
+        QCOMPARE(stats.deltaProducts, quint64(2));
+        QCOMPARE(stats.changedTiles, quint64(4));
+        QCOMPARE(stats.totalTiles, quint64(32));
+    }
+
+    void sceneKeyToleratesSmallShifts() {
+        const QString key = SceneDeltaStore::sceneKey(auxAt(30.1, 120.2), 0.01);
+        QCOMPARE(SceneDeltaStore::sceneKey(auxAt(30.1012, 120.1991), 0.01), key);
+        QVERIFY(SceneDeltaStore::sceneKey(auxAt(30.2, 120.2), 0.01) != key);
+    }
+};
+
+QTEST_APPLESS_MAIN(SceneDeltaTest)
+#include "scene_delta_test.moc"
@@ -0,0 +1,15 @@
+# SLC 芯片直传（窗口定位、消息头与 SlcChipInfo、逐行样本、按 SLC 与 AUX 共同缓存）的行为测试：qmake slc-chip-test.pro && make check
+# 芯片消息头复用 SAR 图像的打包代码，直接引用 aerolink_core.pri
+
+TARGET = slc-chip-test
+TEMPLATE = app
+
+QT = core gui network testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+include(aerolink_core.pri)
+
+SOURCES += \
+    slc_chip_test.cpp
@@ -0,0 +1,20 @@
+# SLC 多视幅度快视吞吐测试：qmake slc-multilook-bench.pro
+# 只依赖 QtCore（多线程部分借用工作线程池），不链接 network/gui
+
+TARGET = slc-multilook-bench
+TEMPLATE = app
+
+QT = core
+
+CONFIG += c++20 console
+CONFIG -= app_bundle
+
+SOURCES += \
+    slc_multilook_bench.cpp \
+    slc_multilook.cpp \
+    worker_pool.cpp
+
+HEADERS += \
+    slc_format.h \
+    slc_multilook.h \
+    worker_pool.h
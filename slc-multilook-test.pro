@@ -0,0 +1,19 @@
+# SLC 多视幅度（AVX2 与标量一致、奇数尺寸与尾部、借用工作线程池）的行为测试：qmake slc-multilook-test.pro && make check
+
+TARGET = slc-multilook-test
+TEMPLATE = app
+
+QT = core testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    slc_multilook.cpp \
+    slc_multilook_test.cpp \
+    worker_pool.cpp
+
+HEADERS += \
+    slc_format.h \
+    slc_multilook.h \
+    worker_pool.h
@@ -0,0 +1,334 @@
+#include "slc_chip.h"
+#include "log_categories.h"
+#include "slc_multilook.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+SlcFile::~SlcFile() {
+    if (m_map) {
+        m_file.unmap(m_map);
+    }
+}
+
+std::shared_ptr<SlcFile> SlcFile::open(const QString& path, qint64 rows, qint64 cols,
+                                       SlcSampleFormat format, qint64 headerBytes, QString* error) {
+    std::shared_ptr<SlcFile> file(new SlcFile);
+    file->m_rows = rows;
+    file->m_cols = cols;
+    file->m_format = format;
+    file->m_headerBytes = headerBytes;
+
+    if (rows <= 0 || cols <= 0 || headerBytes < 0) {
+        if (error) *error = QString("SLC 尺寸无效：%1 × %2").arg(rows).arg(cols);
+        return nullptr;
+    }
+    file->m_file.setFileName(path);
+    if (!file->m_file.open(QIODevice::ReadOnly)) {
+        if (error) *error = "无法打开 " + path + "：" + file->m_file.errorString();
+        return nullptr;
+    }
+    const qint64 expected = headerBytes + rows * cols * file->bytesPerSample();
+    if (file->m_file.size() < expected) {
+        if (error) *error = QString("SLC 文件长度 %1 小于 AUX 尺寸对应的 %2 字节：%3")
+                         .arg(file->m_file.size()).arg(expected).arg(path);
+        return nullptr;
+    }
+    file->m_map = file->m_file.map(0, expected);
+    if (!file->m_map) {
+        if (error) *error = "无法映射 " + path + "：" + file->m_file.errorString();
+        return nullptr;
+    }
+    file->m_mapSize = expected;
+#ifdef Q_OS_UNIX
+    // 请求之间的窗口位置没有规律，关闭顺序预读，只按窗口预取
+    ::madvise(file->m_map, size_t(expected), MADV_RANDOM);
+#endif
+    return file;
+}
+
+int SlcFile::bytesPerSample() const {
+    return slcBytesPerSample(m_format);
+}
+
+SlcWindow SlcFile::window(qint64 centerRow, qint64 centerCol, qint64 rows, qint64 cols) const {
+    SlcWindow window;
+    window.rows = qBound<qint64>(1, rows, m_rows);
+    window.cols = qBound<qint64>(1, cols, m_cols);
+    window.row0 = qBound<qint64>(0, centerRow - window.rows / 2, m_rows - window.rows);
+    window.col0 = qBound<qint64>(0, centerCol - window.cols / 2, m_cols - window.cols);
+    return window;
+}
+
+void SlcFile::prefetch(const SlcWindow& window) const {
+#ifdef Q_OS_UNIX
+    static const qint64 pageSize = ::sysconf(_SC_PAGESIZE);
+    const qint64 rowBytes = window.cols * bytesPerSample();
+    for (qint64 row = window.row0; row < window.row0 + window.rows; ++row) {
+        const qint64 begin = sampleAt(row, window.col0) - m_map;
+        const qint64 alignedBegin = begin - begin % pageSize;
+        ::madvise(m_map + alignedBegin, size_t(begin + rowBytes - alignedBegin), MADV_WILLNEED);
+    }
+#else
+    Q_UNUSED(window);
+#endif
+}
+
+const uchar* SlcFile::sampleAt(qint64 row, qint64 col) const {
+    return m_map + m_headerBytes + (row * m_cols + col) * bytesPerSample();
+}
+
+SlcChipPacketizer::SlcChipPacketizer(std::shared_ptr<SlcFile> file, const SlcWindow& window,
+                                     const SAR_DataInfo& dataInfo, uint16_t imageNumber)
+    : m_file(std::move(file)),
+    m_window(window),
+    m_dataInfo(dataInfo),
+    m_imageNumber(imageNumber)
+{
+    m_rowBytes = m_window.cols * m_file->bytesPerSample();
+    m_chipBytes = m_rowBytes * m_window.rows;
+    m_messageSize = qint64(sizeof(SAR_DataInfo)) + m_chipBytes;
+    m_totalPackets = int((m_messageSize + PAYLOAD_SIZE - 1) / PAYLOAD_SIZE);
+}
+
+bool SlcChipPacketizer::hasNextPacket() {
+    return m_nextPacket < m_totalPackets;
+}
+
+QByteArray SlcChipPacketizer::getNextPacket() {
+    if (!hasNextPacket()) {
+        return QByteArray();
+    }
+    const qint64 offset = qint64(m_nextPacket) * PAYLOAD_SIZE;
+    const qint64 payloadSize = qMin(PAYLOAD_SIZE, m_messageSize - offset);
+
+    QByteArray packet(int(sizeof(SAR_Frame) + payloadSize), Qt::Uninitialized);
+    char* payload = packet.data() + sizeof(SAR_Frame);
+    copyMessage(offset, payload, payloadSize);
+
+    SAR_Frame header;
+    memset(&header, 0, sizeof(SAR_Frame));
+    header.fixed_value = 0x90E9;
+    header.image_number = m_imageNumber;
+    header.image_size = uint32_t(m_chipBytes);
+    header.current_packet = uint16_t(m_nextPacket + 1);
+    header.total_packets = uint16_t(m_totalPackets);
+    header.data_length = uint16_t(payloadSize);
+    header.checksum = calculate_checksum(reinterpret_cast<const uint8_t*>(payload), size_t(payloadSize));
+    memcpy(packet.data(), &header, sizeof(SAR_Frame));
+
+    ++m_nextPacket;
+    return packet;
+}
+
+void SlcChipPacketizer::copyMessage(qint64 offset, char* dst, qint64 length) const {
+    // 消息 = SAR_DataInfo + 芯片各行；芯片部分按行从映射中拷贝
+    if (offset < qint64(sizeof(SAR_DataInfo))) {
+        const qint64 n = qMin(length, qint64(sizeof(SAR_DataInfo)) - offset);
+        memcpy(dst, reinterpret_cast<const char*>(&m_dataInfo) + offset, size_t(n));
+        dst += n;
+        offset += n;
+        length -= n;
+    }
+    qint64 chipOffset = offset - qint64(sizeof(SAR_DataInfo));
+    while (length > 0) {
+        const qint64 row = chipOffset / m_rowBytes;
+        const qint64 inRow = chipOffset % m_rowBytes;
+        const qint64 n = qMin(length, m_rowBytes - inRow);
+        memcpy(dst, m_file->sampleAt(m_window.row0 + row, m_window.col0) + inRow, size_t(n));
+        dst += n;
+        chipOffset += n;
+        length -= n;
+    }
+}
+
+void SlcChipService::setSettings(const SlcSettings& settings) {
+    QMutexLocker locker(&m_mutex);
+    m_settings = settings;
+    m_entries.clear();
+    m_order.clear();
+}
+
+SlcSettings SlcChipService::settings() const {
+    QMutexLocker locker(&m_mutex);
+    return m_settings;
+}
+
+void SlcChipService::setWorkerPool(WorkerPool* pool) {
+    QMutexLocker locker(&m_mutex);
+    m_pool = pool;
+}
+
+// 窗口对应的 AUX 头：尺寸为窗口本身，四角坐标由整幅图像插值得到
+static AuxHeader windowAux(const AuxHeader& aux, const SlcWindow& window) {
+    return auxHeaderForRegion(aux, window.row0, window.col0, window.rows, window.cols);
+}
+
+bool SlcChipService::acquire(const QString& slcPath, const QString& auxPath, Entry* entry, QString* error) {
+    const QFileInfo slcInfo(slcPath);
+    if (!slcInfo.exists()) {
+        if (error) *error = "SLC 文件不存在：" + slcPath;
+        return false;
+    }
+
+    const QDateTime auxModified = QFileInfo(auxPath).lastModified();
+    const EntryKey key(slcPath, auxPath);
+
+    SlcSettings settings;
+    {
+        QMutexLocker locker(&m_mutex);
+        settings = m_settings;
+        const auto it = m_entries.constFind(key);
+        if (it != m_entries.constEnd() && it->size == slcInfo.size() && it->modified == slcInfo.lastModified()
+            && it->auxModified == auxModified) {
+            *entry = *it;
+            m_order.removeOne(key);
+            m_order.append(key);
+            return true;
+        }
+    }
+
+    // 映射与 AUX 解析在锁外完成，不阻塞其他请求
+    AuxFileReader auxReader;
+    if (!auxReader.read(auxPath)) {
+        if (error) *error = "无法读取 AUX 文件：" + auxPath;
+        return false;
+    }
+    entry->aux = auxReader.getHeader();
+    entry->file = SlcFile::open(slcPath, entry->aux.pulse_num, entry->aux.pulse_len,
+                                settings.format, settings.headerBytes, error);
+    if (!entry->file) {
+        return false;
+    }
+    entry->size = slcInfo.size();
+    entry->modified = slcInfo.lastModified();
+    entry->auxModified = auxModified;
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.insert(key, *entry);
+    m_order.removeOne(key);
+    m_order.append(key);
+    while (m_order.size() > qMax(1, m_settings.cachedFiles)) {
+        m_entries.remove(m_order.takeFirst());
+    }
+    return true;
+}
+
+std::shared_ptr<SlcChipPacketizer> SlcChipService::createChip(const QString& slcPath, const QString& auxPath,
+                                                              uint16_t imageNumber, uint16_t sourceImageNumber, quint32 requestId,
+                                                              int offsetX, int offsetY, int rangeWindow, int azimuthWindow,
+                                                              QString* error) {
+    Entry entry;
+    if (!acquire(slcPath, auxPath, &entry, error)) {
+        return nullptr;
+    }
+
+    const SlcWindow window = entry.file->window(offsetY, offsetX, azimuthWindow, rangeWindow);
+    const qint64 chipBytes = window.rows * window.cols * entry.file->bytesPerSample();
+    const qint64 totalPackets = (qint64(sizeof(SAR_DataInfo)) + chipBytes + SlcChipPacketizer::PAYLOAD_SIZE - 1)
+                                / SlcChipPacketizer::PAYLOAD_SIZE;
+    if (window.rows > 0xFFFF || window.cols > 0xFFFF || totalPackets > 0xFFFF) {
+        if (error) *error = QString("芯片 %1 × %2 超出协议可表示的范围").arg(window.rows).arg(window.cols);
+        return nullptr;
+    }
+    entry.file->prefetch(window);
+
+    // 消息头沿用 SAR 图像的 SAR_DataInfo，尺寸与四角坐标改为芯片本身
+    SAR_DataInfo dataInfo = createSarDataInfo(windowAux(entry.aux, window), uint32_t(chipBytes), imageNumber);
+    dataInfo.message_type = SLC_CHIP_MESSAGE_TYPE;
+    SlcChipInfo chipInfo;
+    chipInfo.request_id = requestId;
+    chipInfo.row0 = uint32_t(window.row0);
+    chipInfo.col0 = uint32_t(window.col0);
+    chipInfo.full_rows = uint32_t(entry.file->rows());
+    chipInfo.full_cols = uint32_t(entry.file->cols());
+    chipInfo.sample_format = uint8_t(entry.file->format());
+    chipInfo.bytes_per_sample = uint8_t(entry.file->bytesPerSample());
+    chipInfo.source_image_number = sourceImageNumber;
+    memcpy(dataInfo.reserved2, &chipInfo, sizeof(SlcChipInfo));
+    finalizeSarDataInfoChecksum(dataInfo);
+
+    qCDebug(lcPacking) << "SLC 芯片：" << slcPath << "行" << window.row0 << "列" << window.col0
+             << window.rows << "×" << window.cols << "，" << chipBytes << "字节";
+    return std::make_shared<SlcChipPacketizer>(entry.file, window, dataInfo, imageNumber);
+}
+
+bool SlcChipService::renderQuicklook(const QString& slcPath, const QString& auxPath,
+                                     int offsetX, int offsetY, int rangeWindow, int azimuthWindow,
+                                     QImage* image, AuxHeader* imageAux, QString* error) {
+    Entry entry;
+    if (!acquire(slcPath, auxPath, &entry, error)) {
+        return false;
+    }
+    SlcQuicklookSettings settings;
+    WorkerPool* pool = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        settings = m_settings.quicklook;
+        pool = m_pool;
+    }
+    const int span = qMax(1, settings.span);
+    const SlcWindow window = entry.file->window(offsetY, offsetX, qint64(azimuthWindow) * span, qint64(rangeWindow) * span);
+
+    // 视数：方位向优先用 AUX 建议值；距离向默认取使多视后像素近似为方形的值
+    int azimuthLooks = settings.azimuthLooks > 0 ? settings.azimuthLooks
+                                                 : (entry.aux.az_MLK_num > 0 ? int(entry.aux.az_MLK_num) : 4);
+    int rangeLooks = settings.rangeLooks;
+    if (rangeLooks <= 0) {
+        rangeLooks = entry.aux.Rbin > 0 ? int(std::lround(azimuthLooks * entry.aux.Xbin / entry.aux.Rbin)) : azimuthLooks;
+    }
+    azimuthLooks = int(qBound<qint64>(1, azimuthLooks, window.rows));
+    rangeLooks = int(qBound<qint64>(1, rangeLooks, window.cols));
+    const qint64 outRows = window.rows / azimuthLooks;
+    const qint64 outCols = window.cols / rangeLooks;
+
+    entry.file->prefetch(window);
+    SlcSamples samples;
+    samples.data = entry.file->sampleAt(window.row0, window.col0);
+    samples.rowStride = entry.file->cols() * entry.file->bytesPerSample();
+    samples.rows = window.rows;
+    samples.cols = window.cols;
+    samples.format = entry.file->format();
+
+    MultilookOptions options;
+    options.rangeLooks = rangeLooks;
+    options.azimuthLooks = azimuthLooks;
+    options.power = settings.power;
+    options.pool = pool;
+    options.threads = settings.threads;
+    std::vector<float> magnitude(static_cast<size_t>(outRows * outCols));
+    multilookMagnitude(samples, options, magnitude.data());
+
+    std::vector<quint8> pixels(magnitude.size());
+    logScaleTo8Bit(magnitude.data(), qint64(magnitude.size()), settings.power,
+                   settings.dynamicRangeDb, settings.clipPercentile, pixels.data());
+    QImage result(int(outCols), int(outRows), QImage::Format_Grayscale8);
+    if (result.isNull()) {
+        if (error) *error = QString("无法分配 %1 × %2 的快视图").arg(outCols).arg(outRows);
+        return false;
+    }
+    for (qint64 row = 0; row < outRows; ++row) {
+        memcpy(result.scanLine(int(row)), pixels.data() + row * outCols, size_t(outCols));
+    }
+    *image = result;
+
+    // 多视后的像素间距按视数放大，打包时据此做方位向校正
+    *imageAux = windowAux(entry.aux, window);
+    imageAux->pulse_num = outRows;
+    imageAux->pulse_len = outCols;
+    imageAux->Xbin = entry.aux.Xbin * azimuthLooks;
+    imageAux->Rbin = entry.aux.Rbin * rangeLooks;
+    imageAux->az_MLK_num = azimuthLooks;
+
+    qCDebug(lcPacking) << "SLC 快视图：" << slcPath << "行" << window.row0 << "列" << window.col0
+             << window.rows << "×" << window.cols << "，视数" << azimuthLooks << "×" << rangeLooks
+             << "→" << outCols << "×" << outRows;
+    return true;
+}
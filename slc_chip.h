@@ -0,0 +1,186 @@
+#ifndef SLC_CHIP_H
+#define SLC_CHIP_H
+
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <memory>
+#include "AuxFileReader.h"
+#include "package_sar_data.h"
+#include "slc_format.h"
+
+class WorkerPool;
+
+// 请求区域的多视幅度快视图
+struct SlcQuicklookSettings {
+    bool enabled = false;
+    int span = 4;                   // 快视范围为 ISAR 窗口的倍数
+    int azimuthLooks = 0;           // 0：取 AUX 的 az_MLK_num，无效时为 4
+    int rangeLooks = 0;             // 0：按 Xbin/Rbin 取使像素近似为方形的视数
+    bool power = false;             // true 为 |z|²，false 为 |z|
+    float dynamicRangeDb = 40.0f;
+    float clipPercentile = 99.5f;
+    int threads = 0;                // 多视计算的线程数上限（含调用线程）；<= 0 时使用整个工作线程池
+};
+
+struct SlcSettings {
+    bool directChip = false;        // 收到 ISAR 请求时直接从 SLC 切片回传
+    SlcSampleFormat format = SlcSampleFormat::ComplexFloat32;
+    qint64 headerBytes = 0;         // SLC 文件头长度，样本从此偏移开始
+    int cachedFiles = 4;            // 保持映射的 SLC 文件数
+    SlcQuicklookSettings quicklook;
+};
+
+// 芯片在整幅 SLC 中的位置（行 = 方位向，列 = 距离向）
+struct SlcWindow {
+    qint64 row0 = 0;
+    qint64 col0 = 0;
+    qint64 rows = 0;
+    qint64 cols = 0;
+};
+
+#pragma pack(1)
+// 芯片回传时写入 SAR_DataInfo::reserved2 的扩展信息
+struct SlcChipInfo {
+    uint32_t request_id;        // ISAR 请求编号
+    uint32_t row0;              // 芯片首行（方位向）在整幅 SLC 中的序号
+    uint32_t col0;              // 芯片首列（距离向）
+    uint32_t full_rows;         // 整幅 SLC 行数
+    uint32_t full_cols;         // 整幅 SLC 列数
+    uint8_t sample_format;      // SlcSampleFormat
+    uint8_t bytes_per_sample;
+    uint16_t source_image_number;   // 请求所针对的已发送图像编号（芯片本身占用新的图像编号）
+};
+#pragma pack()
+static_assert(sizeof(SlcChipInfo) <= sizeof(SAR_DataInfo::reserved2), "SlcChipInfo must fit in reserved2");
+
+// SLC 芯片消息的消息类型（SAR 图像为 0x0001）
+constexpr uint16_t SLC_CHIP_MESSAGE_TYPE = 0x0004;
+
+/**
+ * @class SlcFile
+ * @brief 只读内存映射的 SLC 文件。取窗口时按行跨步访问映射，不读入整幅数据。
+ */
+class SlcFile {
+public:
+    ~SlcFile();
+
+    /**
+     * @brief 映射 SLC 文件；rows/cols 来自 AUX 的 pulse_num/pulse_len。
+     * 文件长度不足 headerBytes + rows × cols × 样本字节数时失败。
+     */
+    static std::shared_ptr<SlcFile> open(const QString& path, qint64 rows, qint64 cols,
+                                         SlcSampleFormat format, qint64 headerBytes, QString* error = nullptr);
+
+    qint64 rows() const { return m_rows; }
+    qint64 cols() const { return m_cols; }
+    SlcSampleFormat format() const { return m_format; }
+    int bytesPerSample() const;
+
+    // 以 (centerRow, centerCol) 为中心取 rows × cols 的窗口；越界时整体平移，超过整幅尺寸时截断
+    SlcWindow window(qint64 centerRow, qint64 centerCol, qint64 rows, qint64 cols) const;
+    // 提示内核预读窗口覆盖的各行片段
+    void prefetch(const SlcWindow& window) const;
+    const uchar* sampleAt(qint64 row, qint64 col) const;
+
+private:
+    SlcFile() = default;
+
+    QFile m_file;
+    uchar* m_map = nullptr;
+    qint64 m_mapSize = 0;
+    qint64 m_headerBytes = 0;
+    qint64 m_rows = 0;
+    qint64 m_cols = 0;
+    SlcSampleFormat m_format = SlcSampleFormat::ComplexFloat32;
+};
+
+/**
+ * @class SlcChipPacketizer
+ * @brief 把 SLC 窗口按 SAR_DataInfo + 逐行样本的消息格式切成 SAR_Frame 包。
+ *
+ * 每个包在 getNextPacket() 时才从映射中拷贝，首包只依赖消息头和芯片的前几行，
+ * 因此无需先生成整块芯片即可开始发送。
+ */
+class SlcChipPacketizer : public PacketSource {
+public:
+    SlcChipPacketizer(std::shared_ptr<SlcFile> file, const SlcWindow& window, const SAR_DataInfo& dataInfo, uint16_t imageNumber);
+
+    bool hasNextPacket() override;
+    QByteArray getNextPacket() override;
+
+    qint64 chipBytes() const { return m_chipBytes; }
+    int totalPackets() const { return m_totalPackets; }
+
+    static constexpr qint64 PAYLOAD_SIZE = 4096;
+
+private:
+    void copyMessage(qint64 offset, char* dst, qint64 length) const;
+
+    std::shared_ptr<SlcFile> m_file;
+    SlcWindow m_window;
+    SAR_DataInfo m_dataInfo;
+    uint16_t m_imageNumber;
+    qint64 m_rowBytes;
+    qint64 m_chipBytes;
+    qint64 m_messageSize;
+    int m_totalPackets;
+    int m_nextPacket = 0;
+};
+
+/**
+ * @class SlcChipService
+ * @brief ISAR 请求的 SLC 直传：缓存最近使用的 SLC 映射与 AUX 头，按请求中心切出芯片包源。
+ * 线程安全，可在线程池中并发调用。
+ */
+class SlcChipService {
+public:
+    void setSettings(const SlcSettings& settings);
+    SlcSettings settings() const;
+    // 快视图多视计算借用的线程池；为空时只在调用线程中计算
+    void setWorkerPool(WorkerPool* pool);
+
+    /**
+     * @brief 为一次 ISAR 请求创建芯片包源。offsetX 为距离向（列）中心，offsetY 为方位向（行）中心，
+     * 窗口尺寸与写入 ISARConfig XML 的 rg_win_len/az_win_len 相同。失败时返回空指针并填写 error。
+     * imageNumber 为芯片自己的图像编号（须新分配，不能与源图像相同），sourceImageNumber 写入 SlcChipInfo。
+     */
+    std::shared_ptr<SlcChipPacketizer> createChip(const QString& slcPath, const QString& auxPath,
+                                                  uint16_t imageNumber, uint16_t sourceImageNumber, quint32 requestId,
+                                                  int offsetX, int offsetY, int rangeWindow, int azimuthWindow,
+                                                  QString* error = nullptr);
+
+    /**
+     * @brief 生成请求区域（ISAR 窗口 × span）的多视幅度快视图，8 位灰度。
+     * imageAux 填入快视图对应的尺寸、像素间距与四角坐标，可直接交给 createBinFileFromImageAndAux。
+     */
+    bool renderQuicklook(const QString& slcPath, const QString& auxPath,
+                         int offsetX, int offsetY, int rangeWindow, int azimuthWindow,
+                         QImage* image, AuxHeader* imageAux, QString* error = nullptr);
+
+private:
+    struct Entry {
+        std::shared_ptr<SlcFile> file;
+        AuxHeader aux;
+        qint64 size = 0;
+        QDateTime modified;
+        QDateTime auxModified;
+    };
+    // 同一 SLC 可能配不同的 AUX（尺寸不同则映射长度也不同），缓存按两者共同索引
+    using EntryKey = QPair<QString, QString>;
+
+    bool acquire(const QString& slcPath, const QString& auxPath, Entry* entry, QString* error);
+
+    mutable QMutex m_mutex;
+    SlcSettings m_settings;
+    WorkerPool* m_pool = nullptr;
+    QHash<EntryKey, Entry> m_entries;
+    QList<EntryKey> m_order;    // 最近使用的在末尾
+};
+
+#endif // SLC_CHIP_H
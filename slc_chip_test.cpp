@@ -0,0 +1,233 @@
+// slc_chip_test.cpp
+// SLC 芯片：窗口以请求点为中心，越界时整体平移；消息头为 0x0004 类型的 SAR_DataInfo，reserved2 带 SlcChipInfo，
+// 其后逐行为窗口内的原始样本；映射缓存按 (SLC, AUX) 共同索引，换用或改写 AUX 时重新按新尺寸映射
+#include <QtTest>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <cstring>
+#include "slc_chip.h"
+
+namespace {
+
+const qint64 HEADER_BYTES = 16;
+
+// 按 AuxFileReader::read 的字段顺序写一个最小的 AUX 文件，其后附带足够长度的运动数据
+bool writeAux(const QString& path, qint64 rows, qint64 cols, double xbin, double rbin) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << qint64(0) << qint64(0) << qint64(1);                         // op_mode pp_mode Kr_sign
+    for (int i = 0; i < 8; ++i) {                                       // fc .. PRF
+        out << 0.0;
+    }
+    out << rows << cols << qint64(8);                                   // pulse_num pulse_len amp_bit
+    out << xbin << rbin;
+    out << qint64(2) << qint64(0) << qint64(0);                         // geo_mode look_mode flag_flat
+    for (int i = 0; i < 27; ++i) {                                      // fdc_ref .. lng_e
+        out << 0.0;
+    }
+    out << 30.0 << 120.0 << 30.0 << 120.1 << 29.9 << 120.0 << 29.9 << 120.1;   // 四角经纬度
+    out << 0.0 << qint64(1);                                            // IMG_TH az_MLK_num
+    for (qint64 i = 0; i < rows * 7 + 10; ++i) {
+        out << 0.0;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+// ci16 样本的 I 为行号、Q 为列号，由芯片内容即可判断取自哪个位置
+bool writeSlc(const QString& path, qint64 rows, qint64 cols) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QByteArray data(int(HEADER_BYTES), '\xAB');
+    for (qint64 row = 0; row < rows; ++row) {
+        for (qint64 col = 0; col < cols; ++col) {
+            const qint16 sample[2] = { qint16(row), qint16(col) };
+            data.append(reinterpret_cast<const char*>(sample), sizeof(sample));
+        }
+    }
+    return file.write(data) == data.size();
+}
+
+// 按接收端的方式校验帧头并拼回整条消息
+QByteArray assemble(SlcChipPacketizer& chip, uint16_t imageNumber) {
+    QByteArray message;
+    int expectedPacket = 1;
+    while (chip.hasNextPacket()) {
+        const QByteArray packet = chip.getNextPacket();
+        if (packet.size() < int(sizeof(SAR_Frame))) {
+            return QByteArray();
+        }
+        SAR_Frame header;
+        memcpy(&header, packet.constData(), sizeof(SAR_Frame));
+        const QByteArray payload = packet.mid(sizeof(SAR_Frame));
+        if (header.fixed_value != 0x90E9 || header.image_number != imageNumber
+            || header.current_packet != expectedPacket || header.total_packets != chip.totalPackets()
+            || int(header.data_length) != payload.size()
+            || header.checksum != calculate_checksum(reinterpret_cast<const uint8_t*>(payload.constData()), payload.size())) {
+            return QByteArray();
+        }
+        message.append(payload);
+        ++expectedPacket;
+    }
+    return message;
+}
+
+struct ChipMessage {
+    SAR_DataInfo dataInfo;
+    SlcChipInfo chipInfo;
+    QByteArray samples;
+};
+
+bool parse(const QByteArray& message, ChipMessage* chip) {
+    if (message.size() < int(sizeof(SAR_DataInfo))) {
+        return false;
+    }
+    memcpy(&chip->dataInfo, message.constData(), sizeof(SAR_DataInfo));
+    memcpy(&chip->chipInfo, chip->dataInfo.reserved2, sizeof(SlcChipInfo));
+    chip->samples = message.mid(sizeof(SAR_DataInfo));
+    return true;
+}
+
+} // namespace
+
+class SlcChipTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init() {
+        QVERIFY(m_dir.isValid());
+        m_slcPath = m_dir.filePath("SLC_test.slc");
+        m_auxPath = m_dir.filePath("AUX_test.aux");
+        QVERIFY(writeSlc(m_slcPath, 40, 50));
+        QVERIFY(writeAux(m_auxPath, 40, 50, 1.0, 1.0));
+
+        SlcSettings settings;
+        settings.format = SlcSampleFormat::ComplexInt16;
+        settings.headerBytes = HEADER_BYTES;
+        m_service.setSettings(settings);
+    }
+
+    void chipCarriesWindowSamplesAndChipInfo() {
+        QString error;
+        // 距离向（列）中心 25、方位向（行）中心 20，窗口 8 列 × 10 行
+        const auto chip = m_service.createChip(m_slcPath, m_auxPath, 301, 300, 77, 25, 20, 8, 10, &error);
+        QVERIFY2(chip, qPrintable(error));
+        QCOMPARE(chip->chipBytes(), qint64(10 * 8 * 4));
+
+        ChipMessage message;
+        QVERIFY(parse(assemble(*chip, 301), &message));
+        QCOMPARE(message.dataInfo.frame_header, uint16_t(0x55AA));
+        QCOMPARE(message.dataInfo.message_type, SLC_CHIP_MESSAGE_TYPE);
+        QCOMPARE(message.dataInfo.image_rows, uint16_t(10));
+        QCOMPARE(message.dataInfo.image_cols, uint16_t(8));
+        const uint8_t* header = reinterpret_cast<const uint8_t*>(&message.dataInfo);
+        QCOMPARE(message.dataInfo.checksum,
+                 calculate_checksum(header + sizeof(uint16_t), sizeof(SAR_DataInfo) - sizeof(uint16_t) - sizeof(uint8_t)));
+
+        QCOMPARE(message.chipInfo.request_id, uint32_t(77));
+        QCOMPARE(message.chipInfo.row0, uint32_t(15));
+        QCOMPARE(message.chipInfo.col0, uint32_t(21));
+        QCOMPARE(message.chipInfo.full_rows, uint32_t(40));
+        QCOMPARE(message.chipInfo.full_cols, uint32_t(50));
+        QCOMPARE(message.chipInfo.sample_format, uint8_t(SlcSampleFormat::ComplexInt16));
+        QCOMPARE(message.chipInfo.bytes_per_sample, uint8_t(4));
+        QCOMPARE(message.chipInfo.source_image_number, uint16_t(300));
+
+        QCOMPARE(message.samples.size(), 10 * 8 * 4);
+        const qint16* samples = reinterpret_cast<const qint16*>(message.samples.constData());
+        for (int row = 0; row < 10; ++row) {
+            for (int col = 0; col < 8; ++col) {
+                QCOMPARE(samples[(row * 8 + col) * 2], qint16(15 + row));
+                QCOMPARE(samples[(row * 8 + col) * 2 + 1], qint16(21 + col));
+            }
+        }
+    }
+
+    void windowShiftsInsideImageAtEdges() {
+        ChipMessage message;
+        auto chip = m_service.createChip(m_slcPath, m_auxPath, 1, 0, 0, 0, 0, 8, 10);
+        QVERIFY(chip);
+        QVERIFY(parse(assemble(*chip, 1), &message));
+        QCOMPARE(message.chipInfo.row0, uint32_t(0));
+        QCOMPARE(message.chipInfo.col0, uint32_t(0));
+
+        chip = m_service.createChip(m_slcPath, m_auxPath, 2, 0, 0, 49, 39, 8, 10);
+        QVERIFY(chip);
+        QVERIFY(parse(assemble(*chip, 2), &message));
+        QCOMPARE(message.chipInfo.row0, uint32_t(30));
+        QCOMPARE(message.chipInfo.col0, uint32_t(42));
+
+        // 窗口大于整幅时截断为整幅
+        chip = m_service.createChip(m_slcPath, m_auxPath, 3, 0, 0, 25, 20, 100, 100);
+        QVERIFY(chip);
+        QVERIFY(parse(assemble(*chip, 3), &message));
+        QCOMPARE(message.dataInfo.image_rows, uint16_t(40));
+        QCOMPARE(message.dataInfo.image_cols, uint16_t(50));
+        QCOMPARE(message.samples.size(), 40 * 50 * 4);
+    }
+
+    void cacheIsKeyedOnSlcAndAux() {
+        // 同一 SLC 配另一份 AUX（转置尺寸、字节数相同），不能命中前一次的映射
+        const QString otherAux = m_dir.filePath("AUX_other.aux");
+        QVERIFY(writeAux(otherAux, 50, 40, 1.0, 1.0));
+
+        ChipMessage message;
+        auto chip = m_service.createChip(m_slcPath, m_auxPath, 1, 0, 0, 0, 0, 4, 4);
+        QVERIFY(chip);
+        QVERIFY(parse(assemble(*chip, 1), &message));
+        QCOMPARE(message.chipInfo.full_cols, uint32_t(50));
+
+        chip = m_service.createChip(m_slcPath, otherAux, 2, 0, 0, 0, 0, 4, 4);
+        QVERIFY(chip);
+        QVERIFY(parse(assemble(*chip, 2), &message));
+        QCOMPARE(message.chipInfo.full_rows, uint32_t(50));
+        QCOMPARE(message.chipInfo.full_cols, uint32_t(40));
+
+        chip = m_service.createChip(m_slcPath, m_auxPath, 3, 0, 0, 0, 0, 4, 4);
+        QVERIFY(chip);
+        QVERIFY(parse(assemble(*chip, 3), &message));
+        QCOMPARE(message.chipInfo.full_cols, uint32_t(50));
+    }
+
+    void rewrittenAuxIsReread() {
+        ChipMessage message;
+        auto chip = m_service.createChip(m_slcPath, m_auxPath, 1, 0, 0, 0, 0, 4, 4);
+        QVERIFY(chip);
+        QVERIFY(parse(assemble(*chip, 1), &message));
+        QCOMPARE(message.chipInfo.full_rows, uint32_t(40));
+
+        // 修改时间显式后移，不依赖文件系统的时间精度
+        const QDateTime modified = QFileInfo(m_auxPath).lastModified();
+        QVERIFY(writeAux(m_auxPath, 20, 50, 1.0, 1.0));
+        QFile aux(m_auxPath);
+        QVERIFY(aux.open(QIODevice::ReadWrite));
+        QVERIFY(aux.setFileTime(modified.addSecs(10), QFileDevice::FileModificationTime));
+        aux.close();
+
+        chip = m_service.createChip(m_slcPath, m_auxPath, 2, 0, 0, 0, 0, 4, 4);
+        QVERIFY(chip);
+        QVERIFY(parse(assemble(*chip, 2), &message));
+        QCOMPARE(message.chipInfo.full_rows, uint32_t(20));
+    }
+
+    void missingSlcIsReported() {
+        QString error;
+        QVERIFY(!m_service.createChip(m_dir.filePath("missing.slc"), m_auxPath, 1, 0, 0, 0, 0, 4, 4, &error));
+        QVERIFY(!error.isEmpty());
+    }
+
+private:
+    QTemporaryDir m_dir;
+    QString m_slcPath;
+    QString m_auxPath;
+    SlcChipService m_service;
+};
+
+QTEST_GUILESS_MAIN(SlcChipTest)
+#include "slc_chip_test.moc"
@@ -0,0 +1,16 @@
+#ifndef SLC_FORMAT_H
+#define SLC_FORMAT_H
+
+#include <QtGlobal>
+
+// SLC 复数样本格式：逐行（方位向）存放，每行 pulse_len 个距离向样本，I/Q 交织、小端
+enum class SlcSampleFormat : quint8 {
+    ComplexFloat32 = 1,     // 2 × float32，每样本 8 字节
+    ComplexInt16 = 2        // 2 × int16，每样本 4 字节
+};
+
+inline int slcBytesPerSample(SlcSampleFormat format) {
+    return format == SlcSampleFormat::ComplexInt16 ? 4 : 8;
+}
+
+#endif // SLC_FORMAT_H
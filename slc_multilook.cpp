@@ -0,0 +1,239 @@
+#include "slc_multilook.h"
+#include "worker_pool.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SLC_HAVE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SLC_TARGET_AVX2
+#else
+#define SLC_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+// 每个线程任务处理的输出行数
+static const qint64 ROWS_PER_BLOCK = 8;
+
+bool cpuHasAvx2() {
+#if !defined(SLC_HAVE_X86)
+    return false;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || !fma || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+#endif
+}
+
+// ---- 标量实现：acc[c] += |z| 或 |z|² ----
+
+static void accumulateRowScalar(const uchar* row, qint64 cols, SlcSampleFormat format, bool power, float* acc) {
+    if (format == SlcSampleFormat::ComplexInt16) {
+        const qint16* src = reinterpret_cast<const qint16*>(row);
+        for (qint64 c = 0; c < cols; ++c) {
+            const float re = src[2 * c];
+            const float im = src[2 * c + 1];
+            const float p = re * re + im * im;
+            acc[c] += power ? p : std::sqrt(p);
+        }
+    } else {
+        const float* src = reinterpret_cast<const float*>(row);
+        for (qint64 c = 0; c < cols; ++c) {
+            const float re = src[2 * c];
+            const float im = src[2 * c + 1];
+            const float p = re * re + im * im;
+            acc[c] += power ? p : std::sqrt(p);
+        }
+    }
+}
+
+#ifdef SLC_HAVE_X86
+// ---- AVX2 实现：每次处理 8 个复数样本 ----
+
+SLC_TARGET_AVX2
+static void accumulateRowAvx2(const uchar* row, qint64 cols, SlcSampleFormat format, bool power, float* acc) {
+    qint64 c = 0;
+    if (format == SlcSampleFormat::ComplexInt16) {
+        const qint16* src = reinterpret_cast<const qint16*>(row);
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        for (; c + 8 <= cols; c += 8) {
+            // madd 直接得到 8 个 re² + im²（int32），顺序与样本一致；
+            // 唯一溢出的 (-32768)² × 2 = 2^31 转成 float 后去掉符号即为正确值
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * c));
+            __m256 p = _mm256_andnot_ps(signMask, _mm256_cvtepi32_ps(_mm256_madd_epi16(v, v)));
+            if (!power) {
+                p = _mm256_sqrt_ps(p);
+            }
+            _mm256_storeu_ps(acc + c, _mm256_add_ps(_mm256_loadu_ps(acc + c), p));
+        }
+    } else {
+        const float* src = reinterpret_cast<const float*>(row);
+        for (; c + 8 <= cols; c += 8) {
+            const __m256 a = _mm256_loadu_ps(src + 2 * c);         // 样本 0-3
+            const __m256 b = _mm256_loadu_ps(src + 2 * c + 8);     // 样本 4-7
+            // hadd 得到 [p0 p1 q0 q1 | p2 p3 q2 q3]，再按 64 位重排成样本顺序
+            const __m256 h = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+            __m256 p = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(h), _MM_SHUFFLE(3, 1, 2, 0)));
+            if (!power) {
+                p = _mm256_sqrt_ps(p);
+            }
+            _mm256_storeu_ps(acc + c, _mm256_add_ps(_mm256_loadu_ps(acc + c), p));
+        }
+    }
+    if (c < cols) {
+        accumulateRowScalar(row + c * slcBytesPerSample(format), cols - c, format, power, acc + c);
+    }
+}
+#endif
+
+using AccumulateRow = void (*)(const uchar*, qint64, SlcSampleFormat, bool, float*);
+
+namespace {
+
+// 一次多视计算的分块领取状态。提交到线程池的任务持有共享指针：任务开始得晚、分块已被领完时直接返回，
+// 不会再访问调用方栈上的数据；调用方只等待已领走的分块完成
+struct BlockJob {
+    qint64 blocks = 0;
+    std::function<void(qint64 block, std::vector<float>& acc)> run;
+    std::atomic<qint64> nextBlock{0};
+    qint64 doneBlocks = 0;
+    QMutex mutex;
+    QWaitCondition done;
+
+    void work() {
+        std::vector<float> acc;
+        for (qint64 block = nextBlock.fetch_add(1); block < blocks; block = nextBlock.fetch_add(1)) {
+            run(block, acc);
+            QMutexLocker locker(&mutex);
+            if (++doneBlocks == blocks) {
+                done.wakeAll();
+            }
+        }
+    }
+
+    void wait() {
+        QMutexLocker locker(&mutex);
+        while (doneBlocks < blocks) {
+            done.wait(&mutex);
+        }
+    }
+};
+
+} // namespace
+
+static AccumulateRow selectKernel(SimdLevel level) {
+#ifdef SLC_HAVE_X86
+    if (level == SimdLevel::Avx2 || (level == SimdLevel::Auto && cpuHasAvx2())) {
+        return accumulateRowAvx2;
+    }
+#else
+    Q_UNUSED(level);
+#endif
+    return accumulateRowScalar;
+}
+
+void multilookMagnitude(const SlcSamples& samples, const MultilookOptions& options, float* out) {
+    const int rangeLooks = qMax(1, options.rangeLooks);
+    const int azimuthLooks = qMax(1, options.azimuthLooks);
+    const qint64 outRows = samples.rows / azimuthLooks;
+    const qint64 outCols = samples.cols / rangeLooks;
+    if (outRows <= 0 || outCols <= 0) {
+        return;
+    }
+    const qint64 usedCols = outCols * rangeLooks;
+    const float scale = 1.0f / float(rangeLooks * azimuthLooks);
+    const AccumulateRow accumulate = selectKernel(options.simd);
+
+    auto job = std::make_shared<BlockJob>();
+    job->blocks = (outRows + ROWS_PER_BLOCK - 1) / ROWS_PER_BLOCK;
+    job->run = [&](qint64 block, std::vector<float>& acc) {
+        // 每个线程一行累加缓冲：方位向各视先逐样本累加，最后一次性做距离向合并
+        acc.resize(static_cast<size_t>(usedCols));
+        const qint64 endRow = qMin(outRows, (block + 1) * ROWS_PER_BLOCK);
+        for (qint64 outRow = block * ROWS_PER_BLOCK; outRow < endRow; ++outRow) {
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            for (int look = 0; look < azimuthLooks; ++look) {
+                const uchar* row = samples.data + (outRow * azimuthLooks + look) * samples.rowStride;
+                accumulate(row, usedCols, samples.format, options.power, acc.data());
+            }
+            float* dst = out + outRow * outCols;
+            const float* src = acc.data();
+            for (qint64 c = 0; c < outCols; ++c, src += rangeLooks) {
+                float sum = 0.0f;
+                for (int k = 0; k < rangeLooks; ++k) {
+                    sum += src[k];
+                }
+                dst[c] = sum * scale;
+            }
+        }
+    };
+
+    int helpers = 0;
+    if (options.pool) {
+        helpers = options.threads > 0 ? options.threads - 1 : options.pool->threadCount();
+        helpers = int(qBound<qint64>(0, helpers, job->blocks - 1));
+    }
+    for (int i = 0; i < helpers; ++i) {
+        options.pool->submit([job]() { job->work(); });
+    }
+    job->work();
+    job->wait();
+}
+
+void logScaleTo8Bit(const float* values, qint64 count, bool power, float dynamicRangeDb, float clipPercentile,
+                    quint8* out) {
+    if (count <= 0) {
+        return;
+    }
+    const float factor = power ? 10.0f : 20.0f;
+    const float range = qMax(1.0f, dynamicRangeDb);
+
+    // 亮端取分位数而非最大值，避免个别强散射点把整幅图压暗；大图只抽样估计
+    const qint64 maxSamples = 1 << 16;
+    const qint64 step = qMax<qint64>(1, count / maxSamples);
+    std::vector<float> sample;
+    sample.reserve(size_t(count / step + 1));
+    for (qint64 i = 0; i < count; i += step) {
+        if (values[i] > 0.0f) {
+            sample.push_back(values[i]);
+        }
+    }
+    if (sample.empty()) {
+        memset(out, 0, size_t(count));
+        return;
+    }
+    const double fraction = qBound(0.0, double(clipPercentile) / 100.0, 1.0);
+    const size_t index = qMin(sample.size() - 1, size_t(fraction * double(sample.size() - 1) + 0.5));
+    std::nth_element(sample.begin(), sample.begin() + qint64(index), sample.end());
+    const float topDb = factor * std::log10(sample[index]);
+    const float floorDb = topDb - range;
+    const float gain = 255.0f / range;
+
+    for (qint64 i = 0; i < count; ++i) {
+        if (values[i] <= 0.0f) {
+            out[i] = 0;
+            continue;
+        }
+        const float level = (factor * std::log10(values[i]) - floorDb) * gain;
+        out[i] = quint8(qBound(0.0f, level + 0.5f, 255.0f));
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef SLC_MULTILOOK_H
+#define SLC_MULTILOOK_H
+
+#include <QtGlobal>
+#include "slc_format.h"
+
+class WorkerPool;
+
+// 一块按行跨步存放的 SLC 样本（通常是映射文件中的一个窗口）
+struct SlcSamples {
+    const uchar* data = nullptr;    // 首行首样本
+    qint64 rowStride = 0;           // 相邻两行的字节距离
+    qint64 rows = 0;
+    qint64 cols = 0;
+    SlcSampleFormat format = SlcSampleFormat::ComplexFloat32;
+};
+
+enum class SimdLevel {
+    Auto,       // 运行时检测，CPU 支持时使用 AVX2
+    Scalar,
+    Avx2
+};
+
+struct MultilookOptions {
+    int rangeLooks = 1;
+    int azimuthLooks = 1;
+    bool power = false;             // true 为 |z|²，false 为 |z|
+    WorkerPool* pool = nullptr;     // 为空时只在调用线程中计算
+    int threads = 0;                // 参与计算的线程数上限（含调用线程）；<= 0 时为线程池线程数 + 1
+    SimdLevel simd = SimdLevel::Auto;
+};
+
+// 当前 CPU 与操作系统是否支持 AVX2 + FMA
+bool cpuHasAvx2();
+
+/**
+ * @brief 多视幅度：每 azimuthLooks × rangeLooks 个样本的 |z|（或 |z|²）取平均，
+ * 结果按行写入 out，尺寸为 (rows / azimuthLooks) × (cols / rangeLooks)，不足一视的边缘丢弃。
+ * 按输出行分块，调用线程与线程池中的工作线程一起领取分块计算，每个输入样本只读一次。
+ * 调用线程只等待已被领走的分块，可在同一线程池的任务中调用。
+ */
+void multilookMagnitude(const SlcSamples& samples, const MultilookOptions& options, float* out);
+
+/**
+ * @brief 对数拉伸到 8 位：以 clipPercentile 分位数为亮端、向下 dynamicRangeDb 为暗端线性映射 dB 值。
+ * power 与 multilookMagnitude 一致，决定按 10·lg 还是 20·lg 计算 dB。
+ */
+void logScaleTo8Bit(const float* values, qint64 count, bool power, float dynamicRangeDb, float clipPercentile,
+                    quint8* out);
+
+#endif // SLC_MULTILOOK_H
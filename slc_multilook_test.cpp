@@ -0,0 +1,224 @@
+// slc_multilook_test.cpp
+// 多视幅度：标量结果与逐点直接求平均一致，不足一视的边缘丢弃；AVX2 与标量结果一致，
+// 包括不足 8 个样本的行尾、行跨步大于行宽以及 ci16 的 -32768；借用线程池时结果与单线程相同，
+// 且可在同一线程池的任务中调用而不死锁。
+#include <QtTest>
+#include <QSemaphore>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "slc_multilook.h"
+#include "worker_pool.h"
+
+namespace {
+
+// 行跨步比行宽多 3 个样本，检查按 rowStride 而不是 cols 寻址
+struct SyntheticSlc {
+    std::vector<uchar> data;
+    SlcSamples samples;
+};
+
+SyntheticSlc makeSlc(qint64 rows, qint64 cols, SlcSampleFormat format, unsigned seed) {
+    SyntheticSlc slc;
+    const int bytesPerSample = slcBytesPerSample(format);
+    const qint64 rowStride = (cols + 3) * bytesPerSample;
+    slc.data.resize(static_cast<size_t>(rows * rowStride));
+    std::mt19937 rng(seed);
+    if (format == SlcSampleFormat::ComplexInt16) {
+        std::uniform_int_distribution<int> dist(-32768, 32767);
+        qint16* p = reinterpret_cast<qint16*>(slc.data.data());
+        for (size_t i = 0; i < slc.data.size() / sizeof(qint16); ++i) {
+            p[i] = qint16(dist(rng));
+        }
+        if (rows > 0 && cols > 0) {
+            p[0] = -32768;      // madd 唯一会溢出的样本
+            p[1] = -32768;
+        }
+    } else {
+        std::normal_distribution<float> dist(0.0f, 100.0f);
+        float* p = reinterpret_cast<float*>(slc.data.data());
+        for (size_t i = 0; i < slc.data.size() / sizeof(float); ++i) {
+            p[i] = dist(rng);
+        }
+    }
+    slc.samples.data = slc.data.data();
+    slc.samples.rowStride = rowStride;
+    slc.samples.rows = rows;
+    slc.samples.cols = cols;
+    slc.samples.format = format;
+    return slc;
+}
+
+std::vector<float> run(const SlcSamples& samples, const MultilookOptions& options) {
+    std::vector<float> out(static_cast<size_t>((samples.rows / qMax(1, options.azimuthLooks))
+                                               * (samples.cols / qMax(1, options.rangeLooks))), -1.0f);
+    multilookMagnitude(samples, options, out.data());
+    return out;
+}
+
+// 逐点按定义计算，双精度累加
+std::vector<double> reference(const SlcSamples& samples, const MultilookOptions& options) {
+    const qint64 outRows = samples.rows / options.azimuthLooks;
+    const qint64 outCols = samples.cols / options.rangeLooks;
+    std::vector<double> out(static_cast<size_t>(outRows * outCols));
+    for (qint64 r = 0; r < outRows; ++r) {
+        for (qint64 c = 0; c < outCols; ++c) {
+            double sum = 0.0;
+            for (int a = 0; a < options.azimuthLooks; ++a) {
+                const uchar* row = samples.data + (r * options.azimuthLooks + a) * samples.rowStride;
+                for (int k = 0; k < options.rangeLooks; ++k) {
+                    const qint64 col = c * options.rangeLooks + k;
+                    double re;
+                    double im;
+                    if (samples.format == SlcSampleFormat::ComplexInt16) {
+                        re = reinterpret_cast<const qint16*>(row)[2 * col];
+                        im = reinterpret_cast<const qint16*>(row)[2 * col + 1];
+                    } else {
+                        re = reinterpret_cast<const float*>(row)[2 * col];
+                        im = reinterpret_cast<const float*>(row)[2 * col + 1];
+                    }
+                    const double p = re * re + im * im;
+                    sum += options.power ? p : std::sqrt(p);
+                }
+            }
+            out[size_t(r * outCols + c)] = sum / (options.rangeLooks * options.azimuthLooks);
+        }
+    }
+    return out;
+}
+
+bool close(double actual, double expected, double relative) {
+    return std::fabs(actual - expected) <= relative * qMax(1.0, std::fabs(expected));
+}
+
+void addShapes() {
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("cols");
+    QTest::addColumn<int>("rangeLooks");
+    QTest::addColumn<int>("azimuthLooks");
+    QTest::addColumn<int>("format");
+    QTest::addColumn<bool>("power");
+
+    struct Shape { int rows, cols, rangeLooks, azimuthLooks; };
+    const Shape shapes[] = {
+        { 1, 1, 1, 1 },         // 只有尾部
+        { 3, 7, 1, 1 },         // 不足一个向量
+        { 9, 8, 1, 1 },         // 恰好一个向量
+        { 5, 9, 2, 1 },         // 一个向量 + 尾部，最后一列丢弃
+        { 11, 16, 8, 1 },
+        { 17, 33, 3, 2 },       // 多行分块，行、列都有丢弃
+        { 13, 61, 4, 3 },
+        { 7, 23, 5, 2 },
+        { 20, 100, 1, 4 },
+    };
+    for (const Shape& shape : shapes) {
+        for (const SlcSampleFormat format : { SlcSampleFormat::ComplexFloat32, SlcSampleFormat::ComplexInt16 }) {
+            for (const bool power : { false, true }) {
+                const QByteArray name = QString("%1x%2 %3x%4 %5 %6")
+                    .arg(shape.rows).arg(shape.cols).arg(shape.rangeLooks).arg(shape.azimuthLooks)
+                    .arg(format == SlcSampleFormat::ComplexInt16 ? "ci16" : "cf32")
+                    .arg(power ? "power" : "amplitude").toUtf8();
+                QTest::newRow(name.constData()) << shape.rows << shape.cols << shape.rangeLooks << shape.azimuthLooks
+                                                << int(format) << power;
+            }
+        }
+    }
+}
+
+} // namespace
+
+class SlcMultilookTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void scalarMatchesDefinition_data() { addShapes(); }
+    void scalarMatchesDefinition() {
+        QFETCH(int, rows);
+        QFETCH(int, cols);
+        QFETCH(int, rangeLooks);
+        QFETCH(int, azimuthLooks);
+        QFETCH(int, format);
+        QFETCH(bool, power);
+
+        const SyntheticSlc slc = makeSlc(rows, cols, SlcSampleFormat(format), 7);
+        MultilookOptions options;
+        options.rangeLooks = rangeLooks;
+        options.azimuthLooks = azimuthLooks;
+        options.power = power;
+        options.simd = SimdLevel::Scalar;
+        const std::vector<float> actual = run(slc.samples, options);
+        const std::vector<double> expected = reference(slc.samples, options);
+        QCOMPARE(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+            QVERIFY2(close(actual[i], expected[i], 1e-5),
+                     qPrintable(QString("%1: %2, expected %3").arg(i).arg(actual[i]).arg(expected[i])));
+        }
+    }
+
+    void avx2MatchesScalar_data() { addShapes(); }
+    void avx2MatchesScalar() {
+        if (!cpuHasAvx2()) {
+            QSKIP("CPU does not support AVX2 + FMA");
+        }
+        QFETCH(int, rows);
+        QFETCH(int, cols);
+        QFETCH(int, rangeLooks);
+        QFETCH(int, azimuthLooks);
+        QFETCH(int, format);
+        QFETCH(bool, power);
+
+        const SyntheticSlc slc = makeSlc(rows, cols, SlcSampleFormat(format), 11);
+        MultilookOptions options;
+        options.rangeLooks = rangeLooks;
+        options.azimuthLooks = azimuthLooks;
+        options.power = power;
+        options.simd = SimdLevel::Scalar;
+        const std::vector<float> scalar = run(slc.samples, options);
+        options.simd = SimdLevel::Avx2;
+        const std::vector<float> avx2 = run(slc.samples, options);
+        QCOMPARE(avx2.size(), scalar.size());
+        for (size_t i = 0; i < avx2.size(); ++i) {
+            QVERIFY2(close(avx2[i], scalar[i], 1e-6),
+                     qPrintable(QString("%1: %2, scalar %3").arg(i).arg(avx2[i]).arg(scalar[i])));
+        }
+    }
+
+    void poolMatchesSingleThread() {
+        const SyntheticSlc slc = makeSlc(203, 70, SlcSampleFormat::ComplexFloat32, 3);
+        MultilookOptions options;
+        options.rangeLooks = 2;
+        options.azimuthLooks = 1;
+        const std::vector<float> single = run(slc.samples, options);
+
+        WorkerPool pool(3);
+        options.pool = &pool;
+        QCOMPARE(run(slc.samples, options), single);
+        options.threads = 2;
+        QCOMPARE(run(slc.samples, options), single);
+    }
+
+    void callableFromPoolTask() {
+        // 线程池的全部线程都在调用多视：各自只等待已领走的分块，不依赖空闲线程
+        const SyntheticSlc slc = makeSlc(160, 40, SlcSampleFormat::ComplexInt16, 5);
+        MultilookOptions options;
+        const std::vector<float> single = run(slc.samples, options);
+
+        WorkerPool pool(2);
+        options.pool = &pool;
+        QSemaphore finished;
+        std::vector<std::vector<float>> results(2);
+        for (std::vector<float>& result : results) {
+            pool.submit([&slc, &options, &result, &finished]() {
+                result = run(slc.samples, options);
+                finished.release();
+            });
+        }
+        QVERIFY(finished.tryAcquire(2, 10000));
+        for (const std::vector<float>& result : results) {
+            QCOMPARE(result, single);
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(SlcMultilookTest)
+#include "slc_multilook_test.moc"
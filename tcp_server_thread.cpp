@@ -1,8 +1,12 @@
 #include "tcp_server_thread.h"
+#include "log_categories.h"
 #include "radar_protocol.h"
 #include <QDebug>
 #include <QHostAddress>
 #include <QtEndian>
+#ifdef Q_OS_LINUX
+#include "epoll_command_server.h"
+#endif
 
 TcpServerThread::TcpServerThread(QObject *parent)
     : QObject(parent), m_tcpServer(new QTcpServer(this))
@@ -15,10 +19,37 @@ TcpServerThread::~TcpServerThread()
 {
     // 析构时关闭服务器
     m_tcpServer->close();
+#ifdef Q_OS_LINUX
+    m_epollServer.reset();
+#endif
+}
+
+void TcpServerThread::setConfig(const CommandServerConfig& config)
+{
+    m_config = config;
 }
 
 void TcpServerThread::startServer(const QString& ipAddress, quint16 port)
 {
+#ifdef Q_OS_LINUX
+    if (m_config.useEpoll) {
+        // 回调在 I/O 线程中执行：只转发指令，不逐帧打印日志
+        m_epollServer.reset(new EpollCommandServer([this](quint64, const CommandFrame& frame) {
+            dispatchCommand(frame);
+        }));
+        m_epollServer->setMaxConnections(m_config.maxConnections);
+        std::string error;
+        if (!m_epollServer->start(ipAddress.toStdString(), port, m_config.ioThreads, &error)) {
+            qCDebug(lcCommand) << tr("服务器无法启动！错误：%1。").arg(QString::fromStdString(error));
+            m_epollServer.reset();
+            return;
+        }
+        qCDebug(lcCommand) << tr("TCP服务器（epoll，%1 个 I/O 线程）已成功启动。正在监听 %2:%3。")
+                        .arg(m_config.ioThreads).arg(ipAddress).arg(port);
+        emit serverStarted();
+        return;
+    }
+#endif
     if (!m_tcpServer->listen(QHostAddress(ipAddress), port)) {
         qDebug() << tr("服务器无法启动！错误：%1。").arg(m_tcpServer->errorString());
     } else {
@@ -30,6 +61,16 @@ void TcpServerThread::startServer(const QString& ipAddress, quint16 port)
 
 void TcpServerThread::stopServer()
 {
+#ifdef Q_OS_LINUX
+    if (m_epollServer) {
+        const EpollCommandServer::Stats stats = m_epollServer->stats();
+        m_epollServer.reset();
+        qCDebug(lcCommand) << "TCP服务器已停止。共接受" << stats.acceptedConnections << "个连接，解析"
+                 << stats.frames << "帧，失步丢弃" << stats.discardedBytes << "字节。";
+        emit serverStopped();
+        return;
+    }
+#endif
     if (m_tcpServer->isListening()) {
         m_tcpServer->close();
         qDebug() << "TCP服务器已停止。";
@@ -40,83 +81,117 @@ void TcpServerThread::stopServer()
 
 void TcpServerThread::onNewConnection()
 {
-    // 获取新的连接
-    QTcpSocket* socket = m_tcpServer->nextPendingConnection();
-    qDebug() << tr("来自 %1:%2 的新连接。").arg(socket->peerAddress().toString()).arg(socket->peerPort());
-
-    // 连接新套接字的信号
-    connect(socket, &QTcpSocket::readyRead, this, &TcpServerThread::onSocketReadyRead);
-    connect(socket, &QTcpSocket::disconnected, this, &TcpServerThread::onSocketDisconnected);
-    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::errorOccurred), this, &TcpServerThread::onSocketError);
+    // 一次取完所有待接受的连接
+    while (QTcpSocket* socket = m_tcpServer->nextPendingConnection()) {
+        qCDebug(lcCommand) << tr("来自 %1:%2 的新连接。").arg(socket->peerAddress().toString()).arg(socket->peerPort());
+
+        // 先建立该连接的解析器，再连接信号
+        m_parsers.insert(socket, std::make_shared<CommandFrameParser>());
+        connect(socket, &QTcpSocket::readyRead, this, &TcpServerThread::onSocketReadyRead);
+        connect(socket, &QTcpSocket::disconnected, this, &TcpServerThread::onSocketDisconnected);
+        connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::errorOccurred), this, &TcpServerThread::onSocketError);
+    }
 }
 
 void TcpServerThread::onSocketReadyRead()
 {
     QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
-    if (socket) {
-        m_buffer.append(socket->readAll());
-        const quint8 HEADER_TOTAL_SIZE = 21;
-
-        while (m_buffer.size() >= HEADER_TOTAL_SIZE) {
-            const DataHeader* header = reinterpret_cast<const DataHeader*>(m_buffer.constData());
-            if (qFromLittleEndian(header->fixed_value) != 0x9EE9) {
-                qDebug() << "无效的数据帧头，可能已失步，清空缓冲区。";
-                m_buffer.clear();
-                return;
-            }
-
-            quint16 dataLength = qFromLittleEndian(header->data_length);
-            quint8 checksum = header->checksum;
-
-            if (m_buffer.size() < HEADER_TOTAL_SIZE + dataLength) {
-                return;
-            }
-
-            QByteArray dataInfoPayload = m_buffer.mid(HEADER_TOTAL_SIZE, dataLength);
-            quint8 calculatedChecksum = calculateChecksum(dataInfoPayload);
-
-            if (calculatedChecksum != checksum) {
-                qDebug() << "校验和不匹配！期望:" << checksum << "计算:" << calculatedChecksum;
-                m_buffer.remove(0, HEADER_TOTAL_SIZE + dataLength);
-                continue;
-            }
-
-            const DataInfo* dataInfo = reinterpret_cast<const DataInfo*>(dataInfoPayload.constData());
-            if (qFromLittleEndian(dataInfo->frame_header) != 0x55AA) {
-                qDebug() << "无效的数据信息帧头，数据可能损坏。";
-                m_buffer.remove(0, HEADER_TOTAL_SIZE + dataLength);
-                continue;
-            }
-
-            quint16 imageNumber = qFromLittleEndian(dataInfo->image_number);
-            quint16 offsetX = qFromLittleEndian(dataInfo->pixel_offset_x);
-            quint16 offsetY = qFromLittleEndian(dataInfo->pixel_offset_y);
-            quint8 commandType = dataInfo->command_type;
-
-            // 根据指令类型决定下一步操作
-            if (commandType == 0x01) { // 假设0x01是ISAR成像请求的指令类型
-                // 发出信号，通知主线程处理ISAR请求
-                emit receivedIsarRequest(imageNumber, offsetX, offsetY);
-                qDebug() << "收到ISAR成像请求，正在生成XML文件...";
-            } else {
-                // 处理其他类型的命令，例如您已有的receivedImageData
-                // emit receivedImageData(imageNumber, offsetX, offsetY);
-            }
-
-            qDebug() << "收到完整数据包，大小:" << HEADER_TOTAL_SIZE + dataLength;
-            qDebug() << "  - 图像编号:" << imageNumber;
-                       qDebug() << "  - 像素偏移 X:" << offsetX;
-                       qDebug() << "  - 像素偏移 Y:" << offsetY;
-                       qDebug() << "  - 指令类型:" << QString::number(commandType, 16);
-                        m_buffer.remove(0, HEADER_TOTAL_SIZE + dataLength);
+    if (!socket) {
+        return;
+    }
+    const std::shared_ptr<CommandFrameParser> parser = m_parsers.value(socket);
+    if (!parser) {
+        return;
+    }
+
+    // 直接读入该连接的环形缓冲；缓冲满时先解析腾出空间再继续读
+    CommandFrame frame;
+    while (socket->bytesAvailable() > 0) {
+        qint64 available = 0;
+        char* dst = parser->writePointer(&available);
+        if (available == 0) {
+            break;
+        }
+        const qint64 received = socket->read(dst, available);
+        if (received <= 0) {
+            break;
+        }
+        parser->commitWrite(received);
+        while (parser->next(&frame)) {
+            handleFrame(socket, frame);
         }
     }
+
+    const quint64 discarded = parser->takeDiscardedBytes();
+    if (discarded > 0) {
+        qCDebug(lcCommand) << "连接" << socket->peerAddress().toString() << socket->peerPort()
+                 << "数据失步，跳过" << discarded << "字节，拒绝" << parser->takeRejectedFrames() << "个无效帧。";
+    }
+}
+
+void TcpServerThread::handleFrame(QTcpSocket* socket, const CommandFrame& frame)
+{
+    Q_UNUSED(socket)
+    const quint16 imageNumber = frame.info.image_number;
+    const qint16 offsetX = frame.info.pixel_offset_x;
+    const qint16 offsetY = frame.info.pixel_offset_y;
+    const quint8 commandType = frame.info.command_type;
+
+    // 根据指令类型决定下一步操作
+    dispatchCommand(frame);
+    if (commandType == COMMAND_ISAR_REQUEST) {
+        qCDebug(lcCommand) << "收到ISAR成像请求，正在生成XML文件...";
+    } else if (commandType == COMMAND_ROI_CROP) {
+        qCDebug(lcCommand) << "收到ROI裁剪请求，附加数据" << frame.extra.size() << "字节。";
+    } else if (commandType == COMMAND_RETRANSMIT) {
+        qCDebug(lcCommand) << "收到重传请求，附加数据" << frame.extra.size() << "字节。";
+    }
+
+    qCDebug(lcCommand) << "收到完整数据包，大小:" << CommandFrameParser::HEADER_SIZE + frame.info.data_length
+             << "图像编号:" << imageNumber << "像素偏移:" << offsetX << offsetY
+             << "指令类型:" << QString::number(commandType, 16);
 }
+
+void TcpServerThread::dispatchCommand(const CommandFrame& frame)
+{
+    const DataInfo& info = frame.info;
+    switch (info.command_type) {
+    case COMMAND_ISAR_REQUEST:
+        emit receivedIsarRequest(info.image_number, info.pixel_offset_x, info.pixel_offset_y);
+        break;
+    case COMMAND_ROI_CROP: {
+        const RoiCropExtension extension = decodeRoiCropExtension(frame.extra);
+        emit receivedRoiRequest(info.image_number, info.pixel_offset_x, info.pixel_offset_y,
+                                extension.width, extension.height, extension.jpeg_quality);
+        break;
+    }
+    case COMMAND_RETRANSMIT: {
+        QList<quint16> packets;
+        switch (decodeMissingPackets(frame.extra, &packets)) {
+        case MissingPackets::Invalid:
+            qWarning() << "图像" << info.image_number << "的重传请求缺包描述无效，已忽略。";
+            break;
+        case MissingPackets::NoneSelected:
+            qCDebug(lcCommand) << "图像" << info.image_number << "的重传请求未选中任何缺包，无需补发。";
+            break;
+        case MissingPackets::WholeImage:
+        case MissingPackets::Selected:
+            emit receivedRetransmitRequest(info.image_number, packets);
+            break;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
 void TcpServerThread::onSocketDisconnected()
 {
     QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
     if (socket) {
         qDebug() << tr("客户端已断开连接，来自 %1:%2。").arg(socket->peerAddress().toString()).arg(socket->peerPort());
+        m_parsers.remove(socket);
         socket->deleteLater();
     }
 }
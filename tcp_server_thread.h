@@ -4,6 +4,14 @@
 #include <QObject>
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <QHash>
+#include <memory>
+#include "command_frame_parser.h"
+#include "pipeline_config.h"
+
+#ifdef Q_OS_LINUX
+class EpollCommandServer;
+#endif
 
 class TcpServerThread : public QObject
 {
@@ -13,6 +21,9 @@ public:
     explicit TcpServerThread(QObject *parent = nullptr);
     ~TcpServerThread();
 
+    // 在 startServer 之前调用；epoll 后端只在 Linux 上可用，其他平台退回 QTcpServer
+    void setConfig(const CommandServerConfig& config);
+
 public slots:
     void startServer(const QString& ipAddress, quint16 port);
     void stopServer();
@@ -22,6 +33,10 @@ signals:
     void serverStarted();
     void serverStopped();
     void receivedIsarRequest(quint16 image_num, quint16 pixel_x, quint16 pixel_y);
+    // 区域左上角 (x, y) 与尺寸；width/height 为 0 表示请求未附带尺寸，jpegQuality 为 0 表示使用默认质量
+    void receivedRoiRequest(quint16 image_num, qint16 x, qint16 y, quint16 width, quint16 height, quint8 jpegQuality);
+    // 升序的缺失包号（与 SAR_Frame::current_packet 相同），为空表示整图重发
+    void receivedRetransmitRequest(quint16 image_num, const QList<quint16>& packets);
 
 private slots:
     void onNewConnection();
@@ -30,8 +45,17 @@ private slots:
     void onSocketError(QAbstractSocket::SocketError socketError);
 
 private:
+    void handleFrame(QTcpSocket* socket, const CommandFrame& frame);
+    // 按指令类型发出对应信号；只发信号，可在 epoll I/O 线程中调用
+    void dispatchCommand(const CommandFrame& frame);
+
+    CommandServerConfig m_config;
     QTcpServer* m_tcpServer;
-    QByteArray m_buffer; // 新增：用于存储不完整数据包的缓冲区
+#ifdef Q_OS_LINUX
+    std::unique_ptr<EpollCommandServer> m_epollServer;
+#endif
+    // 每个连接独立的帧缓冲与解析状态，多个客户端同时发送互不干扰
+    QHash<QTcpSocket*, std::shared_ptr<CommandFrameParser>> m_parsers;
 };
 
 #endif // TCPSERVERTHREAD_H
@@ -0,0 +1,15 @@
+# 瓦片产品（瓦片数、瓦片编号、日志持久化）的行为测试：qmake tiled-product-test.pro && make check
+# 打包代码依赖较多公共模块，直接引用 aerolink_core.pri；QImage 需要 gui 模块（不创建 QGuiApplication）
+
+TARGET = tiled-product-test
+TEMPLATE = app
+
+QT = core gui network testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+include(aerolink_core.pri)
+
+SOURCES += \
+    tiled_product_test.cpp
@@ -0,0 +1,300 @@
+// tiled_product_test.cpp
+// 瓦片产品：按校正后尺寸计算瓦片数（不超过上限，超出时放大瓦片边长），各瓦片消息带分配的编号与位置，
+// 缓存可按瓦片编号拆分，按接收端方式拼回的整图与原图一致；
+// 瓦片编号记入产品日志，重启与压缩后保留，且编号水位线越过已分配的瓦片编号；
+// 会复用未结束产品编号的一批编号被拒绝
+#include <QtTest>
+#include <QDataStream>
+#include <QTemporaryDir>
+#include <cstring>
+#include "package_sar_data.h"
+#include "product_cache.h"
+#include "product_journal.h"
+
+namespace {
+
+// 按 AuxFileReader::read 的字段顺序写一个最小的 AUX 文件，其后附带足够长度的运动数据
+bool writeAux(const QString& path, qint64 rows, qint64 cols, double xbin, double rbin) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << qint64(0) << qint64(0) << qint64(1);                         // op_mode pp_mode Kr_sign
+    for (int i = 0; i < 8; ++i) {                                       // fc .. PRF
+        out << 0.0;
+    }
+    out << rows << cols << qint64(8);                                   // pulse_num pulse_len amp_bit
+    out << xbin << rbin;
+    out << qint64(2) << qint64(0) << qint64(0);                         // geo_mode look_mode flag_flat
+    for (int i = 0; i < 27; ++i) {                                      // fdc_ref .. lng_e
+        out << 0.0;
+    }
+    out << 30.0 << 120.0 << 30.0 << 120.1 << 29.9 << 120.0 << 29.9 << 120.1;   // 四角经纬度
+    out << 0.0 << qint64(1);                                            // IMG_TH az_MLK_num
+    for (qint64 i = 0; i < rows * 7 + 10; ++i) {
+        out << 0.0;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+QImage gradientImage(int width, int height) {
+    QImage image(width, height, QImage::Format_Grayscale8);
+    for (int y = 0; y < height; ++y) {
+        uchar* line = image.scanLine(y);
+        for (int x = 0; x < width; ++x) {
+            line[x] = uchar((x + 2 * y) * 255 / (width + 2 * height));
+        }
+    }
+    return image;
+}
+
+struct PackedMessage {
+    quint16 imageNumber = 0;
+    SAR_DataInfo dataInfo;
+};
+
+// 按接收端的方式把 bin 拆成消息：包序号回到 1 即为新消息，SAR_DataInfo 位于首帧载荷开头
+QList<PackedMessage> readMessages(const QString& binPath) {
+    QList<PackedMessage> messages;
+    QFile file(binPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return messages;
+    }
+    const QByteArray frames = file.readAll();
+    qint64 offset = 0;
+    while (offset + qint64(sizeof(SAR_Frame)) <= frames.size()) {
+        const SAR_Frame* header = reinterpret_cast<const SAR_Frame*>(frames.constData() + offset);
+        if (header->current_packet == 1 && header->data_length >= sizeof(SAR_DataInfo)) {
+            PackedMessage message;
+            message.imageNumber = header->image_number;
+            memcpy(&message.dataInfo, frames.constData() + offset + sizeof(SAR_Frame), sizeof(SAR_DataInfo));
+            messages.append(message);
+        }
+        offset += qint64(sizeof(SAR_Frame)) + header->data_length;
+    }
+    return messages;
+}
+
+TileSettings tiling(int tileSize, int minSide) {
+    TileSettings settings;
+    settings.enabled = true;
+    settings.tileSize = tileSize;
+    settings.minSide = minSide;
+    return settings;
+}
+
+} // namespace
+
+class TiledProductTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+        m_imagePath = m_dir.filePath("scene.png");
+        QVERIFY(gradientImage(300, 200).save(m_imagePath, "PNG"));
+        m_auxPath = m_dir.filePath("scene.aux");
+        QVERIFY(writeAux(m_auxPath, 200, 300, 1.0, 1.0));
+    }
+
+    void tileCountFollowsCorrectedSize_data() {
+        QTest::addColumn<double>("xbin");
+        QTest::addColumn<bool>("enabled");
+        QTest::addColumn<int>("tileSize");
+        QTest::addColumn<int>("minSide");
+        QTest::addColumn<int>("expected");
+        QTest::newRow("square pixels") << 1.0 << true << 128 << 0 << 3 * 2;
+        // 方位向像素是距离向的两倍，校正后高度为 400
+        QTest::newRow("stretched rows") << 2.0 << true << 128 << 0 << 3 * 4;
+        QTest::newRow("below min side") << 1.0 << true << 128 << 300 << 0;
+        QTest::newRow("disabled") << 1.0 << false << 128 << 0 << 0;
+        // 瓦片边长不小于 64
+        QTest::newRow("tile size clamped") << 1.0 << true << 10 << 0 << 5 * 4;
+    }
+
+    void tileCountFollowsCorrectedSize() {
+        QFETCH(double, xbin);
+        QFETCH(bool, enabled);
+        QFETCH(int, tileSize);
+        QFETCH(int, minSide);
+        QFETCH(int, expected);
+        const QString auxPath = m_dir.filePath(QString("count_%1.aux").arg(QTest::currentDataTag()));
+        QVERIFY(writeAux(auxPath, 200, 300, xbin, 1.0));
+        TileSettings settings = tiling(tileSize, minSide);
+        settings.enabled = enabled;
+        QCOMPARE(tiledProductTileCount(m_imagePath, auxPath, settings), expected);
+    }
+
+    void tilesCarryAssignedNumbers() {
+        const TileSettings settings = tiling(128, 0);
+        QCOMPARE(tiledProductTileCount(m_imagePath, m_auxPath, settings), 6);
+        // 编号由流水线逐个分配，可能跨过 65535 回绕
+        const QList<uint16_t> tileNumbers = {65534, 65535, 0, 1, 7, 9};
+        const QString binPath = m_dir.filePath("tiled.bin");
+        QVERIFY(createTiledBinFile(m_imagePath, m_auxPath, settings, 4321, tileNumbers, binPath));
+
+        const QList<PackedMessage> messages = readMessages(binPath);
+        QCOMPARE(messages.size(), tileNumbers.size());
+        for (int i = 0; i < messages.size(); ++i) {
+            const PackedMessage& message = messages.at(i);
+            QCOMPARE(message.imageNumber, tileNumbers.at(i));
+            QCOMPARE(message.dataInfo.message_type, TILE_MESSAGE_TYPE);
+            TileInfo tileInfo;
+            memcpy(&tileInfo, message.dataInfo.reserved2, sizeof(TileInfo));
+            QCOMPARE(tileInfo.parent_image_number, uint16_t(4321));
+            QCOMPARE(tileInfo.tile_index, uint16_t(i));
+            QCOMPARE(tileInfo.tile_count, uint16_t(6));
+            QCOMPARE(tileInfo.x, uint16_t((i % 3) * 128));
+            QCOMPARE(tileInfo.y, uint16_t((i / 3) * 128));
+            QCOMPARE(tileInfo.full_cols, uint16_t(300));
+            QCOMPARE(tileInfo.full_rows, uint16_t(200));
+        }
+
+        // 缓存按瓦片编号拆分，重发时可按瓦片取回
+        QFile file(binPath);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QList<QPair<quint16, QByteArray>> split = ProductCache::splitMessages(file.readAll());
+        QCOMPARE(split.size(), tileNumbers.size());
+        for (int i = 0; i < split.size(); ++i) {
+            QCOMPARE(split.at(i).first, tileNumbers.at(i));
+        }
+
+        // 按接收端方式拼回的整图与原图一致（JPEG 有损，只比较平均误差）
+        const QImage decoded = decodePackedSarImage(binPath);
+        QCOMPARE(decoded.size(), QSize(300, 200));
+        const QImage original = gradientImage(300, 200);
+        qint64 error = 0;
+        for (int y = 0; y < 200; ++y) {
+            for (int x = 0; x < 300; ++x) {
+                error += qAbs(int(decoded.constScanLine(y)[x]) - int(original.constScanLine(y)[x]));
+            }
+        }
+        QVERIFY2(error / (300 * 200) < 8, qPrintable(QString("mean error %1").arg(double(error) / (300 * 200))));
+    }
+
+    void tileCountCappedByMaxTiles() {
+        TileSettings settings = tiling(64, 0);
+        settings.maxTiles = 4;
+        int tileSize = 0;
+        // 64 边长需要 5 × 4 个瓦片，放大到 150 后为 2 × 2
+        QCOMPARE(tiledProductTileCount(m_imagePath, m_auxPath, settings, &tileSize), 4);
+        QCOMPARE(tileSize, 150);
+
+        const QString binPath = m_dir.filePath("capped.bin");
+        QVERIFY(createTiledBinFile(m_imagePath, m_auxPath, settings, 77, QList<uint16_t>({10, 11, 12, 13}), binPath));
+        const QList<PackedMessage> messages = readMessages(binPath);
+        QCOMPARE(messages.size(), 4);
+        for (int i = 0; i < messages.size(); ++i) {
+            TileInfo tileInfo;
+            memcpy(&tileInfo, messages.at(i).dataInfo.reserved2, sizeof(TileInfo));
+            QCOMPARE(tileInfo.tile_count, uint16_t(4));
+            QCOMPARE(tileInfo.x, uint16_t((i % 2) * 150));
+            QCOMPARE(tileInfo.y, uint16_t((i / 2) * 150));
+        }
+        QCOMPARE(decodePackedSarImage(binPath).size(), QSize(300, 200));
+
+        // 上限足够时保持配置的边长
+        settings.maxTiles = 20;
+        QCOMPARE(tiledProductTileCount(m_imagePath, m_auxPath, settings, &tileSize), 5 * 4);
+        QCOMPARE(tileSize, 64);
+    }
+
+    void rejectsWrongNumberOfTileNumbers() {
+        const QString binPath = m_dir.filePath("short.bin");
+        QVERIFY(!createTiledBinFile(m_imagePath, m_auxPath, tiling(128, 0), 1, QList<uint16_t>({2, 3, 4}), binPath));
+    }
+
+    void journalKeepsTileNumbersAcrossRestart() {
+        const QString journalPath = m_dir.filePath("journal/product_journal.log");
+        ProductJournal::TiledProduct product;
+        product.filePath = m_imagePath;
+        product.tileSize = 128;
+        quint16 parent = 0;
+        quint16 lastTile = 0;
+        {
+            ProductJournal journal;
+            QVERIFY(journal.open(journalPath));
+            // 与流水线相同：整图编号与各瓦片编号都从日志分配
+            parent = journal.allocateImageNumber();
+            product.tileNumbers = journal.allocateImageNumbers(3);
+            QCOMPARE(product.tileNumbers.size(), 3);
+            QVERIFY(journal.recordTiledProduct(parent, product));
+            ProductJournal::TiledProduct other = product;
+            const quint16 otherParent = journal.allocateImageNumber();
+            other.tileNumbers = journal.allocateImageNumbers(2);
+            lastTile = other.tileNumbers.last();
+            QVERIFY(journal.recordTiledProduct(otherParent, other));
+            // 编号被复用后去掉记录
+            QVERIFY(journal.recordTiledProduct(otherParent, ProductJournal::TiledProduct()));
+        }
+        {
+            ProductJournal journal;
+            QVERIFY(journal.open(journalPath));
+            const QMap<quint16, ProductJournal::TiledProduct> tiled = journal.tiledProducts();
+            QCOMPARE(tiled.size(), 1);
+            QCOMPARE(tiled.value(parent).tileNumbers, product.tileNumbers);
+            QCOMPARE(tiled.value(parent).tileSize, 128);
+            QCOMPARE(tiled.value(parent).filePath, m_imagePath);
+            // 新日志从小编号开始分配，不会回绕：重启后的下一个编号大于所有已分配的瓦片编号
+            QVERIFY(journal.nextImageNumber() > lastTile);
+            // 压缩后同样保留
+            QVERIFY(journal.compact());
+        }
+        ProductJournal journal;
+        QVERIFY(journal.open(journalPath));
+        QCOMPARE(journal.tiledProducts().value(parent).tileNumbers, product.tileNumbers);
+        QVERIFY(journal.nextImageNumber() > lastTile);
+        QCOMPARE(journal.allocateImageNumber(), quint16(lastTile + 1));
+    }
+
+    void journalRejectsBatchOverLiveNumbers() {
+        ProductJournal journal;
+        QVERIFY(journal.open(m_dir.filePath("live/product_journal.log")));
+        const quint16 next = journal.nextImageNumber();
+
+        // 编号回绕后，水位线前方仍有未结束的产品（整图编号 next + 5，瓦片编号 next + 20、next + 21）
+        ProductJob job;
+        job.key = m_dir.filePath("live/_001");
+        job.imagePath = m_imagePath;
+        job.auxPath = m_auxPath;
+        const quint16 parent = quint16(next + 5);
+        QVERIFY(journal.record(job, ProductState::Packed, parent));
+        ProductJournal::TiledProduct product;
+        product.filePath = m_imagePath;
+        product.tileSize = 128;
+        product.tileNumbers = {quint16(next + 20), quint16(next + 21)};
+        QVERIFY(journal.recordTiledProduct(parent, product));
+
+        QVERIFY(journal.allocateImageNumbers(10).isEmpty());
+        QCOMPARE(journal.nextImageNumber(), next);
+        QVERIFY(journal.allocateImageNumbers(0).isEmpty());
+        QVERIFY(journal.allocateImageNumbers(ProductJournal::MAX_BATCH + 1).isEmpty());
+        QCOMPARE(journal.nextImageNumber(), next);
+
+        // 不覆盖未结束编号的批次照常分配
+        const QList<quint16> batch = journal.allocateImageNumbers(5);
+        QCOMPARE(batch.size(), 5);
+        QCOMPARE(batch.first(), next);
+        QCOMPARE(journal.nextImageNumber(), parent);
+        QCOMPARE(journal.allocateImageNumbers(1), QList<quint16>());
+
+        // 越过整图编号后，批次仍不能落到它的瓦片编号上
+        QCOMPARE(journal.allocateImageNumber(), parent);
+        QVERIFY(journal.allocateImageNumbers(15).isEmpty());
+        QCOMPARE(journal.allocateImageNumbers(14).size(), 14);
+
+        // 产品结束后其编号可以复用
+        QVERIFY(journal.record(job, ProductState::Acked, parent));
+        QCOMPARE(journal.allocateImageNumbers(2), QList<quint16>({quint16(next + 20), quint16(next + 21)}));
+    }
+
+private:
+    QTemporaryDir m_dir;
+    QString m_imagePath;
+    QString m_auxPath;
+};
+
+QTEST_GUILESS_MAIN(TiledProductTest)
+#include "tiled_product_test.moc"
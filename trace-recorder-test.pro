@@ -0,0 +1,19 @@
+# 流水线跟踪的会话与导出测试：qmake trace-recorder-test.pro && make check
+# 导出结果用 QJsonDocument 解析后检查，只依赖 QtCore 与 QtTest
+
+TARGET = trace-recorder-test
+TEMPLATE = app
+
+QT = core testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    log_categories.cpp \
+    trace_recorder.cpp \
+    trace_recorder_test.cpp
+
+HEADERS += \
+    log_categories.h \
+    trace_recorder.h
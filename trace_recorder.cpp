@@ -0,0 +1,193 @@
+#include "trace_recorder.h"
+#include "log_categories.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+#include <chrono>
+
+std::atomic<bool> TraceRecorder::s_enabled{false};
+
+static thread_local void* t_buffer = nullptr;
+
+TraceRecorder& TraceRecorder::instance() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+bool TraceRecorder::isEnabled() {
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+qint64 TraceRecorder::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TraceRecorder::recordComplete(const char* name, qint64 startUs, qint64 durationUs, int imageNumber) {
+    if (!isEnabled()) {
+        return;
+    }
+    instance().append(Event{name, startUs, qMax<qint64>(0, durationUs), imageNumber});
+}
+
+void TraceRecorder::setBufferCapacity(int events) {
+    QMutexLocker locker(&m_mutex);
+    m_capacity = qMax(1024, events);
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::registerThread() {
+    QMutexLocker locker(&m_mutex);
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->tid = int(m_buffers.size()) + 1;
+    buffer->capacity = m_capacity;
+    buffer->events.reset(new Event[m_capacity]);
+    QCoreApplication* app = QCoreApplication::instance();
+    if (app && app->thread() == QThread::currentThread()) {
+        buffer->threadName = "main";
+    } else {
+        buffer->threadName = QThread::currentThread()->objectName().toUtf8();
+    }
+    if (buffer->threadName.isEmpty()) {
+        buffer->threadName = "thread-" + QByteArray::number(buffer->tid);
+    }
+    // 缓冲随记录器存活到进程结束，线程退出后其事件仍可导出
+    ThreadBuffer* raw = buffer.get();
+    m_buffers.push_back(std::move(buffer));
+    return raw;
+}
+
+void TraceRecorder::append(const Event& event) {
+    ThreadBuffer* buffer = static_cast<ThreadBuffer*>(t_buffer);
+    if (!buffer) {
+        buffer = registerThread();
+        t_buffer = buffer;
+    }
+    // 新会话开始后由本线程自己清空缓冲，读取方据 generation 跳过尚未清空的旧缓冲
+    const quint64 generation = m_generation.load(std::memory_order_acquire);
+    if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->generation.store(generation, std::memory_order_release);
+    }
+    const int index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= buffer->capacity) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[index] = event;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::start() {
+    QMutexLocker locker(&m_mutex);
+    if (s_enabled.load()) {
+        return;
+    }
+    m_generation.fetch_add(1, std::memory_order_acq_rel);
+    m_dropped.store(0);
+    m_sessionStartUs.store(nowUs());
+    s_enabled.store(true);
+    qCInfo(lcMetrics) << "Pipeline tracing started.";
+}
+
+bool TraceRecorder::isRecording() const {
+    return isEnabled();
+}
+
+QString TraceRecorder::timestampedPath(const QString& dir) {
+    return QDir(dir).filePath(QString("aerolink-trace-%1.json")
+                              .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+}
+
+static QByteArray jsonEscaped(const QByteArray& text) {
+    QByteArray out;
+    out.reserve(text.size());
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (uchar(c) >= 0x20) {
+            out += c;
+        }
+    }
+    return out;
+}
+
+bool TraceRecorder::stop(const QString& path) {
+    QMutexLocker locker(&m_mutex);
+    if (!s_enabled.exchange(false)) {
+        return false;
+    }
+    const quint64 generation = m_generation.load();
+    const qint64 sessionStartUs = m_sessionStartUs.load();
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to write trace file" << path << ":" << file.errorString();
+        return false;
+    }
+
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pid
+           + ",\"tid\":0,\"args\":{\"name\":\"" + jsonEscaped(QCoreApplication::applicationName().toUtf8()) + "\"}}";
+    qint64 eventCount = 0;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : m_buffers) {
+        if (buffer->generation.load(std::memory_order_acquire) != generation) {
+            continue;
+        }
+        const QByteArray tid = QByteArray::number(buffer->tid);
+        out += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+               + ",\"args\":{\"name\":\"" + jsonEscaped(buffer->threadName) + "\"}}";
+        // 停止后仍在途的写入只会落在 count 之后，不影响这里读取的部分
+        const int count = buffer->count.load(std::memory_order_acquire);
+        for (int i = 0; i < count; ++i) {
+            const Event& event = buffer->events[i];
+            if (event.startUs < sessionStartUs) {
+                continue;
+            }
+            out += ",\n{\"name\":\"" + QByteArray(event.name) + "\",\"cat\":\"aerolink\",\"ph\":\"X\",\"pid\":" + pid
+                   + ",\"tid\":" + tid
+                   + ",\"ts\":" + QByteArray::number(event.startUs - sessionStartUs)
+                   + ",\"dur\":" + QByteArray::number(event.durationUs);
+            if (event.imageNumber >= 0) {
+                out += ",\"args\":{\"image\":" + QByteArray::number(event.imageNumber) + "}";
+            }
+            out += '}';
+            ++eventCount;
+        }
+        if (out.size() > (1 << 20)) {
+            file.write(out);
+            out.clear();
+        }
+    }
+    out += "\n]}\n";
+    file.write(out);
+    file.close();
+
+    const quint64 dropped = m_dropped.load();
+    qCInfo(lcMetrics) << "Pipeline trace written to" << path << ":" << eventCount << "events";
+    if (dropped > 0) {
+        qWarning() << "Trace buffers were full," << dropped << "events dropped.";
+    }
+    return true;
+}
+
+namespace trace {
+
+Span::Span(const char* name, int imageNumber)
+    : m_name(name),
+    m_imageNumber(imageNumber),
+    m_startUs(TraceRecorder::isEnabled() ? TraceRecorder::nowUs() : -1)
+{
+}
+
+Span::~Span() {
+    if (m_startUs >= 0) {
+        TraceRecorder::recordComplete(m_name, m_startUs, TraceRecorder::nowUs() - m_startUs, m_imageNumber);
+    }
+}
+
+} // namespace trace
@@ -0,0 +1,88 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * @class TraceRecorder
+ * @brief 可选的流水线跟踪：记录各环节的起止时间，导出为 Chrome trace-event JSON（可直接用 Perfetto 打开）。
+ *
+ * 每个线程第一次记录时分配自己的定长缓冲，此后只有该线程写入，追加一条事件就是一次普通写加一次
+ * release 存储，不加锁；缓冲写满后丢弃并计数。停止记录时由调用线程读取各缓冲中已发布的事件并写文件。
+ * 未开启时 recordComplete() 只有一次原子读。
+ */
+class TraceRecorder {
+public:
+    static TraceRecorder& instance();
+
+    static bool isEnabled();
+    // 单调时钟，微秒
+    static qint64 nowUs();
+    // 记录一个已结束的区间；name 必须是静态字符串，imageNumber 为 -1 时不带图片编号
+    static void recordComplete(const char* name, qint64 startUs, qint64 durationUs, int imageNumber = -1);
+
+    // 每个线程缓冲可容纳的事件数，只影响之后才开始记录的线程
+    void setBufferCapacity(int events);
+    void start();
+    // 停止记录并写出本次会话的全部事件
+    bool stop(const QString& path);
+    bool isRecording() const;
+    // 形如 dir/aerolink-trace-20250101-120000.json
+    static QString timestampedPath(const QString& dir);
+
+private:
+    struct Event {
+        const char* name;
+        qint64 startUs;
+        qint64 durationUs;
+        int imageNumber;
+    };
+
+    struct ThreadBuffer {
+        int tid = 0;
+        QByteArray threadName;
+        std::unique_ptr<Event[]> events;
+        int capacity = 0;
+        std::atomic<int> count{0};
+        std::atomic<quint64> generation{0};
+    };
+
+    TraceRecorder() = default;
+    void append(const Event& event);
+    ThreadBuffer* registerThread();
+
+    static std::atomic<bool> s_enabled;
+
+    mutable QMutex m_mutex;  // 保护缓冲列表与 start/stop
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::atomic<quint64> m_generation{1};
+    std::atomic<qint64> m_sessionStartUs{0};
+    std::atomic<quint64> m_dropped{0};
+    int m_capacity = 65536;
+};
+
+namespace trace {
+
+// 作用域区间：构造时计时，析构时记录
+class Span {
+public:
+    explicit Span(const char* name, int imageNumber = -1);
+    ~Span();
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* m_name;
+    int m_imageNumber;
+    qint64 m_startUs;
+};
+
+} // namespace trace
+
+#endif // TRACE_RECORDER_H
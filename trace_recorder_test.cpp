@@ -0,0 +1,139 @@
+// trace_recorder_test.cpp
+// TraceRecorder：未开启时不记录；一次会话导出各线程的区间（带线程名与图片编号，时间相对会话起点）；
+// 新会话开始后只导出本次会话的事件，上次会话的线程不再出现；线程缓冲写满后丢弃多出的事件。
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QThread>
+#include <functional>
+#include "trace_recorder.h"
+
+namespace {
+
+// 在名为 name 的新线程中执行 body 并等待结束
+void runInThread(const QString& name, std::function<void()> body) {
+    QThread* thread = QThread::create(std::move(body));
+    thread->setObjectName(name);
+    thread->start();
+    thread->wait();
+    delete thread;
+}
+
+} // namespace
+
+class TraceRecorderTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init() {
+        QVERIFY(m_dir.isValid());
+    }
+
+    void recordsNothingWhenStopped() {
+        TraceRecorder& recorder = TraceRecorder::instance();
+        QVERIFY(!recorder.isRecording());
+        QVERIFY(!recorder.stop(m_dir.filePath("never.json")));
+        QVERIFY(!QFile::exists(m_dir.filePath("never.json")));
+
+        { trace::Span span("before_start"); }
+        recorder.start();
+        { trace::Span span("during"); }
+        QVERIFY(recorder.stop(m_dir.filePath("session.json")));
+        QCOMPARE(spanNames(m_dir.filePath("session.json")), QStringList{"during"});
+    }
+
+    void exportsSpansPerThread() {
+        TraceRecorder& recorder = TraceRecorder::instance();
+        recorder.start();
+        QVERIFY(recorder.isRecording());
+        { trace::Span span("pack", 7); }
+        runInThread("io", [] {
+            trace::Span span("send", 7);
+        });
+        const QString path = m_dir.filePath("threads.json");
+        QVERIFY(recorder.stop(path));
+        QVERIFY(!recorder.isRecording());
+
+        const QJsonArray events = loadEvents(path);
+        QHash<int, QString> threadNames;
+        QHash<QString, QJsonObject> spans;
+        for (const QJsonValue& value : events) {
+            const QJsonObject event = value.toObject();
+            if (event.value("ph").toString() == "M" && event.value("name").toString() == "thread_name") {
+                threadNames.insert(event.value("tid").toInt(), event.value("args").toObject().value("name").toString());
+            } else if (event.value("ph").toString() == "X") {
+                spans.insert(event.value("name").toString(), event);
+            }
+        }
+        QCOMPARE(spans.size(), 2);
+        QCOMPARE(threadNames.value(spans.value("pack").value("tid").toInt()), QString("main"));
+        QCOMPARE(threadNames.value(spans.value("send").value("tid").toInt()), QString("io"));
+        for (const QJsonObject& span : spans) {
+            QCOMPARE(span.value("args").toObject().value("image").toInt(), 7);
+            QVERIFY(span.value("ts").toDouble() >= 0);
+            QVERIFY(span.value("dur").toDouble() >= 0);
+        }
+    }
+
+    void newSessionExportsOnlyItsOwnEvents() {
+        TraceRecorder& recorder = TraceRecorder::instance();
+        recorder.start();
+        { trace::Span span("first_main"); }
+        runInThread("first-worker", [] {
+            trace::Span span("first_worker");
+        });
+        QVERIFY(recorder.stop(m_dir.filePath("first.json")));
+        QCOMPARE(spanNames(m_dir.filePath("first.json")), QStringList({"first_main", "first_worker"}));
+
+        recorder.start();
+        { trace::Span span("second_main"); }
+        const QString path = m_dir.filePath("second.json");
+        QVERIFY(recorder.stop(path));
+        QCOMPARE(spanNames(path), QStringList{"second_main"});
+        // 上次会话之后没有再记录的线程，缓冲仍属于旧会话，不导出
+        for (const QJsonValue& value : loadEvents(path)) {
+            QVERIFY(value.toObject().value("args").toObject().value("name").toString() != "first-worker");
+        }
+    }
+
+    void dropsEventsBeyondThreadCapacity() {
+        TraceRecorder& recorder = TraceRecorder::instance();
+        recorder.setBufferCapacity(1024);   // 只影响之后第一次记录的线程
+        recorder.start();
+        runInThread("busy", [] {
+            for (int i = 0; i < 1100; ++i) {
+                trace::Span span("tick", i);
+            }
+        });
+        const QString path = m_dir.filePath("full.json");
+        QVERIFY(recorder.stop(path));
+        QCOMPARE(spanNames(path).size(), 1024);
+    }
+
+private:
+    static QJsonArray loadEvents(const QString& path) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return QJsonArray();
+        }
+        return QJsonDocument::fromJson(file.readAll()).object().value("traceEvents").toArray();
+    }
+
+    static QStringList spanNames(const QString& path) {
+        QStringList names;
+        for (const QJsonValue& value : loadEvents(path)) {
+            const QJsonObject event = value.toObject();
+            if (event.value("ph").toString() == "X") {
+                names << event.value("name").toString();
+            }
+        }
+        return names;
+    }
+
+    QTemporaryDir m_dir;
+};
+
+QTEST_GUILESS_MAIN(TraceRecorderTest)
+#include "trace_recorder_test.moc"
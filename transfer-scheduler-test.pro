@@ -0,0 +1,31 @@
+# 链路调度器过载策略（先进先出、最新优先、按等待时间丢弃、每 k 个保留 1 个）的行为测试：qmake transfer-scheduler-test.pro && make check
+# TransferJob 带有关联器的产品信息与分环节耗时记录（记录时会写跟踪区间），调度器引用持久化队列，均一并编译
+
+TARGET = transfer-scheduler-test
+TEMPLATE = app
+
+QT = core testlib
+
+CONFIG += c++20 console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    durable_queue.cpp \
+    hdr_histogram.cpp \
+    log_categories.cpp \
+    product_correlator.cpp \
+    product_journal.cpp \
+    product_timing.cpp \
+    trace_recorder.cpp \
+    transfer_scheduler.cpp \
+    transfer_scheduler_test.cpp
+
+HEADERS += \
+    durable_queue.h \
+    hdr_histogram.h \
+    log_categories.h \
+    product_correlator.h \
+    product_journal.h \
+    product_timing.h \
+    trace_recorder.h \
+    transfer_scheduler.h
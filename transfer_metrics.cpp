@@ -0,0 +1,194 @@
+#include "transfer_metrics.h"
+#include <QMutexLocker>
+#include <cmath>
+
+// 吞吐量滑动平均的权重（每秒一次）
+static const double RATE_ALPHA = 0.3;
+// Prometheus histogram 的 le 上界（毫秒）：1 ms ~ 5 min，按 1-2-5 递增；大图经慢速链路发送可达数分钟
+static const qint64 LATENCY_BOUNDS_MS[] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500,
+    1000, 2000, 5000, 10000, 20000, 60000, 120000, 300000
+};
+
+TransferMetrics::TransferMetrics() = default;
+
+void TransferMetrics::productDetected() {
+    m_detected.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TransferMetrics::productPacked() {
+    m_packed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TransferMetrics::productSent(qint64 bytes) {
+    m_sent.fetch_add(1, std::memory_order_relaxed);
+    m_bytesSent.fetch_add(static_cast<quint64>(qMax<qint64>(0, bytes)), std::memory_order_relaxed);
+}
+
+void TransferMetrics::productFailed() {
+    m_failed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TransferMetrics::productDropped() {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 失败的传输同样占用了链路，已写出的字节计入线上字节数
+void TransferMetrics::transferAttemptFailed(qint64 bytes) {
+    m_attemptFailures.fetch_add(1, std::memory_order_relaxed);
+    m_bytesSent.fetch_add(static_cast<quint64>(qMax<qint64>(0, bytes)), std::memory_order_relaxed);
+}
+
+void TransferMetrics::recordLatency(TransferStage stage, qint64 milliseconds) {
+    const int index = static_cast<int>(stage);
+    if (index >= 0 && index < static_cast<int>(TransferStage::Count)) {
+        m_latency[index].record(milliseconds);
+    }
+}
+
+quint64 TransferMetrics::detectedCount() const {
+    return m_detected.load(std::memory_order_relaxed);
+}
+
+quint64 TransferMetrics::sentCount() const {
+    return m_sent.load(std::memory_order_relaxed);
+}
+
+quint64 TransferMetrics::bytesSent() const {
+    return m_bytesSent.load(std::memory_order_relaxed);
+}
+
+const HdrHistogram& TransferMetrics::latency(TransferStage stage) const {
+    return m_latency[static_cast<int>(stage)];
+}
+
+bool TransferMetrics::tick(qint64 nowMs) {
+    QMutexLocker locker(&m_rateMutex);
+    const quint64 bytes = bytesSent();
+    const quint64 sent = sentCount();
+    if (m_lastTickMs == 0 || nowMs <= m_lastTickMs) {
+        m_lastTickMs = nowMs;
+        m_lastBytes = bytes;
+        m_lastSent = sent;
+        return false;
+    }
+    const double seconds = (nowMs - m_lastTickMs) / 1000.0;
+    const double byteRate = (bytes - m_lastBytes) / seconds;
+    const double productRate = (sent - m_lastSent) / seconds;
+    const double previousBytes = m_bytesPerSecond;
+    const double previousProducts = m_productsPerSecond;
+    m_bytesPerSecond = (1.0 - RATE_ALPHA) * m_bytesPerSecond + RATE_ALPHA * byteRate;
+    m_productsPerSecond = (1.0 - RATE_ALPHA) * m_productsPerSecond + RATE_ALPHA * productRate;
+    // 空闲时衰减到足够小就归零，避免界面一直显示极小的速率
+    if (m_bytesPerSecond < 1.0) {
+        m_bytesPerSecond = 0.0;
+    }
+    if (m_productsPerSecond < 0.001) {
+        m_productsPerSecond = 0.0;
+    }
+    m_lastTickMs = nowMs;
+    m_lastBytes = bytes;
+    m_lastSent = sent;
+    return m_bytesPerSecond != previousBytes || m_productsPerSecond != previousProducts;
+}
+
+double TransferMetrics::bytesPerSecond() const {
+    QMutexLocker locker(&m_rateMutex);
+    return m_bytesPerSecond;
+}
+
+double TransferMetrics::productsPerSecond() const {
+    QMutexLocker locker(&m_rateMutex);
+    return m_productsPerSecond;
+}
+
+const char* TransferMetrics::stageName(TransferStage stage) {
+    switch (stage) {
+    case TransferStage::Pack: return "pack";
+    case TransferStage::QueueWait: return "queue_wait";
+    case TransferStage::Transfer: return "transfer";
+    case TransferStage::EndToEnd: return "end_to_end";
+    case TransferStage::Preview: return "preview";
+    default: return "unknown";
+    }
+}
+
+namespace {
+void appendHeader(QByteArray& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void appendSample(QByteArray& out, const QByteArray& nameAndLabels, double value) {
+    out += nameAndLabels;
+    out += ' ';
+    out += QByteArray::number(value, 'g', 15);
+    out += '\n';
+}
+
+QByteArray secondsLabel(qint64 milliseconds) {
+    return QByteArray::number(milliseconds / 1000.0, 'g', 6);
+}
+}
+
+QByteArray TransferMetrics::renderPrometheus(const QList<MetricGauge>& gauges) const {
+    QByteArray out;
+    out.reserve(8 * 1024);
+
+    appendHeader(out, "aerolink_products_detected_total", "counter", "Complete product groups detected.");
+    appendSample(out, "aerolink_products_detected_total", m_detected.load());
+    appendHeader(out, "aerolink_products_packed_total", "counter", "Products packed into transfer files.");
+    appendSample(out, "aerolink_products_packed_total", m_packed.load());
+    appendHeader(out, "aerolink_products_total", "counter", "Products by final outcome.");
+    appendSample(out, "aerolink_products_total{outcome=\"sent\"}", m_sent.load());
+    appendSample(out, "aerolink_products_total{outcome=\"failed\"}", m_failed.load());
+    appendSample(out, "aerolink_products_total{outcome=\"dropped\"}", m_dropped.load());
+    appendHeader(out, "aerolink_transfer_failures_total", "counter", "Failed transfer attempts, including ones that were retried.");
+    appendSample(out, "aerolink_transfer_failures_total", m_attemptFailures.load());
+    appendHeader(out, "aerolink_bytes_sent_total", "counter", "Bytes written to the link, including failed attempts.");
+    appendSample(out, "aerolink_bytes_sent_total", m_bytesSent.load());
+
+    appendHeader(out, "aerolink_throughput_bytes_per_second", "gauge", "Smoothed link throughput.");
+    appendSample(out, "aerolink_throughput_bytes_per_second", bytesPerSecond());
+    appendHeader(out, "aerolink_throughput_products_per_second", "gauge", "Smoothed product send rate.");
+    appendSample(out, "aerolink_throughput_products_per_second", productsPerSecond());
+
+    for (const MetricGauge& gauge : gauges) {
+        appendHeader(out, gauge.name.constData(), gauge.type.constData(), gauge.help.constData());
+        appendSample(out, gauge.name, gauge.value);
+    }
+
+    appendHeader(out, "aerolink_stage_latency_seconds", "histogram", "Per-stage product latency.");
+    for (int s = 0; s < static_cast<int>(TransferStage::Count); ++s) {
+        const HdrHistogram& histogram = m_latency[s];
+        const QByteArray stage = stageName(static_cast<TransferStage>(s));
+        for (qint64 bound : LATENCY_BOUNDS_MS) {
+            appendSample(out, "aerolink_stage_latency_seconds_bucket{stage=\"" + stage + "\",le=\"" + secondsLabel(bound) + "\"}",
+                         histogram.countAtOrBelow(bound));
+        }
+        const quint64 count = histogram.count();
+        appendSample(out, "aerolink_stage_latency_seconds_bucket{stage=\"" + stage + "\",le=\"+Inf\"}", count);
+        appendSample(out, "aerolink_stage_latency_seconds_sum{stage=\"" + stage + "\"}", histogram.sum() / 1000.0);
+        appendSample(out, "aerolink_stage_latency_seconds_count{stage=\"" + stage + "\"}", count);
+    }
+
+    appendHeader(out, "aerolink_stage_latency_quantile_seconds", "gauge", "Per-stage latency percentiles estimated from the histogram buckets.");
+    static const double QUANTILES[] = {0.5, 0.9, 0.99};
+    for (int s = 0; s < static_cast<int>(TransferStage::Count); ++s) {
+        const HdrHistogram& histogram = m_latency[s];
+        const QByteArray stage = stageName(static_cast<TransferStage>(s));
+        for (double q : QUANTILES) {
+            appendSample(out, "aerolink_stage_latency_quantile_seconds{stage=\"" + stage + "\",quantile=\""
+                                  + QByteArray::number(q) + "\"}",
+                         histogram.valueAtPercentile(q * 100.0) / 1000.0);
+        }
+    }
+    return out;
+}
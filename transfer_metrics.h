@@ -0,0 +1,80 @@
+#ifndef TRANSFER_METRICS_H
+#define TRANSFER_METRICS_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <atomic>
+#include "hdr_histogram.h"
+
+// 产品在流水线中经历的阶段
+enum class TransferStage {
+    Pack,       // 打包耗时
+    QueueWait,  // 打包完成到出队
+    Transfer,   // 出队到传输结束（含连接）
+    EndToEnd,   // 检测到产品到发送成功
+    Preview,    // 检测到产品到预览发送成功（渐进传输）
+    Count
+};
+
+// 渲染时由调用方提供的瞬时值
+struct MetricGauge {
+    QByteArray name;
+    QByteArray help;
+    double value = 0.0;
+    QByteArray type = "gauge";     // 由其他模块累计的计数用 "counter"
+};
+
+/**
+ * @class TransferMetrics
+ * @brief 传输统计：增量计数器、各阶段延迟直方图与吞吐量。
+ *
+ * 各阶段延迟以毫秒记入 HdrHistogram（与分环节耗时共用同一实现）。
+ * 计数与延迟记录都是 O(1) 的原子操作，可在线程池和 I/O 线程中直接调用；
+ * 吞吐量由 tick() 每秒按计数增量做滑动平均。renderPrometheus() 输出 Prometheus 文本格式。
+ */
+class TransferMetrics {
+public:
+    TransferMetrics();
+
+    void productDetected();
+    void productPacked();
+    void productSent(qint64 bytes);
+    void productFailed();
+    void productDropped();
+    void transferAttemptFailed(qint64 bytes);
+    void recordLatency(TransferStage stage, qint64 milliseconds);
+
+    quint64 detectedCount() const;
+    quint64 sentCount() const;
+    quint64 bytesSent() const;
+    const HdrHistogram& latency(TransferStage stage) const;
+
+    // 每秒调用一次，更新吞吐量滑动平均；返回吞吐量是否有变化
+    bool tick(qint64 nowMs);
+    double bytesPerSecond() const;
+    double productsPerSecond() const;
+
+    QByteArray renderPrometheus(const QList<MetricGauge>& gauges) const;
+
+    static const char* stageName(TransferStage stage);
+
+private:
+    std::atomic<quint64> m_detected{0};
+    std::atomic<quint64> m_packed{0};
+    std::atomic<quint64> m_sent{0};
+    std::atomic<quint64> m_failed{0};
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<quint64> m_attemptFailures{0};
+    std::atomic<quint64> m_bytesSent{0};
+    HdrHistogram m_latency[static_cast<int>(TransferStage::Count)];
+
+    mutable QMutex m_rateMutex;
+    qint64 m_lastTickMs = 0;
+    quint64 m_lastBytes = 0;
+    quint64 m_lastSent = 0;
+    double m_bytesPerSecond = 0.0;
+    double m_productsPerSecond = 0.0;
+};
+
+#endif // TRANSFER_METRICS_H
@@ -0,0 +1,870 @@
+#include "transfer_pipeline.h"
+#include "log_categories.h"
+#include "file_monitor.h"
+#include "worker_pool.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QPointer>
+
+TransferPipeline::TransferPipeline(QObject* parent)
+    : QObject(parent),
+    m_scheduler(new TransferScheduler(this)),
+    m_pool(new WorkerPool),
+    m_io(new IoExecutor(QStringLiteral("transfer-io"))),
+    m_metricsTimer(new QTimer(this))
+{
+    // 排队连接：执行端完成一个产品后才处理下一个，不在 jobFinished 调用栈内重入
+    connect(m_scheduler, &TransferScheduler::dispatchJob, this, &TransferPipeline::executeJob, Qt::QueuedConnection);
+    connect(m_scheduler, &TransferScheduler::jobAbandoned, this, &TransferPipeline::onJobAbandoned);
+    connect(m_scheduler, &TransferScheduler::jobDropped, this, &TransferPipeline::onJobDropped);
+    connect(this, &TransferPipeline::statisticsChanged, this, &TransferPipeline::checkDrained);
+    // 每秒更新一次吞吐量，速率变化时通知界面
+    connect(m_metricsTimer, &QTimer::timeout, this, [this]() {
+        if (m_metrics.tick(QDateTime::currentMSecsSinceEpoch())) {
+            emit statisticsChanged();
+        }
+    });
+    m_metricsTimer->start(1000);
+}
+
+TransferPipeline::~TransferPipeline() {
+    stop();
+    // 等待线程池中正在进行的打包结束，再停止 I/O 线程；其回调投递到本对象，销毁后自动丢弃
+    delete m_pool;
+    delete m_io;
+    destroyRoots();
+}
+
+bool TransferPipeline::openJournal(const QString& journalPath) {
+    if (!m_journal.open(journalPath)) {
+        return false;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_imageLog = m_journal.imagePaths();
+    m_tiledProducts.clear();
+    m_tileParents.clear();
+    const QMap<quint16, ProductJournal::TiledProduct> tiled = m_journal.tiledProducts();
+    for (auto it = tiled.constBegin(); it != tiled.constEnd(); ++it) {
+        m_tiledProducts.insert(it.key(), it.value());
+        for (quint16 tile : it->tileNumbers) {
+            m_tileParents.insert(tile, it.key());
+        }
+    }
+    return true;
+}
+
+bool TransferPipeline::openQueue(const QString& queueDirPath) {
+    return m_scheduler->openQueue(queueDirPath);
+}
+
+ProductJournal* TransferPipeline::journal() {
+    return &m_journal;
+}
+
+TransferScheduler* TransferPipeline::scheduler() {
+    return m_scheduler;
+}
+
+WorkerPool* TransferPipeline::workerPool() {
+    return m_pool;
+}
+
+TransferMetrics* TransferPipeline::metrics() {
+    return &m_metrics;
+}
+
+ProductCache* TransferPipeline::productCache() {
+    return &m_productCache;
+}
+
+QByteArray TransferPipeline::renderMetrics() const {
+    QList<MetricGauge> gauges;
+    gauges.append({"aerolink_queue_depth", "Products packed and waiting for the link.", double(m_scheduler->queuedCount())});
+    gauges.append({"aerolink_transfers_in_flight", "Transfers currently on the link.", double(m_scheduler->inFlightCount())});
+    gauges.append({"aerolink_retry_waiting", "Failed products waiting for their retry backoff.", double(m_scheduler->delayedCount())});
+    gauges.append({"aerolink_link_overloaded", "1 while the scheduler applies its overload policy.", m_scheduler->isOverloaded() ? 1.0 : 0.0});
+    gauges.append({"aerolink_scheduler_throughput_products_per_second", "Link capacity estimated from average service time.", m_scheduler->throughput()});
+    gauges.append({"aerolink_worker_pool_pending", "Tasks waiting in the worker pool.", double(m_pool->pendingCount())});
+    QMutexLocker locker(&m_mutex);
+    gauges.append({"aerolink_products_in_pipeline", "Products detected but not yet finished.", double(m_inFlightProducts.size())});
+    locker.unlock();
+    gauges.append({"aerolink_journal_entries", "Products tracked by the product journal.", double(m_journal.size())});
+    const ProductCache::Stats cache = m_productCache.stats();
+    gauges.append({"aerolink_product_cache_bytes", "Bytes of packed products held in memory for resends.", double(cache.bytes)});
+    gauges.append({"aerolink_product_cache_entries", "Packed products held in memory for resends.", double(cache.entries)});
+    gauges.append({"aerolink_product_cache_hits_total", "Sends served from the product cache.", double(cache.hits), "counter"});
+    gauges.append({"aerolink_product_cache_misses_total", "Sends that had to read or repack the product.", double(cache.misses), "counter"});
+    gauges.append({"aerolink_product_cache_evictions_total", "Products evicted to stay within the cache size.", double(cache.evictions), "counter"});
+    gauges.append({"aerolink_product_cache_hit_ratio", "Fraction of cache lookups that hit.", m_productCache.hitRate()});
+    const SceneDeltaStore::Stats delta = m_deltaStore.stats();
+    gauges.append({"aerolink_delta_full_products_total", "SAR products packed in full while delta mode is on.", double(delta.fullProducts), "counter"});
+    gauges.append({"aerolink_delta_products_total", "SAR products packed as changed tiles against a scene base.", double(delta.deltaProducts), "counter"});
+    gauges.append({"aerolink_delta_changed_tiles_total", "Tiles sent in delta products.", double(delta.changedTiles), "counter"});
+    gauges.append({"aerolink_delta_tiles_total", "Tiles covered by delta products.", double(delta.totalTiles), "counter"});
+    gauges.append({"aerolink_delta_scenes", "Scenes holding a base image for delta packing.", double(delta.scenes)});
+    return m_metrics.renderPrometheus(gauges);
+}
+
+ProductTimingStats* TransferPipeline::timingStats() {
+    return &m_timingStats;
+}
+
+QByteArray TransferPipeline::renderTimings() const {
+    return m_timingStats.report();
+}
+
+void TransferPipeline::setTransferOptions(const TransferOptions& options) {
+    QMutexLocker locker(&m_mutex);
+    m_transferOptions = options;
+}
+
+TransferOptions TransferPipeline::transferOptions() const {
+    QMutexLocker locker(&m_mutex);
+    return m_transferOptions;
+}
+
+void TransferPipeline::setProgressiveSettings(const ProgressiveSettings& settings) {
+    QMutexLocker locker(&m_mutex);
+    m_progressive = settings;
+}
+
+ProgressiveSettings TransferPipeline::progressiveSettings() const {
+    QMutexLocker locker(&m_mutex);
+    return m_progressive;
+}
+
+void TransferPipeline::setTileSettings(const TileSettings& settings) {
+    QMutexLocker locker(&m_mutex);
+    m_tiling = settings;
+}
+
+TileSettings TransferPipeline::tileSettings() const {
+    QMutexLocker locker(&m_mutex);
+    return m_tiling;
+}
+
+void TransferPipeline::setDeltaSettings(const DeltaSettings& settings) {
+    QMutexLocker locker(&m_mutex);
+    m_delta = settings;
+    locker.unlock();
+    m_deltaStore.setMaxScenes(settings.maxScenes);
+}
+
+DeltaSettings TransferPipeline::deltaSettings() const {
+    QMutexLocker locker(&m_mutex);
+    return m_delta;
+}
+
+void TransferPipeline::transferFile(const QString& packedPath, const QString& host, quint16 port,
+                                    QObject* receiver, std::function<void(const ImageTransferResult&)> done) {
+    const TransferOptions options = transferOptions();
+    startTransfer([packedPath, host, port, options]() {
+        return transferPackedFileAsync(packedPath, host, port, options);
+    }, receiver, std::move(done));
+}
+
+void TransferPipeline::transferPackets(std::shared_ptr<PacketSource> source, const QString& host, quint16 port,
+                                       QObject* receiver, std::function<void(const ImageTransferResult&)> done) {
+    const TransferOptions options = transferOptions();
+    startTransfer([source, host, port, options]() {
+        return transferPacketsAsync(source, host, port, options);
+    }, receiver, std::move(done));
+}
+
+// 按编号记录的源文件重新打包：有同名 .txt 的按 GMTI（打包文件为临时文件），其余按 TIF，有 AUX 时一并打包
+static ImageTransferResult repackLoggedImage(const QString& filePath, quint16 imageNumber, QString* packedPath, bool* temporary) {
+    *temporary = false;
+    if (filePath.isEmpty()) {
+        ImageTransferResult result;
+        result.success = false;
+        result.message = QString("No file recorded for image number %1.").arg(imageNumber);
+        return result;
+    }
+    const QFileInfo info(filePath);
+    if (QFileInfo::exists(info.path() + QDir::separator() + info.baseName() + ".txt")) {
+        *temporary = true;
+        return packGMTI(filePath, imageNumber, packedPath);
+    }
+    const QString auxPath = ProductCorrelator::auxPathForImage(filePath);
+    return packManualImage(filePath, QFileInfo::exists(auxPath) ? auxPath : QString(), imageNumber, packedPath);
+}
+
+void TransferPipeline::resendImage(quint16 imageNumber, const QString& host, quint16 port,
+                                   QObject* receiver, std::function<void(const ImageTransferResult&)> done) {
+    resendPackets(imageNumber, QList<quint16>(), host, port, receiver, std::move(done));
+}
+
+void TransferPipeline::resendPackets(quint16 imageNumber, const QList<quint16>& packets, const QString& host, quint16 port,
+                                     QObject* receiver, std::function<void(const ImageTransferResult&)> done) {
+    // 瓦片编号按所属整图的记录重新打包；整图编号重发全部瓦片（包号在各瓦片消息间不唯一，不做选择）
+    QMutexLocker locker(&m_mutex);
+    const quint16 parent = m_tileParents.value(imageNumber, imageNumber);
+    const ProductJournal::TiledProduct tiled = m_tiledProducts.value(parent);
+    locker.unlock();
+    const bool tiledParent = !tiled.tileNumbers.isEmpty() && parent == imageNumber;
+
+    const QByteArray cached = lookupProduct(imageNumber);
+    if (!cached.isEmpty()) {
+        transferPackets(std::make_shared<CachedPacketSource>(cached, tiledParent ? QList<quint16>() : packets),
+                        host, port, receiver, std::move(done));
+        return;
+    }
+    // 重新打包只有在打包方式与编码参数都不变时才与原先发出的字节一致（增量、瓦片、ROI 等产品以及改过
+    // JPEG/渐进设置后都不成立），把新编码的个别包拼进接收端已有的图像会得到错误的结果，因此未命中时一律整图重发
+    if (!packets.isEmpty()) {
+        qCDebug(lcPipeline) << QString("图像 %1 不在产品缓存中，%2 个包的补发请求改为整图重发。").arg(imageNumber).arg(packets.size());
+    }
+    const QString filePath = tiled.tileNumbers.isEmpty() ? imagePath(imageNumber) : tiled.filePath;
+    const TileSettings tiling = tileSettings();
+    QPointer<QObject> target(receiver);
+    m_pool->submit([this, imageNumber, parent, tiled, tiling, filePath, host, port, target, done]() {
+        QString packedPath;
+        bool temporary = false;
+        ImageTransferResult result;
+        if (!tiled.tileNumbers.isEmpty()) {
+            TileSettings settings = tiling;
+            settings.enabled = true;
+            settings.tileSize = tiled.tileSize;
+            settings.minSide = 0;
+            settings.maxTiles = tiled.tileNumbers.size();
+            result = packTiledImage(filePath, ProductCorrelator::auxPathForImage(filePath), settings, parent,
+                                    tiled.tileNumbers, &packedPath);
+        } else {
+            result = repackLoggedImage(filePath, imageNumber, &packedPath, &temporary);
+        }
+        QByteArray frames;
+        if (result.success) {
+            QFile packedFile(packedPath);
+            if (packedFile.open(QIODevice::ReadOnly)) {
+                frames = packedFile.readAll();
+            } else {
+                result.success = false;
+                result.message = "Failed to read repacked file: " + packedPath;
+            }
+            if (temporary) {
+                packedFile.remove();
+            }
+        }
+        if (!result.success) {
+            if (target) {
+                QMetaObject::invokeMethod(target, [done, result]() { done(result); }, Qt::QueuedConnection);
+            }
+            return;
+        }
+        // 重新打包的结果整图发出后放回缓存，接收端此后持有的就是这份编码，后续补发请求直接命中；
+        // 只重发一个瓦片时其余瓦片没有发出，不放入缓存
+        if (tiled.tileNumbers.isEmpty()) {
+            m_productCache.insert(imageNumber, frames);
+        } else {
+            QByteArray selected;
+            for (const auto& message : ProductCache::splitMessages(frames)) {
+                if (imageNumber == parent || message.first == imageNumber) {
+                    m_productCache.insert(message.first, message.second);
+                    selected.append(message.second);
+                }
+            }
+            frames = selected;
+        }
+        transferPackets(std::make_shared<CachedPacketSource>(frames), host, port, target, done);
+    });
+}
+
+void TransferPipeline::startTransfer(std::function<async::Task<ImageTransferResult>()> makeTask,
+                                     QObject* receiver, std::function<void(const ImageTransferResult&)> done) {
+    QPointer<QObject> target(receiver);
+    m_io->post([makeTask, target, done]() {
+        async::start(makeTask(),
+                     [target, done](ImageTransferResult result) {
+                         if (!target) {
+                             return;
+                         }
+                         QMetaObject::invokeMethod(target, [done, result]() { done(result); }, Qt::QueuedConnection);
+                     });
+    });
+}
+
+void TransferPipeline::setRoots(const QList<MonitorRootConfig>& roots) {
+    if (m_running) {
+        qWarning() << "Cannot change monitor roots while the pipeline is running.";
+        return;
+    }
+    destroyRoots();
+    for (const MonitorRootConfig& config : roots) {
+        Root root;
+        root.config = config;
+        root.config.path = QDir::cleanPath(config.path);
+        root.monitor = new FileMonitor(this);
+        root.correlator = new ProductCorrelator(config.productType, this);
+        if (m_journal.isOpen()) {
+            root.correlator->setJournal(&m_journal);
+        }
+        const int index = m_roots.size();
+        const QString rootName = config.name;
+        // 监控端上报产品组成员文件，关联器凑齐一组后再交给调度器
+        connect(root.monitor, &FileMonitor::newFileDetected, root.correlator, &ProductCorrelator::addFile);
+        connect(root.correlator, &ProductCorrelator::productReady, this, [this, index](const ProductJob& product) {
+            onProductReady(index, product);
+        });
+        connect(root.monitor, &FileMonitor::subDirChanged, this, [this, rootName](const QString& subDir) {
+            emit subDirChanged(rootName, subDir);
+        });
+        m_roots.append(root);
+    }
+}
+
+QList<MonitorRootConfig> TransferPipeline::roots() const {
+    QList<MonitorRootConfig> configs;
+    for (const Root& root : m_roots) {
+        configs.append(root.config);
+    }
+    return configs;
+}
+
+bool TransferPipeline::start() {
+    if (m_running) {
+        return true;
+    }
+    if (m_roots.isEmpty()) {
+        qWarning() << "No monitor roots configured.";
+        return false;
+    }
+    for (Root& root : m_roots) {
+        if (!QDir(root.config.path).exists()) {
+            qWarning() << "Monitor root" << root.config.name << "does not exist:" << root.config.path;
+            continue;
+        }
+        root.correlator->clear();
+        root.monitor->setMainFolder(root.config.path);
+        root.monitor->start(root.config.productType == ProductType::GMTI);
+        qDebug() << "开始监控根目录" << root.config.name << ":" << root.config.path
+                 << "类型" << productTypeName(root.config.productType)
+                 << "目的" << root.config.destinationHost << root.config.destinationPort
+                 << "优先级" << root.config.priority;
+    }
+    m_running = true;
+    resumePendingProducts();
+    return true;
+}
+
+void TransferPipeline::stop() {
+    if (!m_running) {
+        return;
+    }
+    for (Root& root : m_roots) {
+        root.monitor->stop();
+        root.correlator->clear();
+    }
+    // 尚未完成的产品保留在持久化队列与日志中，下次启动时续传
+    m_scheduler->clear();
+    // 候选的产品不会再有发送结果，场景基准保留（接收端仍有这些图像）
+    m_deltaStore.clearCandidates();
+    QMutexLocker locker(&m_mutex);
+    m_inFlightProducts.clear();
+    m_running = false;
+    m_draining = false;
+}
+
+bool TransferPipeline::isRunning() const {
+    return m_running;
+}
+
+void TransferPipeline::beginDrain() {
+    if (!m_running || m_draining) {
+        return;
+    }
+    m_draining = true;
+    for (Root& root : m_roots) {
+        root.monitor->stop();
+        root.correlator->clear();
+    }
+    qCDebug(lcPipeline) << "Draining transfer pipeline," << m_scheduler->queuedCount() << "queued and"
+             << m_scheduler->inFlightCount() << "in flight.";
+    checkDrained();
+}
+
+bool TransferPipeline::isDraining() const {
+    return m_draining;
+}
+
+// 退避等待中的任务可能要等很久，不计入；它们留在持久化队列中下次启动再发
+void TransferPipeline::checkDrained() {
+    if (!m_draining) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    const int active = m_inFlightProducts.size() - m_scheduler->delayedCount();
+    locker.unlock();
+    if (active <= 0) {
+        m_draining = false;
+        qCDebug(lcPipeline) << "Transfer pipeline drained.";
+        emit drained();
+    }
+}
+
+quint16 TransferPipeline::allocateImageNumber() {
+    const quint16 imageNumber = m_journal.allocateImageNumber();
+    forgetReusedNumbers({imageNumber});
+    return imageNumber;
+}
+
+QList<quint16> TransferPipeline::allocateImageNumbers(int count) {
+    const QList<quint16> imageNumbers = m_journal.allocateImageNumbers(count);
+    forgetReusedNumbers(imageNumbers);
+    return imageNumbers;
+}
+
+// 编号回绕后复用时，以它为整图或瓦片的旧瓦片记录随之作废
+void TransferPipeline::forgetReusedNumbers(const QList<quint16>& imageNumbers) {
+    QList<int> forgotten;
+    QMutexLocker locker(&m_mutex);
+    for (quint16 imageNumber : imageNumbers) {
+        forgotten.append(forgetTiledLocked(imageNumber));
+    }
+    locker.unlock();
+    for (int imageNumber : forgotten) {
+        dropTiledRecord(imageNumber);
+    }
+}
+
+ProductJournal::TiledProduct TransferPipeline::tiledProduct(quint16 imageNumber) const {
+    QMutexLocker locker(&m_mutex);
+    return m_tiledProducts.value(imageNumber);
+}
+
+void TransferPipeline::recordTiledProduct(quint16 imageNumber, const ProductJournal::TiledProduct& product) {
+    QMutexLocker locker(&m_mutex);
+    m_tiledProducts.insert(imageNumber, product);
+    for (quint16 tile : product.tileNumbers) {
+        m_tileParents.insert(tile, imageNumber);
+    }
+    locker.unlock();
+    m_journal.recordTiledProduct(imageNumber, product);
+}
+
+int TransferPipeline::forgetTiledLocked(quint16 imageNumber) {
+    const quint16 parent = m_tileParents.value(imageNumber, imageNumber);
+    const auto it = m_tiledProducts.constFind(parent);
+    if (it == m_tiledProducts.constEnd()) {
+        return -1;
+    }
+    for (quint16 tile : it->tileNumbers) {
+        m_tileParents.remove(tile);
+    }
+    m_tiledProducts.erase(it);
+    return parent;
+}
+
+void TransferPipeline::dropTiledRecord(int imageNumber) {
+    if (imageNumber >= 0) {
+        m_journal.recordTiledProduct(quint16(imageNumber), ProductJournal::TiledProduct());
+    }
+}
+
+QByteArray TransferPipeline::lookupProduct(quint16 imageNumber) {
+    const ProductJournal::TiledProduct tiled = tiledProduct(imageNumber);
+    if (tiled.tileNumbers.isEmpty()) {
+        return m_productCache.lookup(imageNumber);
+    }
+    QByteArray frames;
+    for (quint16 tile : tiled.tileNumbers) {
+        const QByteArray tileFrames = m_productCache.lookup(tile);
+        if (tileFrames.isEmpty()) {
+            return QByteArray();
+        }
+        frames.append(tileFrames);
+    }
+    return frames;
+}
+
+void TransferPipeline::removeCachedProduct(quint16 imageNumber) {
+    const ProductJournal::TiledProduct tiled = tiledProduct(imageNumber);
+    for (quint16 tile : tiled.tileNumbers) {
+        m_productCache.remove(tile);
+    }
+    m_productCache.remove(imageNumber);
+}
+
+void TransferPipeline::recordImagePath(quint16 imageNumber, const QString& filePath) {
+    QMutexLocker locker(&m_mutex);
+    m_imageLog[imageNumber] = filePath;
+    locker.unlock();
+    m_journal.recordImagePath(imageNumber, filePath);
+}
+
+QString TransferPipeline::imagePath(quint16 imageNumber) const {
+    QMutexLocker locker(&m_mutex);
+    return m_imageLog.value(imageNumber);
+}
+
+TransferJob TransferPipeline::makeJob(const Root& root, const ProductJob& product, quint16 imageNumber) const {
+    TransferJob job;
+    job.product = product;
+    job.imageNumber = imageNumber;
+    job.rootName = root.config.name;
+    job.host = root.config.destinationHost;
+    job.port = root.config.destinationPort;
+    job.priority = root.config.priority;
+    job.detectedMs = QDateTime::currentMSecsSinceEpoch();
+    if (product.fileReadyMs > 0 && product.firstSeenMs > 0) {
+        job.timing.set(TimingStage::Detect, (product.firstSeenMs - product.fileReadyMs) * 1000);
+    }
+    if (product.firstSeenMs > 0 && product.completedMs > 0) {
+        job.timing.set(TimingStage::AuxWait, (product.completedMs - product.firstSeenMs) * 1000);
+    }
+    return job;
+}
+
+void TransferPipeline::onProductReady(int rootIndex, const ProductJob& product) {
+    if (m_draining || rootIndex < 0 || rootIndex >= m_roots.size()) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    if (m_inFlightProducts.contains(product.key)) {
+        qDebug() << "Product" << product.key << "is already queued. Skipping duplicate.";
+        return;
+    }
+    m_inFlightProducts.insert(product.key);
+    locker.unlock();
+    const quint16 imageNumber = allocateImageNumber();
+
+    m_journal.record(product, ProductState::Detected, imageNumber);
+    m_metrics.productDetected();
+    const TransferJob job = makeJob(m_roots.at(rootIndex), product, imageNumber);
+    emit productQueued(job);
+    startPacking(job);
+    emit statisticsChanged();
+}
+
+// 打包只占用 CPU，不受链路调度限制，多个产品在线程池中并行打包
+void TransferPipeline::startPacking(const TransferJob& job) {
+    emit productProgress(job, "packing");
+    const ProgressiveSettings progressive = progressiveSettings();
+    m_pool->submit([this, job, progressive]() {
+        if (progressive.enabled && job.product.type == ProductType::SAR) {
+            sendPreview(job, progressive);
+        }
+        TransferJob packed = job;
+        QElapsedTimer timer;
+        timer.start();
+        const ImageTransferResult result = packJob(job, &packed.packedPath);
+        m_metrics.recordLatency(TransferStage::Pack, timer.elapsed());
+        if (result.success) {
+            m_productCache.insertFile(job.imageNumber, packed.packedPath);
+        }
+        QMetaObject::invokeMethod(this, [this, packed, result]() {
+            onPacked(packed, result);
+        }, Qt::QueuedConnection);
+    });
+}
+
+ImageTransferResult TransferPipeline::packJob(const TransferJob& job, QString* packedPath) {
+    const DeltaSettings delta = deltaSettings();
+    if (delta.enabled && job.product.type == ProductType::SAR) {
+        AuxFileReader auxReader;
+        if (auxReader.read(job.product.auxPath)) {
+            // 基准只在产品送达后提升，这里记下候选：接收端收到本产品后看到的图像
+            const QString scene = SceneDeltaStore::sceneKey(auxReader.getHeader(), delta.cellDegrees);
+            const DeltaBase base = m_deltaStore.base(scene);
+            QImage reconstructed;
+            int changedTiles = -1;
+            int totalTiles = 0;
+            const ImageTransferResult result = packDeltaImage(job.product.imagePath, job.product.auxPath, delta, base, job.imageNumber,
+                                                              &reconstructed, &changedTiles, &totalTiles, packedPath);
+            if (!result.success) {
+                return result;
+            }
+            if (changedTiles >= 0) {
+                // 增量产品是单个消息，去掉此编号先前按瓦片打包时留下的记录，缓存按整图编号查找
+                QMutexLocker locker(&m_mutex);
+                const int forgotten = forgetTiledLocked(job.imageNumber);
+                locker.unlock();
+                dropTiledRecord(forgotten);
+                m_deltaStore.setCandidate(job.imageNumber, scene, reconstructed, base.chainLength + 1, changedTiles, totalTiles);
+                return result;
+            }
+            // 不适合增量时与未开启增量一样选择整图或瓦片打包，基准取打包结果按接收端方式解码的图像
+            const ImageTransferResult full = packFullProduct(job, packedPath);
+            if (full.success) {
+                const QImage decoded = decodePackedSarImage(*packedPath);
+                if (!decoded.isNull()) {
+                    m_deltaStore.setCandidate(job.imageNumber, scene, decoded, 0, -1, totalTiles);
+                }
+            }
+            return full;
+        }
+    }
+    return packFullProduct(job, packedPath);
+}
+
+// 瓦片编号在首次打包时分配并记入日志，整图编号只写在瓦片扩展信息中
+ImageTransferResult TransferPipeline::packFullProduct(const TransferJob& job, QString* packedPath) {
+    if (job.product.type == ProductType::SAR) {
+        TileSettings tiling = tileSettings();
+        ProductJournal::TiledProduct tiled = tiledProduct(job.imageNumber);
+        if (tiled.tileNumbers.isEmpty() || tiled.filePath != job.product.imagePath) {
+            int tileSize = 0;
+            const int tileCount = tiledProductTileCount(job.product.imagePath, job.product.auxPath, tiling, &tileSize);
+            tiled = ProductJournal::TiledProduct();
+            if (tileCount > 0) {
+                // 一批编号会覆盖日志中仍在使用的编号时分配被拒绝，此时按整图打包
+                tiled.tileNumbers = allocateImageNumbers(tileCount);
+                if (tiled.tileNumbers.isEmpty()) {
+                    qCDebug(lcPipeline) << QString("产品 %1 的 %2 个瓦片编号会复用仍在使用的编号，改为整图打包。")
+                                               .arg(job.product.key).arg(tileCount);
+                } else {
+                    tiled.filePath = job.product.imagePath;
+                    tiled.tileSize = tileSize;
+                    recordTiledProduct(job.imageNumber, tiled);
+                }
+            }
+        }
+        if (!tiled.tileNumbers.isEmpty()) {
+            // 重新打包（退避重试、续传、重发）沿用首次分配的瓦片编号与边长，接收端已有的瓦片编号保持有效
+            tiling.enabled = true;
+            tiling.tileSize = tiled.tileSize;
+            tiling.minSide = 0;
+            tiling.maxTiles = tiled.tileNumbers.size();
+            return packTiledImage(job.product.imagePath, job.product.auxPath, tiling, job.imageNumber, tiled.tileNumbers, packedPath);
+        }
+    }
+    return packProduct(job.product, job.imageNumber, packedPath);
+}
+
+// 预览体积约为整图的 1/scale²，不经过链路调度直接发送，整图随后照常打包入队。
+// 预览另外从日志分配编号（整图编号写入 PreviewInfo），不与整图或其它产品共用编号
+void TransferPipeline::sendPreview(const TransferJob& job, const ProgressiveSettings& settings) {
+    const quint16 previewNumber = allocateImageNumber();
+    // 编号回绕后复用时缓存中可能还有旧产品的帧；预览不进缓存，不清掉的话按此编号的重传会发出旧图像
+    removeCachedProduct(previewNumber);
+    const QString previewPath = QDir::temp().filePath(QString("PREVIEW_IMG_%1_packaged.bin").arg(previewNumber));
+    if (!createPreviewBinFile(job.product.imagePath, job.product.auxPath, settings.scale, settings.jpegQuality,
+                              previewPath, previewNumber, job.imageNumber)) {
+        qWarning() << "Failed to create preview for" << job.product.key << ", sending the full product only.";
+        return;
+    }
+    transferFile(previewPath, job.host, job.port, this, [this, job, previewNumber, previewPath](const ImageTransferResult& result) {
+        QFile::remove(previewPath);
+        if (!result.success) {
+            qCDebug(lcPipeline) << ("预览发送失败：" + result.message);
+            return;
+        }
+        if (job.detectedMs > 0) {
+            m_metrics.recordLatency(TransferStage::Preview, QDateTime::currentMSecsSinceEpoch() - job.detectedMs);
+        }
+        qCDebug(lcPipeline) << QString("预览已发送。预览编号: %1，整图编号: %2，%3 字节")
+                                   .arg(previewNumber).arg(job.imageNumber).arg(result.bytesSent);
+    });
+}
+
+void TransferPipeline::onPacked(const TransferJob& job, const ImageTransferResult& result) {
+    if (!result.success) {
+        // 打包失败说明产品文件本身有问题，重试没有意义
+        qDebug() << ("产品打包失败：" + result.message);
+        QMutexLocker locker(&m_mutex);
+        m_inFlightProducts.remove(job.product.key);
+        locker.unlock();
+        m_journal.record(job.product, ProductState::Failed, job.imageNumber);
+        m_metrics.productFailed();
+        emit productFinished(job, false, result.message);
+        emit statisticsChanged();
+        return;
+    }
+    m_journal.record(job.product, ProductState::Packed, job.imageNumber);
+    m_metrics.productPacked();
+    emit productProgress(job, "queued");
+    TransferJob queued = job;
+    queued.queuedMs = QDateTime::currentMSecsSinceEpoch();
+    queued.timing.merge(result.timing);
+    m_scheduler->enqueue(queued);
+    emit statisticsChanged();
+}
+
+void TransferPipeline::executeJob(const TransferJob& job) {
+    qDebug() << "Transferring product from root" << job.rootName << ":" << job.product.imagePath;
+    emit productProgress(job, "sending");
+    if (job.queuedMs > 0 && job.dispatchedMs >= job.queuedMs) {
+        m_metrics.recordLatency(TransferStage::QueueWait, job.dispatchedMs - job.queuedMs);
+    }
+    auto transfer = [this](const TransferJob& sending) {
+        transferFile(sending.packedPath, sending.host, sending.port, this, [this, sending](const ImageTransferResult& result) {
+            onTransferred(sending, result);
+        });
+    };
+    // 缓存命中时直接从内存发送，退避重试与断线续传都不再读盘或重新打包
+    const QByteArray cached = lookupProduct(job.imageNumber);
+    if (!cached.isEmpty()) {
+        transferPackets(std::make_shared<CachedPacketSource>(cached), job.host, job.port, this,
+                        [this, job](const ImageTransferResult& result) {
+            onTransferred(job, result);
+        });
+        return;
+    }
+    if (!job.packedPath.isEmpty() && QFileInfo::exists(job.packedPath)) {
+        transfer(job);
+        return;
+    }
+    // 恢复的任务或退避期间打包文件被清理时，先在线程池中重新打包
+    m_pool->submit([this, job, transfer]() {
+        TransferJob sending = job;
+        const ImageTransferResult result = packJob(sending, &sending.packedPath);
+        sending.timing.merge(result.timing);
+        if (result.success) {
+            m_productCache.insertFile(sending.imageNumber, sending.packedPath);
+            transfer(sending);
+            return;
+        }
+        QMetaObject::invokeMethod(this, [this, sending, result]() {
+            onTransferred(sending, result);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void TransferPipeline::onTransferred(const TransferJob& job, const ImageTransferResult& result) {
+    const QString filePath = job.product.imagePath;
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    if (job.dispatchedMs > 0) {
+        m_metrics.recordLatency(TransferStage::Transfer, nowMs - job.dispatchedMs);
+    }
+    if (result.success) {
+        m_metrics.productSent(result.bytesSent);
+        if (job.detectedMs > 0) {
+            m_metrics.recordLatency(TransferStage::EndToEnd, nowMs - job.detectedMs);
+        }
+        QMutexLocker locker(&m_mutex);
+        m_inFlightProducts.remove(job.product.key);
+        m_imageLog[job.imageNumber] = filePath;
+        locker.unlock();
+
+        // 开启确认时传输成功即表示接收端已回复确认
+        const ProductState state = transferOptions().waitForAck ? ProductState::Acked : ProductState::Sent;
+        m_journal.record(job.product, state, job.imageNumber);
+        m_journal.recordImagePath(job.imageNumber, filePath);
+        m_deltaStore.promote(job.imageNumber);
+        removePackedFile(job);
+        ProductTiming timing = job.timing;
+        timing.merge(result.timing);
+        m_timingStats.record(job.product.type, timing);
+        qDebug() << QString("自动数传成功。图片编号: %1, 文件路径: %2").arg(job.imageNumber).arg(filePath);
+        qCDebug(lcPipeline).noquote() << "Product timing" << job.product.key << ":" << timing.summary();
+    } else {
+        m_metrics.transferAttemptFailed(result.bytesSent);
+        qDebug() << ("自动数传失败：" + result.message);
+    }
+
+    emit productFinished(job, result.success, result.message);
+    emit statisticsChanged();
+    // 失败时由调度器决定退避重试还是放弃；源文件已不存在的产品没有重试意义
+    m_scheduler->jobFinished(job, result.success, QFileInfo::exists(filePath));
+}
+
+// GMTI 打包文件是临时文件，产品结束后删除；SAR 的 .bin 与原先一样保留在 TIF 旁
+void TransferPipeline::removePackedFile(const TransferJob& job) {
+    if (job.product.type == ProductType::GMTI && !job.packedPath.isEmpty()) {
+        QFile::remove(job.packedPath);
+    }
+}
+
+void TransferPipeline::onJobAbandoned(const TransferJob& job) {
+    QMutexLocker locker(&m_mutex);
+    m_inFlightProducts.remove(job.product.key);
+    locker.unlock();
+    m_journal.record(job.product, ProductState::Failed, job.imageNumber);
+    m_metrics.productFailed();
+    removePackedFile(job);
+    removeCachedProduct(job.imageNumber);
+    m_deltaStore.discard(job.imageNumber);
+    emit statisticsChanged();
+}
+
+void TransferPipeline::onJobDropped(const TransferJob& job, const QString& reason) {
+    Q_UNUSED(reason);
+    QMutexLocker locker(&m_mutex);
+    m_inFlightProducts.remove(job.product.key);
+    locker.unlock();
+    m_journal.record(job.product, ProductState::Dropped, job.imageNumber);
+    m_metrics.productDropped();
+    removePackedFile(job);
+    removeCachedProduct(job.imageNumber);
+    m_deltaStore.discard(job.imageNumber);
+    emit statisticsChanged();
+}
+
+int TransferPipeline::rootIndexForPath(const QString& filePath) const {
+    const QString cleanPath = QDir::cleanPath(filePath);
+    int bestIndex = -1;
+    int bestLength = -1;
+    for (int i = 0; i < m_roots.size(); ++i) {
+        const QString& rootPath = m_roots.at(i).config.path;
+        if (cleanPath.startsWith(rootPath + QLatin1Char('/')) && rootPath.length() > bestLength) {
+            bestIndex = i;
+            bestLength = rootPath.length();
+        }
+    }
+    return bestIndex;
+}
+
+/**
+ * @brief 续传上次运行中未完成的产品（崩溃或退出前已检测但尚未发送）。
+ * 先恢复持久化队列中的任务（保留重试次数与退避时间），目的地址按根目录名称取当前配置；
+ * 日志中未完成、但未进入持久化队列的产品（入队记录尚未落盘即崩溃）按文件路径归属根目录后重新入队。
+ * 沿用日志中记录的图像编号，文件已不存在或不属于任何根目录的产品记为失败。
+ */
+void TransferPipeline::resumePendingProducts() {
+    QSet<QString> queuedKeys;
+    const QList<TransferJob> persisted = m_scheduler->persistedJobs();
+    for (TransferJob job : persisted) {
+        for (const Root& root : m_roots) {
+            if (root.config.name == job.rootName) {
+                job.host = root.config.destinationHost;
+                job.port = root.config.destinationPort;
+                job.priority = root.config.priority;
+                break;
+            }
+        }
+        queuedKeys.insert(job.product.key);
+        QMutexLocker locker(&m_mutex);
+        if (m_inFlightProducts.contains(job.product.key)) {
+            continue;
+        }
+        m_inFlightProducts.insert(job.product.key);
+        locker.unlock();
+        job.queuedMs = QDateTime::currentMSecsSinceEpoch();
+        m_scheduler->resume(job);
+    }
+
+    const QList<ProductJournal::PendingProduct> pending = m_journal.pendingProducts();
+    if (!persisted.isEmpty() || !pending.isEmpty()) {
+        qDebug() << "Resuming" << persisted.size() << "queued and" << pending.size() << "unfinished products.";
+    }
+    for (const ProductJournal::PendingProduct& product : pending) {
+        if (queuedKeys.contains(product.job.key)) {
+            continue;
+        }
+        const int rootIndex = rootIndexForPath(product.job.imagePath);
+        if (!QFileInfo::exists(product.job.imagePath) || rootIndex < 0) {
+            qWarning() << "Unfinished product" << product.job.key << "no longer exists or has no monitor root, marking as failed.";
+            m_journal.record(product.job, ProductState::Failed, product.imageNumber);
+            continue;
+        }
+        QMutexLocker locker(&m_mutex);
+        if (m_inFlightProducts.contains(product.job.key)) {
+            continue;
+        }
+        m_inFlightProducts.insert(product.job.key);
+        locker.unlock();
+        startPacking(makeJob(m_roots.at(rootIndex), product.job, product.imageNumber));
+    }
+    emit statisticsChanged();
+}
+
+void TransferPipeline::destroyRoots() {
+    for (Root& root : m_roots) {
+        delete root.monitor;
+        delete root.correlator;
+    }
+    m_roots.clear();
+}
@@ -0,0 +1,184 @@
+#ifndef TRANSFER_PIPELINE_H
+#define TRANSFER_PIPELINE_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QMutex>
+#include "pipeline_config.h"
+#include "product_cache.h"
+#include "product_journal.h"
+#include "transfer_scheduler.h"
+#include "image_transfer.h"
+#include "async_transfer.h"
+#include "product_timing.h"
+#include "scene_delta.h"
+#include "transfer_metrics.h"
+#include <QTimer>
+#include <functional>
+
+class FileMonitor;
+class WorkerPool;
+
+/**
+ * @class TransferPipeline
+ * @brief 多根目录的监控与传输流水线（不依赖界面）。
+ *
+ * 每个监控根目录拥有独立的 FileMonitor 与 ProductCorrelator，按各自的产品类型识别产品组；
+ * 齐全的产品带上该根目录的目的地址与优先级进入共享的 TransferScheduler，
+ * 产品先在共享的工作线程池中打包（记为 Packed），再进入链路调度器排队传输；
+ * 传输以协程方式在单个 I/O 线程中执行，同时进行的传输数由调度器的 maxInFlight 决定，
+ * 不再为每个传输占用一个阻塞的线程；本对象所在线程（界面线程）只做调度与状态记录，
+ * 通过 productProgress / productFinished 信号向界面报告进度。
+ * 产品状态统一记录在一份 ProductJournal 中；传输失败的产品由调度器退避重试，只有最终放弃时才记为 Failed。
+ */
+class TransferPipeline : public QObject {
+    Q_OBJECT
+public:
+    explicit TransferPipeline(QObject* parent = nullptr);
+    ~TransferPipeline();
+
+    bool openJournal(const QString& journalPath);
+    // 持久化待发送队列目录，失败任务的重试状态也保存在其中
+    bool openQueue(const QString& queueDirPath);
+    ProductJournal* journal();
+    TransferScheduler* scheduler();
+    WorkerPool* workerPool();
+    TransferMetrics* metrics();
+    // 已打包产品的内存缓存，容量由调用方按配置设置（默认不缓存）
+    ProductCache* productCache();
+    // 当前统计（含队列深度等瞬时值）的 Prometheus 文本，须在本对象所在线程调用
+    QByteArray renderMetrics() const;
+    // 按产品类型汇总的分环节耗时表（文本），可在任意线程调用
+    ProductTimingStats* timingStats();
+    QByteArray renderTimings() const;
+
+    void setTransferOptions(const TransferOptions& options);
+    TransferOptions transferOptions() const;
+    // 渐进传输：开启后 SAR 产品打包前先生成并发送低分辨率预览
+    void setProgressiveSettings(const ProgressiveSettings& settings);
+    ProgressiveSettings progressiveSettings() const;
+    // 瓦片模式：大幅 SAR 产品切成瓦片分别编码，各瓦片占用新的图像编号
+    void setTileSettings(const TileSettings& settings);
+    TileSettings tileSettings() const;
+    // 场景增量：同一场景的重复过境只发送相对上一幅已送达图像变化的瓦片；需要完整产品时仍按瓦片模式选择
+    void setDeltaSettings(const DeltaSettings& settings);
+    DeltaSettings deltaSettings() const;
+    /**
+     * @brief 在 I/O 线程中异步发送已打包的文件，完成后在 receiver 所在线程调用 done。
+     * 可在任意线程调用；手动发送与自动发送共用同一个 I/O 线程。
+     */
+    void transferFile(const QString& packedPath, const QString& host, quint16 port,
+                      QObject* receiver, std::function<void(const ImageTransferResult&)> done);
+    // 同上，发送任意包源（如 SLC 芯片）；包源交给 I/O 线程后调用方不得再访问
+    void transferPackets(std::shared_ptr<PacketSource> source, const QString& host, quint16 port,
+                         QObject* receiver, std::function<void(const ImageTransferResult&)> done);
+    /**
+     * @brief 按图像编号重发已发送过的产品。缓存命中时直接从内存发送；
+     * 未命中时在线程池中按编号记录的源文件以原编号重新打包（并放入缓存）后发送。可在任意线程调用。
+     * 瓦片产品的整图编号重发全部瓦片，瓦片编号只重发该瓦片；重新打包时沿用原瓦片编号与瓦片边长。
+     */
+    void resendImage(quint16 imageNumber, const QString& host, quint16 port,
+                     QObject* receiver, std::function<void(const ImageTransferResult&)> done);
+    // 同上，只补发 packets 中的包（升序的 SAR_Frame::current_packet），为空时整图重发；
+    // 缓存未命中时无法保证重新打包的字节与原先一致，此时忽略 packets 整图重发
+    void resendPackets(quint16 imageNumber, const QList<quint16>& packets, const QString& host, quint16 port,
+                       QObject* receiver, std::function<void(const ImageTransferResult&)> done);
+
+    // 仅在停止状态下生效
+    void setRoots(const QList<MonitorRootConfig>& roots);
+    QList<MonitorRootConfig> roots() const;
+
+    bool start();
+    void stop();
+    bool isRunning() const;
+    /**
+     * @brief 优雅停止：停止监控、不再接收新产品，已检测的产品继续打包和发送，
+     * 全部完成（或只剩退避等待中的任务）后发出 drained，之后由调用方 stop()。
+     * 未发送的任务保留在持久化队列中，下次启动时续传。
+     */
+    void beginDrain();
+    bool isDraining() const;
+
+    // 手动发送与自动发送共用日志中的同一编号序列，每次分配都落盘
+    quint16 allocateImageNumber();
+    void recordImagePath(quint16 imageNumber, const QString& filePath);
+    QString imagePath(quint16 imageNumber) const;
+
+signals:
+    void productQueued(const TransferJob& job);
+    void productProgress(const TransferJob& job, const QString& stage);
+    void productFinished(const TransferJob& job, bool success, const QString& message);
+    void subDirChanged(const QString& rootName, const QString& subDir);
+    void statisticsChanged();
+    void drained();
+
+private slots:
+    void executeJob(const TransferJob& job);
+    void onJobAbandoned(const TransferJob& job);
+    void onJobDropped(const TransferJob& job, const QString& reason);
+    void checkDrained();
+
+private:
+    struct Root {
+        MonitorRootConfig config;
+        FileMonitor* monitor = nullptr;
+        ProductCorrelator* correlator = nullptr;
+    };
+
+    void onProductReady(int rootIndex, const ProductJob& product);
+    void startTransfer(std::function<async::Task<ImageTransferResult>()> makeTask,
+                       QObject* receiver, std::function<void(const ImageTransferResult&)> done);
+    void startPacking(const TransferJob& job);
+    // 在线程池中调用：开启增量时先尝试增量打包，否则（或增量不适用时）交给 packFullProduct
+    ImageTransferResult packJob(const TransferJob& job, QString* packedPath);
+    // 在线程池中调用：按瓦片设置打包完整产品（整图或瓦片）
+    ImageTransferResult packFullProduct(const TransferJob& job, QString* packedPath);
+    // 连续分配 count 个编号，日志只记一次水位线；会复用仍在使用的编号时返回空列表
+    QList<quint16> allocateImageNumbers(int count);
+    void forgetReusedNumbers(const QList<quint16>& imageNumbers);
+    // 瓦片产品记录（整图编号 → 瓦片编号），非瓦片产品返回空记录
+    ProductJournal::TiledProduct tiledProduct(quint16 imageNumber) const;
+    void recordTiledProduct(quint16 imageNumber, const ProductJournal::TiledProduct& product);
+    // 编号被重新分配时去掉以它为整图或瓦片的旧记录，返回被去掉的整图编号（没有时为 -1）；调用方持有 m_mutex
+    int forgetTiledLocked(quint16 imageNumber);
+    void dropTiledRecord(int imageNumber);
+    // 按实际放入缓存的键取出产品：瓦片产品依次拼接各瓦片，任一瓦片缺失即为未命中
+    QByteArray lookupProduct(quint16 imageNumber);
+    void removeCachedProduct(quint16 imageNumber);
+    // 在线程池中调用：以新分配的编号生成预览并直接交给 I/O 线程发送
+    void sendPreview(const TransferJob& job, const ProgressiveSettings& settings);
+    // 以下两个回调由线程池任务或 I/O 线程投递回本对象所在线程执行
+    void onPacked(const TransferJob& job, const ImageTransferResult& result);
+    void onTransferred(const TransferJob& job, const ImageTransferResult& result);
+    void removePackedFile(const TransferJob& job);
+    void resumePendingProducts();
+    int rootIndexForPath(const QString& filePath) const;
+    TransferJob makeJob(const Root& root, const ProductJob& product, quint16 imageNumber) const;
+    void destroyRoots();
+
+    QList<Root> m_roots;
+    ProductJournal m_journal;
+    TransferScheduler* m_scheduler;
+    WorkerPool* m_pool;
+    IoExecutor* m_io;
+    TransferOptions m_transferOptions;
+    ProgressiveSettings m_progressive;
+    TileSettings m_tiling;
+    DeltaSettings m_delta;
+    SceneDeltaStore m_deltaStore;
+    TransferMetrics m_metrics;
+    ProductCache m_productCache;
+    ProductTimingStats m_timingStats;
+    QTimer* m_metricsTimer;
+    mutable QMutex m_mutex;
+    QMap<quint16, QString> m_imageLog;
+    QHash<quint16, ProductJournal::TiledProduct> m_tiledProducts;   // 整图编号 → 瓦片
+    QHash<quint16, quint16> m_tileParents;                          // 瓦片编号 → 整图编号
+    QSet<QString> m_inFlightProducts;  // 已入队、处理中或退避等待中的产品组键
+    bool m_running = false;
+    bool m_draining = false;
+};
+
+#endif // TRANSFER_PIPELINE_H
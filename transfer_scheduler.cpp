@@ -0,0 +1,352 @@
+#include "transfer_scheduler.h"
+#include "durable_queue.h"
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+
+// 默认最多尝试次数：按 1 s 起、60 s 封顶的退避，约可覆盖 45 分钟的链路中断
+static const int DEFAULT_MAX_ATTEMPTS = 50;
+static const int DEFAULT_INITIAL_BACKOFF_MS = 1000;
+static const int DEFAULT_MAX_BACKOFF_MS = 60000;
+// 持久化记录的批量落盘间隔：同一时段内的多条入队/完成记录共用一次 fsync
+static const int SYNC_INTERVAL_MS = 20;
+// 链路占用时间滑动平均的权重
+static const double SERVICE_TIME_ALPHA = 0.2;
+
+TransferScheduler::TransferScheduler(QObject* parent)
+    : QObject(parent),
+    m_maxAttempts(DEFAULT_MAX_ATTEMPTS),
+    m_initialBackoffMs(DEFAULT_INITIAL_BACKOFF_MS),
+    m_maxBackoffMs(DEFAULT_MAX_BACKOFF_MS),
+    m_durable(new DurableQueue),
+    m_retryTimer(new QTimer(this)),
+    m_syncTimer(new QTimer(this))
+{
+    qRegisterMetaType<TransferJob>("TransferJob");
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &TransferScheduler::onRetryTimeout);
+    m_syncTimer->setSingleShot(true);
+    m_syncTimer->setInterval(SYNC_INTERVAL_MS);
+    connect(m_syncTimer, &QTimer::timeout, this, &TransferScheduler::onSyncTimeout);
+}
+
+TransferScheduler::~TransferScheduler() {
+    delete m_durable;
+}
+
+void TransferScheduler::setMaxInFlight(int maxInFlight) {
+    m_maxInFlight = qMax(1, maxInFlight);
+    pump();
+}
+
+int TransferScheduler::maxInFlight() const {
+    return m_maxInFlight;
+}
+
+bool TransferScheduler::openQueue(const QString& dirPath) {
+    return m_durable->open(dirPath);
+}
+
+void TransferScheduler::closeQueue() {
+    m_syncTimer->stop();
+    m_durable->close();
+}
+
+QList<TransferJob> TransferScheduler::persistedJobs() const {
+    return m_durable->pendingJobs();
+}
+
+void TransferScheduler::setMaxAttempts(int maxAttempts) {
+    m_maxAttempts = qMax(1, maxAttempts);
+}
+
+void TransferScheduler::setBackoff(int initialMs, int maxMs) {
+    m_initialBackoffMs = qMax(1, initialMs);
+    m_maxBackoffMs = qMax(m_initialBackoffMs, maxMs);
+}
+
+void TransferScheduler::setOverloadPolicy(const OverloadPolicy& policy) {
+    m_policy = policy;
+    m_policy.keepEveryK = qMax(1, policy.keepEveryK);
+    m_sarSeenWhileOverloaded = 0;
+}
+
+OverloadPolicy TransferScheduler::overloadPolicy() const {
+    return m_policy;
+}
+
+qint64 TransferScheduler::backoffMs(int attempts) const {
+    const int shift = qBound(0, attempts - 1, 20);
+    return qMin<qint64>(m_maxBackoffMs, static_cast<qint64>(m_initialBackoffMs) << shift);
+}
+
+void TransferScheduler::enqueue(const TransferJob& job) {
+    TransferJob persisted = job;
+    if (m_durable->isOpen()) {
+        m_durable->append(&persisted);
+        scheduleSync();
+    }
+    resume(persisted);
+}
+
+void TransferScheduler::resume(const TransferJob& job) {
+    if (job.notBeforeMs > QDateTime::currentMSecsSinceEpoch()) {
+        pushDelayed(job);
+    } else {
+        pushReady(job);
+        pump();
+    }
+    emit queueChanged(m_queued, m_inFlight);
+}
+
+void TransferScheduler::jobFinished(const TransferJob& job, bool success, bool retryable) {
+    if (m_inFlight > 0) {
+        --m_inFlight;
+    }
+
+    if (success && job.dispatchedMs > 0) {
+        const qint64 serviceMs = QDateTime::currentMSecsSinceEpoch() - job.dispatchedMs;
+        m_avgServiceMs = m_avgServiceMs <= 0.0
+            ? serviceMs
+            : (1.0 - SERVICE_TIME_ALPHA) * m_avgServiceMs + SERVICE_TIME_ALPHA * serviceMs;
+    }
+
+    if (success) {
+        if (job.queueId != 0) {
+            m_durable->markDone(job.queueId);
+            scheduleSync();
+        }
+        // 链路恢复：同一目的地址退避中的任务不再等待，按全速出队
+        releaseDelayed(job.host, job.port);
+    } else {
+        TransferJob retry = job;
+        retry.attempts++;
+        if (!retryable || retry.attempts >= m_maxAttempts) {
+            qWarning() << "Giving up on product" << job.product.key << "after" << retry.attempts << "attempts.";
+            if (job.queueId != 0) {
+                m_durable->markDone(job.queueId);
+                scheduleSync();
+            }
+            emit jobAbandoned(retry);
+        } else {
+            const qint64 delay = backoffMs(retry.attempts);
+            retry.notBeforeMs = QDateTime::currentMSecsSinceEpoch() + delay;
+            if (retry.queueId != 0) {
+                m_durable->markRetry(retry);
+                scheduleSync();
+            }
+            qDebug() << "Product" << job.product.key << "failed (attempt" << retry.attempts << "), retrying in" << delay << "ms.";
+            pushDelayed(retry);
+            emit jobRetryScheduled(retry, delay);
+        }
+    }
+    pump();
+    emit queueChanged(m_queued, m_inFlight);
+}
+
+void TransferScheduler::clear() {
+    // 只清内存队列；持久化队列中的任务保留，下次启动时恢复
+    m_queues.clear();
+    m_delayed.clear();
+    m_retryTimer->stop();
+    m_queued = 0;
+    if (m_durable->isOpen()) {
+        m_durable->sync();
+    }
+    emit queueChanged(m_queued, m_inFlight);
+}
+
+int TransferScheduler::queuedCount() const {
+    return m_queued;
+}
+
+int TransferScheduler::inFlightCount() const {
+    return m_inFlight;
+}
+
+int TransferScheduler::delayedCount() const {
+    return m_delayed.size();
+}
+
+int TransferScheduler::droppedCount() const {
+    return m_dropped;
+}
+
+int TransferScheduler::deferredCount() const {
+    return m_deferred;
+}
+
+double TransferScheduler::throughput() const {
+    if (m_avgServiceMs <= 0.0) {
+        return 0.0;
+    }
+    return m_maxInFlight * 1000.0 / qMax(1.0, m_avgServiceMs);
+}
+
+bool TransferScheduler::isOverloaded() const {
+    if (m_policy.mode == OverloadMode::Fifo || m_queued <= 1) {
+        return false;
+    }
+    const double rate = throughput();
+    if (rate > 0.0) {
+        return m_queued / rate > m_policy.maxDrainSeconds;
+    }
+    return m_queued > m_policy.maxDepth;
+}
+
+void TransferScheduler::pushReady(const TransferJob& job) {
+    m_queues[-job.priority].jobs.enqueue(job);
+    ++m_queued;
+}
+
+void TransferScheduler::pushDelayed(const TransferJob& job) {
+    m_delayed.append(job);
+    armRetryTimer();
+}
+
+void TransferScheduler::releaseDelayed(const QString& host, quint16 port) {
+    bool released = false;
+    for (auto it = m_delayed.begin(); it != m_delayed.end();) {
+        if (it->host == host && it->port == port) {
+            TransferJob job = *it;
+            job.notBeforeMs = 0;
+            pushReady(job);
+            it = m_delayed.erase(it);
+            released = true;
+        } else {
+            ++it;
+        }
+    }
+    if (released) {
+        armRetryTimer();
+    }
+}
+
+void TransferScheduler::armRetryTimer() {
+    if (m_delayed.isEmpty()) {
+        m_retryTimer->stop();
+        return;
+    }
+    const auto earliest = std::min_element(m_delayed.cbegin(), m_delayed.cend(),
+                                           [](const TransferJob& a, const TransferJob& b) {
+                                               return a.notBeforeMs < b.notBeforeMs;
+                                           });
+    const qint64 wait = earliest->notBeforeMs - QDateTime::currentMSecsSinceEpoch();
+    m_retryTimer->start(static_cast<int>(qBound<qint64>(0, wait, m_maxBackoffMs)));
+}
+
+void TransferScheduler::onRetryTimeout() {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = m_delayed.begin(); it != m_delayed.end();) {
+        if (it->notBeforeMs <= now) {
+            pushReady(*it);
+            it = m_delayed.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    armRetryTimer();
+    pump();
+    emit queueChanged(m_queued, m_inFlight);
+}
+
+void TransferScheduler::scheduleSync() {
+    if (m_durable->hasUnsyncedRecords() && !m_syncTimer->isActive()) {
+        m_syncTimer->start();
+    }
+}
+
+void TransferScheduler::onSyncTimeout() {
+    m_durable->sync();
+}
+
+void TransferScheduler::pump() {
+    TransferJob job;
+    while (m_inFlight < m_maxInFlight && takeNext(&job)) {
+        job.dispatchedMs = QDateTime::currentMSecsSinceEpoch();
+        ++m_inFlight;
+        emit dispatchJob(job);
+    }
+}
+
+/**
+ * @brief 按优先级取出下一个任务，过载时应用过载策略。
+ * 未过载时与 FIFO 相同；被丢弃的任务从持久化队列中移除并发出 jobDropped。
+ */
+bool TransferScheduler::takeNext(TransferJob* job) {
+    const bool overloaded = isOverloaded();
+    if (!overloaded) {
+        m_sarSeenWhileOverloaded = 0;
+    }
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    while (!m_queues.isEmpty()) {
+        auto it = m_queues.begin();
+        PriorityQueue& queue = *it;
+        if (overloaded && m_policy.mode == OverloadMode::DropOlderThan) {
+            dropStale(queue, now);
+        }
+        if (queue.jobs.isEmpty()) {
+            m_queues.erase(it);
+            continue;
+        }
+
+        TransferJob next;
+        if (overloaded && m_policy.mode == OverloadMode::NewestFirst) {
+            next = queue.jobs.takeLast();
+            // 剩余的旧任务全部被越过，新增部分计入延后统计
+            const int remaining = queue.jobs.size();
+            if (remaining > queue.deferredPrefix) {
+                m_deferred += remaining - queue.deferredPrefix;
+                queue.deferredPrefix = remaining;
+            }
+            // 取走的若是已计入的任务，前缀不能超出缩短后的队列，否则之后新入队的任务会被当作已计入
+            queue.deferredPrefix = qMin(queue.deferredPrefix, remaining);
+        } else {
+            next = queue.jobs.dequeue();
+            queue.deferredPrefix = qMax(0, queue.deferredPrefix - 1);
+        }
+        --m_queued;
+        if (queue.jobs.isEmpty()) {
+            m_queues.erase(it);
+        }
+
+        if (overloaded && m_policy.mode == OverloadMode::KeepEveryKth && next.product.type == ProductType::SAR) {
+            if (m_sarSeenWhileOverloaded++ % m_policy.keepEveryK != 0) {
+                drop(next, QString("thinned, keeping 1 of every %1 SAR products").arg(m_policy.keepEveryK));
+                continue;
+            }
+        }
+        *job = next;
+        return true;
+    }
+    return false;
+}
+
+void TransferScheduler::dropStale(PriorityQueue& queue, qint64 now) {
+    const qint64 maxAgeMs = static_cast<qint64>(m_policy.maxAgeSeconds) * 1000;
+    int index = 0;
+    for (auto it = queue.jobs.begin(); it != queue.jobs.end();) {
+        if (it->product.type == ProductType::SAR && now - it->detectedMs > maxAgeMs) {
+            const TransferJob stale = *it;
+            it = queue.jobs.erase(it);
+            --m_queued;
+            if (index < queue.deferredPrefix) {
+                --queue.deferredPrefix;
+            }
+            drop(stale, QString("older than %1 s").arg(m_policy.maxAgeSeconds));
+        } else {
+            ++it;
+            ++index;
+        }
+    }
+}
+
+void TransferScheduler::drop(const TransferJob& job, const QString& reason) {
+    ++m_dropped;
+    if (job.queueId != 0) {
+        m_durable->markDone(job.queueId);
+        scheduleSync();
+    }
+    qDebug() << "Link overloaded, dropping product" << job.product.key << ":" << reason;
+    emit jobDropped(job, reason);
+}
@@ -0,0 +1,157 @@
+#ifndef TRANSFER_SCHEDULER_H
+#define TRANSFER_SCHEDULER_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QQueue>
+#include <QTimer>
+#include <QString>
+#include <QMetaType>
+#include "product_correlator.h"
+#include "product_timing.h"
+
+class DurableQueue;
+
+// 一次待传输的产品：产品文件 + 所属根目录的目的地址与优先级
+struct TransferJob {
+    ProductJob product;
+    quint16 imageNumber = 0;
+    QString rootName;
+    QString host;
+    quint16 port = 0;
+    int priority = 0;
+    qint64 detectedMs = 0;
+    quint64 queueId = 0;      // 持久化队列中的编号，0 表示未入持久化队列
+    int attempts = 0;         // 已失败的传输次数
+    qint64 notBeforeMs = 0;   // 重试退避：此时刻之前不出队
+    qint64 dispatchedMs = 0;  // 出队时刻，用于测量单个产品的链路占用时间
+    QString packedPath;       // 打包生成的待发送 bin 文件，空表示尚未打包
+    qint64 queuedMs = 0;      // 进入调度队列的时刻（仅内存中，用于统计排队时间）
+    ProductTiming timing;     // 分环节耗时（仅内存中，从持久化队列恢复的任务不含检测与等待环节）
+};
+Q_DECLARE_METATYPE(TransferJob)
+
+// 链路过载时的出队策略
+enum class OverloadMode {
+    Fifo,           // 先进先出（不丢弃）
+    NewestFirst,    // 最新产品优先，旧产品延后
+    DropOlderThan,  // 丢弃等待超过 maxAgeSeconds 的 SAR 产品
+    KeepEveryKth    // 连续的 SAR 产品每 k 个保留 1 个
+};
+
+/**
+ * 过载策略配置。只有在过载时策略才生效，否则始终按优先级先进先出。
+ * 过载判定：按实测吞吐量估算的排空时间超过 maxDrainSeconds；
+ * 尚无吞吐量测量值时，以队列深度超过 maxDepth 判定。
+ * GMTI 产品体积小且包含目标信息，任何策略下都不丢弃。
+ */
+struct OverloadPolicy {
+    OverloadMode mode = OverloadMode::Fifo;
+    int maxAgeSeconds = 60;
+    int keepEveryK = 2;
+    int maxDrainSeconds = 30;
+    int maxDepth = 16;
+};
+
+/**
+ * @class TransferScheduler
+ * @brief 各监控根目录共享的链路调度器。
+ *
+ * 所有根目录的产品进入同一调度器，按优先级从高到低、同优先级先进先出出队；
+ * 同时在途的传输数受 maxInFlight 限制，避免多个根目录争抢同一条链路。
+ * 执行方收到 dispatchJob 后处理，完成时必须调用 jobFinished 释放名额。
+ *
+ * 打开持久化队列后，入队的任务先写入 DurableQueue，进程崩溃或退出后可恢复；
+ * 传输失败的任务按指数退避重新排队，达到最大次数或不可重试时放弃。
+ * 同一目的地址的任务一旦传输成功，说明链路已恢复，该地址所有退避中的任务立即恢复出队。
+ *
+ * 产出快于链路时，由 OverloadPolicy 决定最新产品优先或按规则丢弃旧产品，并统计丢弃/延后数量。
+ */
+class TransferScheduler : public QObject {
+    Q_OBJECT
+public:
+    explicit TransferScheduler(QObject* parent = nullptr);
+    ~TransferScheduler();
+
+    void setMaxInFlight(int maxInFlight);
+    int maxInFlight() const;
+
+    bool openQueue(const QString& dirPath);
+    void closeQueue();
+    // 持久化队列中尚未完成的任务（重启后由调用方核对后调用 resume 重新排队）
+    QList<TransferJob> persistedJobs() const;
+
+    void setMaxAttempts(int maxAttempts);
+    void setBackoff(int initialMs, int maxMs);
+    void setOverloadPolicy(const OverloadPolicy& policy);
+    OverloadPolicy overloadPolicy() const;
+
+    // 新任务：写入持久化队列后排队
+    void enqueue(const TransferJob& job);
+    // 已在持久化队列中的任务：只恢复到内存队列
+    void resume(const TransferJob& job);
+    // retryable 为 false 时（如文件已不存在）失败直接放弃，不再重试
+    void jobFinished(const TransferJob& job, bool success, bool retryable = true);
+    void clear();
+
+    int queuedCount() const;
+    int inFlightCount() const;
+    int delayedCount() const;
+    // 过载统计：被策略丢弃的产品数、被更新产品插队而延后的产品数
+    int droppedCount() const;
+    int deferredCount() const;
+    // 实测链路吞吐量（产品/秒），尚无测量值时为 0
+    double throughput() const;
+    bool isOverloaded() const;
+
+signals:
+    void dispatchJob(const TransferJob& job);
+    void queueChanged(int queued, int inFlight);
+    void jobRetryScheduled(const TransferJob& job, qint64 delayMs);
+    void jobAbandoned(const TransferJob& job);
+    void jobDropped(const TransferJob& job, const QString& reason);
+
+private slots:
+    void onRetryTimeout();
+    void onSyncTimeout();
+
+private:
+    // 同一优先级的队列；NewestFirst 从队尾出队，被越过的旧任务总是位于队首一段
+    struct PriorityQueue {
+        QQueue<TransferJob> jobs;
+        int deferredPrefix = 0;  // 队首已计入延后统计的任务数
+    };
+
+    void pump();
+    bool takeNext(TransferJob* job);
+    void dropStale(PriorityQueue& queue, qint64 now);
+    void drop(const TransferJob& job, const QString& reason);
+    void pushReady(const TransferJob& job);
+    void pushDelayed(const TransferJob& job);
+    void releaseDelayed(const QString& host, quint16 port);
+    void armRetryTimer();
+    void scheduleSync();
+    qint64 backoffMs(int attempts) const;
+
+    // 键为优先级的相反数，使 QMap 的升序遍历即为优先级降序
+    QMap<int, PriorityQueue> m_queues;
+    // 退避中的任务，到期后移入 m_queues
+    QList<TransferJob> m_delayed;
+    int m_queued = 0;
+    int m_inFlight = 0;
+    int m_maxInFlight = 1;
+    int m_maxAttempts;
+    int m_initialBackoffMs;
+    int m_maxBackoffMs;
+    OverloadPolicy m_policy;
+    int m_dropped = 0;
+    int m_deferred = 0;
+    int m_sarSeenWhileOverloaded = 0;
+    double m_avgServiceMs = 0.0;  // 单个产品链路占用时间的指数滑动平均
+    DurableQueue* m_durable;
+    QTimer* m_retryTimer;
+    QTimer* m_syncTimer;
+};
+
+#endif // TRANSFER_SCHEDULER_H
@@ -0,0 +1,166 @@
+// transfer_scheduler_test.cpp
+// TransferScheduler 过载策略：未过载或 fifo 时按入队顺序出队；newest_first 先发最新产品并统计被越过的旧产品；
+// drop_older_than 只丢弃超龄的 SAR 产品；keep_every_kth 只抽稀连续的 SAR 产品，GMTI 在任何策略下都不丢弃。
+#include <QtTest>
+#include <QDateTime>
+#include <QSignalSpy>
+#include <memory>
+#include "transfer_scheduler.h"
+
+namespace {
+
+TransferJob makeJob(const QString& key, ProductType type = ProductType::SAR, qint64 ageMs = 0) {
+    TransferJob job;
+    job.product.type = type;
+    job.product.key = key;
+    job.host = "127.0.0.1";
+    job.port = 9000;
+    job.detectedMs = QDateTime::currentMSecsSinceEpoch() - ageMs;
+    return job;
+}
+
+// maxDrainSeconds 为 0、maxDepth 为 1：不论是否已测得吞吐量，排队多于 1 个即视为过载，结果与耗时无关
+OverloadPolicy policy(OverloadMode mode) {
+    OverloadPolicy policy;
+    policy.mode = mode;
+    policy.maxDrainSeconds = 0;
+    policy.maxDepth = 1;
+    return policy;
+}
+
+} // namespace
+
+class TransferSchedulerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init() {
+        m_scheduler.reset(new TransferScheduler);
+        m_dispatched.clear();
+        connect(m_scheduler.get(), &TransferScheduler::dispatchJob, this, [this](const TransferJob& job) {
+            m_dispatched.append(job);
+        });
+    }
+
+    void fifoKeepsArrivalOrder() {
+        m_scheduler->setOverloadPolicy(policy(OverloadMode::Fifo));
+        for (const QString key : {"a", "b", "c", "d", "e"}) {
+            m_scheduler->enqueue(makeJob(key));
+        }
+        QCOMPARE(m_scheduler->isOverloaded(), false);
+        drain();
+        QCOMPARE(dispatchedKeys(), QStringList({"a", "b", "c", "d", "e"}));
+        QCOMPARE(m_scheduler->droppedCount(), 0);
+        QCOMPARE(m_scheduler->deferredCount(), 0);
+    }
+
+    void newestFirstDefersOlderProducts() {
+        m_scheduler->setOverloadPolicy(policy(OverloadMode::NewestFirst));
+        for (const QString key : {"a", "b", "c", "d"}) {
+            m_scheduler->enqueue(makeJob(key));
+        }
+        QVERIFY(m_scheduler->isOverloaded());
+        drain();
+        // a 入队时链路空闲直接发出；之后过载期间先发最新的 d、c，只剩一个时恢复先进先出
+        QCOMPARE(dispatchedKeys(), QStringList({"a", "d", "c", "b"}));
+        // b、c 被 d 越过各计一次，c 之后越过 b 不重复计数
+        QCOMPARE(m_scheduler->deferredCount(), 2);
+        QCOMPARE(m_scheduler->droppedCount(), 0);
+    }
+
+    void newestFirstCountsJobsArrivingAfterDeferredOnesTaken() {
+        m_scheduler->setOverloadPolicy(policy(OverloadMode::NewestFirst));
+        for (const QString key : {"a", "b", "c", "d"}) {
+            m_scheduler->enqueue(makeJob(key));
+        }
+        // 先发 a，再越过 b、c 发 d，然后发出已计入延后的 c
+        m_scheduler->jobFinished(m_dispatched.at(0), true);
+        m_scheduler->jobFinished(m_dispatched.at(1), true);
+        QCOMPARE(dispatchedKeys(), QStringList({"a", "d", "c"}));
+        QCOMPARE(m_scheduler->deferredCount(), 2);
+
+        // 之后入队的 e 被 f 越过，应另计一次
+        m_scheduler->enqueue(makeJob("e"));
+        m_scheduler->enqueue(makeJob("f"));
+        drain(2);
+        QCOMPARE(dispatchedKeys(), QStringList({"a", "d", "c", "f", "e", "b"}));
+        QCOMPARE(m_scheduler->deferredCount(), 3);
+    }
+
+    void dropOlderThanDropsOnlyStaleSar() {
+        OverloadPolicy dropPolicy = policy(OverloadMode::DropOlderThan);
+        dropPolicy.maxAgeSeconds = 10;
+        m_scheduler->setOverloadPolicy(dropPolicy);
+        QSignalSpy dropped(m_scheduler.get(), &TransferScheduler::jobDropped);
+
+        m_scheduler->enqueue(makeJob("fresh1"));
+        m_scheduler->enqueue(makeJob("staleSar", ProductType::SAR, 60000));
+        m_scheduler->enqueue(makeJob("staleGmti", ProductType::GMTI, 60000));
+        m_scheduler->enqueue(makeJob("fresh2"));
+        drain();
+
+        QCOMPARE(dispatchedKeys(), QStringList({"fresh1", "staleGmti", "fresh2"}));
+        QCOMPARE(dropped.count(), 1);
+        QCOMPARE(dropped.at(0).at(0).value<TransferJob>().product.key, QString("staleSar"));
+        QCOMPARE(m_scheduler->droppedCount(), 1);
+        QCOMPARE(m_scheduler->queuedCount(), 0);
+    }
+
+    void dropOlderThanIgnoredWithoutOverload() {
+        OverloadPolicy dropPolicy = policy(OverloadMode::DropOlderThan);
+        dropPolicy.maxAgeSeconds = 10;
+        dropPolicy.maxDepth = 16;
+        dropPolicy.maxDrainSeconds = 3600;
+        m_scheduler->setOverloadPolicy(dropPolicy);
+
+        m_scheduler->enqueue(makeJob("fresh"));
+        m_scheduler->enqueue(makeJob("stale", ProductType::SAR, 60000));
+        drain();
+        QCOMPARE(dispatchedKeys(), QStringList({"fresh", "stale"}));
+        QCOMPARE(m_scheduler->droppedCount(), 0);
+    }
+
+    void keepEveryKthThinsConsecutiveSar() {
+        OverloadPolicy thinPolicy = policy(OverloadMode::KeepEveryKth);
+        thinPolicy.keepEveryK = 2;
+        m_scheduler->setOverloadPolicy(thinPolicy);
+        QSignalSpy dropped(m_scheduler.get(), &TransferScheduler::jobDropped);
+
+        m_scheduler->enqueue(makeJob("s1"));
+        m_scheduler->enqueue(makeJob("s2"));
+        m_scheduler->enqueue(makeJob("g1", ProductType::GMTI));
+        m_scheduler->enqueue(makeJob("s3"));
+        m_scheduler->enqueue(makeJob("s4"));
+        m_scheduler->enqueue(makeJob("s5"));
+        drain();
+
+        // 过载期间的 SAR 依次为 s2、s3、s4，保留第 1、3 个；GMTI 不计入也不丢弃；s5 出队时已不再过载
+        QCOMPARE(dispatchedKeys(), QStringList({"s1", "s2", "g1", "s4", "s5"}));
+        QCOMPARE(dropped.count(), 1);
+        QCOMPARE(dropped.at(0).at(0).value<TransferJob>().product.key, QString("s3"));
+    }
+
+private:
+    // 逐个完成已发出的任务（前 finished 个已完成），直到调度器不再发出新任务
+    void drain(int finished = 0) {
+        while (finished < m_dispatched.size()) {
+            const TransferJob job = m_dispatched.at(finished++);   // jobFinished 期间列表会追加
+            m_scheduler->jobFinished(job, true);
+        }
+        QCOMPARE(m_scheduler->inFlightCount(), 0);
+    }
+
+    QStringList dispatchedKeys() const {
+        QStringList keys;
+        for (const TransferJob& job : m_dispatched) {
+            keys << job.product.key;
+        }
+        return keys;
+    }
+
+    std::unique_ptr<TransferScheduler> m_scheduler;
+    QList<TransferJob> m_dispatched;
+};
+
+QTEST_GUILESS_MAIN(TransferSchedulerTest)
+#include "transfer_scheduler_test.moc"
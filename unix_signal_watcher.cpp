@@ -0,0 +1,74 @@
+#include "unix_signal_watcher.h"
+#include <QDebug>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// [0] 由信号处理函数写入，[1] 由事件循环读取
+static int s_signalFds[2] = {-1, -1};
+
+UnixSignalWatcher::UnixSignalWatcher(const QList<int>& signalNumbers, QObject* parent)
+    : QObject(parent),
+    m_signals(signalNumbers)
+{
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, s_signalFds) != 0) {
+        qWarning() << "socketpair() failed:" << strerror(errno);
+        return;
+    }
+    for (int fd : s_signalFds) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    m_notifier = new QSocketNotifier(s_signalFds[1], QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &UnixSignalWatcher::onActivated);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = &UnixSignalWatcher::handleSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    for (int signalNumber : m_signals) {
+        if (::sigaction(signalNumber, &action, nullptr) != 0) {
+            qWarning() << "sigaction() failed for signal" << signalNumber << ":" << strerror(errno);
+        }
+    }
+}
+
+UnixSignalWatcher::~UnixSignalWatcher() {
+    for (int signalNumber : m_signals) {
+        ::signal(signalNumber, SIG_DFL);
+    }
+    delete m_notifier;
+    for (int& fd : s_signalFds) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+}
+
+bool UnixSignalWatcher::isValid() const {
+    return m_notifier != nullptr;
+}
+
+void UnixSignalWatcher::handleSignal(int signalNumber) {
+    const int savedErrno = errno;
+    const unsigned char byte = static_cast<unsigned char>(signalNumber);
+    // 管道满时丢弃：已有未处理的信号，事件循环总会被唤醒
+    [[maybe_unused]] const ssize_t written = ::write(s_signalFds[0], &byte, 1);
+    errno = savedErrno;
+}
+
+void UnixSignalWatcher::onActivated() {
+    unsigned char bytes[16];
+    ssize_t count;
+    while ((count = ::read(s_signalFds[1], bytes, sizeof(bytes))) > 0) {
+        for (ssize_t i = 0; i < count; ++i) {
+            emit signalReceived(bytes[i]);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef UNIX_SIGNAL_WATCHER_H
+#define UNIX_SIGNAL_WATCHER_H
+
+#include <QObject>
+#include <QList>
+
+class QSocketNotifier;
+
+/**
+ * @class UnixSignalWatcher
+ * @brief 把 Unix 信号转成 Qt 信号。
+ *
+ * 信号处理函数里只向 socketpair 写入信号编号（异步信号安全），
+ * 事件循环通过 QSocketNotifier 读出后发出 signalReceived，在普通上下文中处理。
+ * 同一进程只应创建一个实例。
+ */
+class UnixSignalWatcher : public QObject {
+    Q_OBJECT
+public:
+    explicit UnixSignalWatcher(const QList<int>& signalNumbers, QObject* parent = nullptr);
+    ~UnixSignalWatcher();
+
+    bool isValid() const;
+
+signals:
+    void signalReceived(int signalNumber);
+
+private slots:
+    void onActivated();
+
+private:
+    static void handleSignal(int signalNumber);
+
+    QList<int> m_signals;
+    QSocketNotifier* m_notifier = nullptr;
+};
+
+#endif // UNIX_SIGNAL_WATCHER_H
@@ -0,0 +1,118 @@
+#include "worker_pool.h"
+#include <QDebug>
+#include <QMutexLocker>
+
+namespace {
+// 当前线程在所属线程池中的编号，非工作线程为 -1
+thread_local int t_workerIndex = -1;
+thread_local const WorkerPool* t_workerPool = nullptr;
+}
+
+WorkerPool::WorkerPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = qMax(1, QThread::idealThreadCount());
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        m_deques.push_back(std::make_unique<TaskDeque>());
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        QThread* thread = QThread::create([this, i]() { workerLoop(i); });
+        thread->setObjectName(QString("worker-%1").arg(i));
+        m_threads.append(thread);
+        thread->start();
+    }
+    qDebug() << "Worker pool started with" << threadCount << "threads.";
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+int WorkerPool::threadCount() const {
+    return m_threads.size();
+}
+
+int WorkerPool::pendingCount() const {
+    return m_pending.load();
+}
+
+void WorkerPool::submit(Task task) {
+    if (m_stopping.load()) {
+        qWarning() << "Worker pool is shutting down, task discarded.";
+        return;
+    }
+    const int count = static_cast<int>(m_deques.size());
+    const int index = (t_workerPool == this && t_workerIndex >= 0)
+        ? t_workerIndex
+        : static_cast<int>(m_nextDeque.fetch_add(1) % count);
+    {
+        QMutexLocker locker(&m_deques[index]->mutex);
+        m_deques[index]->tasks.push_back(std::move(task));
+    }
+    m_pending.fetch_add(1);
+    // 在持有 m_sleepMutex 时唤醒，保证不会错过正准备进入等待的线程
+    QMutexLocker locker(&m_sleepMutex);
+    m_wakeup.wakeOne();
+}
+
+void WorkerPool::shutdown() {
+    if (m_threads.isEmpty()) {
+        return;
+    }
+    m_stopping.store(true);
+    {
+        QMutexLocker locker(&m_sleepMutex);
+        m_wakeup.wakeAll();
+    }
+    for (QThread* thread : m_threads) {
+        thread->wait();
+        delete thread;
+    }
+    m_threads.clear();
+}
+
+bool WorkerPool::popLocal(int index, Task* task) {
+    TaskDeque& deque = *m_deques[index];
+    QMutexLocker locker(&deque.mutex);
+    if (deque.tasks.empty()) {
+        return false;
+    }
+    *task = std::move(deque.tasks.front());
+    deque.tasks.pop_front();
+    return true;
+}
+
+bool WorkerPool::steal(int thief, Task* task) {
+    const int count = static_cast<int>(m_deques.size());
+    for (int offset = 1; offset < count; ++offset) {
+        TaskDeque& victim = *m_deques[(thief + offset) % count];
+        QMutexLocker locker(&victim.mutex);
+        if (!victim.tasks.empty()) {
+            *task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::workerLoop(int index) {
+    t_workerIndex = index;
+    t_workerPool = this;
+    for (;;) {
+        Task task;
+        if (popLocal(index, &task) || steal(index, &task)) {
+            m_pending.fetch_sub(1);
+            task();
+            continue;
+        }
+        QMutexLocker locker(&m_sleepMutex);
+        if (m_pending.load() > 0) {
+            continue;
+        }
+        if (m_stopping.load()) {
+            break;
+        }
+        m_wakeup.wait(&m_sleepMutex);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @class WorkerPool
+ * @brief 工作窃取线程池。
+ *
+ * 每个工作线程有自己的任务双端队列：外部提交的任务轮流分配到各队列，
+ * 工作线程内部提交的任务放入本线程队列；线程从自己队列头部取任务，
+ * 自己队列为空时从其他线程队列尾部窃取，避免单个长任务（大图打包、链路等待）
+ * 拖住排在它后面的任务。所有根目录的产品共享同一个线程池。
+ */
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+    // threadCount <= 0 时使用 QThread::idealThreadCount()
+    explicit WorkerPool(int threadCount = 0);
+    ~WorkerPool();
+
+    void submit(Task task);
+    // 停止接收新任务，执行完已提交的任务后退出全部线程
+    void shutdown();
+
+    int threadCount() const;
+    int pendingCount() const;
+
+private:
+    struct TaskDeque {
+        QMutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(int index);
+    bool popLocal(int index, Task* task);
+    bool steal(int thief, Task* task);
+
+    std::vector<std::unique_ptr<TaskDeque>> m_deques;
+    QList<QThread*> m_threads;
+    QMutex m_sleepMutex;
+    QWaitCondition m_wakeup;
+    std::atomic<int> m_pending{0};
+    std::atomic<bool> m_stopping{false};
+    std::atomic<unsigned> m_nextDeque{0};
+};
+
+#endif // WORKER_POOL_H